@@ -30,6 +30,7 @@ extern "C" {
 #include "extFlash.h"
 #include "selfTest.h"
 #include "Measurement.h"
+#include "xTaskMeasure.h"
 #include "convert_junit.h"
 #include "PMIC_UART.h"
 #include "pmic.h"
@@ -1034,43 +1035,49 @@ static void handleWakeReason(uint8_t wakeReason)
 
 
 /*!
- * handleEventLog
+ * remainingEventLogEntries
  *
- * @desc	Handle event log from the PMIC
- * @param 	pstcPmicErrorLog - pointer to error log structure
+ * @desc	The PMIC log entries the event log still takes, leaving 10% of it free
+ * @param	-
  *
- * @return
+ * @return	number of entries, of the largest size
  */
-static void handleEventLog(PMIC_ErrorLog* pstcPmicErrorLog)
+static uint8_t remainingEventLogEntries(void)
 {
-	//Get number of logs stored in internal flash
-	static uint8_t nRemainingLogEntryCount = 0;
-
-	static uint16_t nSpaceLeft = 0;
+	tEventLog_inFlash * addrEventLog = NULL;
+	uint32_t nUsedSpace = EventLog_pendingSize();	// those still in RAM, to be committed
 
-	if(nRemainingLogEntryCount == 0)
+	while (EventLog_getLog(&addrEventLog))
 	{
-		tEventLog_inFlash * addrEventLog = NULL;
-		uint16_t nUsedSpace = 0;
-
-		EventLog_InitFlashData();
+		nUsedSpace += EventLog_entrySize(addrEventLog);
+	}
 
-		while (EventLog_getLog(&addrEventLog))
-		{
-			nUsedSpace += MAXERRLOGFRAMELENGTH;
-		}
+	if(nUsedSpace >= SYS_FLASH_ERRLOG_SIZE)
+	{
+		return 0;
+	}
+	//Ensure to leave 10% of space left
+	return (((SYS_FLASH_ERRLOG_SIZE - nUsedSpace) * 9) / 10) / MAXERRLOGFRAMELENGTH;
+}
 
-		EventLog_InitFlashData();
 
-		//Ensure to leave 10% of space left
-		nSpaceLeft = (SYS_FLASH_ERRLOG_SIZE - nUsedSpace) * 0.9;
-		nRemainingLogEntryCount = nSpaceLeft / MAXERRLOGFRAMELENGTH;
-	}
+/*!
+ * handleEventLog
+ *
+ * @desc	Handle event log from the PMIC
+ * @param 	pstcPmicErrorLog - pointer to error log structure
+ *
+ * @return
+ */
+static void handleEventLog(PMIC_ErrorLog* pstcPmicErrorLog)
+{
+	uint8_t nRemainingLogEntryCount = remainingEventLogEntries();
 
 	//If there is space remaining then store the log and send ack to PMIC
 	if (nRemainingLogEntryCount > 0)
 	{
 		char temp[MAXLOGSTRINGLENGTH];
+		bool logged;
 
 		strncpy(temp, (pstcPmicErrorLog->nEventCode < eLOG_MAX) ?
 						PmicElog_getLogMessage(pstcPmicErrorLog->nEventCode) : "Unknown code", MAXLOGSTRINGLENGTH);
@@ -1078,19 +1085,31 @@ static void handleEventLog(PMIC_ErrorLog* pstcPmicErrorLog)
 		snprintf(temp, MAXLOGSTRINGLENGTH, "%s, %s", temp, pstcPmicErrorLog->nLogMessage);
 		temp[MAXLOGSTRINGLENGTH - 1] = 0;
 
-		LOG_EVENT(PMIC_EVENTLOG_BAND + pstcPmicErrorLog->nEventCode,
+		logged = LOG_EVENT(PMIC_EVENTLOG_BAND + pstcPmicErrorLog->nEventCode,
 				LOG_LEVEL_PMIC,
 				pstcPmicErrorLog->severity,
 				temp,
 				pstcPmicErrorLog->nTimestamp_secs);
 
-		uint8_t length = ERRORLOGFIXEDPART + strlen(temp) + 1;
-
-		length += (PGM_SIZE_BYTE - (length % PGM_SIZE_BYTE));
+		// the event log RAM is full, commit it, but not while measuring, and try again
+		if(!logged && !Measure_IsSamplingInProgress())
+		{
+			EventLog_Flush();
+			logged = LOG_EVENT(PMIC_EVENTLOG_BAND + pstcPmicErrorLog->nEventCode,
+					LOG_LEVEL_PMIC,
+					pstcPmicErrorLog->severity,
+					temp,
+					pstcPmicErrorLog->nTimestamp_secs);
+		}
 
-		nSpaceLeft -=  length;
+		// not acknowledged, the PMIC keeps the entry and sends it again
+		if(!logged)
+		{
+			LOG_DBG(LOG_LEVEL_PMIC, "PMIC event log entry not stored, not acknowledged\n");
+			return;
+		}
 
-		nRemainingLogEntryCount = nSpaceLeft / MAXERRLOGFRAMELENGTH;
+		nRemainingLogEntryCount = remainingEventLogEntries();
 	}
 
 	if(nRemainingLogEntryCount != 0)
@@ -45,6 +45,7 @@ extern "C" {
 #endif
 
 #include "xTaskApp.h"
+#include "Trace.h"
 
 #include "taskGnss.h"
 
@@ -208,6 +209,8 @@ static void InitAppNVIC( void )
     // DMA Priorities
     NVIC_SetPriority( DMA0_IRQn, 5U );          // ADC0/1 conversions to buffer
     NVIC_SetPriority( DMA1_IRQn, 6U );          // DAC self-test signal
+    NVIC_SetPriority( DMA2_IRQn, 8U );          // Modem rx ring half/full, same as the modem uart
+    NVIC_SetPriority( DMA3_IRQn, 8U );          // Modem tx segment done
     NVIC_SetPriority( DMA_Error_IRQn, 5U );
 
     // I2C
@@ -248,6 +251,7 @@ static void InitAppNVIC( void )
 
     // PIT
     NVIC_SetPriority( PIT0_IRQn, 3U );          // Counter for RPM calculations
+    NVIC_SetPriority( PIT1_IRQn, 8U );          // IS25 page program wait, notifies the task
 
     // PDB
     NVIC_SetPriority( PDB0_IRQn, 8U );          // PDB used for ADC sample clock/timing
@@ -304,6 +308,10 @@ void InitAppEdma(void)
     //EDMA_HAL_SetChannelPriority(pEdmaRegBase, EDMACHANNEL_AD7766_RX, kEDMAChnPriority15);
     EDMA_HAL_SetChannelPreemptMode(pEdmaRegBase, EDMACHANNEL_AD7766_TX, false, true);
     //EDMA_HAL_SetChannelPriority(pEdmaRegBase, EDMACHANNEL_AD7766_TX, kEDMAChnPriority14);
+
+    // Modem uart receive and transmit: may not suspend the others, may be suspended
+    EDMA_HAL_SetChannelPreemptMode(pEdmaRegBase, EDMACHANNEL_MODEM_RX, true, true);
+    EDMA_HAL_SetChannelPreemptMode(pEdmaRegBase, EDMACHANNEL_MODEM_TX, true, true);
 }
 
 
@@ -530,6 +538,10 @@ void Resources_InitTasks( void )
      Firmware_Version = getFirmwareVersion();
 
     // Task specific initialization before tasks are started
+	Log_Init();
+#ifdef CONFIG_PLATFORM_TRACE
+	Trace_Init();
+#endif
 	DataStore_Init();
 
 	InitRtc(RTC_IDX);
@@ -549,7 +561,7 @@ void Resources_InitTasks( void )
 #endif
 
 #ifdef CONFIG_PLATFORM_EVENT_LOG
-    EventLog_InitFlashData();
+    EventLog_Init();
 #endif
 
 
@@ -86,7 +86,7 @@ extern "C" {
       {false, false, false, false} } }
 
 #define DRVPIT_TIMERID_RPMPULSE     (0)           // Timer used by PulseMeasure module
-#define DRVPIT_TIMERID_RESV1        (1)           // Reserved (free...)
+#define DRVPIT_TIMERID_IS25         (1)           // Timer used by the IS25 driver for sub-tick waits, PIT1_IRQn
 #define DRVPIT_TIMERID_RESV2        (2)           // Reserved (free...)
 #define DRVPIT_TIMERID_RESV3        (3)           // Reserved (free...)
 
@@ -193,7 +193,7 @@ extern "C" {
                                         {false, false, false, false} } }
 
 #define DRVPIT_TIMERID_RPMPULSE     (0)           // Timer used by PulseMeasure module
-#define DRVPIT_TIMERID_RESV1        (1)           // Reserved (free...)
+#define DRVPIT_TIMERID_IS25         (1)           // Timer used by the IS25 driver for sub-tick waits, PIT1_IRQn
 #define DRVPIT_TIMERID_RESV2        (2)           // Reserved (free...)
 #define DRVPIT_TIMERID_RESV3        (3)           // Reserved (free...)
 
@@ -307,7 +307,7 @@ extern "C" {
                                         {false, false, false, false} } }
 
 #define DRVPIT_TIMERID_RPMPULSE     (0)           // Timer used by PulseMeasure module
-#define DRVPIT_TIMERID_RESV1        (1)           // Reserved (free...)
+#define DRVPIT_TIMERID_IS25         (1)           // Timer used by the IS25 driver for sub-tick waits, PIT1_IRQn
 #define DRVPIT_TIMERID_RESV2        (2)           // Reserved (free...)
 #define DRVPIT_TIMERID_RESV3        (3)           // Reserved (free...)
 
@@ -381,6 +381,8 @@ extern int32_t *g_pSampleBuffer;    // NOTE: Signed
 // in the InitAppEdma() function. Need to improve eventually.
 #define EDMACHANNEL_AD7766_TX   (14)
 #define EDMACHANNEL_AD7766_RX   (15)
+#define EDMACHANNEL_MODEM_RX    (2)     // modem uart receive ring, low priority
+#define EDMACHANNEL_MODEM_TX    (3)     // modem uart transmit queue
 
 //..............................................................................
 // FlexTimer allocations
@@ -37,10 +37,15 @@ extern "C" {
 #include "EnergyMonitor.h"
 #include "Device.h"
 #include "pmic.h"
+#include "Vbat.h"
 #include "../CUnit/util.h"
 #include "Measurement.h"
 
 #define GNSS_SPEED_TIMEOUT_MAX	300
+// How long a streamed waveform segment can wait for the previous one's flash
+// write - sampling carries on meanwhile, so this must stay within the ADC
+// block queueing of the measurement task
+#define WAVE_STREAM_SEGMENT_WAIT_MS	(5)
 
 enum {
 	eErase = 1100,
@@ -50,6 +55,10 @@ enum {
 extern tExtFlashHandle extFlashHandle;
 extern report_t gReport;
 
+// the streamed waveform segments are written from the measurement task, so need their own handle
+static tExtFlashHandle streamFlashHandle = { .EventQueue_extFlashRep = NULL };
+static bool streamWritePending = false;
+
 struct gnssWaveMeasureSpeed
 {
     bool validMeasurement;
@@ -69,9 +78,14 @@ struct gnssWaveMeasureSpeedRange
 // --------------------- static function prototypes ------------------------- //
 // -------------------------------------------------------------------------- //
 static void logDClevel(void);
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+static void storeWaveFeatures(const uint32_t *, uint8_t, const uint32_t *, float);
+#endif
+static bool streamWaveSegment(const int32_t *, uint32_t, bool);
 static bool dataType_to_sampleParams(uint32_t, tMeasId *, uint32_t *, uint32_t *, float *);
 static bool readGnssSpeed(tGnssCollectedData *, bool, bool);
-static bool waveMeasure(struct gnssWaveMeasureSpeed*, struct gnssWaveMeasureSpeedRange*, uint32_t, uint32_t, bool, bool);
+static bool waveMeasure(struct gnssWaveMeasureSpeed*, struct gnssWaveMeasureSpeedRange*, const uint32_t *, uint8_t, uint32_t, bool, bool);
+static bool waveMeasureAll(struct gnssWaveMeasureSpeed*, struct gnssWaveMeasureSpeedRange*, const uint32_t *, uint8_t, uint32_t, bool, bool);
 static void updateGnssMeasurementRecord_NoFix(const tGnssCollectedData* const pGnssCollectedData);
 static void updateGnssMeasurementRecordFromPMIC_NoFix(const PmicGnssStatus_t* const pGnssData);
 static bool updateGnssMeasurementRecord_1(tGnssCollectedData *, struct gnssWaveMeasureSpeedRange *, float);
@@ -213,28 +227,73 @@ static bool readGnssSpeed(tGnssCollectedData *gnssData_p, bool before, bool igno
 
 
 /**
- * @brief    Perform the required wave measurement
+ * @brief    Measurement segment callback of a streamed waveform - queues the
+ *           segment for writing to the open external flash stream, once the
+ *           previous segment (whose buffer is about to be re-used) is written.
+ *           Called from the measurement task.
+ *
+ * @param   pSamples - the segment's samples
+ * @param   NumSamples - number of samples in the segment
+ * @param   bFinal - last segment of the waveform
+ *
+ * @return - true if queued, false if the flash can't keep up or failed
+ */
+static bool streamWaveSegment(const int32_t *pSamples, uint32_t NumSamples, bool bFinal)
+{
+	int errCode;
+
+	if(streamWritePending)
+	{
+		streamWritePending = false;
+		errCode = extFlash_WaitReady(&streamFlashHandle, WAVE_STREAM_SEGMENT_WAIT_MS);
+		if(errCode < 0)
+		{
+			return false;
+		}
+	}
+
+	errCode = extFlash_streamWrite(&streamFlashHandle, (uint8_t *) pSamples, NumSamples * sizeof(int32_t), 0);
+	if(errCode < 0)
+	{
+		return false;
+	}
+
+	// the final write is waited for by closing the stream
+	streamWritePending = !bFinal;
+	return true;
+}
+
+/**
+ * @brief    Perform the required wave measurement(s) from a single capture.
+ *           Several waveform types can only be captured together if they
+ *           share the analog front end and ADC rate - see waveMeasureAll().
+ *           A single waveform is streamed to the external flash while it is
+ *           sampled, several are stored after sampling.
  *
  * @param   gnssSpeed_p - pointer gnssWaveMeasureSpeed structure
  * @param   speedrange_p - pointer to gnssWaveMeasureSpeedRange structure
- * @param   dataType - waveform type RAW/ENV/WFLAT
+ * @param   dataTypes_p - waveform types RAW/ENV/WFLAT to capture together
+ * @param   numDataTypes - number of waveform types, up to MEASURE_MAX_OUTPUTS
  * @param   measureSetNr - measurement data set to use
  * @param   ignoreGnssFailures - ignore GNSS failures
  * @param   bGNSSisValid - GNSS is valid
  *
  * @return - true if successful, otherwise false
  */
-static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWaveMeasureSpeedRange* speedrange_p, uint32_t dataType,
-						uint32_t measureSetNr, bool ignoreGnssFailures, bool bGNSSisValid)
+static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWaveMeasureSpeedRange* speedrange_p, const uint32_t *dataTypes_p,
+						uint8_t numDataTypes, uint32_t measureSetNr, bool ignoreGnssFailures, bool bGNSSisValid)
 {
     bool rc_ok = true;
     bool extflash_ok = false;
+    bool streamOpen = false;
     tGnssCollectedData gnssData;// just a warning, this is a large structure
-    uint32_t numSamples;
-    uint32_t sampleRate;
-    tMeasId  measId;
+    uint32_t numSamples[MEASURE_MAX_OUTPUTS];
+    uint32_t sampleRate[MEASURE_MAX_OUTPUTS];
+    tMeasId  measId[MEASURE_MAX_OUTPUTS];
     float conversionfactor;
     int errCode;
+    uint8_t i;
+    const uint32_t dataType = dataTypes_p[0];
     const char sWaveforms[][6] = {
     		"raw",
 			"env3",
@@ -283,14 +342,44 @@ static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWav
 		LOG_DBG(LOG_LEVEL_APP, "%s(): ERROR disabling GNSS messages\n", __func__);
 	}
 
-    LOG_DBG(LOG_LEVEL_APP, "%s(%s) capture waveform\n" , __func__, sWaveforms[dataType]);
-    if (true == dataType_to_sampleParams(dataType, &measId, &numSamples, &sampleRate, &conversionfactor))
+    if ((numDataTypes == 0) || (numDataTypes > MEASURE_MAX_OUTPUTS))
+    {
+    	rc_ok = false;
+    }
+    for (i = 0; rc_ok && (i < numDataTypes); i++)
+    {
+        LOG_DBG(LOG_LEVEL_APP, "%s(%s) capture waveform\n" , __func__, sWaveforms[dataTypes_p[i]]);
+        rc_ok = dataType_to_sampleParams(dataTypes_p[i], &measId[i], &numSamples[i], &sampleRate[i], &conversionfactor);
+    }
+    if (rc_ok)
     {
         float fStartEnergy;
         bool energyReadOk = EnergyMonitor_GetEnergyConsumed_J(&fStartEnergy, NULL);
     	uint32_t startMeasureTicks = xTaskGetTickCount();
 
-    	rc_ok = xTaskApp_doSampling(false, measId, numSamples, sampleRate);
+    	if (numDataTypes == 1)
+    	{
+    		streamWritePending = false;
+    		if(!extFlash_InitCommands(&streamFlashHandle))
+    		{
+    			rc_ok = false;
+    		}
+    		else
+    		{
+    			errCode = extFlash_streamOpen(&extFlashHandle, dataType, measureSetNr, EXTFLASH_MAXWAIT_MS);
+    			if(errCode < 0)
+    			{
+    				LOG_EVENT(eWrite, LOG_NUM_APP, ERRLOGFATAL, "extFlash stream open failed; error %s", extFlash_ErrorString(errCode));
+    				rc_ok = false;
+    			}
+    		}
+    		streamOpen = rc_ok;
+    		rc_ok = rc_ok && xTaskApp_doSamplingStreamed(measId[0], numSamples[0], sampleRate[0], streamWaveSegment);
+    	}
+    	else
+    	{
+    		rc_ok = xTaskApp_doSamplingMulti(measId, numSamples, sampleRate, numDataTypes);
+    	}
 
     	uint32_t nDuration_msecs = DURATION_MSECS(startMeasureTicks);
 
@@ -315,16 +404,40 @@ static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWav
 		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR enabling GNSS messages\n", __func__);
 	}
 
-    // lets kick off the storing of the waveform while the gnss is busy, so it runs in parallel with the gnss speed retrieval.
-    if (rc_ok)
+    // a streamed waveform is already in the flash, apart from its final segment - let the close (and its size + CRC) follow that in parallel with
+    // the gnss speed retrieval, or if sampling failed abandon the stream, waiting so that no segment write is left pending and the
+    // programmed pages are erased again.
+    if(streamOpen)
+    {
+    	errCode = extFlash_streamClose(&extFlashHandle, rc_ok, rc_ok ? 0 : EXTFLASH_MAXWAIT_MS);
+    	if(errCode < 0)
+    	{
+    		LOG_EVENT(eWrite, LOG_NUM_APP, ERRLOGFATAL, "extFlash stream close failed; error %s", extFlash_ErrorString(errCode));
+    		rc_ok = false;
+    	}
+    	extflash_ok = rc_ok;
+    }
+
+    // lets kick off the storing of the waveform(s) while the gnss is busy, so the last one runs in parallel with the gnss speed retrieval.
+    // the flash can only do one write at a time, so any earlier outputs of a multi-output capture are waited for first.
+    for (i = 0; rc_ok && !streamOpen && (i < numDataTypes); i++)
     {
     	extflash_ok = true;
-    	errCode = extFlash_write(&extFlashHandle, (uint8_t *) g_pSampleBuffer , numSamples * sizeof(int32_t) , dataType, measureSetNr, 0);
+    	errCode = extFlash_write(&extFlashHandle, (uint8_t *) Measure_GetOutputBuffer(i), numSamples[i] * sizeof(int32_t), dataTypes_p[i], measureSetNr, 0);
     	if(errCode < 0)
     	{
     		LOG_EVENT(eWrite, LOG_NUM_APP, ERRLOGFATAL, "extFlash write failed; error %s", extFlash_ErrorString(errCode));
     		extflash_ok = rc_ok = false;
     	}
+    	else if (i < (numDataTypes - 1))
+    	{
+    		errCode = extFlash_WaitReady(&extFlashHandle, EXTFLASH_MAXWAIT_MS);
+    		if(errCode < 0)
+    		{
+    			LOG_EVENT(eWait, LOG_NUM_APP, ERRLOGFATAL, "extFlash write timeout; error %s", extFlash_ErrorString(errCode));
+    			extflash_ok = rc_ok = false;
+    		}
+    	}
     }
 
     // read speed after measure if GNSS is good
@@ -428,6 +541,10 @@ static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWav
 		{
 			updateGnssMeasurementRecord_2(gnssSpeed_p);
 		}
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+		storeWaveFeatures(dataTypes_p, numDataTypes, sampleRate,
+						bGNSSisValid ? ((gnssSpeed_p->speedAfter_Hz + gnssSpeed_p->speedBefore_Hz) / 2) : 0.0f);
+#endif
 	}
 	else
 	{
@@ -437,6 +554,63 @@ static bool waveMeasure(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWav
     return rc_ok;
 }
 
+/**
+ * @brief    Perform the wave measurements for a list of waveform types, in
+ *           order. Consecutive types whose measurement IDs share the same
+ *           ADC capture (analog front end and ADC rate) are sampled together
+ *           in one burst, the others each get their own capture.
+ *
+ * @param   gnssSpeed_p - pointer gnssWaveMeasureSpeed structure
+ * @param   speedrange_p - pointer to gnssWaveMeasureSpeedRange structure
+ * @param   dataTypes_p - waveform types RAW/ENV/WFLAT to measure
+ * @param   numDataTypes - number of waveform types
+ * @param   measureSetNr - measurement data set to use
+ * @param   ignoreGnssFailures - ignore GNSS failures
+ * @param   bGNSSisValid - GNSS is valid
+ *
+ * @return - true if all successful, otherwise false (remaining measurements
+ *           are abandoned after the first failure)
+ */
+static bool waveMeasureAll(struct gnssWaveMeasureSpeed* gnssSpeed_p, struct gnssWaveMeasureSpeedRange* speedrange_p, const uint32_t *dataTypes_p,
+						   uint8_t numDataTypes, uint32_t measureSetNr, bool ignoreGnssFailures, bool bGNSSisValid)
+{
+    bool rc_ok = true;
+    uint8_t first = 0;
+    uint8_t count;
+    tMeasId firstMeasId, measId;
+    uint32_t numSamples, sampleRate;
+    uint32_t totalSamples;
+    float conversionfactor;
+
+    while (rc_ok && (first < numDataTypes))
+    {
+    	// grow the group while the next type can come from the same capture, and all fit the sample buffer
+    	// together - a waveform longer than the sample buffer can only be streamed, so is captured on its own
+    	count = 1;
+    	if (dataType_to_sampleParams(dataTypes_p[first], &firstMeasId, &numSamples, &sampleRate, &conversionfactor))
+    	{
+    		totalSamples = numSamples;
+    		while (((first + count) < numDataTypes) && (count < MEASURE_MAX_OUTPUTS) &&
+    			   dataType_to_sampleParams(dataTypes_p[first + count], &measId, &numSamples, &sampleRate, &conversionfactor) &&
+    			   PassRailMeasure_MeasIdsShareCapture(firstMeasId, measId) &&
+    			   ((totalSamples + numSamples) <= SAMPLE_BUFFER_SIZE_WORDS))
+    		{
+    			totalSamples += numSamples;
+    			count++;
+    		}
+    	}
+
+    	rc_ok = waveMeasure(gnssSpeed_p, speedrange_p, &dataTypes_p[first], count, measureSetNr, ignoreGnssFailures, bGNSSisValid);
+    	if (!rc_ok && ((first + count) < numDataTypes))
+    	{
+    		LOG_DBG(LOG_LEVEL_APP, "%s(): remaining wave measures abandoned\n", __func__);
+    	}
+    	first += count;
+    }
+
+    return rc_ok;
+}
+
 /**
  * @brief Update measurement record with gnss data from PMIC status, when no fix is obtained
  *
@@ -641,6 +815,50 @@ static void logDClevel(void)
 	}
 }
 
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+#if ((4 + FEATURES_NUM_BANDS + FEATURES_NUM_ORDERS) != MR_WAVE_FEATURES_LENGTH)
+#error "MR_WAVE_FEATURES_LENGTH does not match the waveform features"
+#endif
+
+/**
+ * @brief    Store the features of each waveform of a capture, which the
+ *           measurement task calculated while sampling, in the measurement
+ *           record (laid out as described at MR_WAVE_FEATURES_LENGTH)
+ *
+ * @param   dataTypes_p - waveform types RAW/ENV/WFLAT of the capture
+ * @param   numDataTypes - number of waveform types
+ * @param   sampleRate_p - sample rate of each waveform
+ * @param   wheelHz - wheel rotation rate for the order features, 0 if unknown
+ */
+static void storeWaveFeatures(const uint32_t *dataTypes_p, uint8_t numDataTypes, const uint32_t *sampleRate_p, float wheelHz)
+{
+	FeaturesType features;
+	float *values_p;
+	uint8_t i;
+
+	for (i = 0; i < numDataTypes; i++)
+	{
+		if ((dataTypes_p[i] < MR_WAVE_FEATURES_TYPES) &&
+			Measure_GetOutputFeatures(i, sampleRate_p[i], wheelHz, &features))
+		{
+			values_p = measureRecord.params.Wave_Features[dataTypes_p[i]];
+			*values_p++ = features.Rms;
+			*values_p++ = features.CrestFactor;
+			*values_p++ = features.Kurtosis;
+			memcpy(values_p, features.BandEnergy, sizeof(features.BandEnergy));
+			values_p += FEATURES_NUM_BANDS;
+			memcpy(values_p, features.OrderEnergy, sizeof(features.OrderEnergy));
+			values_p += FEATURES_NUM_ORDERS;
+			*values_p = features.PeakHz[0];
+
+			LOG_DBG(LOG_LEVEL_APP, "Features(%d): rms=%.0f peak=%.0f crest=%.2f kurt=%.2f, peak %.1fHz, order1..4=%.3g %.3g %.3g %.3g\n",
+					dataTypes_p[i], features.Rms, features.Peak, features.CrestFactor, features.Kurtosis, features.PeakHz[0],
+					features.OrderEnergy[0], features.OrderEnergy[1], features.OrderEnergy[2], features.OrderEnergy[3]);
+		}
+	}
+}
+#endif
+
 /**
  * Handles the gnss fixes and records waveforms
  *
@@ -860,33 +1078,24 @@ static bool handleGnssMeasurement(bool keepGnssOn, bool* speedValid)
 
               // waveMeasure passed extra parameter (gnss_ok) to NOT do speed stuff
               // TODO speed measure really should be factored out of waveMeasure
-			  rc_ok = waveMeasure(&gnssSpeed, &speedRange, IS25_VIBRATION_DATA, gNvmData.dat.is25.is25CurrentDatasetNo, ignoreGnssFailures, gnss_ok);
-			  if(rc_ok)
-			  {
-				  rc_ok = waveMeasure(&gnssSpeed, &speedRange, IS25_WHEEL_FLAT_DATA, gNvmData.dat.is25.is25CurrentDatasetNo, ignoreGnssFailures, gnss_ok);
-			  }
-			  else
-			  {
-				  LOG_DBG(LOG_LEVEL_APP, "%s(): 2nd wave measure abandoned\n", __func__);
-			  }
-
               // maybe we could do the raw as last to have the measurements as close together as possible (the flash write takes much longer, because of the amount of data)
               // also advised by Julian, because of analog settling time
-			  if(rc_ok)
-			  {
-				  if(gNvmCfg.dev.measureConf.Is_Raw_Acceleration_Enabled)
-				  {
-					  rc_ok = waveMeasure(&gnssSpeed, &speedRange, IS25_RAW_SAMPLED_DATA, gNvmData.dat.is25.is25CurrentDatasetNo, ignoreGnssFailures, gnss_ok);
-				  }
-				  else
-				  {
-					  LOG_DBG(LOG_LEVEL_APP, "%s(): raw acceleration measurement disabled, skipped\n", __func__);
-				  }
-			  }
-			  else
-			  {
-				  LOG_DBG(LOG_LEVEL_APP, "%s(): raw acceleration measurement abandoned\n", __func__);
-			  }
+              uint32_t waveDataTypes[3];
+              uint8_t numWaveDataTypes = 0;
+
+              waveDataTypes[numWaveDataTypes++] = IS25_VIBRATION_DATA;
+              waveDataTypes[numWaveDataTypes++] = IS25_WHEEL_FLAT_DATA;
+              if(gNvmCfg.dev.measureConf.Is_Raw_Acceleration_Enabled)
+              {
+            	  waveDataTypes[numWaveDataTypes++] = IS25_RAW_SAMPLED_DATA;
+              }
+              else
+              {
+            	  LOG_DBG(LOG_LEVEL_APP, "%s(): raw acceleration measurement disabled, skipped\n", __func__);
+              }
+
+              // waveforms sharing an ADC capture are sampled in a single burst
+			  rc_ok = waveMeasureAll(&gnssSpeed, &speedRange, waveDataTypes, numWaveDataTypes, gNvmData.dat.is25.is25CurrentDatasetNo, ignoreGnssFailures, gnss_ok);
            }
        }	// if(rc_ok || ignoreGnssFailures)
 
@@ -957,6 +1166,14 @@ static bool saveMeasureRecordToFlash(void)
 
 	gNvmData.dat.schedule.noOfGoodMeasurements++;
 
+	// an upload broken off in the dataset just overwritten cannot be resumed
+	uint8_t journalDataset;
+	uint16_t journalProgress;
+	if(Vbat_GetUploadJournal(&journalDataset, &journalProgress) && (journalDataset == gNvmData.dat.is25.is25CurrentDatasetNo))
+	{
+		Vbat_ClearUploadJournal();
+	}
+
 		// as far as I understand this part, is25CurrentDatasetNo points to the first empty dataset to use for storage,
 		// set 0 is special, so it wraps around to '1'
 	if(++gNvmData.dat.is25.is25CurrentDatasetNo >= MAX_NUMBER_OF_DATASETS)
@@ -50,8 +50,8 @@ extern "C" {
 //  23        |	1			|	LimitAttempts
 //  24		  | 1			|	Alarms24HourCounter
 //	25		  |	1			|	Limits24HourCounter
-//	26		  |				|	(Dummy)
-//
+//	26		  |	2			|	UploadProgress
+//	28		  |	1			|	UploadDataset
 //	29		  |	2			|	Watchdog
 //	31		  |	1			|	Chksum
 //  ----------------------------------
@@ -323,6 +323,79 @@ bool Vbat_SetUploadDayOffset(uint8_t UploadDayOffset)
 	return ProtectedWrite(__func__, VBAT_DATA_UPLOAD_DAY_OFFSET, (uint8_t*)&UploadDayOffset, VBAT_RW_ONE_BYTE);
 }
 
+/*
+ * Vbat_GetUploadJournal
+ *
+ * @brief	Retrieves the upload journal, the dataset being uploaded and how far
+ * 			its upload got, from the VBAT register file.
+ *
+ * @param	pDataset - dataset being uploaded
+ * 			pProgress - the upload progress within the dataset
+ *
+ * @return  true - if a journal is kept, false otherwise.
+ */
+bool Vbat_GetUploadJournal(uint8_t *pDataset, uint16_t *pProgress)
+{
+	uint8_t dataset = 0;
+
+	// the dataset is kept plus one, so the cleared register file holds no journal
+	if(!ProtectedRead(__func__, VBAT_DATA_INDX_UPLOAD_DATASET, &dataset, VBAT_RW_ONE_BYTE) ||
+	   (dataset == 0) ||
+	   !ProtectedRead(__func__, VBAT_DATA_INDX_UPLOAD_PROGRESS, pProgress, VBAT_RW_TWO_BYTES))
+	{
+		return false;
+	}
+	*pDataset = dataset - 1;
+	return true;
+}
+
+/*
+ * Vbat_SetUploadJournal
+ *
+ * @brief	Sets the upload journal in the VBAT register file, written as the
+ * 			upload progresses, so a broken off upload can be resumed.
+ *
+ * @param	dataset - dataset being uploaded
+ * 			progress - the upload progress within the dataset
+ *
+ * @return  true - if successful , false otherwise.
+ */
+bool Vbat_SetUploadJournal(uint8_t dataset, uint16_t progress)
+{
+	uint8_t current;
+	uint8_t next = dataset + 1;
+	uint16_t none = 0;
+
+	if(!ProtectedRead(__func__, VBAT_DATA_INDX_UPLOAD_DATASET, &current, VBAT_RW_ONE_BYTE))
+	{
+		return false;
+	}
+	// clear the progress before changing the dataset, a reset in between must not
+	// leave the progress of one dataset recorded against another
+	if((current != next) &&
+	   !(ProtectedWrite(__func__, VBAT_DATA_INDX_UPLOAD_PROGRESS, &none, VBAT_RW_TWO_BYTES) &&
+		 ProtectedWrite(__func__, VBAT_DATA_INDX_UPLOAD_DATASET, &next, VBAT_RW_ONE_BYTE)))
+	{
+		return false;
+	}
+	return ProtectedWrite(__func__, VBAT_DATA_INDX_UPLOAD_PROGRESS, &progress, VBAT_RW_TWO_BYTES);
+}
+
+/*
+ * Vbat_ClearUploadJournal
+ *
+ * @brief	Clears the upload journal in the VBAT register file, when the dataset
+ * 			is uploaded, dropped or overwritten.
+ *
+ * @return  true - if successful , false otherwise.
+ */
+bool Vbat_ClearUploadJournal()
+{
+	uint8_t none = 0;
+
+	return ProtectedWrite(__func__, VBAT_DATA_INDX_UPLOAD_DATASET, &none, VBAT_RW_ONE_BYTE);
+}
+
 /*
  * Vbat_GetFlags
  *
@@ -37,8 +37,9 @@ typedef enum
 	VBAT_DATA_INDX_24_HOUR_COUNTER_ALARMS	= 24,	// 1 byte Down counter, decremented every 10 min wake. Used for daily (Amber/Red) Alarm send retry and masking
 	VBAT_DATA_INDX_24_HOUR_COUNTER_LIMITS	= 25,	// 1 byte Down counter, decremented every 10 min wake. Used for daily Limit alarm retry and masking
 
-	//VBAT_DATA_DUMMY           			= 26,	// Just a place holder.
-	/* Add new index here */
+	VBAT_DATA_INDX_UPLOAD_PROGRESS			= 26,	// 2 bytes used for the upload journal, progress of the dataset being uploaded
+	VBAT_DATA_INDX_UPLOAD_DATASET			= 28,	// 1 byte used for the upload journal, dataset being uploaded + 1 (0 none)
+	/* No room left for a new index */
 	VBAT_DATA_INDX_WATCHDOG_L				= 29,	// watchdog low flag
 	VBAT_DATA_INDX_WATCHDOG_H				= 30,	// watchdog high flag
 	VBAT_DATA_INDX_CHKSUM					= 31,	// 1 byte used for the checksum
@@ -131,6 +132,11 @@ bool Vbat_GetByte(VBAT_DATA_INDEX_t index, uint8_t* pVal);
 uint8_t Vbat_GetUploadDayOffset();
 bool Vbat_SetUploadDayOffset(uint8_t UploadDayOffset);
 
+// Upload journal, to resume a broken off dataset upload
+bool Vbat_GetUploadJournal(uint8_t *pDataset, uint16_t *pProgress);
+bool Vbat_SetUploadJournal(uint8_t dataset, uint16_t progress);
+bool Vbat_ClearUploadJournal();
+
 SimulatedTemperature_t* Vbat_CheckForSimulatedTemperatures();
 void Vbat_ClearSimulatedTemperatures();
 
@@ -697,6 +697,8 @@ static void prepareForSleep(bool bDoDataUpload, bool bMeasurement, bool bSleepLE
 
     	// We've done a data upload or a measurement so save the comms record for next time
     	storeCommsData();
+    	// and the CPU time and stack use of the tasks this wakeup
+    	storeTaskStats();
     }
 
 	// #659370 E_Previous_Wakeup
@@ -1476,10 +1478,139 @@ bool xTaskApp_doSampling(bool bRawAdcSampling,
 	return retval;
 }
 
+/*
+ * xTaskApp_doSamplingMulti
+ *
+ * @desc - Control waveform sampling of several measurement IDs from a single
+ * 		   ADC capture. The measurement IDs must share the same analog front
+ * 		   end and ADC rate (see PassRailMeasure_MeasIdsShareCapture()); the
+ * 		   outputs are then found using Measure_GetOutputBuffer().
+ *
+ * @param   pMeasIds (const tMeasId *): Measurement IDs, one per output
+ * @param   pNumOutputSamples (const uint32_t *): Output samples required,
+ * 			one per output
+ * @param   pOutputSamplesPerSec (const uint32_t *): Output samples per second,
+ * 			one per output - only used to determine the sampling duration
+ * @param   nNumOutputs (uint8_t): Number of outputs, up to MEASURE_MAX_OUTPUTS
+ * @return 	true  - if the sampling is complete,
+ * 		 	false - otherwise.
+ */
+bool xTaskApp_doSamplingMulti(const tMeasId *pMeasIds,
+                              const uint32_t *pNumOutputSamples,
+                              const uint32_t *pOutputSamplesPerSec,
+                              uint8_t nNumOutputs)
+{
+	bool retval = false;
+	uint32_t nMaxSamplingTime_msec = 0;
+	uint32_t nOutputTime_msec;
+	uint8_t i;
+
+    if((gSemDoSample != NULL) && (xSemaphoreTake(gSemDoSample, 0) != pdFALSE))
+    {
+    	g_bAppSamplingIsComplete = false;
+    	retval = Measure_StartMulti(pMeasIds, pNumOutputSamples, nNumOutputs,
+    								AppMeasureIsCompleteCallback);
+
+    	// All outputs run concurrently, so the longest one sets the duration.
+    	for (i = 0; i < nNumOutputs; i++)
+    	{
+    		nOutputTime_msec = (uint32_t)(((float)pNumOutputSamples[i] / (float)pOutputSamplesPerSec[i]) * 1000);
+    		if (nOutputTime_msec > nMaxSamplingTime_msec)
+    		{
+    			nMaxSamplingTime_msec = nOutputTime_msec;
+    		}
+    	}
+    	nMaxSamplingTime_msec += SAMPLING_TIME_MARGIN_MILLISECS;
+
+    	// Block until timeout.
+    	if(xSemaphoreTake(gSemDoSample, pdMS_TO_TICKS(nMaxSamplingTime_msec)) != pdFALSE)
+    	{
+        	if((retval != true) || (g_bAppSamplingIsComplete != true))
+        	{
+        		LOG_EVENT(eLOG_SAMPLING, LOG_NUM_APP, ERRLOGMAJOR, "****ERROR-Sampling, RetVal= %d, SampleComplete=%d", retval, g_bAppSamplingIsComplete);
+        	}
+    	}
+    	else
+    	{
+    		LOG_EVENT(eLOG_SAMP_WAIT, LOG_NUM_APP, ERRLOGMAJOR, "***Semaphore Wait FAILED***");
+    	}
+
+    	// Release the Semaphore for the next sampling cycle.
+    	xSemaphoreGive(gSemDoSample);
+    }
+    else
+    {
+    	LOG_EVENT(eLOG_SAMP_LOCK, LOG_NUM_APP, ERRLOGMAJOR,"***FAILED to Get Sampling Semaphore***");
+    }
+
+	return retval;
+}
+
+/*
+ * xTaskApp_doSamplingStreamed
+ *
+ * @desc - Control waveform sampling where the samples are handed on segment
+ * 		   by segment while sampling (see Measure_StartStreamed()), so the
+ * 		   waveform length is not limited by the sample buffer.
+ *
+ * @param   eMeasId (tMeasId): Measurement ID of type tMeasId
+ * @param   nSampleLength (uint32_t): Number of output samples required
+ * @param   nOutputSamplesPerSec (uint32_t): Output samples per second, only
+ * 			used to determine the sampling duration
+ * @param   pSegmentCallback (tMeasureSegmentCallback): Called with each
+ * 			segment of samples
+ * @return 	true  - if the sampling is complete without errors, so every
+ * 			segment has been handed on,
+ * 		 	false - otherwise.
+ */
+bool xTaskApp_doSamplingStreamed(tMeasId eMeasId,
+								 uint32_t nSampleLength,
+								 uint32_t nOutputSamplesPerSec,
+								 tMeasureSegmentCallback pSegmentCallback)
+{
+	bool retval = false;
+	uint32_t nMaxSamplingTime_msec = 0;
+
+    if((gSemDoSample != NULL) && (xSemaphoreTake(gSemDoSample, 0) != pdFALSE))
+    {
+    	g_bAppSamplingIsComplete = false;
+    	retval = Measure_StartStreamed(eMeasId, nSampleLength, pSegmentCallback,
+    								   AppMeasureIsCompleteCallback);
+
+    	// Determine max sampling time with the margin included.
+    	nMaxSamplingTime_msec = (uint32_t)((((float)nSampleLength / (float)nOutputSamplesPerSec) * 1000) + SAMPLING_TIME_MARGIN_MILLISECS);
+
+    	// Block until timeout.
+    	if(xSemaphoreTake(gSemDoSample, pdMS_TO_TICKS(nMaxSamplingTime_msec)) != pdFALSE)
+    	{
+        	if((retval != true) || (g_bAppSamplingIsComplete != true))
+        	{
+        		LOG_EVENT(eLOG_SAMPLING, LOG_NUM_APP, ERRLOGMAJOR, "****ERROR-Sampling, RetVal= %d, SampleComplete=%d", retval, g_bAppSamplingIsComplete);
+        	}
+    	}
+    	else
+    	{
+    		LOG_EVENT(eLOG_SAMP_WAIT, LOG_NUM_APP, ERRLOGMAJOR, "***Semaphore Wait FAILED***");
+    	}
+    	// A partial stream must not be kept
+    	retval = retval && g_bAppSamplingIsComplete;
+
+    	// Release the Semaphore for the next sampling cycle.
+    	xSemaphoreGive(gSemDoSample);
+    }
+    else
+    {
+    	LOG_EVENT(eLOG_SAMP_LOCK, LOG_NUM_APP, ERRLOGMAJOR,"***FAILED to Get Sampling Semaphore***");
+    }
+
+	return retval;
+}
+
 /*
  * AppMeasureIsCompleteCallback
  *
- * @desc - Callback function used exclusively by xTaskApp_doSampling.
+ * @desc - Callback function used exclusively by xTaskApp_doSampling,
+ *         xTaskApp_doSamplingMulti and xTaskApp_doSamplingStreamed.
  *
  * @return void.
  *
@@ -100,6 +100,14 @@ bool xTaskApp_doSampling(bool bRawAdcSampling,
                    	     tMeasId eMeasId,
 						 uint32_t nNumOutputSamples,
 						 uint32_t nAdcSamplesPerSecIfRawAdc);
+bool xTaskApp_doSamplingMulti(const tMeasId *pMeasIds,
+                              const uint32_t *pNumOutputSamples,
+                              const uint32_t *pOutputSamplesPerSec,
+                              uint8_t nNumOutputs);
+bool xTaskApp_doSamplingStreamed(tMeasId eMeasId,
+								 uint32_t nSampleLength,
+								 uint32_t nOutputSamplesPerSec,
+								 tMeasureSegmentCallback pSegmentCallback);
 
 bool xTaskApp_startApplicationTask(uint8_t wakeupReason);
 bool xTaskApp_commsTest(uint32_t testFuncNum, uint32_t repeatCount);
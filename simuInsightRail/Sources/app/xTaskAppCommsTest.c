@@ -23,6 +23,7 @@ extern "C" {
 #include "Timer.h"
 #include "xTaskAppEvent.h"
 #include "xTaskDefs.h"
+#include "configFeatures.h"
 #include "configLog.h"
 #include "log.h"
 #include "device.h"
@@ -56,6 +57,7 @@ extern "C" {
 #include "fsl_rtc_hal.h"
 #include "gnssMT3333.h"
 #include "image.h"
+#include "waveCodec.h"
 #include "temperature.h"
 #include "PMIC.h"
 #include "imageTypes.h"
@@ -89,6 +91,7 @@ static QueueHandle_t EventQueue_App;
 static tCommHandle CommHandle = { .EventQueue_CommResp = NULL};
 
 static bool checkIncommingMessages(uint32_t maxWaitMs, bool *requestReceived_p);
+static bool pollIncommingMessages(bool *requestReceived_p);
 
 #if 0
 // ideas for better administration of what dataset is uploaded, and flash storage can be made free.
@@ -218,11 +221,6 @@ static bool removeMessageIdAckInfo(int32_t messageId, uint32_t maxWaitMs)
 
 #endif
 
-typedef union {
-    int32_t i;
-    float f;
-} tInt32Float;
-
 static struct  {
     uint16_t total_records;
     uint16_t current_index;
@@ -310,15 +308,6 @@ static bool init_temperature_sending(bool simulationMode)
     return rc_ok;
 }
 
-// in place conversion from int32 to float format (both are 32bits)
-void cvt_int32ToFloat(tInt32Float * value_p, uint32_t count, float scaling)
-{
-    while (count--) {
-        value_p->f = value_p->i * scaling;
-        value_p++;
-    }
-}
-
 bool xTaskAppCommsTestInit()
 {
     EventQueue_App         = xQueueCreate( EVENTQUEUE_NR_ELEMENTS_APP, sizeof(tAppEvent));
@@ -603,7 +592,7 @@ static bool sendEventLog()
         }
 #endif
        // dammit, we need to set it in network byte order, so have to copy it to RAM
-        strcpy(&localLogCopy.logMsg[0], &addrEventLog->logMsg[0]);
+        EventLog_formatMessage(addrEventLog, localLogCopy.logMsg, sizeof(localLogCopy.logMsg));
 #ifdef _MSC_VER
 
         localLogCopy.woLogMsg.compNumber = _byteswap_ushort(addrEventLog->logHeader.compNumber);
@@ -694,7 +683,7 @@ void initSimulAmSignal(float sample_freq)
 }
 
 void calcSimulAmSignal(uint32_t samples, int32_t * out);
-static bool generate_dummy_waveform(uint32_t sampleRate, uint32_t samples);
+static uint32_t generate_dummy_waveform(uint32_t sampleRate, uint32_t samples);
 
 static const char simulAmSignalHelp[] = {
         "simulAmSignal sets the parameters for the AM signal generator for generating test and simulation signals\r\n"
@@ -785,13 +774,23 @@ bool cliSimulAmSignal( uint32_t args, uint8_t * argv[], uint32_t * argi)
 }
 #endif
 
-static bool generate_dummy_waveform(uint32_t sampleRate, uint32_t samples)
+/*
+ * generate a dummy waveform in the sample buffer, no longer than it holds
+ *
+ * return the number of samples generated
+ */
+static uint32_t generate_dummy_waveform(uint32_t sampleRate, uint32_t samples)
 {
+    if(samples > (__sample_buffer_size / sizeof(int32_t)))
+    {
+        samples = __sample_buffer_size / sizeof(int32_t);
+    }
+
     initSimulAmSignal( sampleRate);
 
     calcSimulAmSignal(samples, __sample_buffer);
 
-    return true;
+    return samples;
 }
 
 bool generate_dummy_communication_record(uint32_t seed)
@@ -1092,6 +1091,24 @@ static bool checkIncommingMessages(uint32_t maxWaitMs, bool *requestReceived_p)
     return rc_ok;
 }
 
+/*
+ * pollIncommingMessages
+ *
+ * @desc	processes the messages already received, without waiting for more
+ *
+ * @param	requestReceived_p as for checkIncommingMessages
+ *
+ * @returns true if ok else false
+ */
+static bool pollIncommingMessages(bool *requestReceived_p)
+{
+    bool rc_ok = true;
+
+    while (rc_ok && (uxQueueMessagesWaiting(EventQueue_App) > 0)) {
+        rc_ok = checkIncommingMessages(0, requestReceived_p);
+    }
+    return rc_ok;
+}
 
 static bool comms_test_wait_reply()
 {
@@ -1191,11 +1208,11 @@ static bool comms_test_4(bool simulationMode)
     LOG_DBG( LOG_LEVEL_CLI,  "\ncomms_test_4: Device sends one waveform, server should eat it.\n"
                              "\nSend dummy raw waveform\n");
 
-    generate_dummy_waveform(gNvmCfg.dev.measureConf.Sample_Rate_Raw, gNvmCfg.dev.measureConf.Samples_Raw);
-    cvt_int32ToFloat( (tInt32Float *) __sample_buffer, gNvmCfg.dev.measureConf.Samples_Raw, gNvmCfg.dev.measureConf.Scaling_Raw);
+    uint32_t samples = generate_dummy_waveform(gNvmCfg.dev.measureConf.Sample_Rate_Raw, gNvmCfg.dev.measureConf.Samples_Raw);
+    configData_WaveformFromRam(__sample_buffer, gNvmCfg.dev.measureConf.Scaling_Raw);
 
     timestamp_raw = ConfigSvcData_GetIDEFTime();//12350000+dummycount; // rubbish example value
-    bool rc_ok = (ISVCDATARC_OK == ISvcData_Publish_Data( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataWaveformRaw], gNvmCfg.dev.measureConf.Samples_Raw, SKF_MsgType_PUBLISH, 0));// raw
+    bool rc_ok = (ISVCDATARC_OK == ISvcData_Publish_Data( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataWaveformRaw], samples, SKF_MsgType_PUBLISH, 0));// raw
     if (rc_ok==false)
     {
     	LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_Publish_Data not OK\n");
@@ -1274,6 +1291,26 @@ static struct {
     uint16_t blocksLeft;
 } dataUploadVars;
 
+/*
+ * upload journal progress, kept in VBAT so a dataset upload broken off is resumed next time:
+ * the waveforms of the dataset acknowledged (QoS1 only), and for the waveform being sent, whether packed and
+ * the number of leading blocks the server acknowledged (only resumed from with
+ * CONFIG_PLATFORM_UPLOAD_BLOCK_RESUME, and only counted for QoS1 publishes)
+ */
+#define UPLOAD_JOURNAL_WAVES_DONE_MASK	(0x0007)
+#define UPLOAD_JOURNAL_WAVE_SHIFT		(3)
+#define UPLOAD_JOURNAL_WAVE_MASK		(0x0003 << UPLOAD_JOURNAL_WAVE_SHIFT)
+#define UPLOAD_JOURNAL_WAVE_NONE		(0x0003 << UPLOAD_JOURNAL_WAVE_SHIFT)
+#define UPLOAD_JOURNAL_PACKED			(0x0020)
+#define UPLOAD_JOURNAL_BLOCKS_SHIFT		(6)
+#define UPLOAD_JOURNAL_BLOCKS_MAX		(0x03FF)
+
+static struct {
+    bool active;			// false when the journal is not kept, e.g. simulation mode
+    uint8_t measurementSetNr;
+    uint16_t progress;
+} uploadJournal;
+
 
 /*
  *
@@ -1354,6 +1391,10 @@ static void ackUploadedData(uint16_t  measurementSetNr)
     			gNvmData.dat.is25.noOfMeasurementDatasetsToUpload--;
     		}
 
+    		// done with this dataset, nothing to resume
+    		Vbat_ClearUploadJournal();
+    		uploadJournal.active = false;
+
     		LOG_DBG( LOG_LEVEL_APP,
     				"%s() - noOfMeasurementDatasetsToUpload %d\n",
 					__func__,
@@ -1489,14 +1530,13 @@ static int getMeasurementRecord(uint16_t measurementSetNr)
 
 
 /*
- * retrieve the waveform selected by measurementSetNr and waveform type, which belongs to
- * the measurement record retrieved under the same measurementSetNr and send waveform if ok
- * returns also the number of samples in the waveform.
- *
- * return false when something goes wrong.
+ * retrieve the waveform selected by measurementSetNr and waveform type for upload,
+ * which reads it (as floats) through the waveform datastore items. When bStream is
+ * set a waveform in external flash is read in pieces while it is uploaded, otherwise
+ * it is read into the sample buffer first.
+ * Returns the number of samples (0 when it could not be read)
  */
-
-static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling, int IDEF_data)
+static uint32_t fetchWaveform(whatToSend *what, uint16_t waveformType, float scaling, bool bStream)
 {
 	const char *strType[] =
 	{
@@ -1511,15 +1551,6 @@ static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling
 			"IS25_WHEEL_FLAT_DATA"
 	};
 	uint32_t sampleRate, samples = 0;
-    bool serverRequests = false;
-	bool connection_ok = true;		// status of the MQTT connection
-
-	// make sure of a valid waveformType and
-	// have we a sample for the requested wave type
-	if((waveformType >= IS25_MEASURED_DATA) || (0 == (what->waves & (1 << waveformType))))
-	{
-		return true;
-	}
 
 	// simulation mode ?
 	if (dataUploadVars.simulation_mode)
@@ -1542,7 +1573,22 @@ static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling
 
 		// now do the work
 		LOG_DBG( LOG_LEVEL_CLI,  "\nSend dummy %s waveform\n", strType[waveformType]);
-		generate_dummy_waveform(sampleRate, samples);
+		samples = generate_dummy_waveform(sampleRate, samples);
+		configData_WaveformFromRam(__sample_buffer, scaling);
+	}
+	else if(bStream)
+	{
+		LOG_DBG( LOG_LEVEL_CLI,  "\nStream %s waveform from external flash.\n\n", strType[waveformType]);
+		int samplesInFlash = configData_WaveformFromFlash(waveformType, what->measurementSetNr, scaling);
+		if(samplesInFlash < 0)
+		{
+			LOG_EVENT(1100 + waveformType, LOG_NUM_COMM, ERRLOGMAJOR, "FAILED %s read for set # %d; error %s",
+					strWave[waveformType], what->measurementSetNr, extFlash_ErrorString(samplesInFlash));
+		}
+		else
+		{
+			samples = samplesInFlash;
+		}
 	}
 	else
 	{
@@ -1557,6 +1603,7 @@ static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling
 		else
 		{
 			samples = bytesRead/sizeof(int32_t);
+			configData_WaveformFromRam(__sample_buffer, scaling);
 		}
 	}
 
@@ -1568,14 +1615,187 @@ static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling
 				 strWave[waveformType],
 				 strType[waveformType],
 				 what->measurementSetNr);
-        cvt_int32ToFloat( (tInt32Float *) __sample_buffer, samples, scaling);
-        checkIncommingMessages(10, &serverRequests);// just check before the time consuming waveupload something came in ?
-        if (ISVCDATARC_OK != ISvcData_Publish_Data( (SvcDataData_t * ) &idefDataDataRecords[IDEF_data], samples, SKF_MsgType_PUBLISH, 0))
+	}
+
+	return samples;
+}
+
+/*
+ * start (or resume) the upload journal for the dataset measurementSetNr
+ */
+static void uploadJournalStart(uint16_t measurementSetNr)
+{
+	uint8_t dataset;
+	uint16_t progress;
+
+	uploadJournal.active = !dataUploadVars.simulation_mode;
+	if(!uploadJournal.active)
+	{
+		return;
+	}
+
+	uploadJournal.measurementSetNr = (uint8_t)measurementSetNr;
+	if(Vbat_GetUploadJournal(&dataset, &progress) && (dataset == uploadJournal.measurementSetNr))
+	{
+		uploadJournal.progress = progress;
+		LOG_DBG( LOG_LEVEL_CLI, "\nResume upload of dataset %d, waveforms sent 0x%x, block %d\n", measurementSetNr,
+				 progress & UPLOAD_JOURNAL_WAVES_DONE_MASK, progress >> UPLOAD_JOURNAL_BLOCKS_SHIFT);
+	}
+	else
+	{
+		uploadJournal.progress = UPLOAD_JOURNAL_WAVE_NONE;
+		Vbat_SetUploadJournal(uploadJournal.measurementSetNr, uploadJournal.progress);
+	}
+}
+
+#ifdef CONFIG_PLATFORM_UPLOAD_BLOCK_RESUME
+/*
+ * SvcData progress of the waveform being sent, journal the blocks acknowledged
+ */
+static void uploadJournalBlocksAcked(uint32_t blocksAcked, uint32_t blockCount)
+{
+	if(blocksAcked > UPLOAD_JOURNAL_BLOCKS_MAX)
+	{
+		blocksAcked = UPLOAD_JOURNAL_BLOCKS_MAX;	// resends a few blocks too many
+	}
+	uploadJournal.progress = (uploadJournal.progress & ~(UPLOAD_JOURNAL_BLOCKS_MAX << UPLOAD_JOURNAL_BLOCKS_SHIFT)) |
+							 (blocksAcked << UPLOAD_JOURNAL_BLOCKS_SHIFT);
+	Vbat_SetUploadJournal(uploadJournal.measurementSetNr, uploadJournal.progress);
+}
+#endif
+
+/*
+ * the SvcData progress callback of the waveform being sent, NULL when its blocks are not journalled
+ */
+static tSvcDataBlocksAckedFuncPtr uploadJournalBlocksAckedFunc(void)
+{
+#ifdef CONFIG_PLATFORM_UPLOAD_BLOCK_RESUME
+	return uploadJournal.active ? uploadJournalBlocksAcked : NULL;
+#else
+	return NULL;
+#endif
+}
+
+/*
+ * the first block of the waveform to send, past those acknowledged in an earlier upload
+ * of the same waveform in the same form, and journal that waveform as the one being sent
+ */
+static uint32_t uploadJournalFirstBlock(uint16_t waveformType, bool packed)
+{
+	uint16_t wave = (waveformType << UPLOAD_JOURNAL_WAVE_SHIFT) | (packed ? UPLOAD_JOURNAL_PACKED : 0);
+
+	if(!uploadJournal.active)
+	{
+		return 0;
+	}
+#ifdef CONFIG_PLATFORM_UPLOAD_BLOCK_RESUME
+	if((uploadJournal.progress & (UPLOAD_JOURNAL_WAVE_MASK | UPLOAD_JOURNAL_PACKED)) == wave)
+	{
+		return uploadJournal.progress >> UPLOAD_JOURNAL_BLOCKS_SHIFT;
+	}
+#endif
+	uploadJournal.progress = (uploadJournal.progress & UPLOAD_JOURNAL_WAVES_DONE_MASK) | wave;
+	Vbat_SetUploadJournal(uploadJournal.measurementSetNr, uploadJournal.progress);
+	return 0;
+}
+
+/*
+ * journal the waveform as sent, only when the server acknowledged its blocks (QoS1),
+ * published at QoS0 it is sent again with the dataset, until its store data reply is in
+ */
+static void uploadJournalWaveDone(uint16_t waveformType)
+{
+	if(uploadJournal.active && SvcData_IsPublishAcknowledged())
+	{
+		uploadJournal.progress = ((uploadJournal.progress & UPLOAD_JOURNAL_WAVES_DONE_MASK) | (1 << waveformType)) |
+								 UPLOAD_JOURNAL_WAVE_NONE;
+		Vbat_SetUploadJournal(uploadJournal.measurementSetNr, uploadJournal.progress);
+	}
+}
+
+/*
+ * retrieve the waveform selected by measurementSetNr and waveform type, which belongs to
+ * the measurement record retrieved under the same measurementSetNr and send waveform if ok.
+ * The waveform is sent compressed (IDEF_dataPacked) when that is selected and it
+ * compresses, as floats (IDEF_data) otherwise.
+ *
+ * return false when something goes wrong.
+ */
+
+static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling, int IDEF_data, int IDEF_dataPacked)
+{
+	uint32_t samples;
+	int32_t packedBytes = -1;
+    bool serverRequests = false;
+	bool connection_ok = true;		// status of the MQTT connection
+
+	// make sure of a valid waveformType and
+	// have we a sample for the requested wave type
+	if((waveformType >= IS25_MEASURED_DATA) || (0 == (what->waves & (1 << waveformType))))
+	{
+		return true;
+	}
+
+	// sent in an earlier, broken off, upload ?
+	if(uploadJournal.active && (uploadJournal.progress & (1 << waveformType)))
+	{
+		return true;
+	}
+
+	if(commCLI_IsWaveCodecSet())
+	{
+		// the codec needs the whole waveform in the sample buffer, compressed over the samples. A longer
+		// waveform, streamed to the flash while it was sampled, is streamed from it and sent as floats
+		samples = fetchWaveform(what, waveformType, scaling, true);
+		if((samples > 0) && (samples <= (__sample_buffer_size / sizeof(int32_t))))
+		{
+			samples = fetchWaveform(what, waveformType, scaling, false);
+			if(samples > 0)
+			{
+				packedBytes = waveCodec_Encode((int32_t *) __sample_buffer, samples, scaling, (uint8_t *) __sample_buffer, (uint32_t) __sample_buffer_size);
+				if(packedBytes < 0)
+				{
+					// does not compress, and has been partly overwritten, so fetch it again to send as floats
+					LOG_DBG( LOG_LEVEL_CLI, "\nwaveform does not compress, sending floats\n");
+					samples = fetchWaveform(what, waveformType, scaling, true);
+				}
+				else
+				{
+					LOG_DBG( LOG_LEVEL_CLI, "waveform compressed to %d bytes (%d%%)\n", packedBytes, (packedBytes * 100) / (samples * sizeof(int32_t)));
+				}
+			}
+		}
+	}
+	else
+	{
+		samples = fetchWaveform(what, waveformType, scaling, true);
+	}
+
+	if(packedBytes >= 0)
+	{
+        pollIncommingMessages(&serverRequests);// just check before the time consuming waveupload something came in ?
+        if (ISVCDATARC_OK != ISvcData_Publish_DataBlocks( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataPacked], packedBytes, SKF_MsgType_PUBLISH, 0,
+        												  uploadJournalFirstBlock(waveformType, true), uploadJournalBlocksAckedFunc()))
         {
-        	LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_Publish_Data %s not OK\n", strType[waveformType]);
+        	LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_Publish_Data packed waveform %d not OK\n", waveformType);
         	connection_ok = false;
         }
 	}
+	else if(samples > 0)
+	{
+        pollIncommingMessages(&serverRequests);// just check before the time consuming waveupload something came in ?
+        if (ISVCDATARC_OK != ISvcData_Publish_DataBlocks( (SvcDataData_t * ) &idefDataDataRecords[IDEF_data], samples, SKF_MsgType_PUBLISH, 0,
+        												  uploadJournalFirstBlock(waveformType, false), uploadJournalBlocksAckedFunc()))
+        {
+        	LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_Publish_Data waveform %d not OK\n", waveformType);
+        	connection_ok = false;
+        }
+	}
+
+	if(connection_ok)
+	{
+		uploadJournalWaveDone(waveformType);
+	}
 
 	// return connection status
 	return connection_ok;
@@ -1587,10 +1807,21 @@ static bool sendWaveform(whatToSend *what, uint16_t waveformType,  float scaling
  * END interface functions to read the data stored in external flash
  */
 
-static bool uploadGatedMeasurements()
+/*
+ * the state of an upload session, shared by the upload steps
+ */
+typedef struct
+{
+	bool simulationMode;
+	bool serverRequests;		// a request came in from the server
+	whatToSend what;			// the dataset being, or last, uploaded
+} tUploadSession;
+
+typedef bool (* tUploadStepFuncPtr)(tUploadSession *session_p);
+
+static bool uploadGatedMeasurements(tUploadSession *session_p)
 {
 	bool rc_ok = true;
-	bool serverRequests = false;
 	uint32_t gatedIndex = 0;
 
 	while(rc_ok && ExtFlash_fetchGatedMeasData(gatedIndex))
@@ -1603,10 +1834,10 @@ static bool uploadGatedMeasurements()
 		rc_ok = (ISVCDATARC_OK == ISvcData_RequestStoreData( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataMeasureRecord], &messageId));
 		storedataReply.ack_ok = false;// not really nice, but unlikely that a reply is in before this code is executed.
 		// TODO wait for store data reply, should have same messageId
-		// now the server should send a reply
+		// the reply is handled when it is in, no need to wait for it
 		if (rc_ok)
 		{
-			rc_ok = checkIncommingMessages(1000, &serverRequests);// 1000ms ?
+			rc_ok = pollIncommingMessages(&session_p->serverRequests);
 		}
 		else
 		{
@@ -1617,14 +1848,129 @@ static bool uploadGatedMeasurements()
 	return rc_ok;
 }
 
+static bool uploadTemperatureRecords(tUploadSession *session_p)
+{
+	bool rc_ok = true;
+	uint32_t messageId;
+
+	if (init_temperature_sending(session_p->simulationMode))
+	{
+		// if the initialization went Ok, we can do the real encoding/sending
+		while(rc_ok && (temperature_status.current_index < temperature_status.total_records))
+		{
+			LOG_DBG( LOG_LEVEL_CLI, "\nSend temperature Records (storedatarequest) startindex:%d\n", temperature_status.current_index);
+			rc_ok = (ISVCDATARC_OK == ISvcData_RequestStoreData( (SvcDataData_t * ) &TemperatureRecordData, &messageId));
+			temperature_status.current_index += temperature_status.max_records_in_block;
+		}
+	}
+	return rc_ok;
+}
+
+/*
+ * the measurement datasets, oldest first, each with its waveforms followed by its measurement record
+ */
+static bool uploadMeasurementDatasets(tUploadSession *session_p)
+{
+	bool rc_ok = true;
+	uint32_t messageId;
+
+	// loop while ok and we have something to upload
+	while (checkWhatDataToUpload(&session_p->what))
+	{
+		rc_ok = pollIncommingMessages(&session_p->serverRequests);
+		if(false == rc_ok) break;
+
+		// first retrieve the general measurement data, it holds the timestamp
+		int errCode = getMeasurementRecord(session_p->what.measurementSetNr);
+		if(errCode < 0)
+		{
+			// if reading the measurement record fails then we drop the whole measurement set
+			LOG_EVENT(1103, LOG_NUM_COMM, ERRLOGMAJOR, "FAILED measureRecord read for set # %d; error %s",
+					session_p->what.measurementSetNr, extFlash_ErrorString(errCode));
+		}
+		else
+		{
+			// we do not send it yet, lets first do the waveforms (if any)
+			// timestamp when the measurement is performed (that probably is not the current time !!!
+			timestamp_raw = timestamp_env3 = timestamp_wheelflat = measureRecord.timestamp;
+			uploadJournalStart(session_p->what.measurementSetNr);
+
+			if(false == (rc_ok = sendWaveform(&session_p->what,
+										IS25_VIBRATION_DATA,
+										(MEASURE_BEARING_ENV3_SCALING * gNvmCfg.dev.measureConf.Scaling_Bearing),
+										IDEF_dataWaveformEnv3,
+										IDEF_dataWaveformEnv3Packed)))
+				break;
+
+			if(false == (rc_ok = sendWaveform(&session_p->what,
+										IS25_WHEEL_FLAT_DATA,
+										(MEASURE_WHEELFLAT_SCALING * gNvmCfg.dev.measureConf.Scaling_Wheel_Flat),
+										IDEF_dataWaveformWheelflat,
+										IDEF_dataWaveformWheelflatPacked)))
+				break;
+
+			if(false == (rc_ok = sendWaveform(&session_p->what,
+										IS25_RAW_SAMPLED_DATA,
+										(MEASURE_RAW_SCALING * gNvmCfg.dev.measureConf.Scaling_Raw),
+										IDEF_dataWaveformRaw,
+										IDEF_dataWaveformRawPacked)))
+				break;
+
+			// we did not send it earlier, but lets do it now after the waveforms
+			print_measurement_record();
+			LOG_DBG( LOG_LEVEL_CLI, "\r\n Send Measurement Record (storedatarequest) Num:%d \r\n", session_p->what.measurementSetNr);
+			rc_ok = (ISVCDATARC_OK == ISvcData_RequestStoreData( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataMeasureRecord], &messageId));
+			storedataReply.ack_ok = false;		// not really nice, but unlikely that a reply is in before this code is executed.
+			// TODO wait for store data reply, should have same messageId
+			if (false == rc_ok)
+			{
+				LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_RequestStoreData not OK\n");
+				break;
+			}
+
+			// the reply is handled when it is in, no need to wait for it
+			rc_ok = pollIncommingMessages(&session_p->serverRequests);
+		}
+
+		storedataReply.ack_ok = true;// TODO: server takes way too long to react, so for the moment the reply is ignored. must be fixed later
+		if (storedataReply.ack_ok == true)
+		{
+			ackUploadedData(session_p->what.measurementSetNr );// when the reply of the storedataRequest is received we can signal that this set can be deleted on the sensor
+		}
+		else
+		{
+			// no reply received, could stop communication now ?
+		}
+	}	// End of While
+
+	return rc_ok;
+}
+
+/*
+ * the upload schedule, in order of priority. The small records go first, so they are in
+ * even when the session is broken off during the bulk waveform upload of the datasets,
+ * which resumes where it stopped. The steps follow each other without waiting for the
+ * server replies, these are handled as they come in between the steps.
+ * The communication record goes last, its acknowledge closes the session.
+ */
+static const struct
+{
+	const char *name;
+	tUploadStepFuncPtr upload;
+} uploadSchedule[] =
+{
+	{ "gated measurements", uploadGatedMeasurements },
+	{ "temperature records", uploadTemperatureRecords },
+	{ "measurement datasets", uploadMeasurementDatasets },
+};
+
 // template for the real application communication flow
 static bool commsUpload(bool simulationMode)
 {
     bool rc_ok = true;		// result of communication functions
-    whatToSend whatToUpload = {0, 0};
+    tUploadSession session = { .simulationMode = simulationMode, .serverRequests = false, .what = {0, 0} };
     uint16_t datasetsToUpload = gNvmData.dat.is25.noOfMeasurementDatasetsToUpload;
     uint16_t msrmntDatasetStartIndex = gNvmData.dat.is25.measurementDatasetStartIndex;
-    bool serverRequests = false;
     uint16_t serverWaits = 10;// when we received a server request, we will wait some extra time, maybe the server has more to ask
     uint32_t messageId;
 
@@ -1632,87 +1978,10 @@ static bool commsUpload(bool simulationMode)
 
     do
     {
-		// loop while ok and we have something to upload
-		while (checkWhatDataToUpload(&whatToUpload))
-		{
-			rc_ok = checkIncommingMessages(1000, &serverRequests);	// 1000ms ?
-			if(false == rc_ok) break;
-
-			// first retrieve the general measurement data, it holds the timestamp
-			int errCode = getMeasurementRecord(whatToUpload.measurementSetNr);
-			if(errCode < 0)
-			{
-				// if reading the measurement record fails then we drop the whole measurement set
-				LOG_EVENT(1103, LOG_NUM_COMM, ERRLOGMAJOR, "FAILED measureRecord read for set # %d; error %s",
-						whatToUpload.measurementSetNr, extFlash_ErrorString(errCode));
-			}
-			else
-			{
-				// we do not send it yet, lets first do the waveforms (if any)
-				// timestamp when the measurement is performed (that probably is not the current time !!!
-				timestamp_raw = timestamp_env3 = timestamp_wheelflat = measureRecord.timestamp;
-
-				if(false == (rc_ok = sendWaveform(&whatToUpload,
-											IS25_VIBRATION_DATA,
-											(MEASURE_BEARING_ENV3_SCALING * gNvmCfg.dev.measureConf.Scaling_Bearing),
-											IDEF_dataWaveformEnv3)))
-					break;
-
-				if(false == (rc_ok = sendWaveform(&whatToUpload,
-											IS25_WHEEL_FLAT_DATA,
-											(MEASURE_WHEELFLAT_SCALING * gNvmCfg.dev.measureConf.Scaling_Wheel_Flat),
-											IDEF_dataWaveformWheelflat)))
-					break;
-
-				if(false == (rc_ok = sendWaveform(&whatToUpload,
-											IS25_RAW_SAMPLED_DATA,
-											(MEASURE_RAW_SCALING * gNvmCfg.dev.measureConf.Scaling_Raw),
-											IDEF_dataWaveformRaw)))
-					break;
-
-				// we did not send it earlier, but lets do it now after the waveforms
-				print_measurement_record();
-				LOG_DBG( LOG_LEVEL_CLI, "\r\n Send Measurement Record (storedatarequest) Num:%d \r\n", whatToUpload.measurementSetNr);
-				rc_ok = (ISVCDATARC_OK == ISvcData_RequestStoreData( (SvcDataData_t * ) &idefDataDataRecords[IDEF_dataMeasureRecord], &messageId));
-				storedataReply.ack_ok = false;		// not really nice, but unlikely that a reply is in before this code is executed.
-				// TODO wait for store data reply, should have same messageId
-				if (false == rc_ok)
-				{
-					LOG_DBG( LOG_LEVEL_CLI, "\nISvcData_RequestStoreData not OK\n");
-					break;
-				}
-
-				// now the server should send a reply
-				rc_ok = checkIncommingMessages(1000, &serverRequests);// 1000ms ?
-			}
-
-			storedataReply.ack_ok = true;// TODO: server takes way too long to react, so for the moment the reply is ignored. must be fixed later
-			if (storedataReply.ack_ok == true)
-			{
-				ackUploadedData(whatToUpload.measurementSetNr );// when the reply of the storedataRequest is received we can signal that this set can be deleted on the sensor
-			}
-			else
-			{
-				// no reply received, could stop communication now ?
-			}
-		}	// End of While
-
-		// did we fail in the while loop?
-		if(false == rc_ok) break;
-
-		// Now we send any gated measurements.
-    	rc_ok = uploadGatedMeasurements();
-		if(false == rc_ok) break;
-
-		if (init_temperature_sending(simulationMode))
+		for(int i = 0; rc_ok && (i < sizeof(uploadSchedule)/sizeof(uploadSchedule[0])); i++)
 		{
-			// if the initialization went Ok, we can do the real encoding/sending
-			while(rc_ok && (temperature_status.current_index < temperature_status.total_records))
-			{
-				LOG_DBG( LOG_LEVEL_CLI, "\nSend temperature Records (storedatarequest) startindex:%d\n", temperature_status.current_index);
-				rc_ok = (ISVCDATARC_OK == ISvcData_RequestStoreData( (SvcDataData_t * ) &TemperatureRecordData, &messageId));
-				temperature_status.current_index += temperature_status.max_records_in_block;
-			}
+			LOG_DBG( LOG_LEVEL_CLI, "\nUpload %s\n", uploadSchedule[i].name);
+			rc_ok = uploadSchedule[i].upload(&session) && pollIncommingMessages(&session.serverRequests);
 		}
 		if(false == rc_ok) break;
 
@@ -1759,18 +2028,18 @@ static bool commsUpload(bool simulationMode)
 		if(false == rc_ok) break;
 
 		// if no message was received from the server yet it should wait 30 seconds
-		if(serverRequests==false)
+		if(session.serverRequests==false)
 		{
-			rc_ok = checkIncommingMessages(30000, &serverRequests);
+			rc_ok = checkIncommingMessages(30000, &session.serverRequests);
 		}
 		if(false == rc_ok) break;
 
     	// Waiting loop if when receiving multiple subsequent messages
-        while (serverRequests && (serverWaits > 0))
+        while (session.serverRequests && (serverWaits > 0))
         {
             LOG_DBG( LOG_LEVEL_CLI, "Extra wait of 15secs for incoming messages inserted!\n");
-            serverRequests = false;
-            rc_ok = checkIncommingMessages(15000, &serverRequests);
+            session.serverRequests = false;
+            rc_ok = checkIncommingMessages(15000, &session.serverRequests);
             serverWaits-- ;
         }
 		if(false == rc_ok) break;
@@ -1783,7 +2052,7 @@ static bool commsUpload(bool simulationMode)
 		if (storedataReply.ack_ok == true)
 		{
 			// ack all sets should be stored in the database
-			ackUploadedData(whatToUpload.measurementSetNr );// when the reply of the storedataRequest is received we can signal that this set can be deleted on the sensor
+			ackUploadedData(session.what.measurementSetNr );// when the reply of the storedataRequest is received we can signal that this set can be deleted on the sensor
 			LOG_DBG( LOG_LEVEL_CLI, "CommsRecord Successful %d!\n",serverWaits);
 		}
 		else
@@ -45,6 +45,8 @@ extern "C" {
 #include "boardSpecificCLI.h"
 #include "configCLI.h"
 #include "Log.h"
+#include "Trace.h"
+#include "TaskStats.h"
 
 #include "PowerControl.h"
 #include "PinConfig.h"
@@ -86,6 +88,7 @@ extern "C" {
 #include "PassRailAnalogCtrl.h"
 
 #include "PassRailDSP.h"
+#include "PassRailDspBench.h"
 
 #include "fsl_rtc_driver.h"
 #include "PassRailMeasure.h"
@@ -180,7 +183,7 @@ static bool cliLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
 	bool rc_ok = true;
 
 	if (args == 0) {
-		 printf("log %d\n", dbg_logging);
+		 printf("log %d (dropped %d, over rate %d)\n", dbg_logging, dbg_logDropped, dbg_logRateLimited);
 
 		 // Show active levels
 		 for ( logIdx = 0; logIdx < 32; logIdx++ ) {
@@ -203,6 +206,28 @@ static bool cliLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
 	return rc_ok;
 }
 
+#ifdef CONFIG_PLATFORM_TRACE
+/*
+ * cliTrace
+ *
+ * trace command
+ */
+static bool cliTrace( uint32_t args, uint8_t * argv[], uint32_t * argi)
+{
+	if (args == 0) {
+		Trace_Print();
+	} else if (strcmp((const char*)argv[0], "reset") == 0) {
+		Trace_Reset();
+	} else if (strcmp((const char*)argv[0], "ring") == 0) {
+		Trace_PrintRing();
+	} else {
+		return false;
+	}
+
+	return true;
+}
+#endif
+
 
 /*
  * TODO I don't think this function should be here
@@ -333,6 +358,7 @@ static bool cliExtHelpTask(uint32_t argc, uint8_t * argv[], uint32_t * argi)
 		{ NULL, 0 }
 	};
     printf("task info\t: print list of tasks and stack usage.\n");
+    printf("task stats [last]\t: CPU time, share and stack high-water of all tasks, this wakeup or as stored by the last.\n");
     printf("task shutdown\t: gracefully shuts down (first writing back changed config/data to flash etc.)\n");
     printf("task run [app|ota] <param>\t: start application task  or firmware update task, with optional parameter\n");
     printf("examples:\n");
@@ -374,7 +400,28 @@ static bool cliTask( uint32_t args, uint8_t * argv[], uint32_t * argi)
 	else
 	{
 	    // args >=1
-        if (strcmp((const char*)argv[0], "shutdown") == 0)
+        if (strcmp((const char*)argv[0], "stats") == 0)
+        {
+            static tTaskStatsRecord taskStats;
+
+            if ((args >= 2) && (strcmp((const char*)argv[1], "last") == 0))
+            {
+                rc_ok = fetchTaskStats(&taskStats);
+                if (!rc_ok)
+                {
+                    printf("no task statistics stored\n");
+                }
+            }
+            else
+            {
+                rc_ok = TaskStats_Capture(&taskStats);
+            }
+            if (rc_ok)
+            {
+                TaskStats_Print(&taskStats);
+            }
+        }
+        else if (strcmp((const char*)argv[0], "shutdown") == 0)
         {
             xTaskDeviceShutdown(false);
             rc_ok = true;
@@ -1451,6 +1498,58 @@ static bool cliSample(uint32_t argc, uint8_t * argv[], uint32_t * argi)
     return true;
 }
 
+#if defined(PASSRAIL_DSP_NEW) && defined(CONFIG_PLATFORM_DSPBENCH)
+/*
+ * cliDspBench
+ *
+ * @desc    Runs the DSP benchmark on all decimation chains - throughput (MCU
+ *          cycles and load), SNR vs. a double-precision reference, passband
+ *          ripple and golden-output check. Uses the built-in stimulus, or the
+ *          first <numsamples> samples left in the sample buffer by a previous
+ *          "sample <numsamples> raw25600".
+ *
+ * @param   The usual CLI parameters.
+ *
+ * @returns -
+ */
+static bool cliDspBench(uint32_t argc, uint8_t * argv[], uint32_t * argi)
+{
+    const int32_t *pRecordedSamples = NULL;
+    uint32_t NumRecordedSamples = 0;
+
+    if (argc > 1)
+    {
+        printf("ERROR: Incorrect number of parameters\n");
+        return true;
+    }
+
+    if (argc == 1)
+    {
+        NumRecordedSamples = argi[0];
+        if ((NumRecordedSamples == 0) || (NumRecordedSamples > SAMPLE_BUFFER_SIZE_WORDS))
+        {
+            printf("ERROR: Number of samples must be 1 to %ld\n", SAMPLE_BUFFER_SIZE_WORDS);
+            return true;
+        }
+        pRecordedSamples = g_pSampleBuffer;
+    }
+
+    // The benchmark re-initialises the DSP
+    if (Measure_IsSamplingInProgress())
+    {
+        printf("ERROR: Sampling in progress\n");
+        return true;
+    }
+
+    if (!PassRailDspBench_RunAll(pRecordedSamples, NumRecordedSamples, true))
+    {
+        printf("ERROR: DSP benchmark failed\n");
+    }
+
+    return true;
+}
+#endif // PASSRAIL_DSP_NEW && CONFIG_PLATFORM_DSPBENCH
+
 /*
  * cliAD7766SendResultsToCliAndTestUart
  *
@@ -1843,6 +1942,9 @@ bool cliExtHelpBlinkLed(uint32_t argc, uint8_t * argv[], uint32_t * argi);
 
 static const struct cliCmd boardSpecificCommands[] = {
 		{"log","value [port]\t\tlogging bitmask",cliLog, NULL},
+#ifdef CONFIG_PLATFORM_TRACE
+		{"trace","[reset|ring]\t\ttrace point timings (min/avg/max, histogram), reset them, or the latest events",cliTrace, NULL},
+#endif
 		{"configwrite","val	\tval=1: write ram copy of the device config to flash, val=-1:initialise ramcopy and flash with defaults",cliNvmWrite,NULL},
 		{"task", "\t\t\t\ttask list and stack usage", cliTask, cliExtHelpTask },
 		{"datastore", "\t<id>\t\tData dictionary read id=1..n, or name", cliDataStore, cliExtHelpDataStore },
@@ -1929,6 +2031,9 @@ static const struct cliCmd boardSpecificCommands[] = {
 
 #ifdef PASSRAIL_DSP_NEW
         {"sample", "<numsamples> <raw25600 | vib[1280|2560|5120] | wflats[256|512|1280]>\tPerform sampling burst with full hardware control & DSP, output to test UART @ 115kbaud", cliSample, NULL},
+#ifdef CONFIG_PLATFORM_DSPBENCH
+        {"dspbench", "[<numsamples>]\tBenchmark the DSP chains, on built-in stimulus or <numsamples> of a previous raw25600 capture", cliDspBench, NULL},
+#endif
 #else
         {"sample", "<numsamples> <raw25600|vib2560|wflats1280>\tPerform sampling burst with full hardware control & DSP, output to test UART @ 115kbaud", cliSample, NULL},
 #endif
@@ -40,6 +40,7 @@ typedef enum
 	E_Raw_ASCII,
 	E_BinaryCli_OTAStart,
 	E_BinaryCli_OTACompleted,
+	E_BinaryCli_TraceStats,		// reply is a tTraceStats per trace region, a non zero request byte resets them after
 } tE_CLIcommand;
 
 typedef enum
@@ -17,6 +17,7 @@ extern "C" {
 #include "binaryCLI_Task.h"
 #include "xTaskDefs.h"
 #include "SvcMqttFirmware.h"
+#include "Trace.h"
 
 extern int CLI_handle_command(char * cmdbuf, uint8_t dbg_put_ch);
 
@@ -78,6 +79,23 @@ void xTaskBinaryCLI(void *pvParameters)
 					xTaskApp_binaryCliOta();
 					break;
 
+				case E_BinaryCli_TraceStats:
+				{
+					tTraceStats stats;
+					for(int region = 0; region < TRACE_NUM_REGIONS; region++)
+					{
+						if(Trace_GetStats((tTraceRegion)region, &stats))
+						{
+							binaryCLI_sendPacket(E_BinaryCli_TraceStats, &stats, sizeof(stats));
+						}
+					}
+					if((nMessageSize > 0) && (pbyMessage[0] != 0))
+					{
+						Trace_Reset();
+					}
+					break;
+				}
+
 				default:
 					break;
 				}
@@ -41,6 +41,7 @@ extern "C" {
 
 #include "CS1.h"
 #include "Log.h"
+#include "Trace.h"
 
 // Services
 #ifdef CONFIG_PLATFORM_SVCDATA
@@ -91,6 +92,7 @@ static struct MQTT_Network sMQTTNetwork = {
         .conn_p = NULL,
         .mqttread = MQTTFreeRTOS_lwIP_read,
         .mqttwrite = MQTTFreeRTOS_lwIP_write,
+        .mqttwritequeued = NULL,
         .disconnect = MQTTFreeRTOS_lwIP_disconnect,
         .errorhandler = CommMQTT_ErrorHandler,
         .lastdata_p = NULL,
@@ -101,6 +103,7 @@ static struct MQTT_Network sMQTTNetwork = {
         .conn_p = NULL,
         .mqttread = MQTTFreeRTOS_Modem_Read,
         .mqttwrite = MQTTFreeRTOS_Modem_Write,
+        .mqttwritequeued = MQTTFreeRTOS_Modem_WriteQueued,
         .disconnect = MQTTFreeRTOS_Modem_Disconnect,
         .errorhandler = CommMQTT_ErrorHandler,
         .lastdata_p = NULL,
@@ -123,6 +126,9 @@ static MQTTClient sMQTTClient;
  */
 static uint8_t sSendBuf[CONFIG_MQTT_SEND_BUFFER_SIZE];
 static uint8_t sRecvBuf[CONFIG_MQTT_RECV_BUFFER_SIZE];
+#if (CONFIG_MQTT_PUBLISH_WINDOW > 1)
+static uint8_t sInflightBuf[CONFIG_MQTT_PUBLISH_WINDOW * CONFIG_MQTT_MAX_PUBLISH_SIZE];// QoS1 publishes waiting for their PUBACK
+#endif
 
 
 /*
@@ -312,12 +318,27 @@ static bool CommMQTT_Publish( MQTTClient *client_p, MQTT_Network *n, tPublishReq
     mqttMsg.qos        = QOS0; // Default non-confirmed PUBLISH (at most once delivery)
     mqttMsg.retained   = 0; // Don't retain the message at the broker by default
 
+    TRACE_ENTER(TRACE_MQTT_PUBLISH);
     rc = MQTTPublish(&sMQTTClient, PublishReq->topic == NULL ? (const char  *)mqttGetPubTopic() : (const char *) PublishReq->topic, &mqttMsg );
+    TRACE_EXIT(TRACE_MQTT_PUBLISH);
 
     return (rc == SUCCESS);
 }
 
 
+/*
+ * TaskComm_SetPublishWindow
+ *
+ * @brief Set how many QoS1 publishes may be sent ahead of their PUBACK
+ * @param window  1 for stop-and-wait, up to CONFIG_MQTT_PUBLISH_WINDOW
+ * @return the window set
+ */
+int TaskComm_SetPublishWindow( unsigned int window )
+{
+    return MQTTSetPublishWindow( &sMQTTClient, window );
+}
+
+
 /*
  * TaskComm_Init
  *
@@ -366,6 +387,9 @@ void TaskComm_Init(void) {
             sSendBuf, CONFIG_MQTT_SEND_BUFFER_SIZE,
             sRecvBuf, CONFIG_MQTT_RECV_BUFFER_SIZE );
 #endif
+#if (CONFIG_MQTT_PUBLISH_WINDOW > 1)
+    MQTTClientInitWindow( &sMQTTClient, sInflightBuf, sizeof(sInflightBuf), CONFIG_MQTT_MAX_PUBLISH_SIZE, CONFIG_MQTT_PUBACK_TIMEOUT_MS );
+#endif
 
     /*
      * Register Comm CLI commands
@@ -64,6 +64,7 @@ int32_t TaskComm_Connect( tCommHandle * handle, uint32_t maxWaitMs );
 int32_t TaskComm_Disconnect( tCommHandle * handle, uint32_t maxWaitMs );
 
 int32_t TaskComm_Publish( tCommHandle * handle, void *payload_p, int payloadlen, uint8_t * topic,  uint32_t maxWaitMs );// TODO : debug function at the moment
+int TaskComm_SetPublishWindow( unsigned int window );
 
 int32_t TaskComm_SendData( void ); // TODO Generic data references
 int32_t TaskComm_FirmwareUpdate( void );
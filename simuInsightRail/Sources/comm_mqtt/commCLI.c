@@ -35,6 +35,7 @@ extern "C" {
  * Data
  */
 static bool bIgnoreCommsAck = false;
+static bool bWaveCodec = false;
 static tCommHandle CommHandle = { .EventQueue_CommResp = NULL};
 
 /*
@@ -43,12 +44,14 @@ static tCommHandle CommHandle = { .EventQueue_CommResp = NULL};
 static bool cliCommsConnect( uint32_t args, uint8_t * argv[], uint32_t * argi);
 static bool cliCommsDisconnect( uint32_t args, uint8_t * argv[], uint32_t * argi);
 static bool cliCommsAckIgnore( uint32_t args, uint8_t * argv[], uint32_t * argi);
+static bool cliCommsWaveCodec( uint32_t args, uint8_t * argv[], uint32_t * argi);
 
 struct cliSubCmd commSubCmds[] =
 {
 	{"connect", 	cliCommsConnect},
 	{"disconnect",  cliCommsDisconnect},
 	{"AckIgnore", 	cliCommsAckIgnore},
+	{"WaveCodec", 	cliCommsWaveCodec},
 };
 
 bool cliComm( uint32_t args, uint8_t * argv[], uint32_t * argi)
@@ -136,6 +139,34 @@ bool commCLI_IsCommsAckIgnoreSet()
 	return bIgnoreCommsAck;
 }
 
+static bool cliCommsWaveCodec( uint32_t args, uint8_t * argv[], uint32_t * argi)
+{
+	if ((args == 1) && (argi[0] <= 1))
+	{
+		bWaveCodec = (argi[0] == 1);
+		LOG_DBG( LOG_LEVEL_CLI, "Waveforms uploaded %s\n", bWaveCodec ? "compressed" : "as floats");
+	}
+	else
+	{
+		printf("Only single parameter needed (enter 1 to compress or 0 for floats), Current waveform compression:%d\n", bWaveCodec);
+	}
+
+	return true;
+}
+
+/*
+ * commCLI_IsWaveCodecSet
+ *
+ * @desc    Fetches whether waveforms are uploaded compressed (waveCodec) rather
+ *          than as floats.
+ *
+ * @returns TRUE if waveforms are to be compressed, FALSE otherwise.
+ */
+bool commCLI_IsWaveCodecSet()
+{
+	return bWaveCodec;
+}
+
 static bool cliMqtt( uint32_t args, uint8_t * argv[], uint32_t * argi)
 {
     bool rc_ok = true;
@@ -183,6 +214,17 @@ static bool cliMqtt( uint32_t args, uint8_t * argv[], uint32_t * argi)
         {
         	rc_ok = publishImagesManifestUpdate();
         }
+        else if(strcasecmp((const char*)argv[0], "window")==0)
+        {
+        	if (args == 2)
+        	{
+        		printf("QoS1 publish window %d\n", TaskComm_SetPublishWindow(argi[1]));
+        	}
+        	else
+        	{
+        		rc_ok = false;
+        	}
+        }
 
     }
 
@@ -198,7 +240,8 @@ static bool cliCommLongHelp( uint32_t args, uint8_t * argv[], uint32_t * argi)
     printf( "actions:\n"
             "  connect         		Connect to cloud services using IDEF/MQTT\n"
             "  disconnect      		Disconnect from cloud services\n"
-    		"  ackIgnore <En/Dis>	\tIgnore the COMMS ACK\n");
+    		"  ackIgnore <En/Dis>	\tIgnore the COMMS ACK\n"
+    		"  waveCodec <En/Dis>	\tUpload the waveforms compressed\n");
     return true;
 }
 
@@ -208,6 +251,7 @@ static bool cliMqttLongHelp( uint32_t args, uint8_t * argv[], uint32_t * argi)
             "  pub <msg> [<topic>]   Publish message from CLI to MQTT broker on <topic>\n"
     		"  Otamanifest <ImageType: 1->Loader, 2->App, 3->Pmic_App> Publish OTAcomplete manifest\n"
     		"  Imagesmanifest          Publish Images manifest\n"
+    		"  window <n>              QoS1 publishes sent ahead of their PUBACK, 1 for stop-and-wait\n"
             /*"  sub <topic>         Subscribe to <topic>; msgs are printed on the CLI\n" */);
     return true;
 }
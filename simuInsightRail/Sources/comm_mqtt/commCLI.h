@@ -34,6 +34,7 @@ extern "C" {
 
 bool commCliInit(void);
 bool commCLI_IsCommsAckIgnoreSet();
+bool commCLI_IsWaveCodecSet();
 
 #endif /* SOURCES_COMM_MQTT_PLATFORM_COMMCLI_H_ */
 
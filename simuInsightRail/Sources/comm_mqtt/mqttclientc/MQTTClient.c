@@ -20,6 +20,10 @@ extern "C" {
  *
  *    01-jul-2016 gdf: MQTTUnsubscribe, toficFilter to unsubscribe now removed from the topicFilter list !
  *    04-oct-2016 gdf: waitfor() now also exits when reading gives an error
+ *    QoS1 publish window: publishes are sent ahead of the PUBACKs of earlier ones, which are matched
+ *                         in cycle(), retransmitted on timeout and after a reconnect
+ *    MQTTPublish: only the publish header is serialised into the send buffer, the payload is written
+ *                 to the network from the caller's buffer
  *******************************************************************************/
 #include "MQTTClient.h"
 #include "MQTTFreeRTOS.h"
@@ -55,14 +59,14 @@ static int getNextPacketId(MQTTClient *c) {
 }
 
 
-static int sendPacket(MQTTClient* c, int length, MQTT_Timer* timer)
+static int sendBuffer(MQTTClient* c, unsigned char* buf, int length, MQTT_Timer* timer)
 {
     int rc = FAILURE, 
         sent = 0;
     
     while (sent < length && !MQTT_TimerIsExpired(timer))
     {
-        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, MQTT_TimerLeftMS(timer));
+        rc = c->ipstack->mqttwrite(c->ipstack, &buf[sent], length - sent, MQTT_TimerLeftMS(timer));
         if (rc < 0)  // there was an error writing the data
             break;
         sent += rc;
@@ -78,6 +82,88 @@ static int sendPacket(MQTTClient* c, int length, MQTT_Timer* timer)
 }
 
 
+static int sendPacket(MQTTClient* c, int length, MQTT_Timer* timer)
+{
+    return sendBuffer(c, c->buf, length, timer);
+}
+
+
+// for buffers that stay untouched until their ack, the network may send them while the next packet is prepared
+static int sendBufferQueued(MQTTClient* c, unsigned char* buf, int length, MQTT_Timer* timer)
+{
+    if (c->ipstack->mqttwritequeued == NULL)
+        return sendBuffer(c, buf, length, timer);
+
+    if (c->ipstack->mqttwritequeued(c->ipstack, buf, length, MQTT_TimerLeftMS(timer)) != length)
+        return FAILURE;
+    MQTT_TimerCountdown(&c->ping_timer, c->keepAliveInterval);
+    return SUCCESS;
+}
+
+
+static unsigned int inflightCount(MQTTClient* c)
+{
+    unsigned int i, count = 0;
+
+    for (i = 0; i < c->inflightSlots; ++i)
+        if (c->inflight[i].id != 0)
+            count++;
+    return count;
+}
+
+
+static struct InflightPublish* inflightFreeSlot(MQTTClient* c)
+{
+    unsigned int i;
+
+    for (i = 0; i < c->inflightSlots; ++i)
+        if (c->inflight[i].id == 0)
+            return &c->inflight[i];
+    return NULL;
+}
+
+
+static void inflightAck(MQTTClient* c, unsigned short packetid)
+{
+    unsigned int i;
+
+    for (i = 0; i < c->inflightSlots; ++i)
+        if (c->inflight[i].id == packetid)
+            c->inflight[i].id = 0;
+}
+
+
+// resend the publishes whose PUBACK is overdue, or all of them (after a reconnect), flagged as duplicates
+static int inflightRetransmit(MQTTClient* c, MQTT_Timer* timer, int all)
+{
+    unsigned int i;
+    MQTTHeader header = {0};
+
+    for (i = 0; i < c->inflightSlots; ++i)
+    {
+        struct InflightPublish* p = &c->inflight[i];
+
+        if (p->id == 0)
+            continue;
+        if (all)
+            p->retries = 0;
+        else if (!MQTT_TimerIsExpired(&p->timer))
+            continue;
+        else if (p->retries >= MAX_PUBLISH_RETRIES)
+            return FAILURE; // no PUBACK coming, the connection must be gone
+
+        header.byte = p->packet[0];
+        header.bits.dup = 1;
+        p->packet[0] = header.byte;
+        if (sendBufferQueued(c, p->packet, p->len, timer) != SUCCESS)
+            return FAILURE;
+        p->retries++;
+        MQTT_TimerCountdownMS(&p->timer, c->puback_timeout_ms);
+    }
+    return SUCCESS;
+}
+
+
 void MQTTClientInit(MQTTClient* c, MQTT_Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
@@ -96,12 +182,47 @@ void MQTTClientInit(MQTTClient* c, MQTT_Network* network, unsigned int command_t
     c->defaultMessageHandler = NULL;
 	c->next_packetid = 1;
     MQTT_TimerInit(&c->ping_timer);
+    for (i = 0; i < MAX_INFLIGHT_PUBLISHES; ++i)
+        c->inflight[i].id = 0;
+    c->inflightWindow = 1;
+    c->inflightSlots = 0;
+    c->inflightPacket_size = 0;
+    c->puback_timeout_ms = command_timeout_ms;
 #if defined(MQTT_TASK)
     MQTT_MutexInit(&c->mutex);
     c->thread.task = NULL;
 #endif
 }
 
+int MQTTClientInitWindow(MQTTClient* c, unsigned char* buf, size_t buf_size, size_t packet_size, unsigned int puback_timeout_ms)
+{
+    unsigned int i;
+
+    c->inflightSlots = buf_size / packet_size;
+    if (c->inflightSlots > MAX_INFLIGHT_PUBLISHES)
+        c->inflightSlots = MAX_INFLIGHT_PUBLISHES;
+    c->inflightPacket_size = packet_size;
+    for (i = 0; i < c->inflightSlots; ++i)
+    {
+        c->inflight[i].id = 0;
+        c->inflight[i].packet = &buf[i * c->inflightPacket_size];
+        MQTT_TimerInit(&c->inflight[i].timer);
+    }
+    c->puback_timeout_ms = puback_timeout_ms;
+
+    return MQTTSetPublishWindow(c, c->inflightSlots);
+}
+
+
+int MQTTSetPublishWindow(MQTTClient* c, unsigned int window)
+{
+    if (window > c->inflightSlots)
+        window = c->inflightSlots;
+    c->inflightWindow = (window < 1) ? 1 : window;
+    return c->inflightWindow;
+}
+
+
 static int decodePacket(MQTTClient* c, int* value, int timeout)
 {
     unsigned char i;
@@ -313,9 +434,16 @@ int cycle(MQTTClient* c, MQTT_Timer* timer)
     switch (packet_type)
     {
         case CONNACK:
-        case PUBACK:
         case SUBACK:
             break;
+        case PUBACK:
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) == 1)
+                inflightAck(c, mypacketid);
+            break;
+        }
         case PUBLISH:
         {
             MQTTString topicName;
@@ -370,6 +498,15 @@ int cycle(MQTTClient* c, MQTT_Timer* timer)
             break;
     }
     keepalive(c);
+    if (c->isconnected)
+    {
+        // the read may have used up the caller's timer on a quiet link, which is when a retransmit is due
+        MQTT_Timer retransmit_timer;
+        MQTT_TimerInit(&retransmit_timer);
+        MQTT_TimerCountdownMS(&retransmit_timer, c->command_timeout_ms);
+        if (inflightRetransmit(c, &retransmit_timer, 0) == FAILURE)
+            rc = FAILURE;
+    }
 exit:
     if (rc == SUCCESS)
         rc = packet_type;
@@ -596,7 +733,15 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
     
 exit:
     if (rc == SUCCESS)
+    {
         c->isconnected = 1;
+        // publishes not acknowledged on the lost connection are sent again
+        if (inflightRetransmit(c, &connect_timer, 1) != SUCCESS)
+        {
+            c->isconnected = 0;
+            rc = FAILURE;
+        }
+    }
 
 #if defined(MQTT_TASK)
     MQTT_MutexUnlock(&c->mutex);
@@ -732,15 +877,48 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 	MQTT_TimerInit(&timer);
 	MQTT_TimerCountdownMS(&timer, c->command_timeout_ms);
 
+    if (message->qos == QOS1 && c->inflightWindow > 1)
+    {
+        struct InflightPublish* p = NULL;
+
+        // wait for room in the window, reading the PUBACKs
+        while ((inflightCount(c) >= c->inflightWindow) || ((p = inflightFreeSlot(c)) == NULL))
+        {
+            if (MQTT_TimerIsExpired(&timer) || (cycle(c, &timer) == FAILURE))
+            {
+                rc = FAILURE;
+                goto exit;
+            }
+        }
+
+        message->id = getNextPacketId(c);
+        len = MQTTSerialize_publish(p->packet, c->inflightPacket_size, 0, message->qos, message->retained, message->id,
+                  topic, (unsigned char*)message->payload, message->payloadlen);
+        if (len <= 0)
+            goto exit;
+        if ((rc = sendBufferQueued(c, p->packet, len, &timer)) != SUCCESS)
+            goto exit;
+
+        // its PUBACK is matched by cycle()
+        p->len = len;
+        p->retries = 0;
+        p->id = message->id;
+        MQTT_TimerCountdownMS(&p->timer, c->puback_timeout_ms);
+        goto exit;
+    }
+
     if (message->qos == QOS1 || message->qos == QOS2)
         message->id = getNextPacketId(c);
     
-    len = MQTTSerialize_publish(c->buf, c->buf_size, 0, message->qos, message->retained, message->id, 
-              topic, (unsigned char*)message->payload, message->payloadlen);
+    // only the header goes through the send buffer, the payload is sent from where it is
+    len = MQTTSerialize_publishHeader(c->buf, c->buf_size, 0, message->qos, message->retained, message->id,
+              topic, message->payloadlen);
     if (len <= 0)
         goto exit;
-    if ((rc = sendPacket(c, len, &timer)) != SUCCESS) // send the subscribe packet
+    if ((rc = sendPacket(c, len, &timer)) != SUCCESS) // send the publish header
         goto exit; // there was a problem
+    if ((rc = sendBuffer(c, (unsigned char*)message->payload, message->payloadlen, &timer)) != SUCCESS)
+        goto exit;
     
     if (message->qos == QOS1)
     {
@@ -775,6 +953,48 @@ exit:
 }
 
 
+int MQTTPublishFlush(MQTTClient* c, int timeout_ms)
+{
+    int rc = SUCCESS;
+    MQTT_Timer timer;
+
+#if defined(MQTT_TASK)
+    MQTT_MutexLock(&c->mutex);
+#endif
+    MQTT_TimerInit(&timer);
+    MQTT_TimerCountdownMS(&timer, timeout_ms);
+
+    while (inflightCount(c) > 0)
+    {
+        if (!c->isconnected || MQTT_TimerIsExpired(&timer) || (cycle(c, &timer) == FAILURE))
+        {
+            rc = FAILURE;
+            break;
+        }
+    }
+
+#if defined(MQTT_TASK)
+    MQTT_MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+int MQTTPublishInflight(MQTTClient* c)
+{
+    int count;
+
+#if defined(MQTT_TASK)
+    MQTT_MutexLock(&c->mutex);
+#endif
+    count = (int)inflightCount(c);
+#if defined(MQTT_TASK)
+    MQTT_MutexUnlock(&c->mutex);
+#endif
+    return count;
+}
+
+
 int MQTTDisconnect(MQTTClient* c)
 {  
     int rc = FAILURE;
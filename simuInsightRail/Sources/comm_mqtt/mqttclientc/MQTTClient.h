@@ -61,6 +61,14 @@ extern "C" {
 #define MAX_MESSAGE_HANDLERS 5 /* redefinable - how many subscriptions do you want? */
 #endif
 
+#if !defined(MAX_INFLIGHT_PUBLISHES)
+#define MAX_INFLIGHT_PUBLISHES 4 /* redefinable - how many QoS1 publishes may wait for their PUBACK at once */
+#endif
+
+#if !defined(MAX_PUBLISH_RETRIES)
+#define MAX_PUBLISH_RETRIES 3 /* redefinable - retransmissions of a QoS1 publish before the connection is taken as lost */
+#endif
+
 enum QoS { QOS0, QOS1, QOS2 };
 
 /* all failure return codes must be negative */
@@ -123,6 +131,20 @@ typedef struct MQTTClient
 
     MQTT_Network* ipstack;
     MQTT_Timer ping_timer;
+
+    struct InflightPublish
+    {
+        unsigned short id;          /* packet id waiting for its PUBACK, 0 when the slot is free */
+        unsigned char retries;
+        int len;
+        unsigned char *packet;      /* the serialised publish, kept to retransmit it */
+        MQTT_Timer timer;           /* PUBACK timeout */
+    } inflight[MAX_INFLIGHT_PUBLISHES];  /* QoS1 publishes sent ahead of their PUBACK */
+
+    unsigned int inflightWindow,    /* max publishes waiting for their PUBACK, 1 is stop-and-wait */
+      inflightSlots,                /* slots with a packet buffer */
+      puback_timeout_ms;
+    size_t inflightPacket_size;
 #if defined(MQTT_TASK)
 	MQTT_Mutex mutex;
 	MQTT_Thread thread;
@@ -137,7 +159,7 @@ typedef struct MQTTClient
  * @param client
  * @param network
  * @param command_timeout_ms
- * @param
+ * @param sendbuf - for the packets sent, publishes only take their header from it, the payload is sent from the caller's buffer
  */
 DLLExport void MQTTClientInit(MQTTClient* client, MQTT_Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size);
@@ -149,7 +171,8 @@ DLLExport void MQTTClientInit(MQTTClient* client, MQTT_Network* network, unsigne
  */
 DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
 
-/** MQTT Publish - send an MQTT publish packet and wait for all acks to complete for all QoSs
+/** MQTT Publish - send an MQTT publish packet and wait for all acks to complete for all QoSs,
+ *  except QoS1 publishes with a publish window set, which are acknowledged in the background
  *  @param client - the client object to use
  *  @param topic - the topic to publish to
  *  @param message - the message to send
@@ -157,6 +180,41 @@ DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
  */
 DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
 
+/** MQTT Publish window - give the client buffers to keep QoS1 publishes in until they are acknowledged,
+ *  so that they can be sent ahead of the PUBACKs of earlier ones.
+ *  Unacknowledged publishes are retransmitted after puback_timeout_ms, and after a reconnect.
+ *  @param client - the client object to use
+ *  @param buf - buffer for the publishes waiting for their PUBACK, each takes packet_size
+ *  @param buf_size - size of buf
+ *  @param packet_size - the largest publish packet, topic and header included, sent in the window
+ *  @param puback_timeout_ms - time to wait for a PUBACK before the publish is retransmitted
+ *  @return the window size available, also set as window
+ */
+DLLExport int MQTTClientInitWindow(MQTTClient* client, unsigned char* buf, size_t buf_size, size_t packet_size, unsigned int puback_timeout_ms);
+
+/** MQTT Publish window - set how many QoS1 publishes may wait for their PUBACK.
+ *  MQTTPublish then returns as soon as a QoS1 publish is sent, and only blocks while the window is full.
+ *  @param client - the client object to use
+ *  @param window - max number of publishes waiting for their PUBACK, 1 for stop-and-wait
+ *  @return the window size set, limited to the buffers given to MQTTClientInitWindow
+ */
+DLLExport int MQTTSetPublishWindow(MQTTClient* client, unsigned int window);
+
+/** MQTT Publish flush - wait for the PUBACKs of all publishes in the window
+ *  @param client - the client object to use
+ *  @param timeout_ms - the time, in milliseconds, to wait
+ *  @return success code
+ */
+DLLExport int MQTTPublishFlush(MQTTClient* client, int timeout_ms);
+
+/** MQTT Publish inflight - the number of publishes in the window still waiting for their PUBACK.
+ *  The server acknowledges QoS1 publishes in the order they were sent, so of the publishes
+ *  sent all but this many, the oldest, are delivered.
+ *  @param client - the client object to use
+ *  @return the number of unacknowledged publishes
+ */
+DLLExport int MQTTPublishInflight(MQTTClient* client);
+
 /** MQTT Subscribe - send an MQTT subscribe packet and wait for suback before returning.
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter to subscribe to
@@ -107,12 +107,25 @@ int MQTTFreeRTOS_Modem_Write( MQTT_Network* n, unsigned char* buffer, int len, i
     return written;
 }
 
+// the data goes out in the background, so the caller must leave it alone until it is acknowledged
+int MQTTFreeRTOS_Modem_WriteQueued( MQTT_Network* n, unsigned char* buffer, int len, int timeout_ms )
+{
+    int queued = Modem_writeQueued(buffer, len, timeout_ms);
+    if ((queued != len) && Modem_IsDCDEventFlagSet())
+    {
+         return FAILURE;
+    }
+
+    return queued;
+}
+
 void MQTTFreeRTOS_Modem_NetworkInit( MQTT_Network* n )
 {
     // TODO
     n->conn_p = NULL;
     n->mqttread = MQTTFreeRTOS_Modem_Read;
     n->mqttwrite = MQTTFreeRTOS_Modem_Write;
+    n->mqttwritequeued = MQTTFreeRTOS_Modem_WriteQueued;
     n->disconnect = MQTTFreeRTOS_Modem_Disconnect;
     //n->errorhandler = NULL;
     n->lastdata_p = NULL;
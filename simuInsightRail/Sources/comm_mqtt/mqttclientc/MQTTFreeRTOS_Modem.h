@@ -32,6 +32,7 @@ extern "C" {
 
 int MQTTFreeRTOS_Modem_Read( MQTT_Network*, unsigned char*, int, int );
 int MQTTFreeRTOS_Modem_Write( MQTT_Network*, unsigned char*, int, int );
+int MQTTFreeRTOS_Modem_WriteQueued( MQTT_Network*, unsigned char*, int, int );
 
 void MQTTFreeRTOS_Modem_NetworkInit( MQTT_Network* );
 int MQTTFreeRTOS_Modem_NetworkConnect( MQTT_Network*, char*, int );
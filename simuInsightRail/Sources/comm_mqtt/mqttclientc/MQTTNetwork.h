@@ -26,6 +26,7 @@ struct MQTT_Network
     void *conn_p;     // Points to network specific connection data (e.g. socket, netconn, etc.)
     int (*mqttread) (MQTT_Network*, unsigned char*, int, int);
     int (*mqttwrite) (MQTT_Network*, unsigned char*, int, int);
+    int (*mqttwritequeued) (MQTT_Network*, unsigned char*, int, int); // optional, returns before the data is sent
     void (*disconnect) (MQTT_Network*);
     void (*errorhandler) (MQTT_Network*, int);
     void *lastdata_p; // Holds last buffer
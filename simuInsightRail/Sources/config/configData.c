@@ -20,6 +20,7 @@ extern "C" {
 #include "DataDef.h"
 #include "configData.h" // project file with the project items to store
 #include "NvmConfig.h"
+#include "ExtFlash.h"
 
 #ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
 
@@ -28,6 +29,8 @@ extern "C" {
 
 #define TESTARRAYSIZE (4)
 #define TESTARRAYSIZEBIG (10)
+// the unit tests' arrays of every type, they all share the sample buffer
+#define TESTARRAYLENGTH(dd) ((MAX_RAM_SAMPLES * sizeof(int32_t)) / (DATADEFTYPE2SIZE(dd)))
 
 // some dummy stuff to test the svcdata/idef stuff
 bool    svcdata_bool;
@@ -118,9 +121,20 @@ uint64_t timestamp_env3;
 uint64_t timestamp_wheelflat;
 uint64_t timestamp_raw;
 
-//uint32_t extflash_env3_adress;// contains byte address where the envelope 3 waveform in external flash starts
-//uint32_t extflash_wheelflat_adress; // etc.
-//uint32_t extflash_raw_adress;
+// source of the waveform read through the MR_Acceleration_Env3/Wheel_Flat_Detect/Raw items (only one is uploaded at a time).
+// The int32 samples are scaled to float as they are read, either from RAM or streamed in pieces from external flash
+#define WAVEFORM_READ_AHEAD_SAMPLES (256)
+
+static struct {
+    const int32_t * samples_p;      // samples in RAM, NULL when streamed from external flash
+    float scaling;
+    uint32_t totalBytes;            // external flash only, size of the waveform
+    uint32_t bufByteOffset;         // waveform offset of buf[0]
+    uint32_t bufBytes;              // valid bytes in buf
+    int32_t buf[WAVEFORM_READ_AHEAD_SAMPLES];
+} waveformSource = { .samples_p = NULL, .totalBytes = 0 };
+
+extern tExtFlashHandle extFlashHandle;
 
 uint64_t currentIdefTime;// used for timestamping with the time of sending.
 
@@ -191,6 +205,7 @@ static bool samplesRawCheck(uint32_t * value_p)
     switch (*value_p) {
     case 16384:
     case 32768:
+    case 65536:// MAX_RAW_SAMPLES, more than the sample buffer holds, streamed to the external flash
         rc_ok = true;
         break;
     }
@@ -356,6 +371,19 @@ const DataDef_t sDataDef[] = {
     {SVCDATATEST_TIMESTAMPA,    INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  "svctest_datetimeA",    NULL,               (uint8_t *) &svcdata_datetimeA },
     {SVCDATATEST_TIMESTAMPB,    INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  "svctest_datetimeB",    NULL,               (uint8_t *) &svcdata_datetimeB },
     {SVCDATATEST_TIMESTAMPC,    INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  "svctest_datetimeC",    NULL,               (uint8_t *) &svcdata_datetimeC },
+    // read only, as they are views of the sampled data in the sample buffer
+    {SVCDATATEST_ARRAY_BOOL,    INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_BOOL), DD_TYPE_BOOL,       DD_R,   "svctest_array_bool",   NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_BYTE,    INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_BYTE), DD_TYPE_BYTE,       DD_R,   "svctest_array_byte",   NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_SBYTE,   INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_SBYTE), DD_TYPE_SBYTE,      DD_R,   "svctest_array_sbyte",  NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_INT16,   INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_INT16), DD_TYPE_INT16,      DD_R,   "svctest_array_int16",  NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_UINT16,  INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_UINT16), DD_TYPE_UINT16,     DD_R,   "svctest_array_uint16", NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_INT32,   INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_INT32), DD_TYPE_INT32,      DD_R,   "svctest_array_int32",  NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_UINT32,  INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_UINT32), DD_TYPE_UINT32,     DD_R,   "svctest_array_uint32", NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_INT64,   INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_INT64), DD_TYPE_INT64,      DD_R,   "svctest_array_int64",  NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_UINT64,  INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_UINT64), DD_TYPE_UINT64,     DD_R,   "svctest_array_uint64", NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_SINGLE,  INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_SINGLE), DD_TYPE_SINGLE,     DD_R,   "svctest_array_single", NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_DOUBLE,  INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_DOUBLE), DD_TYPE_DOUBLE,     DD_R,   "svctest_array_double", NULL,               (uint8_t *) __sample_buffer },
+    {SVCDATATEST_ARRAY_DATETIME,INT_RAM,        false,      TESTARRAYLENGTH(DD_TYPE_DATETIME), DD_TYPE_DATETIME,   DD_R,   "svctest_array_datetime", NULL,               (uint8_t *) __sample_buffer },
 
 #endif
     // {objectId,                   memId,       configObject,  length,             type,               rw,     cliName,                paramCheckPointer,  address,},
@@ -389,12 +417,19 @@ const DataDef_t sDataDef[] = {
     {MR_GNSS_Sat_Id,            INT_RAM,        false,      MAX_GNSS_SATELITES, DD_TYPE_BYTE,       DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.GNSS_Sat_Id[0] },
     {MR_GNSS_Sat_Snr,           INT_RAM,        false,      MAX_GNSS_SATELITES, DD_TYPE_BYTE,       DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.GNSS_Sat_Snr[0] },
     {MR_Timestamp_Env3,         INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  NULL,                   NULL,               (uint8_t *) &timestamp_env3 },
-    {MR_Acceleration_Env3,      INT_RAM,        false,      MAX_ENV3_SAMPLES,   DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) __sample_buffer/* &extflash_env3_adress */ },
+    {MR_Acceleration_Env3,      EXT_FLASH,      false,      MAX_ENV3_SAMPLES,   DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) &waveformSource },
     {MR_Timestamp__Wheel_Flat_Detect, INT_RAM,  false,      1,                  DD_TYPE_DATETIME,   DD_RW,  NULL,                   NULL,               (uint8_t *) &timestamp_wheelflat },
-    {MR_Acceleration_Wheel_Flat_Detect, INT_RAM,false,      MAX_FLAT_SAMPLES,   DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) __sample_buffer /*&extflash_wheelflat_adress */},
+    {MR_Acceleration_Wheel_Flat_Detect, EXT_FLASH,false,    MAX_FLAT_SAMPLES,   DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) &waveformSource },
     {MR_Timestamp_Raw,          INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  NULL,                   NULL,               (uint8_t *) &timestamp_raw },
-    {MR_Acceleration_Raw,       INT_RAM,        false,      MAX_RAW_SAMPLES,    DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) __sample_buffer /*&extflash_raw_adress */},
+    {MR_Acceleration_Raw,       EXT_FLASH,      false,      MAX_RAW_SAMPLES,    DD_TYPE_SINGLE,     DD_RW,  NULL,                   NULL,               (uint8_t *) &waveformSource },
+    // waveCodec compressed waveforms, coded over the samples so never longer than them
+    {MR_Acceleration_Env3_Packed, INT_RAM,      false,      MAX_ENV3_SAMPLES * sizeof(int32_t), DD_TYPE_BYTE, DD_RW, NULL,          NULL,               (uint8_t *) __sample_buffer },
+    {MR_Acceleration_Wheel_Flat_Detect_Packed, INT_RAM, false, MAX_FLAT_SAMPLES * sizeof(int32_t), DD_TYPE_BYTE, DD_RW, NULL,       NULL,               (uint8_t *) __sample_buffer },
+    {MR_Acceleration_Raw_Packed, INT_RAM,       false,      MAX_RAM_SAMPLES * sizeof(int32_t), DD_TYPE_BYTE, DD_RW, NULL,           NULL,               (uint8_t *) __sample_buffer },
     {MR_Is_Good_Speed_Diff,     INT_RAM,        false,      1,                  DD_TYPE_BOOL,       DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.Is_Good_Speed_Diff },
+    {MR_Features_Env3,          INT_RAM,        false,      MR_WAVE_FEATURES_LENGTH, DD_TYPE_SINGLE,  DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.Wave_Features[IS25_VIBRATION_DATA][0] },
+    {MR_Features_Wheel_Flat_Detect, INT_RAM,    false,      MR_WAVE_FEATURES_LENGTH, DD_TYPE_SINGLE,  DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.Wave_Features[IS25_WHEEL_FLAT_DATA][0] },
+    {MR_Features_Raw,           INT_RAM,        false,      MR_WAVE_FEATURES_LENGTH, DD_TYPE_SINGLE,  DD_RW,  NULL,                   NULL,               (uint8_t *) &measureRecord.params.Wave_Features[IS25_RAW_SAMPLED_DATA][0] },
 
 
     {CR_Com_timestamp,          INT_RAM,        false,      1,                  DD_TYPE_DATETIME,   DD_RW,  NULL,                   NULL,               (uint8_t *) &commsRecord.timestamp },
@@ -568,6 +603,98 @@ bool copyBytesRamToStore(const DataDef_t * dst_info, uint8_t byteOffset, uint8_t
 }
 
 
+/*
+ * configData_WaveformFromRam
+ *
+ * @desc    read the waveform items from samples in RAM
+ *
+ * @param   samples_p  the int32 samples
+ * @param   scaling    sample to float scaling
+ */
+void configData_WaveformFromRam(const int32_t * samples_p, float scaling)
+{
+    waveformSource.samples_p = samples_p;
+    waveformSource.scaling = scaling;
+    waveformSource.totalBytes = 0;
+}
+
+/*
+ * configData_WaveformFromFlash
+ *
+ * @desc    read the waveform items straight from an external flash dataset element, in pieces while they are encoded,
+ *          so the upload does not have to wait for the whole waveform to be read and needs no sample buffer.
+ *          The waveform must be read in order, its CRC is checked when the last sample is read.
+ *
+ * @param   dataType   the waveform's dataset element, e.g. IS25_RAW_SAMPLED_DATA
+ * @param   dataSet    the dataset index
+ * @param   scaling    sample to float scaling
+ *
+ * @returns # of samples, or negative external flash error code
+ */
+int configData_WaveformFromFlash(uint32_t dataType, uint16_t dataSet, float scaling)
+{
+    int bytes = extFlash_readStreamOpen(&extFlashHandle, dataType, dataSet, EXTFLASH_MAXWAIT_MS);
+
+    waveformSource.samples_p = NULL;
+    waveformSource.scaling = scaling;
+    waveformSource.totalBytes = (bytes > 0) ? bytes : 0;
+    waveformSource.bufByteOffset = 0;
+    waveformSource.bufBytes = 0;
+
+    return (bytes < 0) ? bytes : (int)(bytes / sizeof(int32_t));
+}
+
+/*
+ * readWaveform
+ *
+ * @desc    copy waveform samples as floats
+ *
+ * @param   dst_p      destination
+ * @param   byteOffset offset in bytes relative to the start of the waveform
+ * @param   count      number of bytes to copy
+ *
+ * @returns false  on failure, e.g. going back in a waveform streamed from external flash, or a flash read/CRC error
+ */
+static bool readWaveform(float *dst_p, uint32_t byteOffset, uint32_t count)
+{
+    uint32_t idx;
+
+    if (waveformSource.samples_p) {
+        for (idx = 0; idx < count / sizeof(int32_t); idx++) {
+            dst_p[idx] = waveformSource.samples_p[(byteOffset / sizeof(int32_t)) + idx] * waveformSource.scaling;
+        }
+        return true;
+    }
+
+    if (((byteOffset + count) > waveformSource.totalBytes) || (byteOffset < waveformSource.bufByteOffset)) {
+        return false;
+    }
+
+    while (count) {
+        if (byteOffset >= (waveformSource.bufByteOffset + waveformSource.bufBytes)) {
+            // read ahead the next piece
+            int bytesRead;
+
+            waveformSource.bufByteOffset += waveformSource.bufBytes;
+            waveformSource.bufBytes = 0;
+            bytesRead = extFlash_readStream(&extFlashHandle, (uint8_t *) waveformSource.buf, sizeof(waveformSource.buf), EXTFLASH_MAXWAIT_MS);
+            if (bytesRead <= 0) {
+                LOG_DBG( LOG_LEVEL_COMM, "readWaveform: flash read at %d failed: %s\n", waveformSource.bufByteOffset, extFlash_ErrorString(bytesRead));
+                waveformSource.totalBytes = 0;// no way to continue
+                return false;
+            }
+            waveformSource.bufBytes = bytesRead;
+            continue;
+        }
+
+        idx = (byteOffset - waveformSource.bufByteOffset) / sizeof(int32_t);
+        *dst_p++ = waveformSource.buf[idx] * waveformSource.scaling;
+        byteOffset += sizeof(int32_t);
+        count -= (count < sizeof(int32_t)) ? count : sizeof(int32_t);
+    }
+    return true;
+}
+
 /*
  * copyBytesStoreToRam
  *
@@ -596,18 +723,8 @@ bool copyBytesStoreToRam(uint8_t *ram_p, const DataDef_t * src_info, uint32_t by
         break;
 
     case EXT_FLASH:
-        // not implemented (yet)
-        {
-         // uint32_t startAddress = *( (uint32_t *) src_info->address);
-        // dst_info->address points , in this EXT_FLASH case, to a uint32_t variable which holds the starting address
-        // startPage?? = *( (uint32_t *) dst_info->address); // what if we want to read starting halfway a page ???
-        // datalength = count
-        // destAddress = ram_p
-        // retval = IS25_NormalRead(startPage, destAddress, dataLength);
-
-        // printf("copyBytesStoreToRam: here should be a function to read from EXT_FLASH address %08x, %04x bytes\n", startAddress+byteOffset, count);
-        }
-        // rc_ok = false;
+        // only the waveforms live here (src_info->address points to their source), as int32 samples which are read as floats
+        rc_ok = (src_info->type == DD_TYPE_SINGLE) && readWaveform((float *) ram_p, byteOffset, count);
         break;
 
     case PROGRAM_FLASH:
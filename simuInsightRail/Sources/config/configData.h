@@ -27,9 +27,21 @@ extern "C" {
 // The values I made up without knowing what the real limit should be, so adapt !
 #define MAX_ENV3_SAMPLES        (1024*4)
 #define MAX_FLAT_SAMPLES        (1024*4)
-#define MAX_RAW_SAMPLES         (1024*32)
+// a raw waveform fills up to the 256 KB RAW dataset element in the external flash, which is more
+// than the sample buffer holds, as it is streamed to the flash while it is sampled
+#define MAX_RAW_SAMPLES         (1024*64)
+// samples the sample buffer holds (SAMPLE_BUFFER_SIZE_WORDS), for the items that are views of it
+#define MAX_RAM_SAMPLES         (1024*32)
 
 #define MAXCARDINALDIRECTIONLENGTH (1)
+
+// waveform features of the measurement record (see PassRailFeatures.h), per
+// waveform type raw, env3, wheel flat (indexed by the IS25 data type): rms,
+// crest factor, kurtosis, the 4 band energies, the 4 order energies, and the
+// frequency of the largest spectral peak. N.B. the record is stored in the
+// 0x100 bytes before the dataset's record details, which these fill
+#define MR_WAVE_FEATURES_TYPES  (3)
+#define MR_WAVE_FEATURES_LENGTH (12)
 #define MAXSTATUSSELFTESTLENGTH (20)
 
 // Define the minimum value of upload repeat, in secs.
@@ -63,6 +75,8 @@ typedef struct {
 
         uint8_t GNSS_Sat_Id[MAX_GNSS_SATELITES];
         uint8_t GNSS_Sat_Snr[MAX_GNSS_SATELITES];
+        // all zero for a waveform which wasn't measured
+        float Wave_Features[MR_WAVE_FEATURES_TYPES][MR_WAVE_FEATURES_LENGTH];
 #if 0
         // measurement settings used for the waveform data, will become active after TG5 because it needs needs new IDEF parameters
         // (quick fix for TG5, but Roland has to do also some work for that and don't want this now !)
@@ -268,6 +282,18 @@ typedef enum {
     SVCDATATEST_DATETIME,
     SVCDATATEST_UINT32A,
     SVCDATATEST_UINT32ABIG,
+    SVCDATATEST_ARRAY_BOOL,
+    SVCDATATEST_ARRAY_BYTE,
+    SVCDATATEST_ARRAY_SBYTE,
+    SVCDATATEST_ARRAY_INT16,
+    SVCDATATEST_ARRAY_UINT16,
+    SVCDATATEST_ARRAY_INT32,
+    SVCDATATEST_ARRAY_UINT32,
+    SVCDATATEST_ARRAY_INT64,
+    SVCDATATEST_ARRAY_UINT64,
+    SVCDATATEST_ARRAY_SINGLE,
+    SVCDATATEST_ARRAY_DOUBLE,
+    SVCDATATEST_ARRAY_DATETIME,
 #endif
 
     // MR: short for Measurement Record (see parameter table
@@ -297,6 +323,12 @@ typedef enum {
     MR_Acceleration_Wheel_Flat_Detect,
     MR_Timestamp_Raw,
     MR_Acceleration_Raw,
+    MR_Acceleration_Env3_Packed,
+    MR_Acceleration_Wheel_Flat_Detect_Packed,
+    MR_Acceleration_Raw_Packed,
+    MR_Features_Env3,
+    MR_Features_Wheel_Flat_Detect,
+    MR_Features_Raw,
 
 //  CR: Communications Record
 
@@ -425,6 +457,8 @@ extern const DataDef_t sDataDef[] ;
 uint32_t getNrDataDefElements();
 bool copyBytesRamToStore(const DataDef_t * dst_info, uint8_t byteOffset, uint8_t *ram_p, uint32_t count, bool su);
 bool copyBytesStoreToRam(uint8_t *ram_p, const DataDef_t * src_info, uint32_t byteOffset,  uint32_t count);
+void configData_WaveformFromRam(const int32_t * samples_p, float scaling);
+int configData_WaveformFromFlash(uint32_t dataType, uint16_t dataSet, float scaling);
 
 
 #endif /* SOURCES_DATASTORE_CONFIGDATA_H_ */
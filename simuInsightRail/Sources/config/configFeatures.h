@@ -45,6 +45,25 @@ extern "C" {
 
 #define CONFIG_PLATFORM_NFC
 
+// trace points in the hot paths, see the "trace" CLI command
+#define CONFIG_PLATFORM_TRACE
+
+// DSP benchmark, see the "dspbench" CLI command. Its reference model is double
+// precision, which the MCU runs in software, so it is only built in the
+// simulator unless defined for a benchmark build of the target
+#ifdef _MSC_VER
+#define CONFIG_PLATFORM_DSPBENCH
+#endif
+
+// streaming waveform features, calculated while sampling and uploaded with the
+// measurement record. They take about 6.5 KB of RAM
+#define CONFIG_PLATFORM_WAVE_FEATURES
+
+// a waveform upload broken off part way resumes at its first unacknowledged block in
+// the next upload session. That needs the server to join the blocks of both sessions,
+// which it is not known to do, so without it the waveform is sent again from block 0
+//#define CONFIG_PLATFORM_UPLOAD_BLOCK_RESUME
+
 #endif /* SOURCES_CONFIG_CONFIGFEATURES_H_ */
 
 
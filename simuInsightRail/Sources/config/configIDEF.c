@@ -57,6 +57,18 @@ static const SvcDataParamValue_t svcIdefDataStoreId[] = {
         { IDEFTEST_STRING , SVCDATATEST_STRING},
         { IDEFTEST_UINT32A , SVCDATATEST_UINT32A},
         { IDEFTEST_UINT32ABIG , SVCDATATEST_UINT32ABIG},
+        { IDEFTEST_ARRAY_BOOL , SVCDATATEST_ARRAY_BOOL},
+        { IDEFTEST_ARRAY_BYTE , SVCDATATEST_ARRAY_BYTE},
+        { IDEFTEST_ARRAY_SBYTE , SVCDATATEST_ARRAY_SBYTE},
+        { IDEFTEST_ARRAY_INT16 , SVCDATATEST_ARRAY_INT16},
+        { IDEFTEST_ARRAY_UINT16 , SVCDATATEST_ARRAY_UINT16},
+        { IDEFTEST_ARRAY_INT32 , SVCDATATEST_ARRAY_INT32},
+        { IDEFTEST_ARRAY_UINT32 , SVCDATATEST_ARRAY_UINT32},
+        { IDEFTEST_ARRAY_INT64 , SVCDATATEST_ARRAY_INT64},
+        { IDEFTEST_ARRAY_UINT64 , SVCDATATEST_ARRAY_UINT64},
+        { IDEFTEST_ARRAY_SINGLE , SVCDATATEST_ARRAY_SINGLE},
+        { IDEFTEST_ARRAY_DOUBLE , SVCDATATEST_ARRAY_DOUBLE},
+        { IDEFTEST_ARRAY_DATETIME , SVCDATATEST_ARRAY_DATETIME},
         { IDEFTEST_DATETIME , SVCDATATEST_DATETIME},
 #endif
 
@@ -172,6 +184,12 @@ static const SvcDataParamValue_t svcIdefDataStoreId[] = {
         {   IDEFPARAMID_ICCID                                           , CR_ICCID},
         {   IDEFPARAMID_TRAIN_NAME                                      , AR_Train_Name},
         {   IDEFPARAMID_BOGIE_NUMBER_IN_WAGON                           , AR_Bogie_Number_In_Wagon},
+        {   IDEFPARAMID_ACCELERATION_ENV3_PACKED                        , MR_Acceleration_Env3_Packed},
+        {   IDEFPARAMID_ACCELERATION_WHEEL_FLAT_DETECT_PACKED           , MR_Acceleration_Wheel_Flat_Detect_Packed},
+        {   IDEFPARAMID_ACCELERATION_RAW_PACKED                         , MR_Acceleration_Raw_Packed},
+        {   IDEFPARAMID_FEATURES_ENV3                                   , MR_Features_Env3},
+        {   IDEFPARAMID_FEATURES_WHEEL_FLAT_DETECT                      , MR_Features_Wheel_Flat_Detect},
+        {   IDEFPARAMID_FEATURES_RAW                                    , MR_Features_Raw},
 
 };
 
@@ -274,6 +292,11 @@ static const IDEF_paramid_t IdefParamMeasureList01[] = {
         IDEFPARAMID_GNSS_TIME_DIFF,
         IDEFPARAMID_GNSS_SAT_ID,
         IDEFPARAMID_GNSS_SAT_SNR,
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+        IDEFPARAMID_FEATURES_ENV3,
+        IDEFPARAMID_FEATURES_WHEEL_FLAT_DETECT,
+        IDEFPARAMID_FEATURES_RAW,
+#endif
 #if 0
         // these are the configuration parameters (quick fix for TG5,)
         // actually these should not be used, we want actually send the configuration parameters used during the measurement,
@@ -303,11 +326,27 @@ static const IDEF_paramid_t IdefParamMeasureList04[] = {
         IDEFPARAMID_ACCELERATION_RAW,
  };
 
+// the same waveforms, compressed with waveCodec
+static const IDEF_paramid_t IdefParamMeasureList05[] = {
+        IDEFPARAMID_ACCELERATION_ENV3_PACKED,
+};
+
+static const IDEF_paramid_t IdefParamMeasureList06[] = {
+        IDEFPARAMID_ACCELERATION_WHEEL_FLAT_DETECT_PACKED,
+};
+
+static const IDEF_paramid_t IdefParamMeasureList07[] = {
+        IDEFPARAMID_ACCELERATION_RAW_PACKED,
+};
+
 static const SvcDataParamValueGroup_t idefParamValueMeasureRecords[]= {
         { MR_Timestamp,         sizeof(IdefParamMeasureList01)/sizeof(*IdefParamMeasureList01), (IDEF_paramid_t *)  IdefParamMeasureList01 },
         { MR_Timestamp_Env3,    sizeof(IdefParamMeasureList02)/sizeof(*IdefParamMeasureList02), (IDEF_paramid_t *)   IdefParamMeasureList02 },
         { MR_Timestamp__Wheel_Flat_Detect, sizeof(IdefParamMeasureList03)/sizeof(*IdefParamMeasureList03), (IDEF_paramid_t *)   IdefParamMeasureList03 },
         { MR_Timestamp_Raw,     sizeof(IdefParamMeasureList04)/sizeof(*IdefParamMeasureList04), (IDEF_paramid_t *)   IdefParamMeasureList04 },
+        { MR_Timestamp_Env3,    sizeof(IdefParamMeasureList05)/sizeof(*IdefParamMeasureList05), (IDEF_paramid_t *)   IdefParamMeasureList05 },
+        { MR_Timestamp__Wheel_Flat_Detect, sizeof(IdefParamMeasureList06)/sizeof(*IdefParamMeasureList06), (IDEF_paramid_t *)   IdefParamMeasureList06 },
+        { MR_Timestamp_Raw,     sizeof(IdefParamMeasureList07)/sizeof(*IdefParamMeasureList07), (IDEF_paramid_t *)   IdefParamMeasureList07 },
 
 };
 
@@ -450,6 +489,9 @@ const SvcDataData_t idefDataDataRecords[] = {
  /* signon record       */      {1, (SvcDataParamValueGroup_t *) &idefParamValueSignOnRecords[0], NULL },
  /* deviceSettings      */      {1, (SvcDataParamValueGroup_t *) &idefParamValueDeviceSettingsRecords[0], NULL },
  /* signon+deviceSettings */    {sizeof(idefParamValueSignOnDeviceSettingsRecords)/sizeof(SvcDataParamValueGroup_t), (SvcDataParamValueGroup_t *) &idefParamValueSignOnDeviceSettingsRecords[0], NULL },
+ /* waveform_env3 packed */     {1, (SvcDataParamValueGroup_t *) &idefParamValueMeasureRecords[4], NULL },
+ /* waveform_wheelflat packed */{1, (SvcDataParamValueGroup_t *) &idefParamValueMeasureRecords[5], NULL },
+ /* waveform_raw packed */      {1, (SvcDataParamValueGroup_t *) &idefParamValueMeasureRecords[6], NULL },
 };
 
 
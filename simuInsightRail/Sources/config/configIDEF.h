@@ -235,6 +235,9 @@ typedef enum ePredefinedIdefDatasets {
     IDEF_dataSignon = 5,
     IDEF_dataDeviceSettings = 6,
     IDEF_dataSignonDeviceSettings = 7,
+    IDEF_dataWaveformEnv3Packed = 8,
+    IDEF_dataWaveformWheelflatPacked = 9,
+    IDEF_dataWaveformRawPacked = 10,
 } tPredefinedIdefDatasets;
 
 uint32_t SvcData_IdefIdToDataStoreId(uint32_t IdefId);
@@ -132,6 +132,12 @@ const char * IDEF_paramid_to_str(IDEF_paramid_t e){
 	((e) == IDEFPARAMID_SCALING_WHEEL_FLAT                      ) ? "SCALING_WHEEL_FLAT" :
 	((e) == IDEFPARAMID_TRAIN_NAME                              ) ? "TRAIN_NAME" :
 	((e) == IDEFPARAMID_BOGIE_NUMBER_IN_WAGON                   ) ? "BOGIE_NUMBER_IN_WAGON" :
+	((e) == IDEFPARAMID_ACCELERATION_ENV3_PACKED                ) ? "ACCELERATION_ENV3_PACKED" :
+	((e) == IDEFPARAMID_ACCELERATION_WHEEL_FLAT_DETECT_PACKED   ) ? "ACCELERATION_WHEEL_FLAT_DETECT_PACKED" :
+	((e) == IDEFPARAMID_ACCELERATION_RAW_PACKED                 ) ? "ACCELERATION_RAW_PACKED" :
+	((e) == IDEFPARAMID_FEATURES_ENV3                           ) ? "FEATURES_ENV3" :
+	((e) == IDEFPARAMID_FEATURES_WHEEL_FLAT_DETECT              ) ? "FEATURES_WHEEL_FLAT_DETECT" :
+	((e) == IDEFPARAMID_FEATURES_RAW                            ) ? "FEATURES_RAW" :
 #ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
 	((e) == IDEFTEST_BOOL                                    ) ? "BOOL" :
 	((e) == IDEFTEST_BYTE                                    ) ? "BYTE" :
@@ -148,6 +154,18 @@ const char * IDEF_paramid_to_str(IDEF_paramid_t e){
 	((e) == IDEFTEST_DATETIME                                ) ? "DATETIME" :
 	((e) == IDEFTEST_UINT32A                                 ) ? "UINT32A" :
 	((e) == IDEFTEST_UINT32ABIG                              ) ? "UINT32ABIG" :
+	((e) == IDEFTEST_ARRAY_BOOL                              ) ? "ARRAY_BOOL" :
+	((e) == IDEFTEST_ARRAY_BYTE                              ) ? "ARRAY_BYTE" :
+	((e) == IDEFTEST_ARRAY_SBYTE                             ) ? "ARRAY_SBYTE" :
+	((e) == IDEFTEST_ARRAY_INT16                             ) ? "ARRAY_INT16" :
+	((e) == IDEFTEST_ARRAY_UINT16                            ) ? "ARRAY_UINT16" :
+	((e) == IDEFTEST_ARRAY_INT32                             ) ? "ARRAY_INT32" :
+	((e) == IDEFTEST_ARRAY_UINT32                            ) ? "ARRAY_UINT32" :
+	((e) == IDEFTEST_ARRAY_INT64                             ) ? "ARRAY_INT64" :
+	((e) == IDEFTEST_ARRAY_UINT64                            ) ? "ARRAY_UINT64" :
+	((e) == IDEFTEST_ARRAY_SINGLE                            ) ? "ARRAY_SINGLE" :
+	((e) == IDEFTEST_ARRAY_DOUBLE                            ) ? "ARRAY_DOUBLE" :
+	((e) == IDEFTEST_ARRAY_DATETIME                          ) ? "ARRAY_DATETIME" :
 #endif /* CONFIG_PLATFORM_IDEFSVCTESTDATA */
 		"unknown";
 }
@@ -157,6 +157,12 @@ typedef enum idefparamid_enum {
 	IDEFPARAMID_SCALING_WHEEL_FLAT                              = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x0436),
 	IDEFPARAMID_TRAIN_NAME                                      = IDEFPARAMID_ENUMVALUE(IDEFPROPID_OPERATING_CONDITION             ,0x0437),
 	IDEFPARAMID_BOGIE_NUMBER_IN_WAGON                           = IDEFPARAMID_ENUMVALUE(IDEFPROPID_OPERATING_CONDITION             ,0x0438),
+	IDEFPARAMID_ACCELERATION_ENV3_PACKED                        = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x0439),
+	IDEFPARAMID_ACCELERATION_WHEEL_FLAT_DETECT_PACKED           = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x043a),
+	IDEFPARAMID_ACCELERATION_RAW_PACKED                         = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x043b),
+	IDEFPARAMID_FEATURES_ENV3                                   = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x043c),
+	IDEFPARAMID_FEATURES_WHEEL_FLAT_DETECT                      = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x043d),
+	IDEFPARAMID_FEATURES_RAW                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VIBRATION                       ,0x043e),
 #ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
 	IDEFTEST_BOOL                                            = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf000),
 	IDEFTEST_BYTE                                            = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf001),
@@ -173,6 +179,18 @@ typedef enum idefparamid_enum {
 	IDEFTEST_DATETIME                                        = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf00c),
 	IDEFTEST_UINT32A                                         = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf00d),
 	IDEFTEST_UINT32ABIG                                      = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf00e),
+	IDEFTEST_ARRAY_BOOL                                      = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf00f),
+	IDEFTEST_ARRAY_BYTE                                      = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf010),
+	IDEFTEST_ARRAY_SBYTE                                     = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf011),
+	IDEFTEST_ARRAY_INT16                                     = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf012),
+	IDEFTEST_ARRAY_UINT16                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf013),
+	IDEFTEST_ARRAY_INT32                                     = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf014),
+	IDEFTEST_ARRAY_UINT32                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf015),
+	IDEFTEST_ARRAY_INT64                                     = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf016),
+	IDEFTEST_ARRAY_UINT64                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf017),
+	IDEFTEST_ARRAY_SINGLE                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf018),
+	IDEFTEST_ARRAY_DOUBLE                                    = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf019),
+	IDEFTEST_ARRAY_DATETIME                                  = IDEFPARAMID_ENUMVALUE(IDEFPROPID_VERIFICATION                    ,0xf01a),
 #endif /* CONFIG_PLATFORM_IDEFSVCTESTDATA */
 } IDEF_paramid_t;
 
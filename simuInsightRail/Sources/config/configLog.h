@@ -22,7 +22,9 @@ extern "C" {
 #include "EventLog.h"
 //from linker scripts
 extern uint32_t __event_log[] ,
-        __eventlog_size;
+        __eventlog_size,
+        __eventlog_ram[],		// not initialised, kept over a warm reset
+        __eventlog_ram_size;
 
 //#define DEBUGPRINTKEY
 
@@ -71,6 +73,13 @@ extern uint32_t __event_log[] ,
 	LOG_LEVEL_PMIC  \
 )
 
+/*
+ * LOG_DBG output ring, and the rate of messages per module (bit of the level) over which they are dropped
+ */
+#define LOG_DBG_RING_SIZE		(2048)	// a power of 2
+#define LOG_DBG_RATE_PER_SEC	(50)
+#define LOG_DBG_RATE_BURST		(100)
+
 /*
  * LEVEL to STRING macro for CLI 'log' command
  */
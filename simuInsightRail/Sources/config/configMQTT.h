@@ -15,9 +15,18 @@ extern "C" {
 #include "NvmConfig.h"
 
 /* Buffer sizes */
-#define CONFIG_MQTT_SEND_BUFFER_SIZE             (2048*2)	//(1024)
+#define CONFIG_MQTT_MAX_PUBLISH_SIZE             (2048*2)	// largest publish packet, header & topic included
+#define CONFIG_MQTT_SEND_BUFFER_SIZE             (256)		// control packets and publish headers only, payloads are sent from the caller's buffer
 #define CONFIG_MQTT_RECV_BUFFER_SIZE             (2048*2)	//(1024)
 
+/* publish header: fixed header (1 + 2 length bytes), topic length and packet id */
+#define CONFIG_MQTT_PUBLISH_OVERHEAD             (1 + 2 + 2 + 2 + MQTT_MAX_TOPIC_LEN)
+
+/* QoS1 publishes sent ahead of their PUBACK, each takes CONFIG_MQTT_MAX_PUBLISH_SIZE of RAM to retransmit it from.
+ * 1 is stop-and-wait, which needs no buffer - data is published at QoS0 by default, so raise it only for QoS1 builds */
+#define CONFIG_MQTT_PUBLISH_WINDOW               (1)
+#define CONFIG_MQTT_PUBACK_TIMEOUT_MS            (20000)	// a full send buffer takes seconds on a 2G link
+
 #define MQTT_MAX_TOPIC_LEN  (MQTT_TOPIC_PREFIX_LEN + MQTT_DEVICEID_LEN)
 
 #if 0
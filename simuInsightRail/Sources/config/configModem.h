@@ -21,6 +21,9 @@ extern "C" {
 // unfortunately, also the IRQ vectors must be set
 #define MODEM_UART_RX_TX_IRQhandler UART1_RX_TX_IRQHandler
 #define MODEM_UART_ERR_IRQhandler UART1_ERR_IRQHandler
+// and the DMA request sources of its receiver and transmitter
+#define MODEM_UART_EDMA_RX_REQUEST kDmaRequestMux0UART1Rx
+#define MODEM_UART_EDMA_TX_REQUEST kDmaRequestMux0UART1Tx
 
 // functions to power the modem on and off
 bool configModem_PowerOn(void);
@@ -22,6 +22,8 @@ extern "C" {
 #include <FreeRTOS.h>
 #include "Vbat.h"
 #include "Resources.h"
+#include "TaskStats.h"
+#include "ModemIo.h"
 
 /*
  * Functions
@@ -74,7 +76,10 @@ void RTOS_vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
 void RTOS_vApplicationTickHook(void)
 {
   /* Called for every RTOS tick. */
-  /* Write your code here ... */
+  /* Keeps the run time counter up to date with the cycle counter, also when no task switches */
+  (void)TaskStats_GetRunTimeCounter();
+  /* Switches the modem idle line interrupt on again after short bursts */
+  ModemIo_TickISR();
 }
 
 /*
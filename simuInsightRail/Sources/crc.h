@@ -21,6 +21,17 @@ void crc32_calc(void *pBuff, uint32_t length);
 uint32_t crc32_finish(void);
 uint32_t crc32_hardware(void *pBuff, uint32_t length);
 
+// Incremental CRC32, same result as crc32_hardware() but can be updated piece
+// by piece, and alongside other CRC calculations
+typedef struct
+{
+	uint32_t crc;		// running CRC, before the final inversion
+} crc32Context_t;
+
+void crc32_ctxInit(crc32Context_t *ctx_p);
+void crc32_ctxUpdate(crc32Context_t *ctx_p, const void *pBuff, uint32_t length);
+uint32_t crc32_ctxFinish(const crc32Context_t *ctx_p);
+
 
 #endif /* SOURCES_CRC_H_ */
 
@@ -39,6 +39,7 @@ extern "C" {
 #include "../CUnit/Basic.h"
 #include "UnitTest.h"
 #include "device.h"
+#include "configFeatures.h"
 
 extern void CU_automated_enable_junit_xml(CU_BOOL);
 extern void CU_automated_run_tests(void);
@@ -56,6 +57,14 @@ extern CUnit_suite_t UTNVMConfig;
 extern CUnit_suite_t UTpmic;
 extern CUnit_suite_t UTbinaryCLI;
 extern CUnit_suite_t UTalarms;
+extern CUnit_suite_t UTdecimfilt;
+extern CUnit_suite_t UTdspfrontend;
+extern CUnit_suite_t UTfeatures;
+extern CUnit_suite_t UTwavecodec;
+extern CUnit_suite_t UTmqttwindow;
+extern CUnit_suite_t UTsvcdataplan;
+extern CUnit_suite_t UTpbsinglepass;
+extern CUnit_suite_t UTmodemio;
 
 CUnit_suite_t *suites[] = {
 	&UTbasic,
@@ -70,6 +79,18 @@ CUnit_suite_t *suites[] = {
 	&UTpmic,
 	&UTbinaryCLI,
 	&UTalarms,
+	&UTdecimfilt,
+	&UTdspfrontend,
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+	&UTfeatures,
+#endif
+	&UTwavecodec,
+	&UTmqttwindow,
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+	&UTsvcdataplan,
+	&UTpbsinglepass,
+#endif
+	&UTmodemio,
 	NULL
 };
 
@@ -0,0 +1,225 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_DecimFilt.c
+ *
+ * Checks that the symmetry-folding decimation engine in PassRailDecimFilt.c
+ * is bit-exact with the CMSIS-DSP arm_fir_decimate_q31() it replaced, also
+ * when streaming input blocks which aren't a multiple of the decimation factor.
+ */
+
+#include <string.h>
+#include "UnitTest.h"
+#include "arm_math.h"
+#include "PassRailDSP.h"
+#include "PassRailDecimFilt.h"
+#include "AdcApiDefs.h"
+
+// Reference blocks are 160 samples (a multiple of every decimation factor),
+// and the test stream length is a multiple of both 160 and 128
+#define UT_DECIMFILT_MAX_BLOCKSIZE  (160)
+#define UT_DECIMFILT_STREAM_LEN     (1280)
+
+void testDecimFiltProductionFilters(void);
+void testDecimFiltHalfBand(void);
+void testDecimFiltNonSymmetric(void);
+void testDecimFiltOddBlockSizes(void);
+void testDecimFiltInPlaceInput(void);
+void testDecimFiltBadParams(void);
+
+CUnit_suite_t UTdecimfilt = {
+	{ "decimfilt", NULL, NULL, CU_TRUE, "test DSP decimation filter engine"},
+	{
+		{ "production filters bit-exact", testDecimFiltProductionFilters },
+		{ "half-band filter bit-exact", testDecimFiltHalfBand },
+		{ "non-symmetric filter bit-exact", testDecimFiltNonSymmetric },
+		{ "odd streaming block sizes", testDecimFiltOddBlockSizes },
+		{ "input written in-place", testDecimFiltInPlaceInput },
+		{ "invalid parameters rejected", testDecimFiltBadParams },
+		{ NULL, NULL }
+	}
+};
+
+static q31_t refState[UT_DECIMFILT_MAX_BLOCKSIZE + DECIMFILT_MAX_TAPS - 1];
+static q31_t testState[UT_DECIMFILT_MAX_BLOCKSIZE + DECIMFILT_MAX_TAPS - 1];
+static q31_t inStream[UT_DECIMFILT_STREAM_LEN];
+static q31_t refOut[UT_DECIMFILT_STREAM_LEN];
+static q31_t testOut[UT_DECIMFILT_STREAM_LEN];
+static uint32_t lcgSeed;
+
+/*
+ * Pseudo-random full-scale 24-bit signed sample, right-justified as the
+ * AD7766 samples are in the DSP chain
+ */
+static q31_t nextSample(void)
+{
+	lcgSeed = (lcgSeed * 1664525u) + 1013904223u;
+	return ((int32_t)lcgSeed) >> 8;
+}
+
+/*
+ * Decimate the same input stream with arm_fir_decimate_q31() in 160-sample
+ * blocks, and with DecimFilt_Process() in streamBlockSize blocks, then count
+ * the output samples which differ. If inPlace, then each block is written
+ * into DecimFilt_GetInputBuffer() first, as the DSP chain does.
+ */
+static uint32_t compareWithReference(const q31_t *pCoeffs, uint16_t numTaps,
+									 uint8_t factor, uint32_t streamBlockSize,
+									 bool inPlace)
+{
+	const q31_t *pSrc;
+	arm_fir_decimate_instance_q31 ref;
+	DecimFiltInstanceType test;
+	uint32_t refBlockSize = (UT_DECIMFILT_MAX_BLOCKSIZE / factor) * factor;
+	uint32_t numRefOut = 0;
+	uint32_t numTestOut = 0;
+	uint32_t mismatches = 0;
+	uint32_t pos;
+	uint32_t len;
+
+	memset(refState, 0, sizeof(refState));
+	CU_ASSERT_FATAL(ARM_MATH_SUCCESS == arm_fir_decimate_init_q31(&ref, numTaps, factor,
+											(q31_t *)pCoeffs, refState, refBlockSize));
+	CU_ASSERT_FATAL(DecimFilt_Init(&test, numTaps, factor, pCoeffs, testState, streamBlockSize));
+
+	lcgSeed = numTaps;
+	for(pos = 0; pos < UT_DECIMFILT_STREAM_LEN; pos++)
+	{
+		inStream[pos] = nextSample();
+	}
+
+	for(pos = 0; (pos + refBlockSize) <= UT_DECIMFILT_STREAM_LEN; pos += refBlockSize)
+	{
+		arm_fir_decimate_q31(&ref, &inStream[pos], &refOut[numRefOut], refBlockSize);
+		numRefOut += refBlockSize / factor;
+	}
+
+	for(pos = 0; pos < UT_DECIMFILT_STREAM_LEN; pos += len)
+	{
+		len = UT_DECIMFILT_STREAM_LEN - pos;
+		if(len > streamBlockSize)
+		{
+			len = streamBlockSize;
+		}
+		pSrc = &inStream[pos];
+		if(inPlace)
+		{
+			memcpy(DecimFilt_GetInputBuffer(&test), pSrc, len * sizeof(q31_t));
+			pSrc = DecimFilt_GetInputBuffer(&test);
+		}
+		numTestOut += DecimFilt_Process(&test, pSrc, len, &testOut[numTestOut]);
+	}
+
+	// the reference may drop a partial final block
+	CU_ASSERT(numTestOut >= numRefOut);
+	for(pos = 0; pos < numRefOut; pos++)
+	{
+		if(refOut[pos] != testOut[pos])
+		{
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+void testDecimFiltProductionFilters(void)
+{
+	const int32_t *pCoeffs;
+	uint16_t numTaps;
+	uint8_t factor;
+	uint32_t blockSize;
+	uint8_t index = 0;
+
+	while(PassRailDsp_GetDecimFilt(index, &pCoeffs, &numTaps, &factor, &blockSize))
+	{
+		CU_ASSERT(blockSize <= UT_DECIMFILT_MAX_BLOCKSIZE);
+		if(blockSize <= UT_DECIMFILT_MAX_BLOCKSIZE)
+		{
+			CU_ASSERT(0 == compareWithReference(pCoeffs, numTaps, factor, blockSize, false));
+		}
+		index++;
+	}
+	CU_ASSERT(index > 0);
+}
+
+void testDecimFiltHalfBand(void)
+{
+	// 11-tap half-band shape - every other tap (apart from the centre) is zero
+	static const q31_t halfBand[] = {
+		-21474836, 0, 107374182, 0, -322122547, 1073741824,
+		-322122547, 0, 107374182, 0, -21474836
+	};
+	DecimFiltInstanceType test;
+
+	CU_ASSERT(0 == compareWithReference(halfBand, sizeof(halfBand)/sizeof(halfBand[0]), 2, 13, false));
+
+	CU_ASSERT_FATAL(DecimFilt_Init(&test, sizeof(halfBand)/sizeof(halfBand[0]), 2, halfBand, testState, 16));
+	CU_ASSERT(test.bSymmetric && test.bHasZeroTaps);
+	CU_ASSERT(3 == test.NumNonZeroFoldedTaps);
+}
+
+void testDecimFiltNonSymmetric(void)
+{
+	static const q31_t skewed[] = {
+		100000000, 50000000, -30000000, 20000000, 7000000, -1000000, 500000
+	};
+	DecimFiltInstanceType test;
+
+	CU_ASSERT(0 == compareWithReference(skewed, sizeof(skewed)/sizeof(skewed[0]), 4, 30, false));
+
+	CU_ASSERT_FATAL(DecimFilt_Init(&test, sizeof(skewed)/sizeof(skewed[0]), 4, skewed, testState, 40));
+	CU_ASSERT(false == test.bSymmetric);
+}
+
+void testDecimFiltOddBlockSizes(void)
+{
+	static const uint32_t blockSizes[] = { 1, 3, 7, 9, 11, 128 };
+	const int32_t *pCoeffs;
+	uint16_t numTaps;
+	uint8_t factor;
+	uint32_t blockSize;
+
+	// stream the first production filter (/10) in awkward block sizes
+	CU_ASSERT_FATAL(PassRailDsp_GetDecimFilt(0, &pCoeffs, &numTaps, &factor, &blockSize));
+	for(int i = 0; i < sizeof(blockSizes)/sizeof(blockSizes[0]); i++)
+	{
+		CU_ASSERT(0 == compareWithReference(pCoeffs, numTaps, factor, blockSizes[i], false));
+	}
+}
+
+void testDecimFiltInPlaceInput(void)
+{
+	const int32_t *pCoeffs;
+	uint16_t numTaps;
+	uint8_t factor;
+	uint32_t blockSize;
+	uint8_t index = 0;
+
+	// the stage 1 filters are fed in-place by the enveloper
+	while(PassRailDsp_GetDecimFilt(index, &pCoeffs, &numTaps, &factor, &blockSize))
+	{
+		CU_ASSERT(0 == compareWithReference(pCoeffs, numTaps, factor, ADC_SAMPLES_PER_BLOCK, true));
+		index += 2;
+	}
+	CU_ASSERT(index > 0);
+}
+
+void testDecimFiltBadParams(void)
+{
+	static const q31_t coeffs[] = { 1, 2, 1 };
+	DecimFiltInstanceType test;
+
+	CU_ASSERT(false == DecimFilt_Init(&test, 3, 4, coeffs, testState, 0));
+	// too many taps
+	CU_ASSERT(false == DecimFilt_Init(&test, DECIMFILT_MAX_TAPS + 1, 2, coeffs, testState, 10));
+	CU_ASSERT(false == DecimFilt_Init(&test, 3, 0, coeffs, testState, 10));
+	CU_ASSERT(false == DecimFilt_Init(&test, 3, 2, NULL, testState, 10));
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,304 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_DspFrontEnd.c
+ *
+ * Checks the fused DSP front-end - the block conversion of raw AD7766 SPI
+ * words with DC removal, and the fused rectifier + smoothing filter - against
+ * the separate per-sample conversion, arm_abs_q31() and smoothing filter
+ * steps which they replaced.
+ */
+
+#include <string.h>
+#include "UnitTest.h"
+#include "arm_math.h"
+#include "AD7766_DMA.h"
+#include "PassRailDSP.h"
+#include "PassRailDspBench.h"
+
+// Not a multiple of the 4x loop unrolling, to exercise the tail handling
+#define UT_FRONTEND_ODD_BLOCK       (131)
+#define UT_FRONTEND_NUM_BLOCKS      (12)
+
+void testFrontEndSpiBlockConversion(void);
+void testFrontEndSpiEchoMismatch(void);
+void testFrontEndEnveloperBitExact(void);
+void testFrontEndRawWordsMatchSamples(void);
+void testFrontEndBenchGolden(void);
+
+CUnit_suite_t UTdspfrontend = {
+	{ "dspfrontend", NULL, NULL, CU_TRUE, "test fused DSP front-end"},
+	{
+		{ "SPI block conversion", testFrontEndSpiBlockConversion },
+		{ "SPI echo byte mismatch detected", testFrontEndSpiEchoMismatch },
+		{ "fused enveloper bit-exact", testFrontEndEnveloperBitExact },
+		{ "raw SPI words match samples", testFrontEndRawWordsMatchSamples },
+#ifdef CONFIG_PLATFORM_DSPBENCH
+		{ "benchmark golden outputs", testFrontEndBenchGolden },
+#endif
+		{ NULL, NULL }
+	}
+};
+
+extern int32_t VibEnvFiltCoeffs[2];
+extern int32_t WflatEnvFiltCoeffs[2];
+
+static uint32_t rawWords[UT_FRONTEND_ODD_BLOCK];
+static int32_t samples[UT_FRONTEND_ODD_BLOCK];
+static uint32_t adcBlock[ADC_SAMPLES_PER_BLOCK];
+static int32_t sampleBlock[ADC_SAMPLES_PER_BLOCK];
+static int32_t outBufs[PASSRAILDSP_MAX_OUTPUTS][ADC_SAMPLES_PER_BLOCK];
+static int32_t refOutBufs[PASSRAILDSP_MAX_OUTPUTS][ADC_SAMPLES_PER_BLOCK];
+static uint32_t lcgSeed;
+
+/*
+ * Pseudo-random signed 24-bit sample, around a DC offset
+ */
+static int32_t nextSample(void)
+{
+	lcgSeed = (lcgSeed * 1664525u) + 1013904223u;
+	return 1500000 + (((int32_t)lcgSeed) >> 10);
+}
+
+/*
+ * Pack a signed 24-bit sample into a raw SPI word as received from the
+ * AD7766 - 16-bit halves swapped, with the daisy-chain echo byte
+ */
+static uint32_t sampleToSpiWord(int32_t sample)
+{
+	uint32_t word24 = ((uint32_t)sample) & 0x00FFFFFFu;
+
+	return ((word24 >> 8) & 0x0000FFFFu) | AD7766_SPI_ECHO_BYTE_EXPECTED |
+		   ((word24 & 0xFFu) << 24);
+}
+
+static void fillAdcBlock(void)
+{
+	for(int i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+	{
+		adcBlock[i] = sampleToSpiWord(nextSample());
+	}
+}
+
+void testFrontEndSpiBlockConversion(void)
+{
+	static const int32_t offsets[] = { 0, 12345, -800000 };
+	int32_t expected;
+	uint32_t mismatches = 0;
+
+	lcgSeed = 1;
+	for(int i = 0; i < UT_FRONTEND_ODD_BLOCK; i++)
+	{
+		rawWords[i] = sampleToSpiWord(nextSample() - 3000000);
+	}
+	// full-scale extremes
+	rawWords[0] = sampleToSpiWord(0x007FFFFF);
+	rawWords[1] = sampleToSpiWord(-0x00800000);
+	rawWords[2] = sampleToSpiWord(-1);
+
+	for(int j = 0; j < sizeof(offsets)/sizeof(offsets[0]); j++)
+	{
+		CU_ASSERT(AD7766_PreProcessRawSpiBlock(rawWords, samples, offsets[j], UT_FRONTEND_ODD_BLOCK));
+		for(int i = 0; i < UT_FRONTEND_ODD_BLOCK; i++)
+		{
+			CU_ASSERT_FATAL(AD7766_PreProcessRawSpiIntoSampleVal(rawWords[i], &expected));
+			if(samples[i] != (expected - offsets[j]))
+			{
+				mismatches++;
+			}
+		}
+	}
+	CU_ASSERT(0 == mismatches);
+	CU_ASSERT(-0x00800000 == samples[1] + offsets[2]);
+
+	// in-place
+	memcpy(samples, rawWords, sizeof(samples));
+	CU_ASSERT(AD7766_PreProcessRawSpiBlock((uint32_t *)samples, samples, 0, UT_FRONTEND_ODD_BLOCK));
+	CU_ASSERT(0x007FFFFF == samples[0]);
+	CU_ASSERT(-1 == samples[2]);
+}
+
+void testFrontEndSpiEchoMismatch(void)
+{
+	// bad echo byte in the unrolled part and in the tail
+	static const uint32_t badIndexes[] = { 5, UT_FRONTEND_ODD_BLOCK - 1 };
+
+	for(int j = 0; j < sizeof(badIndexes)/sizeof(badIndexes[0]); j++)
+	{
+		for(int i = 0; i < UT_FRONTEND_ODD_BLOCK; i++)
+		{
+			rawWords[i] = sampleToSpiWord(i);
+		}
+		rawWords[badIndexes[j]] ^= 0x00010000u;
+
+		CU_ASSERT(false == AD7766_PreProcessRawSpiBlock(rawWords, samples, 0, UT_FRONTEND_ODD_BLOCK));
+		// the waveform is still converted
+		CU_ASSERT(7 == samples[7]);
+		CU_ASSERT((UT_FRONTEND_ODD_BLOCK - 2) == samples[UT_FRONTEND_ODD_BLOCK - 2]);
+	}
+	AD7766_ClearError();
+}
+
+/*
+ * Chains with no decimation, so that the outputs are the enveloper outputs -
+ * compared with per-sample conversion, DC removal, arm_abs_q31() and the
+ * smoothing filter done as separate steps
+ */
+void testFrontEndEnveloperBitExact(void)
+{
+	static const PassRailDspOutputType outputs[] = {
+		{ ENV_VIB, DECIMCHAIN_NONE },
+		{ ENV_WFLATS, DECIMCHAIN_NONE },
+		{ ENV_NONE, DECIMCHAIN_NONE }
+	};
+	int32_t *pOutBufs[PASSRAILDSP_MAX_OUTPUTS] = { outBufs[0], outBufs[1], outBufs[2] };
+	uint32_t numOut[PASSRAILDSP_MAX_OUTPUTS];
+	int64_t refState[2] = { 0, 0 };
+	int32_t *pRefCoeffs[2] = { VibEnvFiltCoeffs, WflatEnvFiltCoeffs };
+	int64_t timesCoeff0;
+	int32_t mean;
+	uint32_t meanCount;
+	uint32_t mismatches = 0;
+	uint32_t numBlocksOut = 0;
+
+	CU_ASSERT_FATAL(PassRailDsp_InitMulti(outputs, 3));
+
+	lcgSeed = 7;
+	for(int block = 0; block < UT_FRONTEND_NUM_BLOCKS; block++)
+	{
+		fillAdcBlock();
+		for(int i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+		{
+			CU_ASSERT_FATAL(AD7766_PreProcessRawSpiIntoSampleVal(adcBlock[i], &sampleBlock[i]));
+		}
+
+		CU_ASSERT(PassRailDsp_ProcessAdcBlockMulti(adcBlock, pOutBufs, numOut));
+		if(numOut[0] == 0)
+		{
+			// settling
+			continue;
+		}
+		CU_ASSERT_FATAL((numOut[0] == ADC_SAMPLES_PER_BLOCK) && (numOut[1] == ADC_SAMPLES_PER_BLOCK) &&
+						(numOut[2] == ADC_SAMPLES_PER_BLOCK));
+		numBlocksOut++;
+
+		// the mean is frozen once settled
+		getMeanValues(&mean, &meanCount);
+		for(int i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+		{
+			sampleBlock[i] -= mean;
+			if(adcBlock[i] != (uint32_t)sampleBlock[i])		// converted in-place
+			{
+				mismatches++;
+			}
+			refOutBufs[2][i] = sampleBlock[i];
+		}
+
+		for(int chain = 0; chain < 2; chain++)
+		{
+			arm_abs_q31(sampleBlock, refOutBufs[chain], ADC_SAMPLES_PER_BLOCK);
+			for(int i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+			{
+				timesCoeff0 = (int64_t)refOutBufs[chain][i] * pRefCoeffs[chain][0];
+				refOutBufs[chain][i] = (int32_t)((timesCoeff0 + refState[chain]) >> 31);
+				refState[chain] = timesCoeff0 - ((int64_t)refOutBufs[chain][i] * pRefCoeffs[chain][1]);
+			}
+		}
+
+		mismatches += (0 != memcmp(outBufs, refOutBufs, sizeof(outBufs)));
+	}
+
+	CU_ASSERT(numBlocksOut >= (UT_FRONTEND_NUM_BLOCKS - 2));
+	CU_ASSERT(0 == mismatches);
+}
+
+/*
+ * The same stream through decimating chains, as raw SPI words and as
+ * already-converted samples, must give identical outputs
+ */
+void testFrontEndRawWordsMatchSamples(void)
+{
+	static const PassRailDspOutputType outputs[] = {
+		{ ENV_VIB, DECIMCHAIN_VIB_1280 },
+		{ ENV_VIB, DECIMCHAIN_VIB_5120 },
+		{ ENV_NONE, DECIMCHAIN_VIB_2560 }
+	};
+	static int32_t rawOut[PASSRAILDSP_MAX_OUTPUTS][UT_FRONTEND_NUM_BLOCKS * ADC_SAMPLES_PER_BLOCK];
+	static int32_t sampleOut[PASSRAILDSP_MAX_OUTPUTS][UT_FRONTEND_NUM_BLOCKS * ADC_SAMPLES_PER_BLOCK];
+	int32_t *pOutBufs[PASSRAILDSP_MAX_OUTPUTS] = { outBufs[0], outBufs[1], outBufs[2] };
+	uint32_t numRawOut[PASSRAILDSP_MAX_OUTPUTS] = { 0 };
+	uint32_t numSampleOut[PASSRAILDSP_MAX_OUTPUTS] = { 0 };
+	uint32_t numOut[PASSRAILDSP_MAX_OUTPUTS];
+	int pass;
+
+	for(pass = 0; pass < 2; pass++)
+	{
+		CU_ASSERT_FATAL(PassRailDsp_InitMulti(outputs, 3));
+		lcgSeed = 99;
+		for(int block = 0; block < UT_FRONTEND_NUM_BLOCKS; block++)
+		{
+			fillAdcBlock();
+			if(pass == 0)
+			{
+				CU_ASSERT(PassRailDsp_ProcessAdcBlockMulti(adcBlock, pOutBufs, numOut));
+			}
+			else
+			{
+				for(int i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+				{
+					AD7766_PreProcessRawSpiIntoSampleVal(adcBlock[i], &sampleBlock[i]);
+				}
+				PassRailDsp_ProcessBlockMulti(sampleBlock, pOutBufs, numOut);
+			}
+
+			for(int chain = 0; chain < 3; chain++)
+			{
+				int32_t *pDst = (pass == 0) ? &rawOut[chain][numRawOut[chain]] :
+											  &sampleOut[chain][numSampleOut[chain]];
+				memcpy(pDst, outBufs[chain], numOut[chain] * sizeof(int32_t));
+				if(pass == 0)
+				{
+					numRawOut[chain] += numOut[chain];
+				}
+				else
+				{
+					numSampleOut[chain] += numOut[chain];
+				}
+			}
+		}
+	}
+
+	for(int chain = 0; chain < 3; chain++)
+	{
+		CU_ASSERT(numRawOut[chain] > 0);
+		CU_ASSERT(numRawOut[chain] == numSampleOut[chain]);
+		CU_ASSERT(0 == memcmp(rawOut[chain], sampleOut[chain], numRawOut[chain] * sizeof(int32_t)));
+	}
+}
+
+#ifdef CONFIG_PLATFORM_DSPBENCH
+/*
+ * All chains must still give their golden outputs for the benchmark stimulus,
+ * and remain close to the double-precision reference
+ */
+void testFrontEndBenchGolden(void)
+{
+	DspBenchResultType result;
+
+	CU_ASSERT(PassRailDspBench_RunAll(NULL, 0, false));
+
+	CU_ASSERT_FATAL(PassRailDspBench_RunChain(DECIMCHAIN_VIB_1280, NULL, 0, &result));
+	CU_ASSERT(result.NumOutputSamples == ((DSPBENCH_NUM_BLOCKS - 2) * ADC_SAMPLES_PER_BLOCK + 39) / 40);
+	CU_ASSERT(result.SnrDb > 80.0f);
+	CU_ASSERT(result.PassbandRippleDb < 1.0f);
+
+	CU_ASSERT(PassRailDspBench_RunChain(DECIMCHAIN_NONE, NULL, 0, &result) == false);
+}
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,213 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_Features.c
+ *
+ * Checks the streaming waveform features against values calculated directly
+ * over the whole waveform, and against known sine wave properties.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "UnitTest.h"
+#include "PassRailFeatures.h"
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+
+#define UT_FEATURES_NUM_SAMPLES     (8192)
+#define UT_FEATURES_SPS             (5120)
+// Not a divisor of the FFT length, so that frames span blocks
+#define UT_FEATURES_BLOCK           (100)
+// Ring buffer as a streamed waveform's, the smallest for the block size
+#define UT_FEATURES_RING_BLOCK      (300)
+#define UT_FEATURES_RING_LEN        (UT_FEATURES_RING_BLOCK + FEATURES_FFT_LEN - 1)
+
+void testFeaturesSineStatistics(void);
+void testFeaturesSineSpectrum(void);
+void testFeaturesNoiseMatchesDirect(void);
+void testFeaturesRingBuffer(void);
+
+CUnit_suite_t UTfeatures = {
+	{ "features", NULL, NULL, CU_TRUE, "test streaming waveform features"},
+	{
+		{ "sine statistics", testFeaturesSineStatistics },
+		{ "sine spectrum, bands & orders", testFeaturesSineSpectrum },
+		{ "noise statistics match direct calculation", testFeaturesNoiseMatchesDirect },
+		{ "ring buffer same as whole waveform", testFeaturesRingBuffer },
+		{ NULL, NULL }
+	}
+};
+
+static FeaturesStateType state;
+static FeaturesType features;
+static int32_t waveform[UT_FEATURES_NUM_SAMPLES];
+static int32_t ring[UT_FEATURES_RING_LEN];
+
+static void processInBlocks(uint32_t blockSize)
+{
+	uint32_t i;
+
+	PassRailFeatures_Init(&state);
+	for(i = 0; i < UT_FEATURES_NUM_SAMPLES; i += blockSize)
+	{
+		PassRailFeatures_ProcessBlock(&state, waveform, UT_FEATURES_NUM_SAMPLES,
+									  ((UT_FEATURES_NUM_SAMPLES - i) < blockSize) ? (UT_FEATURES_NUM_SAMPLES - i) : blockSize);
+	}
+}
+
+static bool isClose(double value, double expected, double relTolerance)
+{
+	return fabs(value - expected) <= (fabs(expected) * relTolerance);
+}
+
+/*
+ * Sine wave at freqHz, amplitude amp, on a DC offset
+ */
+static void makeSine(double freqHz, double amp, double offset)
+{
+	for(int i = 0; i < UT_FEATURES_NUM_SAMPLES; i++)
+	{
+		waveform[i] = (int32_t)floor(offset + (amp * sin((2.0 * 3.14159265358979 * freqHz * i) / UT_FEATURES_SPS)) + 0.5);
+	}
+}
+
+void testFeaturesSineStatistics(void)
+{
+	const double amp = 1000000.0;
+	const double offset = 3000000.0;
+
+	// whole number of cycles
+	makeSine(80.0, amp, offset);
+	processInBlocks(UT_FEATURES_BLOCK);
+	CU_ASSERT_FATAL(PassRailFeatures_GetResults(&state, UT_FEATURES_SPS, 0.0f, &features));
+
+	CU_ASSERT(UT_FEATURES_NUM_SAMPLES == features.NumSamples);
+	CU_ASSERT(isClose(features.Mean, offset, 1e-4));
+	CU_ASSERT(isClose(features.Rms, sqrt((offset * offset) + ((amp * amp) / 2)), 1e-4));
+	CU_ASSERT(isClose(features.Peak, offset + amp, 1e-6));
+	CU_ASSERT(isClose(features.CrestFactor, (offset + amp) / sqrt((offset * offset) + ((amp * amp) / 2)), 1e-4));
+	// a sine's kurtosis is 1.5
+	CU_ASSERT(isClose(features.Kurtosis, 1.5, 1e-3));
+
+	PassRailFeatures_Init(&state);
+	CU_ASSERT(false == PassRailFeatures_GetResults(&state, UT_FEATURES_SPS, 0.0f, &features));
+}
+
+void testFeaturesSineSpectrum(void)
+{
+	const double amp = 1000000.0;
+	const float binHz = (float)UT_FEATURES_SPS / FEATURES_FFT_LEN;
+	const float sineHz = 30 * binHz;
+	float bandTotal = 0.0f;
+	float orderTotal = 0.0f;
+
+	makeSine(sineHz, amp, -500000.0);
+	processInBlocks(UT_FEATURES_BLOCK);
+
+	// the sine is the 2nd order
+	CU_ASSERT_FATAL(PassRailFeatures_GetResults(&state, UT_FEATURES_SPS, sineHz / 2, &features));
+
+	CU_ASSERT(fabs(features.PeakHz[0] - sineHz) < 0.01f);
+	CU_ASSERT(features.PeakEnergy[1] < (features.PeakEnergy[0] * 1e-3f));
+
+	for(int i = 0; i < FEATURES_NUM_BANDS; i++)
+	{
+		bandTotal += features.BandEnergy[i];
+	}
+	for(int i = 0; i < FEATURES_NUM_ORDERS; i++)
+	{
+		orderTotal += features.OrderEnergy[i];
+	}
+	// Parseval - the energy is the sine's mean-square, all in band 0 & order 2
+	CU_ASSERT(isClose(bandTotal, (amp * amp) / 2, 0.01));
+	CU_ASSERT(isClose(features.BandEnergy[0], bandTotal, 1e-3));
+	CU_ASSERT(isClose(features.OrderEnergy[1], orderTotal, 1e-3));
+	CU_ASSERT(isClose(orderTotal, bandTotal, 1e-3));
+
+	// no orders without the wheel rotation rate
+	CU_ASSERT_FATAL(PassRailFeatures_GetResults(&state, UT_FEATURES_SPS, 0.0f, &features));
+	CU_ASSERT(0.0f == features.OrderEnergy[1]);
+}
+
+/*
+ * Near-Gaussian noise plus impulses, with a large DC offset - the statistics
+ * must match a direct calculation for any block size
+ */
+void testFeaturesNoiseMatchesDirect(void)
+{
+	static const uint32_t blockSizes[] = { 1, 7, 128, UT_FEATURES_NUM_SAMPLES };
+	uint32_t seed = 1;
+	double mean = 0.0;
+	double m2 = 0.0;
+	double m4 = 0.0;
+	double dev;
+	int32_t sum;
+
+	for(int i = 0; i < UT_FEATURES_NUM_SAMPLES; i++)
+	{
+		sum = 0;
+		for(int j = 0; j < 12; j++)
+		{
+			seed = (seed * 1664525u) + 1013904223u;
+			sum += (int32_t)(seed >> 16) - 32768;
+		}
+		waveform[i] = 20000000 + (sum * 8) + (((i % 1000) == 0) ? 4000000 : 0);
+		mean += waveform[i];
+	}
+	mean /= UT_FEATURES_NUM_SAMPLES;
+	for(int i = 0; i < UT_FEATURES_NUM_SAMPLES; i++)
+	{
+		dev = waveform[i] - mean;
+		m2 += dev * dev;
+		m4 += dev * dev * dev * dev;
+	}
+
+	for(int b = 0; b < sizeof(blockSizes)/sizeof(blockSizes[0]); b++)
+	{
+		processInBlocks(blockSizes[b]);
+		CU_ASSERT_FATAL(PassRailFeatures_GetResults(&state, UT_FEATURES_SPS, 0.0f, &features));
+		CU_ASSERT(isClose(features.Mean, mean, 1e-6));
+		CU_ASSERT(isClose(features.Rms, sqrt((m2 / UT_FEATURES_NUM_SAMPLES) + (mean * mean)), 1e-6));
+		CU_ASSERT(isClose(features.Kurtosis, (UT_FEATURES_NUM_SAMPLES * m4) / (m2 * m2), 1e-3));
+	}
+	// impulses make it heavier-tailed than Gaussian
+	CU_ASSERT(features.Kurtosis > 3.0f);
+}
+
+/*
+ * The frames are read back from a ring buffer across its end as from the
+ * whole waveform
+ */
+void testFeaturesRingBuffer(void)
+{
+	static FeaturesStateType ringState;
+	uint32_t n;
+
+	makeSine(333.0, 1000000.0, 200000.0);
+	processInBlocks(UT_FEATURES_BLOCK);
+
+	PassRailFeatures_Init(&ringState);
+	for(uint32_t i = 0; i < UT_FEATURES_NUM_SAMPLES; i += n)
+	{
+		n = ((UT_FEATURES_NUM_SAMPLES - i) < UT_FEATURES_RING_BLOCK) ? (UT_FEATURES_NUM_SAMPLES - i) : UT_FEATURES_RING_BLOCK;
+		for(uint32_t j = i; j < (i + n); j++)
+		{
+			ring[j % UT_FEATURES_RING_LEN] = waveform[j];
+		}
+		PassRailFeatures_ProcessBlock(&ringState, ring, UT_FEATURES_RING_LEN, n);
+	}
+
+	CU_ASSERT(ringState.NumFrames == state.NumFrames);
+	CU_ASSERT(ringState.NumFrames == ((2 * UT_FEATURES_NUM_SAMPLES) / FEATURES_FFT_LEN) - 1);
+	CU_ASSERT(ringState.PeakAbs == state.PeakAbs);
+	CU_ASSERT(memcmp(ringState.PowerSum, state.PowerSum, sizeof(state.PowerSum)) == 0);
+}
+
+#endif // CONFIG_PLATFORM_WAVE_FEATURES
+
+
+#ifdef __cplusplus
+}
+#endif
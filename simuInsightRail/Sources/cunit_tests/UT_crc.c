@@ -15,12 +15,14 @@ extern "C" {
 
 void testCRCbuffer(void);
 void testCRCimage(void);
+void testCRCincremental(void);
 
 CUnit_suite_t UTcrc = {
 	{ "crc", NULL, NULL, CU_TRUE, "test crc functions"},
 	{
 		{ "test memory CRC", testCRCbuffer },
 		{ "test image CRC", testCRCimage },
+		{ "test incremental CRC", testCRCincremental },
 		{ NULL, NULL }
 	}
 };
@@ -54,6 +56,48 @@ void testCRCimage(void)
 	CU_ASSERT(CRCTARGETVALUE == crc32_hardware((void *)__app_origin, (uint32_t)__app_image_size));
 }
 
+/*
+ * The incremental CRC must give the same result however the data is split
+ * up, including unaligned pieces
+ */
+void testCRCincremental(void)
+{
+	const uint32_t size = 0x1000;
+	const uint32_t pieces[] = { 1, 3, 4, 255, 256, 1023, 1025, 2000 };
+	crc32Context_t ctx;
+	uint8_t *p = (uint8_t*)__sample_buffer;
+	uint32_t offset;
+	uint32_t crc;
+
+	// check value of the standard CRC32
+	crc32_ctxInit(&ctx);
+	crc32_ctxUpdate(&ctx, "123456789", 9);
+	CU_ASSERT(0xCBF43926 == crc32_ctxFinish(&ctx));
+
+	// whole sample buffer, as testCRCbuffer()
+	memset(__sample_buffer, 0x55, (uint32_t)__sample_buffer_size);
+	crc32_ctxInit(&ctx);
+	crc32_ctxUpdate(&ctx, __sample_buffer, (uint32_t)__sample_buffer_size);
+	CU_ASSERT(0xEEA78A0D == crc32_ctxFinish(&ctx));
+
+	for(offset = 0; offset < size; offset++)
+	{
+		p[offset] = (uint8_t)((offset * 7) ^ (offset >> 8));
+	}
+	crc32_ctxInit(&ctx);
+	crc32_ctxUpdate(&ctx, p, size);
+	crc = crc32_ctxFinish(&ctx);
+
+	for(int i = 0; i < sizeof(pieces)/sizeof(pieces[0]); i++)
+	{
+		crc32_ctxInit(&ctx);
+		for(offset = 0; offset < size; offset += pieces[i])
+		{
+			crc32_ctxUpdate(&ctx, &p[offset], ((size - offset) < pieces[i]) ? (size - offset) : pieces[i]);
+		}
+		CU_ASSERT(crc == crc32_ctxFinish(&ctx));
+	}
+}
 
 
 #ifdef __cplusplus
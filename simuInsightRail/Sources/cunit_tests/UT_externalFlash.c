@@ -18,6 +18,9 @@ extern "C" {
 #include "linker.h"
 #include "UnitTest.h"
 #include "drv_is25.h"
+#include "ExtFlash.h"
+#include "configData.h"
+#include "DataStore.h"
 
 // 16 pages per sector, 0x100 bytes per page
 #define BYTES_PER_PAGE	(0x100)
@@ -29,6 +32,13 @@ static const int testSize = TEST_BLOCK_SIZE_SECTORS(32);
 static const int startAddress = 0;
 static const char testValue = 0x55;
 
+// streamed waveform read test, several read-ahead pieces with a part piece at the end
+#define STREAM_TEST_DATASET		(MAX_NUMBER_OF_DATASETS)
+#define STREAM_TEST_SAMPLES		(1000)
+#define STREAM_TEST_SCALING		(0.5f)
+
+extern tExtFlashHandle extFlashHandle;
+
 /*
  * NOTE! These tests WILL corrupt the flash device contents.
  * Also, there may be interdependence across tests so don't change the test suite calling order
@@ -119,12 +129,89 @@ static void test2()
 	CU_ASSERT(b_ok && (find_last_match(buf, testValue, testSize) != testSize));
 }
 
+/*
+ * checkWaveformRead
+ *
+ * @desc	read samples of the streamed waveform through the datastore and compare them
+ *
+ * @param	samples - the samples written
+ * @param	index - first sample to read
+ * @param	count - number of samples to read
+ *
+ * @returns	true when the read succeeded and returned the scaled samples
+ */
+static bool checkWaveformRead(const int32_t* samples, uint32_t index, uint32_t count)
+{
+	float values[16];
+
+	if((count > (sizeof(values) / sizeof(values[0]))) ||
+	   !DataStore_BlockGetSingle(MR_Acceleration_Raw, index, count, values))
+	{
+		return false;
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(values[i] != (samples[index + i] * STREAM_TEST_SCALING))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * test3
+ *
+ * @desc	streamed waveform read, reading in order, skipping ahead and failing to go back
+ *
+ * @param	none
+ *
+ * @returns	none
+ */
+static void test3()
+{
+	int32_t* samples = (int32_t*)__sample_buffer;
+
+	for(int32_t i = 0; i < STREAM_TEST_SAMPLES; i++)
+	{
+		samples[i] = (i * 4099) - 2000000;
+	}
+
+	CU_ASSERT_FATAL(extFlash_erase(&extFlashHandle, STREAM_TEST_DATASET, EXTFLASH_MAXWAIT_MS) >= 0);
+	CU_ASSERT_FATAL(extFlash_write(&extFlashHandle, (uint8_t*)samples, STREAM_TEST_SAMPLES * sizeof(int32_t),
+								   IS25_RAW_SAMPLED_DATA, STREAM_TEST_DATASET, EXTFLASH_MAXWAIT_MS) >= 0);
+	CU_ASSERT_FATAL(configData_WaveformFromFlash(IS25_RAW_SAMPLED_DATA, STREAM_TEST_DATASET, STREAM_TEST_SCALING) == STREAM_TEST_SAMPLES);
+
+	// in order, also re-reading within the current piece and across the piece boundaries
+	CU_ASSERT(checkWaveformRead(samples, 0, 16));
+	CU_ASSERT(checkWaveformRead(samples, 16, 16));
+	CU_ASSERT(checkWaveformRead(samples, 8, 16));
+	CU_ASSERT(checkWaveformRead(samples, 250, 12));
+
+	// skipping ahead, over a whole piece to the last one
+	CU_ASSERT(checkWaveformRead(samples, 800, 16));
+
+	// going back to before the current piece fails, and so does reading past the end
+	CU_ASSERT(!checkWaveformRead(samples, 100, 4));
+	CU_ASSERT(!checkWaveformRead(samples, STREAM_TEST_SAMPLES - 4, 8));
+
+	// carrying on after the failures, up to the last sample
+	CU_ASSERT(checkWaveformRead(samples, 816, 16));
+	CU_ASSERT(checkWaveformRead(samples, STREAM_TEST_SAMPLES - 16, 16));
+
+	configData_WaveformFromRam(NULL, 1.0f);
+	CU_ASSERT(extFlash_erase(&extFlashHandle, STREAM_TEST_DATASET, EXTFLASH_MAXWAIT_MS) >= 0);
+}
+
+
 
 CUnit_suite_t UTexternalFlash = {
 	{ "FLASH", NULL, NULL, CU_TRUE, "test external flash functions" },
 	{
 		{"write speed test", test1},
 		{"read test", test2},
+		{"streamed waveform read", test3},
 		{ NULL, NULL }
 	}
 };
@@ -0,0 +1,211 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_modemIo.c
+ *
+ * Runs the modem uart receive ring in the uart's internal loopback, so what
+ * is written comes straight back through the receive eDMA: reads ended by the
+ * idle line, the idle line interrupt after each burst, the ring wrapping and
+ * the flow control holding characters in the uart until they are read.
+ *
+ * NOTE! Only with the modem powered down, the uart is taken over.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "fsl_uart_hal.h"
+#include "UnitTest.h"
+#include "PowerControl.h"
+#include "xTaskModem.h"
+#include "ModemIo.h"
+
+#define UT_MODEMIO_BAUDRATE     (115200)
+#define UT_MODEMIO_TIMEOUT      (200 / portTICK_PERIOD_MS)
+// a burst read must end well before the timeout, on the idle line
+#define UT_MODEMIO_MAX_TICKS    (30 / portTICK_PERIOD_MS)
+// the rx ring pauses above about half its 1024 bytes, the loopback can not be held by RTS
+#define UT_MODEMIO_BURST        (300)
+#define UT_MODEMIO_PAUSE_BURST  (500)
+#define UT_MODEMIO_HELD         (4)
+
+extern uint32_t MODEM_rx_pause_count;
+
+static uint8_t txBuf[UT_MODEMIO_PAUSE_BURST + UT_MODEMIO_HELD];
+static uint8_t rxBuf[UT_MODEMIO_PAUSE_BURST + UT_MODEMIO_HELD];
+
+static UART_Type *modemUart(void)
+{
+	UART_Type *uartBase[UART_INSTANCE_COUNT] = UART_BASE_PTRS;
+
+	return uartBase[MODEM_UART_IDX];
+}
+
+static void setLoopback(bool loop)
+{
+	UART_Type *base = modemUart();
+
+	UART_HAL_DisableTransmitter(base);
+	UART_HAL_DisableReceiver(base);
+	// CTS is the powered down modem's, the receiver's RTS does not stop the loopback
+	UART_HAL_SetTransmitterCtsCmd(base, !loop);
+	UART_HAL_SetLoopCmd(base, loop);
+	UART_HAL_EnableTransmitter(base);
+	UART_HAL_EnableReceiver(base);
+}
+
+static int initModemIo(void)
+{
+	if(powerModemIsOn())
+	{
+		return 1;
+	}
+	Modem_init_serial(MODEM_UART_IDX, UT_MODEMIO_BAUDRATE);
+	// keep the modem task away from the characters
+	modemStatus.ioState = MODEMIOSTATE_DOWN;
+	setLoopback(true);
+
+	return 0;
+}
+
+static int cleanModemIo(void)
+{
+	setLoopback(false);
+	modemStatus.ioState = MODEMIOSTATE_DOWN;
+
+	return 0;
+}
+
+/*
+ * sendAndRead
+ *
+ * @desc	queues a burst and reads it back
+ *
+ * @param	len - burst length
+ * @param	seed - for the contents
+ *
+ * @returns	ticks taken by the read, UT_MODEMIO_TIMEOUT when it did not come back intact
+ */
+static TickType_t sendAndRead(uint32_t len, uint8_t seed)
+{
+	TickType_t start;
+	uint32_t n;
+
+	for(uint32_t i = 0; i < len; i++)
+	{
+		txBuf[i] = (uint8_t)(seed + (i * 7));
+	}
+	memset(rxBuf, 0, len);
+
+	if(!ModemIo_WriteQueue(txBuf, len, NULL, NULL, UT_MODEMIO_TIMEOUT))
+	{
+		return UT_MODEMIO_TIMEOUT;
+	}
+	start = xTaskGetTickCount();
+	n = ModemIo_Read(rxBuf, len, UT_MODEMIO_TIMEOUT);
+	if((n != len) || (memcmp(txBuf, rxBuf, len) != 0))
+	{
+		return UT_MODEMIO_TIMEOUT;
+	}
+	return xTaskGetTickCount() - start;
+}
+
+/*
+ * testModemIoIdleRead
+ *
+ * @desc	a read of a burst shorter than half the ring, only the idle line ends it
+ */
+static void testModemIoIdleRead(void)
+{
+	CU_ASSERT(sendAndRead(64, 1) < UT_MODEMIO_MAX_TICKS);
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == 0);
+}
+
+/*
+ * testModemIoIdleRearm
+ *
+ * @desc	short bursts with the line idle in between, each one must end on its idle
+ *			line interrupt, switched off at the previous idle and on again since
+ */
+static void testModemIoIdleRearm(void)
+{
+	for(int i = 0; i < 20; i++)
+	{
+		CU_ASSERT(sendAndRead(8, (uint8_t)i) < UT_MODEMIO_MAX_TICKS);
+		vTaskDelay(2 / portTICK_PERIOD_MS);
+	}
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == 0);
+}
+
+/*
+ * testModemIoRingWrap
+ *
+ * @desc	bursts going round the ring, copied out in two pieces at its end
+ */
+static void testModemIoRingWrap(void)
+{
+	for(int i = 0; i < 8; i++)
+	{
+		CU_ASSERT(sendAndRead(UT_MODEMIO_BURST, (uint8_t)(i * 3)) < UT_MODEMIO_MAX_TICKS);
+	}
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == 0);
+}
+
+/*
+ * testModemIoFlowControl
+ *
+ * @desc	more than the pause level waiting switches the receive DMA off, what comes
+ *			next stays in the uart, until the reader has taken the ring down
+ */
+static void testModemIoFlowControl(void)
+{
+	const uint32_t len = UT_MODEMIO_PAUSE_BURST + UT_MODEMIO_HELD;
+	uint32_t pauses = MODEM_rx_pause_count;
+
+	for(uint32_t i = 0; i < len; i++)
+	{
+		txBuf[i] = (uint8_t)(i * 13);
+	}
+	memset(rxBuf, 0, len);
+
+	// nobody reading, the idle line pauses
+	CU_ASSERT(Modem_writeBlock(txBuf, UT_MODEMIO_PAUSE_BURST, UT_MODEMIO_TIMEOUT) == UT_MODEMIO_PAUSE_BURST);
+	vTaskDelay(5 / portTICK_PERIOD_MS);
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == UT_MODEMIO_PAUSE_BURST);
+	CU_ASSERT(MODEM_rx_pause_count == pauses + 1);
+
+	// held in the uart fifo
+	CU_ASSERT(Modem_writeBlock(&txBuf[UT_MODEMIO_PAUSE_BURST], UT_MODEMIO_HELD, UT_MODEMIO_TIMEOUT) == UT_MODEMIO_HELD);
+	vTaskDelay(5 / portTICK_PERIOD_MS);
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == UT_MODEMIO_PAUSE_BURST);
+
+	// reading resumes, the held characters follow without an idle line of their own
+	CU_ASSERT(ModemIo_Read(rxBuf, len, UT_MODEMIO_TIMEOUT) == len);
+	CU_ASSERT(memcmp(txBuf, rxBuf, len) == 0);
+	CU_ASSERT(MODEM_rx_pause_count == pauses + 1);
+
+	CU_ASSERT(sendAndRead(16, 5) < UT_MODEMIO_MAX_TICKS);
+	CU_ASSERT(Modem_UART_GetCharsInRxBuf() == 0);
+}
+
+CUnit_suite_t UTmodemio = {
+	{ "modemio", initModemIo, cleanModemIo, CU_TRUE, "test the modem uart receive ring in loopback, modem off"},
+	{
+		{ "burst read ended by the idle line", testModemIoIdleRead },
+		{ "idle line interrupt back on after each burst", testModemIoIdleRearm },
+		{ "bursts round the ring", testModemIoRingWrap },
+		{ "flow control holds characters until read", testModemIoFlowControl },
+		{ NULL, NULL }
+	}
+};
+
+
+#ifdef __cplusplus
+}
+#endif
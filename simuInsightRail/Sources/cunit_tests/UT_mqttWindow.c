@@ -0,0 +1,444 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_mqttWindow.c
+ *
+ * Runs the MQTT client's QoS1 publish window against a loopback broker,
+ * which acknowledges after a simulated round trip time and can lose
+ * acknowledgements or the whole link. Also that publishes larger than the
+ * client's send buffer get through, their payload not being copied into it,
+ * and that queued (background) writes leave the packets alone until sent.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "UnitTest.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "MQTTClient.h"
+
+#define UT_MQTTWINDOW_RTT_MS        (10)
+#define UT_MQTTWINDOW_PUBACK_MS     (100)
+#define UT_MQTTWINDOW_BUF_SIZE      (256)
+#define UT_MQTTWINDOW_SLOTS         (4)
+#define UT_MQTTWINDOW_NUM_PUBLISH   (20)
+#define UT_MQTTWINDOW_MAX_REPLIES   (16)
+#define UT_MQTTWINDOW_LARGE_PAYLOAD (3 * UT_MQTTWINDOW_BUF_SIZE)
+
+void testMqttWindowPipelined(void);
+void testMqttWindowStopAndWait(void);
+void testMqttWindowLostAck(void);
+void testMqttWindowRetransmitOnYield(void);
+void testMqttWindowReconnect(void);
+void testMqttWindowDeadLink(void);
+void testMqttPublishLarge(void);
+void testMqttWindowQueuedWrites(void);
+static int initMqttWindow(void);
+
+CUnit_suite_t UTmqttwindow = {
+	{ "mqttwindow", initMqttWindow, NULL, CU_TRUE, "test MQTT QoS1 publish window"},
+	{
+		{ "window keeps the link busy", testMqttWindowPipelined },
+		{ "window of 1 is stop-and-wait", testMqttWindowStopAndWait },
+		{ "lost PUBACK retransmitted", testMqttWindowLostAck },
+		{ "lost PUBACK retransmitted when a yield times out", testMqttWindowRetransmitOnYield },
+		{ "unacknowledged publishes resent on reconnect", testMqttWindowReconnect },
+		{ "dead link fails the flush", testMqttWindowDeadLink },
+		{ "publish larger than the send buffer", testMqttPublishLarge },
+		{ "window publishes sent by queued writes", testMqttWindowQueuedWrites },
+		{ NULL, NULL }
+	}
+};
+
+/*
+ * The broker: whole packets are parsed from what the client writes, and its
+ * replies queued until their round trip time has passed
+ */
+static struct {
+	uint8_t rx[UT_MQTTWINDOW_LARGE_PAYLOAD + UT_MQTTWINDOW_BUF_SIZE];
+	int rxLen;
+	struct {
+		TickType_t due;
+		uint8_t packet[4];
+		int len;
+	} reply[UT_MQTTWINDOW_MAX_REPLIES];
+	int replyHead, replyCount, replyOffset;
+
+	bool linkDead;				// swallow everything
+	int dropAcks;				// PUBACKs still to lose
+	int publishes, duplicates, outstanding, maxOutstanding;
+	int lastPayloadLen;
+	bool payloadsOk;			// all payloads as sent
+} broker;
+
+// queued writes, only taken in by the broker when the client writes or reads next
+static struct {
+	unsigned char *buf;
+	int len;
+} queued[UT_MQTTWINDOW_SLOTS * 2];
+static int queuedCount, queuedWrites;
+
+static MQTTClient client;
+static MQTT_Network network;
+static uint8_t sendBuf[UT_MQTTWINDOW_BUF_SIZE];
+static uint8_t readBuf[UT_MQTTWINDOW_BUF_SIZE];
+static uint8_t inflightBuf[UT_MQTTWINDOW_SLOTS * UT_MQTTWINDOW_BUF_SIZE];
+
+static void brokerReply(int len)
+{
+	int i = (broker.replyHead + broker.replyCount++) % UT_MQTTWINDOW_MAX_REPLIES;
+
+	broker.reply[i].due = xTaskGetTickCount() + (UT_MQTTWINDOW_RTT_MS / portTICK_PERIOD_MS);
+	broker.reply[i].len = len;
+}
+
+static uint8_t *brokerNextReply(void)
+{
+	CU_ASSERT_FATAL(broker.replyCount < UT_MQTTWINDOW_MAX_REPLIES);
+	return broker.reply[(broker.replyHead + broker.replyCount) % UT_MQTTWINDOW_MAX_REPLIES].packet;
+}
+
+static void brokerPacket(uint8_t *packet, int len)
+{
+	MQTTHeader header = {0};
+	unsigned char dup, retained;
+	unsigned short id;
+	int qos, payloadLen;
+	unsigned char *payload;
+	MQTTString topic;
+
+	header.byte = packet[0];
+	switch (header.bits.type)
+	{
+	case CONNECT:
+		brokerReply(MQTTSerialize_connack(brokerNextReply(), 4, 0, 0));
+		break;
+	case PUBLISH:
+		CU_ASSERT_FATAL(MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &payloadLen, packet, len) == 1);
+		broker.lastPayloadLen = payloadLen;
+		for (int i = 0; i < payloadLen; i++)
+		{
+			broker.payloadsOk &= (payload[i] == (uint8_t)i);
+		}
+		if (qos == QOS0)
+		{
+			broker.publishes++;
+			break;
+		}
+		if (dup)
+		{
+			broker.duplicates++;
+		}
+		else
+		{
+			broker.publishes++;
+			if (++broker.outstanding > broker.maxOutstanding)
+			{
+				broker.maxOutstanding = broker.outstanding;
+			}
+		}
+		if (broker.dropAcks > 0)
+		{
+			broker.dropAcks--;
+		}
+		else
+		{
+			brokerReply(MQTTSerialize_ack(brokerNextReply(), 4, PUBACK, 0, id));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void brokerReceive(unsigned char *buf, int len)
+{
+	int remLen, total;
+
+	if (broker.linkDead)
+	{
+		return;
+	}
+	CU_ASSERT_FATAL(broker.rxLen + len <= sizeof(broker.rx));
+	memcpy(&broker.rx[broker.rxLen], buf, len);
+	broker.rxLen += len;
+
+	while (broker.rxLen >= 2)
+	{
+		total = 1 + MQTTPacket_decodeBuf(&broker.rx[1], &remLen);
+		total += remLen;
+		if (total > broker.rxLen)
+		{
+			break;
+		}
+		brokerPacket(broker.rx, total);
+		memmove(broker.rx, &broker.rx[total], broker.rxLen - total);
+		broker.rxLen -= total;
+	}
+}
+
+static void brokerReceiveQueued(void)
+{
+	for (int i = 0; i < queuedCount; i++)
+	{
+		brokerReceive(queued[i].buf, queued[i].len);
+	}
+	queuedCount = 0;
+}
+
+static int brokerWrite(MQTT_Network *n, unsigned char *buf, int len, int timeout_ms)
+{
+	brokerReceiveQueued();
+	brokerReceive(buf, len);
+	return len;
+}
+
+static int brokerWriteQueued(MQTT_Network *n, unsigned char *buf, int len, int timeout_ms)
+{
+	CU_ASSERT_FATAL(queuedCount < (sizeof(queued) / sizeof(queued[0])));
+	queued[queuedCount].buf = buf;
+	queued[queuedCount].len = len;
+	queuedCount++;
+	queuedWrites++;
+	return len;
+}
+
+static int brokerRead(MQTT_Network *n, unsigned char *buf, int len, int timeout_ms)
+{
+	int head = broker.replyHead;
+	int available;
+	MQTTHeader header = {0};
+
+	brokerReceiveQueued();
+
+	if ((broker.replyCount == 0) || ((int32_t)(xTaskGetTickCount() - broker.reply[head].due) < 0))
+	{
+		vTaskDelay(1);
+		return 0;
+	}
+	available = broker.reply[head].len - broker.replyOffset;
+	if (len > available)
+	{
+		len = available;
+	}
+	memcpy(buf, &broker.reply[head].packet[broker.replyOffset], len);
+	broker.replyOffset += len;
+	if (broker.replyOffset == broker.reply[head].len)
+	{
+		header.byte = broker.reply[head].packet[0];
+		if (header.bits.type == PUBACK)
+		{
+			broker.outstanding--;
+		}
+		broker.replyHead = (head + 1) % UT_MQTTWINDOW_MAX_REPLIES;
+		broker.replyCount--;
+		broker.replyOffset = 0;
+	}
+	return len;
+}
+
+static int initMqttWindow(void)
+{
+	network.mqttread = brokerRead;
+	network.mqttwrite = brokerWrite;
+	MQTTClientInit(&client, &network, 1000, sendBuf, sizeof(sendBuf), readBuf, sizeof(readBuf));
+	return (MQTTClientInitWindow(&client, inflightBuf, sizeof(inflightBuf), UT_MQTTWINDOW_BUF_SIZE, UT_MQTTWINDOW_PUBACK_MS) == UT_MQTTWINDOW_SLOTS) ? 0 : 1;
+}
+
+static void connect(void)
+{
+	MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+
+	memset(&broker, 0, sizeof(broker));
+	broker.payloadsOk = true;
+	queuedCount = 0;
+	options.keepAliveInterval = 0;
+	CU_ASSERT_FATAL(MQTTConnect(&client, &options) == SUCCESS);
+}
+
+static int publishSized(int count, enum QoS qos, int payloadLen)
+{
+	static uint8_t payload[UT_MQTTWINDOW_LARGE_PAYLOAD];
+	MQTTMessage message;
+	int rc = SUCCESS;
+
+	for (int i = 0; i < payloadLen; i++)
+	{
+		payload[i] = (uint8_t)i;
+	}
+	for (int i = 0; (i < count) && (rc == SUCCESS); i++)
+	{
+		message.qos = qos;
+		message.retained = 0;
+		message.dup = 0;
+		message.payload = payload;
+		message.payloadlen = payloadLen;
+		rc = MQTTPublish(&client, "ut/window", &message);
+	}
+	return rc;
+}
+
+static int publish(int count)
+{
+	return publishSized(count, QOS1, 64);
+}
+
+void testMqttWindowPipelined(void)
+{
+	TickType_t start;
+
+	connect();
+	CU_ASSERT(MQTTSetPublishWindow(&client, 8) == UT_MQTTWINDOW_SLOTS);
+
+	start = xTaskGetTickCount();
+	CU_ASSERT(publish(UT_MQTTWINDOW_NUM_PUBLISH) == SUCCESS);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+
+	CU_ASSERT(broker.publishes == UT_MQTTWINDOW_NUM_PUBLISH);
+	CU_ASSERT(broker.outstanding == 0);
+	CU_ASSERT(broker.maxOutstanding == UT_MQTTWINDOW_SLOTS);
+	CU_ASSERT(broker.duplicates == 0);
+	// a round trip per window, not per publish
+	CU_ASSERT(((xTaskGetTickCount() - start) * portTICK_PERIOD_MS) < ((UT_MQTTWINDOW_NUM_PUBLISH * UT_MQTTWINDOW_RTT_MS) / 2));
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowStopAndWait(void)
+{
+	TickType_t start;
+
+	connect();
+	CU_ASSERT(MQTTSetPublishWindow(&client, 1) == 1);
+
+	start = xTaskGetTickCount();
+	CU_ASSERT(publish(UT_MQTTWINDOW_NUM_PUBLISH) == SUCCESS);
+	CU_ASSERT(((xTaskGetTickCount() - start) * portTICK_PERIOD_MS) >= (UT_MQTTWINDOW_NUM_PUBLISH * UT_MQTTWINDOW_RTT_MS));
+	CU_ASSERT(MQTTPublishFlush(&client, 0) == SUCCESS);
+
+	CU_ASSERT(broker.publishes == UT_MQTTWINDOW_NUM_PUBLISH);
+	CU_ASSERT(broker.maxOutstanding == 1);
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowLostAck(void)
+{
+	connect();
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+
+	broker.dropAcks = 1;
+	CU_ASSERT(publish(UT_MQTTWINDOW_SLOTS) == SUCCESS);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+
+	CU_ASSERT(broker.publishes == UT_MQTTWINDOW_SLOTS);
+	CU_ASSERT(broker.duplicates == 1);
+	CU_ASSERT(broker.outstanding == 0);
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowRetransmitOnYield(void)
+{
+	connect();
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+
+	broker.dropAcks = 1;
+	CU_ASSERT(publish(1) == SUCCESS);
+	vTaskDelay((UT_MQTTWINDOW_PUBACK_MS / portTICK_PERIOD_MS) + 1);
+
+	// the quiet link uses up the yield's timer before the PUBACK timeout is checked
+	CU_ASSERT(MQTTYield(&client, 1) == SUCCESS);
+	CU_ASSERT(broker.duplicates == 1);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+	CU_ASSERT(broker.outstanding == 0);
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowReconnect(void)
+{
+	connect();
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+
+	// the connection goes before any PUBACK
+	broker.linkDead = true;
+	CU_ASSERT(publish(3) == SUCCESS);
+	CU_ASSERT(MQTTPublishInflight(&client) == 3);
+	MQTTDisconnect(&client);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == FAILURE);
+	CU_ASSERT(MQTTPublishInflight(&client) == 3);
+
+	connect();
+	CU_ASSERT(broker.duplicates == 3);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+	CU_ASSERT(MQTTPublishInflight(&client) == 0);
+	CU_ASSERT(broker.publishes == 0);
+	CU_ASSERT(broker.replyCount == 0);
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowDeadLink(void)
+{
+	TickType_t start;
+
+	connect();
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+
+	broker.linkDead = true;
+	CU_ASSERT(publish(2) == SUCCESS);
+	start = xTaskGetTickCount();
+	CU_ASSERT(MQTTPublishFlush(&client, 5000) == FAILURE);
+	// given up after the retries, not at the flush timeout
+	CU_ASSERT(((xTaskGetTickCount() - start) * portTICK_PERIOD_MS) < 5000);
+	CU_ASSERT(((xTaskGetTickCount() - start) * portTICK_PERIOD_MS) >= ((MAX_PUBLISH_RETRIES + 1) * UT_MQTTWINDOW_PUBACK_MS));
+	MQTTDisconnect(&client);
+
+	// and delivered once the link is back
+	connect();
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+	CU_ASSERT(broker.duplicates == 2);
+	MQTTDisconnect(&client);
+}
+
+void testMqttPublishLarge(void)
+{
+	connect();
+
+	CU_ASSERT(publishSized(1, QOS0, UT_MQTTWINDOW_LARGE_PAYLOAD) == SUCCESS);
+	CU_ASSERT(broker.lastPayloadLen == UT_MQTTWINDOW_LARGE_PAYLOAD);
+	MQTTSetPublishWindow(&client, 1);
+	CU_ASSERT(publishSized(1, QOS1, UT_MQTTWINDOW_LARGE_PAYLOAD) == SUCCESS);
+	CU_ASSERT(broker.lastPayloadLen == UT_MQTTWINDOW_LARGE_PAYLOAD);
+	CU_ASSERT(broker.publishes == 2);
+	CU_ASSERT(broker.payloadsOk);
+
+	// a publish window slot has to hold the whole packet
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+	CU_ASSERT(publishSized(1, QOS1, UT_MQTTWINDOW_BUF_SIZE) != SUCCESS);
+	CU_ASSERT(publishSized(1, QOS1, UT_MQTTWINDOW_BUF_SIZE - 32) == SUCCESS);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+	CU_ASSERT(broker.payloadsOk);
+	MQTTDisconnect(&client);
+}
+
+void testMqttWindowQueuedWrites(void)
+{
+	network.mqttwritequeued = brokerWriteQueued;
+	connect();
+	MQTTSetPublishWindow(&client, UT_MQTTWINDOW_SLOTS);
+
+	queuedWrites = 0;
+	CU_ASSERT(publish(UT_MQTTWINDOW_NUM_PUBLISH) == SUCCESS);
+	CU_ASSERT(MQTTPublishFlush(&client, 1000) == SUCCESS);
+
+	CU_ASSERT(queuedWrites == UT_MQTTWINDOW_NUM_PUBLISH);
+	CU_ASSERT(broker.publishes == UT_MQTTWINDOW_NUM_PUBLISH);
+	CU_ASSERT(broker.outstanding == 0);
+	CU_ASSERT(broker.payloadsOk);
+	MQTTDisconnect(&client);
+	network.mqttwritequeued = NULL;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_pbSinglePass.c
+ *
+ * Encodes the PUBLISH-DATA blocks of the svctest_array DataStore items, as
+ * SvcData makes them up, both in two passes and in a single pass with the
+ * lengths back-patched, checks that the output is the same, that the data
+ * callbacks run once, and that the receive path decodes the single pass
+ * output back to what is in the DataStore.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "UnitTest.h"
+#include "pb_encode.h"
+#include "pb_decode.h"
+#include "svcdata.pb.h"
+#include "UT_svcDataFixture.h"
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+#define UT_PBSINGLEPASS_BUF_SIZE    (20000)
+
+// svctest_array index
+#define UT_PBSINGLEPASS_BYTE        (1)
+
+void testPbSinglePassSvcDataMsg(void);
+void testPbSinglePassLengths(void);
+void testPbSinglePassStreamFull(void);
+
+CUnit_suite_t UTpbsinglepass = {
+	{ "pbsinglepass", UT_SvcData_Init, UT_SvcData_Clean, CU_TRUE, "test single pass submessage encoding"},
+	{
+		{ "publish data same as two pass & decodes", testPbSinglePassSvcDataMsg },
+		{ "lengths around varint boundaries", testPbSinglePassLengths },
+		{ "stream full", testPbSinglePassStreamFull },
+		{ NULL, NULL }
+	}
+};
+
+static uint8_t bufTwoPass[UT_PBSINGLEPASS_BUF_SIZE];
+static uint8_t bufSinglePass[UT_PBSINGLEPASS_BUF_SIZE];
+
+/*
+ * Encodes the block both ways, returns true when both give the same bytes,
+ * the single pass one calling the data callbacks once
+ */
+static bool encodeBothWays(SvcDataData_t *list_p, uint32_t blockIndex, uint32_t blockCount,
+						   uint32_t offset, uint32_t nrElements, size_t *pSize)
+{
+	const SKF_SvcDataMsg *msg_p = UT_SvcData_Block(list_p, blockIndex, blockCount, offset, nrElements);
+	pb_ostream_t streamTwoPass = pb_ostream_from_buffer(bufTwoPass, sizeof(bufTwoPass));
+	pb_ostream_t streamSinglePass = pb_ostream_from_buffer_single_pass(bufSinglePass, sizeof(bufSinglePass));
+	uint32_t dataCallsTwoPass;
+	uint32_t dataCallsSinglePass;
+
+	memset(bufSinglePass, 0x5A, sizeof(bufSinglePass));
+	(void)UT_SvcData_DataCalls();
+	if (!pb_encode(&streamTwoPass, SKF_SvcDataMsg_fields, msg_p)) {
+		return false;
+	}
+	dataCallsTwoPass = UT_SvcData_DataCalls();
+	if (!pb_encode(&streamSinglePass, SKF_SvcDataMsg_fields, msg_p)) {
+		return false;
+	}
+	dataCallsSinglePass = UT_SvcData_DataCalls();
+	*pSize = streamSinglePass.bytes_written;
+	return (streamSinglePass.bytes_written == streamTwoPass.bytes_written) &&
+		   (memcmp(bufSinglePass, bufTwoPass, streamTwoPass.bytes_written) == 0) &&
+		   (dataCallsSinglePass == 2 * list_p->numberOfParamGroups) &&
+		   (dataCallsTwoPass > dataCallsSinglePass);
+}
+
+void testPbSinglePassSvcDataMsg(void)
+{
+	SKF_SvcDataMsg decoded = SKF_SvcDataMsg_init_default;
+	pb_istream_t stream;
+	size_t size;
+
+	// a publish data block as uploaded, one group of one array
+	CU_ASSERT_FATAL(encodeBothWays(UT_SvcData_ArrayList(UT_PBSINGLEPASS_BYTE), 92, 94, 92 * 1400, 1400, &size));
+	CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+
+	// the standard decoder reads it back, the callback fields are skipped in the oneof
+	stream = pb_istream_from_buffer(bufSinglePass, size);
+	CU_ASSERT_FATAL(pb_decode(&stream, SKF_SvcDataMsg_fields, &decoded));
+	CU_ASSERT(stream.bytes_left == 0);
+	CU_ASSERT(decoded.hdr.message_id == INT32_MAX);
+	CU_ASSERT(decoded.which__messages == SKF_SvcDataMsg_publish_tag);
+	CU_ASSERT(decoded._messages.publish.which__publications == SKF_Publish_data_tag);
+	CU_ASSERT(decoded._messages.publish._publications.data.block_count == 94);
+	CU_ASSERT(decoded._messages.publish._publications.data.block_index == 92);
+
+	// and every value of a few groups decodes to what is in the DataStore
+	CU_ASSERT_FATAL(encodeBothWays(UT_SvcData_GroupsList(), 0, 1, 0, 200, &size));
+	CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+
+	// every data type
+	for (uint32_t a = 0; a < UT_SVCDATA_NUM_ARRAYS; a++) {
+		CU_ASSERT(encodeBothWays(UT_SvcData_ArrayList(a), 1, 3, 1000, 1000, &size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+	}
+}
+
+/*
+ * Encodes the block in a single pass into a buffer of bufSize bytes,
+ * returns true when it fits
+ */
+static bool encodeSinglePass(SvcDataData_t *list_p, uint32_t nrElements, size_t bufSize)
+{
+	const SKF_SvcDataMsg *msg_p = UT_SvcData_Block(list_p, 0, 1, 0, nrElements);
+	pb_ostream_t stream = pb_ostream_from_buffer_single_pass(bufSinglePass, bufSize);
+
+	return pb_encode(&stream, SKF_SvcDataMsg_fields, msg_p) && (stream.bytes_written == bufSize);
+}
+
+/*
+ * The submessage lengths take 1 to 3 bytes, and fewer than reserved in all
+ * but the outer ones, so that most are moved down after encoding
+ */
+void testPbSinglePassLengths(void)
+{
+	SvcDataData_t *list_p = UT_SvcData_ArrayList(UT_PBSINGLEPASS_BYTE);
+	size_t size;
+
+	// the data, value, group and message lengths around 127 and 16383 bytes
+	for (uint32_t nrElements = 1; nrElements < 160; nrElements++) {
+		CU_ASSERT(encodeBothWays(list_p, 0, 1, 0, nrElements, &size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+	}
+	for (uint32_t nrElements = 16320; nrElements < 16400; nrElements++) {
+		CU_ASSERT(encodeBothWays(list_p, 0, 1, 0, nrElements, &size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+		// in a buffer that fits it exactly, where the room left for the outer
+		// submessage and its length needs a longer varint than the submessage,
+		// e.g. 16385 bytes for a 16383 byte submessage with a 2 byte length
+		CU_ASSERT(encodeSinglePass(list_p, nrElements, size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+		CU_ASSERT(!encodeSinglePass(list_p, nrElements, size - 1));
+	}
+	CU_ASSERT(encodeBothWays(list_p, 0, 1, 0, 19000, &size));
+	CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+
+	// several groups of several values, each their own length
+	list_p = UT_SvcData_GroupsList();
+	for (uint32_t nrElements = 1; nrElements < 40; nrElements++) {
+		CU_ASSERT(encodeBothWays(list_p, 0, 1, 0, nrElements, &size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+	}
+	for (uint32_t nrElements = 355; nrElements < 375; nrElements++) {
+		CU_ASSERT(encodeBothWays(list_p, 0, 1, 0, nrElements, &size));
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+	}
+}
+
+/*
+ * The single pass encoding fails with "stream full" in a buffer too small
+ * for the message, and fits any buffer at least as large
+ */
+void testPbSinglePassStreamFull(void)
+{
+	const SKF_SvcDataMsg *msg_p;
+	pb_ostream_t stream;
+	size_t size;
+
+	CU_ASSERT_FATAL(encodeBothWays(UT_SvcData_GroupsList(), 0, 1, 0, 10, &size));
+	msg_p = UT_SvcData_Block(UT_SvcData_GroupsList(), 0, 1, 0, 10);
+
+	for (size_t bufSize = 0; bufSize < size; bufSize++) {
+		stream = pb_ostream_from_buffer_single_pass(bufSinglePass, bufSize);
+		CU_ASSERT(!pb_encode(&stream, SKF_SvcDataMsg_fields, msg_p));
+		CU_ASSERT((stream.errmsg != NULL) && (strcmp(stream.errmsg, "stream full") == 0));
+	}
+	for (size_t bufSize = size; bufSize < size + 4; bufSize++) {
+		memset(bufSinglePass, 0x5A, sizeof(bufSinglePass));
+		stream = pb_ostream_from_buffer_single_pass(bufSinglePass, bufSize);
+		CU_ASSERT(pb_encode(&stream, SKF_SvcDataMsg_fields, msg_p));
+		CU_ASSERT(stream.bytes_written == size);
+		CU_ASSERT(UT_SvcData_Check(bufSinglePass, size));
+	}
+	// nothing written past the buffer
+	stream = pb_ostream_from_buffer_single_pass(bufSinglePass, size - 1);
+	memset(bufSinglePass, 0x5A, sizeof(bufSinglePass));
+	CU_ASSERT(!pb_encode(&stream, SKF_SvcDataMsg_fields, msg_p));
+	CU_ASSERT(bufSinglePass[size - 1] == 0x5A);
+}
+
+#endif // CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,388 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_svcDataFixture.c
+ *
+ * The PUBLISH-DATA blocks as SvcData makes them up, the data lists with the
+ * svctest_array DataStore items, and a decoder checking a block against the
+ * DataStore. The arrays all share the sample buffer, which is filled with a
+ * pattern.
+ *
+ * NOTE! The blocks are made up in the SvcData state, so not while publishing.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pb_decode.h"
+#include "svcdata.pb.h"
+#include "configData.h"
+#include "DataStore.h"
+#include "SvcData.h"
+#include "SvcDataMsg.h"
+#include "linker.h"
+#include "UT_svcDataFixture.h"
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+static const struct {
+	IDEF_paramid_t paramId;
+	DD_Type_enum ddType;
+	SKF_Value_t valueType;
+} arrays[UT_SVCDATA_NUM_ARRAYS] = {
+	{ IDEFTEST_ARRAY_BOOL, DD_TYPE_BOOL, SKF_Value_t_BOOL },
+	{ IDEFTEST_ARRAY_BYTE, DD_TYPE_BYTE, SKF_Value_t_BYTE },
+	{ IDEFTEST_ARRAY_SBYTE, DD_TYPE_SBYTE, SKF_Value_t_BYTE },
+	{ IDEFTEST_ARRAY_INT16, DD_TYPE_INT16, SKF_Value_t_INT16 },
+	{ IDEFTEST_ARRAY_UINT16, DD_TYPE_UINT16, SKF_Value_t_UINT16 },
+	{ IDEFTEST_ARRAY_INT32, DD_TYPE_INT32, SKF_Value_t_INT32 },
+	{ IDEFTEST_ARRAY_UINT32, DD_TYPE_UINT32, SKF_Value_t_UINT32 },
+	{ IDEFTEST_ARRAY_INT64, DD_TYPE_INT64, SKF_Value_t_INT64 },
+	{ IDEFTEST_ARRAY_UINT64, DD_TYPE_UINT64, SKF_Value_t_UINT64 },
+	{ IDEFTEST_ARRAY_SINGLE, DD_TYPE_SINGLE, SKF_Value_t_SINGLE },
+	{ IDEFTEST_ARRAY_DOUBLE, DD_TYPE_DOUBLE, SKF_Value_t_DOUBLE },
+	{ IDEFTEST_ARRAY_DATETIME, DD_TYPE_DATETIME, SKF_Value_t_UINT64 },
+};
+
+static const IDEF_paramid_t groupValues[UT_SVCDATA_GROUP_VALUES] = {
+	IDEFTEST_ARRAY_BYTE,
+	IDEFTEST_ARRAY_INT16,
+	IDEFTEST_ARRAY_UINT32,
+	IDEFTEST_ARRAY_DOUBLE,
+};
+
+static bool countDataCalls(uint32_t iter, const SvcDataParamValueGroup_t * dpvg_p);
+
+static SvcDataParamValueGroup_t groups[UT_SVCDATA_NUM_GROUPS] = {
+	{ SVCDATATEST_TIMESTAMPA, UT_SVCDATA_GROUP_VALUES, (IDEF_paramid_t *) groupValues },
+	{ SVCDATATEST_TIMESTAMPB, UT_SVCDATA_GROUP_VALUES, (IDEF_paramid_t *) groupValues },
+	{ SVCDATATEST_TIMESTAMPC, UT_SVCDATA_GROUP_VALUES, (IDEF_paramid_t *) groupValues },
+};
+static SvcDataData_t groupsList = { UT_SVCDATA_NUM_GROUPS, groups, &countDataCalls };
+
+// one group with one array each
+static SvcDataParamValueGroup_t arrayGroups[UT_SVCDATA_NUM_ARRAYS];
+static SvcDataData_t arrayLists[UT_SVCDATA_NUM_ARRAYS];
+
+// the block last made up, and the data callback count
+static struct {
+	SvcDataData_t * list_p;
+	uint32_t blockIndex;
+	uint32_t blockCount;
+	uint32_t offset;
+	uint32_t nrElements;
+	uint32_t dataCalls;
+} block;
+
+// what the decoder found
+static struct {
+	uint32_t groups;
+	uint32_t values;
+	bool dataSeen;
+	bool ok;
+} dec;
+
+static const DataDef_t * paramDataDef(uint32_t paramId)
+{
+	return getDataDefElementById(SvcData_IdefIdToDataStoreId(paramId));
+}
+
+static uint32_t elementSize(const DataDef_t * dataDef_p)
+{
+	return DATADEFTYPE2SIZE(dataDef_p->type);
+}
+
+/*
+ * countDataCalls
+ *
+ * @desc	the data list callback, each group once, as without a callback
+ */
+static bool countDataCalls(uint32_t iter, const SvcDataParamValueGroup_t * dpvg_p)
+{
+	block.dataCalls++;
+	return iter == 0;
+}
+
+int UT_SvcData_Init(void)
+{
+	const DataDef_t * dataDef_p = paramDataDef(IDEFTEST_ARRAY_BYTE);
+	uint8_t * p = (uint8_t *) __sample_buffer;
+
+	if (dataDef_p == NULL)
+	{
+		return 1;
+	}
+	for (uint32_t i = 0; i < dataDef_p->length; i++)
+	{
+		p[i] = (uint8_t)((i * 7) + (i >> 8));
+	}
+
+	for (uint32_t a = 0; a < UT_SVCDATA_NUM_ARRAYS; a++)
+	{
+		arrayGroups[a].timestampDatastoreId = SVCDATATEST_TIMESTAMPA;
+		arrayGroups[a].numberOfParamValues = 1;
+		arrayGroups[a].ParamValue_p = (IDEF_paramid_t *) &arrays[a].paramId;
+		arrayLists[a].numberOfParamGroups = 1;
+		arrayLists[a].ParamValueGroup_p = &arrayGroups[a];
+		arrayLists[a].dataData_cb = &countDataCalls;
+		if (paramDataDef(arrays[a].paramId) == NULL)
+		{
+			return 1;
+		}
+	}
+	memset(&block, 0, sizeof(block));
+
+	return 0;
+}
+
+int UT_SvcData_Clean(void)
+{
+	SvcData_TestEnd();
+
+	return 0;
+}
+
+/*
+ * UT_SvcData_ArrayList
+ *
+ * @desc	the data list of one group with the one array
+ *
+ * @param	array - 0 to UT_SVCDATA_NUM_ARRAYS-1, one for each data type
+ */
+SvcDataData_t * UT_SvcData_ArrayList(uint32_t array)
+{
+	return &arrayLists[array];
+}
+
+uint32_t UT_SvcData_ArrayLength(uint32_t array)
+{
+	return paramDataDef(arrays[array].paramId)->length;
+}
+
+uint32_t UT_SvcData_ElementSize(uint32_t array)
+{
+	return elementSize(paramDataDef(arrays[array].paramId));
+}
+
+/*
+ * UT_SvcData_GroupsList
+ *
+ * @desc	the data list of UT_SVCDATA_NUM_GROUPS groups with UT_SVCDATA_GROUP_VALUES arrays each
+ */
+SvcDataData_t * UT_SvcData_GroupsList(void)
+{
+	return &groupsList;
+}
+
+/*
+ * UT_SvcData_Block
+ *
+ * @desc	the PUBLISH-DATA message of a block, as SvcData makes it up
+ *
+ * @param	list_p - the data list, its arrays must have offset+nrElements elements
+ * @param	blockIndex, blockCount - the block in the transfer
+ * @param	offset, nrElements - the elements of the block
+ *
+ * @returns	the message, to encode or size
+ */
+const SKF_SvcDataMsg * UT_SvcData_Block(SvcDataData_t * list_p, uint32_t blockIndex, uint32_t blockCount,
+										uint32_t offset, uint32_t nrElements)
+{
+	block.list_p = list_p;
+	block.blockIndex = blockIndex;
+	block.blockCount = blockCount;
+	block.offset = offset;
+	block.nrElements = nrElements;
+
+	return SvcData_TestPublishDataBlock(list_p, blockIndex, blockCount, offset, nrElements);
+}
+
+/*
+ * UT_SvcData_Plan
+ *
+ * @desc	the elements per block SvcData plans for nrElements of a one array list
+ */
+uint32_t UT_SvcData_Plan(SvcDataData_t * list_p, uint32_t nrElements, size_t maxSize)
+{
+	return SvcData_TestPlanBlocks(list_p, nrElements, maxSize);
+}
+
+/*
+ * UT_SvcData_DataCalls
+ *
+ * @desc	the data list callbacks since the last call, one per group and one ending the groups
+ *			each time the groups are encoded
+ */
+uint32_t UT_SvcData_DataCalls(void)
+{
+	uint32_t calls = block.dataCalls;
+
+	block.dataCalls = 0;
+	return calls;
+}
+
+static SKF_Value_t valueType(DD_Type_enum ddType)
+{
+	for (uint32_t a = 0; a < UT_SVCDATA_NUM_ARRAYS; a++)
+	{
+		if (arrays[a].ddType == ddType)
+		{
+			return arrays[a].valueType;
+		}
+	}
+	return SKF_Value_t_STRING;
+}
+
+/*
+ * decodeData
+ *
+ * @desc	the elements, in network order, against those in the DataStore
+ */
+static bool decodeData(pb_istream_t *stream_p, const pb_field_t *field, void **arg)
+{
+	const DataDef_t * dataDef_p = *arg;
+	uint32_t size = elementSize(dataDef_p);
+	const uint8_t * element_p = &dataDef_p->address[block.offset * size];
+	uint8_t bytes[sizeof(uint64_t)];
+
+	dec.dataSeen = true;
+	if (stream_p->bytes_left != (block.nrElements * size))
+	{
+		dec.ok = false;
+	}
+	for (uint32_t n = 0; (n < block.nrElements) && (stream_p->bytes_left >= size); n++)
+	{
+		if (!pb_read(stream_p, bytes, size))
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < size; i++)
+		{
+			if (bytes[i] != element_p[size - 1 - i])
+			{
+				dec.ok = false;
+			}
+		}
+		element_p += size;
+	}
+	return (stream_p->bytes_left == 0) || pb_read(stream_p, NULL, stream_p->bytes_left);
+}
+
+static bool decodeParameterValue(pb_istream_t *stream_p, const pb_field_t *field, void **arg)
+{
+	const SvcDataParamValueGroup_t * group_p = *arg;
+	SKF_ParameterValue parVal = SKF_ParameterValue_init_default;
+	const DataDef_t * dataDef_p;
+
+	if (dec.values >= group_p->numberOfParamValues)
+	{
+		return false;
+	}
+	dataDef_p = paramDataDef(group_p->ParamValue_p[dec.values]);
+	if (dataDef_p == NULL)
+	{
+		return false;
+	}
+
+	dec.dataSeen = false;
+	parVal.value.data.funcs.decode = &decodeData;
+	parVal.value.data.arg = (void *) dataDef_p;
+	if (!pb_decode_noinit(stream_p, SKF_ParameterValue_fields, &parVal))
+	{
+		return false;
+	}
+	if ((parVal.parameter_id != (uint32_t) group_p->ParamValue_p[dec.values]) || !parVal.has_offset ||
+		(parVal.offset != (int32_t) block.offset) || (parVal.value.value_type != valueType(dataDef_p->type)) ||
+		!dec.dataSeen)
+	{
+		dec.ok = false;
+	}
+	dec.values++;
+	return true;
+}
+
+static bool decodeParameterValueGroup(pb_istream_t *stream_p, const pb_field_t *field, void **arg)
+{
+	SKF_ParameterValueGroup parValGrp = SKF_ParameterValueGroup_init_default;
+	const SvcDataParamValueGroup_t * group_p;
+
+	if (dec.groups >= block.list_p->numberOfParamGroups)
+	{
+		return false;
+	}
+	group_p = &block.list_p->ParamValueGroup_p[dec.groups];
+
+	dec.values = 0;
+	parValGrp.param_values.funcs.decode = &decodeParameterValue;
+	parValGrp.param_values.arg = (void *) group_p;
+	if (!pb_decode_noinit(stream_p, SKF_ParameterValueGroup_fields, &parValGrp))
+	{
+		return false;
+	}
+	if ((parValGrp.timestamp != DataStore_GetUint64(group_p->timestampDatastoreId, 0)) ||
+		(dec.values != group_p->numberOfParamValues))
+	{
+		dec.ok = false;
+	}
+	dec.groups++;
+	return true;
+}
+
+/*
+ * UT_SvcData_Check
+ *
+ * @desc	decodes an encoded block the way the receive path does, and checks it is the block
+ *			last made up: header, block index and count, groups, values and all their elements
+ *
+ * @param	buf_p - the encoded message
+ * @param	size - its size
+ *
+ * @returns	true when it is
+ */
+bool UT_SvcData_Check(const uint8_t * buf_p, size_t size)
+{
+	SKF_SvcDataMsg msg = SKF_SvcDataMsg_init_default;
+	SKF_DataPub *data_p = &msg._messages.publish._publications.data;
+	pb_istream_t stream = pb_istream_from_buffer((uint8_t *) buf_p, size);
+	pb_istream_t substream, subsubstream;
+	const pb_field_t *fields_p;
+	bool rc_ok;
+
+	memset(&dec, 0, sizeof(dec));
+	dec.ok = true;
+
+	if (!SvcDataMsg_DecodeHeader(&stream, &msg) ||
+		!getSubStreamForTargetFields(&stream, SKF_SvcDataMsg_fields, SKF_Publish_fields, SKF_SvcDataMsg_publish_tag,
+									 &fields_p, &substream))
+	{
+		return false;
+	}
+	rc_ok = getSubStreamForTargetFields(&substream, SKF_Publish_fields, SKF_DataPub_fields, SKF_Publish_data_tag,
+										&fields_p, &subsubstream);
+	if (rc_ok)
+	{
+		data_p->data.param_value_groups.funcs.decode = &decodeParameterValueGroup;
+		rc_ok = pb_decode_noinit(&subsubstream, SKF_DataPub_fields, data_p) && (subsubstream.bytes_left == 0);
+		pb_close_string_substream(&substream, &subsubstream);
+	}
+	rc_ok = rc_ok && (substream.bytes_left == 0);
+	pb_close_string_substream(&stream, &substream);
+
+	return rc_ok && dec.ok && (stream.bytes_left == 0) &&
+		   (msg.hdr.function_id == SKF_FunctionId_PUBDATA) && (msg.hdr.type == SKF_MsgType_PUBLISH) &&
+		   (msg.hdr.message_id == INT32_MAX) &&
+		   (data_p->has_block_count == (block.blockCount > 1)) && (data_p->has_block_index == (block.blockCount > 1)) &&
+		   ((block.blockCount <= 1) ||
+			((data_p->block_count == (int32_t) block.blockCount) && (data_p->block_index == (int32_t) block.blockIndex))) &&
+		   (dec.groups == block.list_p->numberOfParamGroups);
+}
+
+#endif // CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+
+#ifdef __cplusplus
+}
+#endif
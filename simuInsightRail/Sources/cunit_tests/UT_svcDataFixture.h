@@ -0,0 +1,55 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_svcDataFixture.h
+ *
+ * The PUBLISH-DATA blocks as SvcData makes them up, encoded by the SvcDataMsg
+ * parameter value callbacks from the svctest_array DataStore items, for the
+ * unit tests of the block planning and of the single pass encoding.
+ */
+
+#ifndef UT_SVCDATAFIXTURE_H_
+#define UT_SVCDATAFIXTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "configFeatures.h"
+#include "configIDEF.h"
+#include "svcdata.pb.h"
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+// the svctest_array items, one of every data type
+#define UT_SVCDATA_NUM_ARRAYS       (12)
+
+// the groups of UT_SvcData_GroupsList()
+#define UT_SVCDATA_NUM_GROUPS       (3)
+#define UT_SVCDATA_GROUP_VALUES     (4)
+
+int UT_SvcData_Init(void);
+int UT_SvcData_Clean(void);
+
+SvcDataData_t * UT_SvcData_ArrayList(uint32_t array);
+uint32_t UT_SvcData_ArrayLength(uint32_t array);
+uint32_t UT_SvcData_ElementSize(uint32_t array);
+SvcDataData_t * UT_SvcData_GroupsList(void);
+
+const SKF_SvcDataMsg * UT_SvcData_Block(SvcDataData_t * list_p, uint32_t blockIndex, uint32_t blockCount,
+                                        uint32_t offset, uint32_t nrElements);
+uint32_t UT_SvcData_Plan(SvcDataData_t * list_p, uint32_t nrElements, size_t maxSize);
+
+uint32_t UT_SvcData_DataCalls(void);
+bool UT_SvcData_Check(const uint8_t * buf_p, size_t size);
+
+#endif // CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+#endif /* UT_SVCDATAFIXTURE_H_ */
+
+
+#ifdef __cplusplus
+}
+#endif
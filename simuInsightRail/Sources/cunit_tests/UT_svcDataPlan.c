@@ -0,0 +1,139 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_svcDataPlan.c
+ *
+ * Plans block transfers of the svctest_array DataStore items of every data
+ * type as SvcData does, and checks by encoding the PUBLISH-DATA blocks that
+ * each block fits the buffer, that one more element per block would not, and
+ * that the sizes the plan is made with are exact.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "UnitTest.h"
+#include "pb_encode.h"
+#include "svcdata.pb.h"
+#include "SvcDataMsg.h"
+#include "UT_svcDataFixture.h"
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+#define UT_SVCDATAPLAN_BUF_SIZE     (1460)
+
+// svctest_array indices
+#define UT_SVCDATAPLAN_BYTE         (1)
+#define UT_SVCDATAPLAN_DOUBLE       (10)
+
+void testSvcDataPlanAllTypes(void);
+void testSvcDataPlanSmallBuffers(void);
+void testSvcDataPlanNothingFits(void);
+
+CUnit_suite_t UTsvcdataplan = {
+	{ "svcdataplan", UT_SvcData_Init, UT_SvcData_Clean, CU_TRUE, "test publish data block planning"},
+	{
+		{ "blocks full & fitting, all data types", testSvcDataPlanAllTypes },
+		{ "small buffers", testSvcDataPlanSmallBuffers },
+		{ "nothing fits", testSvcDataPlanNothingFits },
+		{ NULL, NULL }
+	}
+};
+
+static uint8_t buf[UT_SVCDATAPLAN_BUF_SIZE * 2];
+
+/*
+ * Encodes all blocks with perBlock elements in each, as they are sent, returns
+ * the largest, or more than maxSize when one does not encode
+ */
+static size_t encodeBlocks(SvcDataData_t *list_p, uint32_t nrElements, uint32_t perBlock, size_t maxSize, bool *pSizingExact)
+{
+	uint32_t blockCount = (nrElements + perBlock - 1) / perBlock;
+	size_t largest = 0;
+	size_t sized;
+
+	for (uint32_t i = 0; i < blockCount; i++) {
+		uint32_t offset = i * perBlock;
+		uint32_t count = ((nrElements - offset) < perBlock) ? (nrElements - offset) : perBlock;
+		pb_ostream_t stream = pb_ostream_from_buffer_single_pass(buf, maxSize);
+		const SKF_SvcDataMsg *msg_p = UT_SvcData_Block(list_p, i, blockCount, offset, count);
+
+		if (!pb_encode(&stream, SKF_SvcDataMsg_fields, msg_p)) {
+			return maxSize + 1;
+		}
+		if (stream.bytes_written > largest) {
+			largest = stream.bytes_written;
+		}
+		// the sizing pass the plan is made with
+		if (!pb_get_encoded_size(&sized, SKF_SvcDataMsg_fields, msg_p) || (sized != stream.bytes_written)) {
+			*pSizingExact = false;
+		}
+	}
+	return largest;
+}
+
+static void checkPlan(uint32_t array, uint32_t nrElements, size_t maxSize)
+{
+	SvcDataData_t *list_p = UT_SvcData_ArrayList(array);
+	uint32_t perBlock = UT_SvcData_Plan(list_p, nrElements, maxSize);
+	bool sizingExact = true;
+
+	CU_ASSERT_FATAL(perBlock > 0);
+	CU_ASSERT(perBlock <= nrElements);
+	CU_ASSERT(encodeBlocks(list_p, nrElements, perBlock, maxSize, &sizingExact) <= maxSize);
+	CU_ASSERT(sizingExact);
+
+	// as full as they can be, one more does not fit
+	if (perBlock < nrElements) {
+		CU_ASSERT(encodeBlocks(list_p, nrElements, perBlock + 1, sizeof(buf), &sizingExact) > maxSize);
+	}
+}
+
+void testSvcDataPlanAllTypes(void)
+{
+	static const uint32_t counts[] = { 1, 7, 1000, 8192, 65536 };
+
+	for (uint32_t a = 0; a < UT_SVCDATA_NUM_ARRAYS; a++) {
+		for (int c = 0; c < sizeof(counts)/sizeof(counts[0]); c++) {
+			// as many as the array has
+			uint32_t count = (counts[c] < UT_SvcData_ArrayLength(a)) ? counts[c] : UT_SvcData_ArrayLength(a);
+
+			checkPlan(a, count, UT_SVCDATAPLAN_BUF_SIZE);
+		}
+	}
+}
+
+/*
+ * Small buffers, where the length fields are near a varint boundary
+ */
+void testSvcDataPlanSmallBuffers(void)
+{
+	for (size_t maxSize = 60; maxSize < 300; maxSize++) {
+		checkPlan(UT_SVCDATAPLAN_BYTE, 1000, maxSize);
+	}
+
+	for (size_t maxSize = 100; maxSize < 300; maxSize += 7) {
+		checkPlan(UT_SVCDATAPLAN_DOUBLE, 1000, maxSize);
+	}
+}
+
+void testSvcDataPlanNothingFits(void)
+{
+	SvcDataData_t *list_p = UT_SvcData_ArrayList(UT_SVCDATAPLAN_DOUBLE);
+	size_t overhead;
+
+	CU_ASSERT_FATAL(pb_get_encoded_size(&overhead, SKF_SvcDataMsg_fields, UT_SvcData_Block(list_p, 0, 1, 0, 0)));
+
+	CU_ASSERT(UT_SvcData_Plan(list_p, 100, overhead) == 0);
+	CU_ASSERT(UT_SvcData_Plan(list_p, 100, overhead + 4) == 0);
+	CU_ASSERT(UT_SvcData_Plan(list_p, 0, UT_SVCDATAPLAN_BUF_SIZE) == 0);
+	CU_ASSERT(SvcDataMsg_PlanBlockElements(100, 0, UT_SVCDATAPLAN_BUF_SIZE, NULL, NULL) == 0);
+}
+
+#endif // CONFIG_PLATFORM_IDEFSVCTESTDATA
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UT_waveCodec.c
+ *
+ * Round trips waveforms like the ones recorded through the codec, checks the
+ * compression they get, and that damaged streams are rejected.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "UnitTest.h"
+#include "waveCodec.h"
+
+#define UT_WAVECODEC_NUM_SAMPLES    (8192)
+#define UT_WAVECODEC_SPS            (25600)
+
+void testWaveCodecRecorded(void);
+void testWaveCodecLengths(void);
+void testWaveCodecIncompressible(void);
+void testWaveCodecInPlace(void);
+void testWaveCodecCorrupt(void);
+
+CUnit_suite_t UTwavecodec = {
+	{ "wavecodec", NULL, NULL, CU_TRUE, "test lossless waveform codec"},
+	{
+		{ "recorded waveforms round trip & compress", testWaveCodecRecorded },
+		{ "partial blocks round trip", testWaveCodecLengths },
+		{ "incompressible waveforms round trip", testWaveCodecIncompressible },
+		{ "in place encoding", testWaveCodecInPlace },
+		{ "damaged streams rejected", testWaveCodecCorrupt },
+		{ NULL, NULL }
+	}
+};
+
+static int32_t waveform[UT_WAVECODEC_NUM_SAMPLES];
+static int32_t decoded[UT_WAVECODEC_NUM_SAMPLES];
+static uint8_t encoded[(UT_WAVECODEC_NUM_SAMPLES * 4) + 64 + WAVECODEC_HEADER_BYTES];
+static uint32_t seed;
+
+static int32_t noise(int32_t amplitude)
+{
+	seed = (seed * 1664525u) + 1013904223u;
+	return (int32_t)(((int64_t)(int32_t)seed * amplitude) >> 31);
+}
+
+/*
+ * Like a raw acceleration capture: wheel rotation harmonics, decaying bearing
+ * defect impulses and broadband noise, in 24 bit ADC counts
+ */
+static void makeRaw(uint32_t numSamples, int32_t noiseAmplitude)
+{
+	const double wheelHz = 11.3;
+
+	seed = 12345;
+	for(uint32_t i = 0; i < numSamples; i++)
+	{
+		double t = (double)i / UT_WAVECODEC_SPS;
+		double v = 200000.0 * sin(2 * 3.14159265358979 * wheelHz * t) +
+				   60000.0 * sin(2 * 3.14159265358979 * 3 * wheelHz * t + 0.5);
+
+		// defect impulse every 1/97 s, ringing at 3.1kHz
+		double tImpulse = fmod(t, 1.0 / 97);
+		v += 300000.0 * exp(-tImpulse * 6000.0) * sin(2 * 3.14159265358979 * 3100.0 * tImpulse);
+
+		waveform[i] = (int32_t)floor(v + 0.5) + noise(noiseAmplitude);
+	}
+}
+
+static bool roundTrip(uint32_t numSamples, int32_t *pBytes)
+{
+	float scaling = 0.0f;
+	int32_t bytes = waveCodec_Encode(waveform, numSamples, 1.25e-6f, encoded, sizeof(encoded));
+
+	*pBytes = bytes;
+	if ((bytes < 0) || (bytes > waveCodec_MaxEncodedBytes(numSamples)))
+	{
+		return false;
+	}
+	memset(decoded, 0x5A, sizeof(decoded));
+	return (waveCodec_Decode(encoded, bytes, decoded, UT_WAVECODEC_NUM_SAMPLES, &scaling) == (int32_t)numSamples) &&
+		   (memcmp(decoded, waveform, numSamples * sizeof(int32_t)) == 0) &&
+		   (scaling == 1.25e-6f);
+}
+
+void testWaveCodecRecorded(void)
+{
+	int32_t bytes;
+
+	// quiet, as the decimated vibration & wheel flat streams
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 50);
+	CU_ASSERT(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+	CU_ASSERT(bytes < (UT_WAVECODEC_NUM_SAMPLES * sizeof(int32_t)) / 3);
+
+	// noisy raw capture, still under half
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 2000);
+	CU_ASSERT(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+	CU_ASSERT(bytes < (UT_WAVECODEC_NUM_SAMPLES * sizeof(int32_t)) / 2);
+}
+
+void testWaveCodecLengths(void)
+{
+	static const uint32_t lengths[] = { 0, 1, 2, 3, WAVECODEC_BLOCK_SAMPLES - 1, WAVECODEC_BLOCK_SAMPLES,
+										WAVECODEC_BLOCK_SAMPLES + 1, WAVECODEC_BLOCK_SAMPLES + 2, 1000 };
+	int32_t bytes;
+
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 2000);
+	for(int i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++)
+	{
+		CU_ASSERT(roundTrip(lengths[i], &bytes));
+	}
+	CU_ASSERT(waveCodec_Encode(waveform, 0, 1.0f, encoded, sizeof(encoded)) == WAVECODEC_HEADER_BYTES);
+}
+
+void testWaveCodecIncompressible(void)
+{
+	int32_t bytes;
+
+	// full scale noise, and the extreme values with the largest residuals
+	seed = 1;
+	for(int i = 0; i < UT_WAVECODEC_NUM_SAMPLES; i++)
+	{
+		waveform[i] = noise(INT32_MAX);
+	}
+	CU_ASSERT(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+
+	for(int i = 0; i < UT_WAVECODEC_NUM_SAMPLES; i++)
+	{
+		waveform[i] = ((i / 3) & 1) ? INT32_MAX : INT32_MIN;
+	}
+	CU_ASSERT(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+
+	// mostly quiet with a few full scale spikes, which take the escape code
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 50);
+	waveform[1000] = INT32_MAX;
+	waveform[1001] = INT32_MIN;
+	waveform[4095] = INT32_MIN;
+	CU_ASSERT(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+	CU_ASSERT(bytes < (UT_WAVECODEC_NUM_SAMPLES * sizeof(int32_t)) / 3);
+
+	// no room
+	CU_ASSERT(waveCodec_Encode(waveform, UT_WAVECODEC_NUM_SAMPLES, 1.0f, encoded, bytes - 1) < 0);
+}
+
+void testWaveCodecInPlace(void)
+{
+	static int32_t buffer[UT_WAVECODEC_NUM_SAMPLES];
+	int32_t bytes;
+
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 20000);
+	memcpy(buffer, waveform, sizeof(buffer));
+	bytes = waveCodec_Encode(buffer, UT_WAVECODEC_NUM_SAMPLES, 1.0f, (uint8_t *)buffer, sizeof(buffer));
+	CU_ASSERT_FATAL(bytes > 0);
+	CU_ASSERT(waveCodec_Decode((uint8_t *)buffer, bytes, decoded, UT_WAVECODEC_NUM_SAMPLES, NULL) == UT_WAVECODEC_NUM_SAMPLES);
+	CU_ASSERT(memcmp(decoded, waveform, sizeof(decoded)) == 0);
+
+	// a waveform that does not compress cannot be coded over itself
+	seed = 7;
+	for(int i = 0; i < UT_WAVECODEC_NUM_SAMPLES; i++)
+	{
+		buffer[i] = noise(INT32_MAX);
+	}
+	CU_ASSERT(waveCodec_Encode(buffer, UT_WAVECODEC_NUM_SAMPLES, 1.0f, (uint8_t *)buffer, sizeof(buffer)) < 0);
+}
+
+void testWaveCodecCorrupt(void)
+{
+	int32_t bytes;
+
+	makeRaw(UT_WAVECODEC_NUM_SAMPLES, 2000);
+	CU_ASSERT_FATAL(roundTrip(UT_WAVECODEC_NUM_SAMPLES, &bytes));
+
+	// truncated
+	CU_ASSERT(waveCodec_Decode(encoded, bytes - 1, decoded, UT_WAVECODEC_NUM_SAMPLES, NULL) < 0);
+	CU_ASSERT(waveCodec_Decode(encoded, WAVECODEC_HEADER_BYTES - 1, decoded, UT_WAVECODEC_NUM_SAMPLES, NULL) < 0);
+	// too long for the output
+	CU_ASSERT(waveCodec_Decode(encoded, bytes, decoded, UT_WAVECODEC_NUM_SAMPLES - 1, NULL) < 0);
+	// not a codec stream
+	encoded[0] = 'X';
+	CU_ASSERT(waveCodec_Decode(encoded, bytes, decoded, UT_WAVECODEC_NUM_SAMPLES, NULL) < 0);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
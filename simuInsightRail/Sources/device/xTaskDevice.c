@@ -651,6 +651,7 @@ bool xTaskDeviceShutdown(bool bCommsCycle)
  *			2. Update Config & Data in the NVM, if they have changed.
  * 			3. Update the energy used.Updates the total energy consumed by the
  * 			   sensor in comms cycle.
+ * 			4. Commit the event log entries still in RAM.
  *
  * @param	bIsCommsCycle - Indicate whether it is a COMMS cycle.
  *
@@ -669,6 +670,11 @@ static void PrepareShutdown(bool bIsCommsCycle)
     // If the CFG data has changed, update the NVM with the RAM copy.
     NvmConfigUpdateIfChanged(false);
 
+#ifdef CONFIG_PLATFORM_EVENT_LOG
+    // The event log entries in RAM are lost at power down
+    EventLog_Flush();
+#endif
+
     if(!Device_HasPMIC() && (PutNodeToSleep(retrycount) == false))
     {
     	LOG_EVENT( 0, LOG_NUM_APP, ERRLOGDEBUG, "Node powerdown failed, RetryLeft:%d",retrycount - 1);
@@ -546,7 +546,7 @@ bool AD7766_PreProcessRawSpiIntoSampleVal(uint32_t AdcRawValIn,
                  ((AdcRawValIn & 0xFF000000U) >> 24);    // Lower 8 bits
     *pSampleValOut = AD7766_ConvertRawToSigned(AD7766Word);
 
-    if (((AdcRawValIn & 0x00FF0000U) >> 16) != 0xB3)        // ********* TODO: Tie in the check byte value in with the DSPI Tx buffer generation
+    if ((AdcRawValIn & AD7766_SPI_ECHO_BYTE_MASK) != AD7766_SPI_ECHO_BYTE_EXPECTED)        // ********* TODO: Tie in the check byte value in with the DSPI Tx buffer generation
 #endif
     {
         AD7766_SetError(AD7766ERROR_SPI_ECHO_BYTE_MISMATCH);
@@ -556,6 +556,99 @@ bool AD7766_PreProcessRawSpiIntoSampleVal(uint32_t AdcRawValIn,
     return true;
 }
 
+/*
+ * AD7766_PreProcessRawSpiBlock
+ *
+ * @desc    Block version of AD7766_PreProcessRawSpiIntoSampleVal(), for the
+ *          real-time sample handling - converts a block of raw AD7766 SPI
+ *          words into signed sample values in a single unrolled pass, and
+ *          optionally subtracts a DC offset at the same time. The echo bytes
+ *          are checked for the whole block at once, by accumulating their
+ *          differences from the expected value. The input and output blocks
+ *          can be the same buffer (typecast).
+ *          N.B. Does NOT stop at an echo byte mismatch - the waveform is
+ *          still wanted for error diagnostics.
+ *
+ * @param   pAdcBlockIn: Raw ADC words from DSPI EDMA
+ * @param   pSampleBlockOut: Signed sample value outputs, minus Offset
+ * @param   Offset: DC offset to subtract from every sample (0 for none)
+ * @param   NumSamples: Number of samples in the block
+ *
+ * @returns true if all the echo bytes were OK
+ */
+bool AD7766_PreProcessRawSpiBlock(const uint32_t *pAdcBlockIn,
+                                  int32_t *pSampleBlockOut,
+                                  int32_t Offset, uint32_t NumSamples)
+{
+#ifdef PUSHBUTTON_LOOPBACK_TESTING
+    uint32_t i;
+    bool bOK = true;
+
+    for (i = 0; i < NumSamples; i++)
+    {
+        if (!AD7766_PreProcessRawSpiIntoSampleVal(pAdcBlockIn[i],
+                                                  &pSampleBlockOut[i]))
+        {
+            bOK = false;
+        }
+        pSampleBlockOut[i] -= Offset;
+    }
+
+    return bOK;
+#else
+    uint32_t EchoDiff = 0;
+    uint32_t Raw0, Raw1, Raw2, Raw3;
+    // Sign-extending a 24-bit value: flipping its sign bit and subtracting
+    // 0x00800000 is the same as AD7766_ConvertRawToSigned(), without a branch
+    int32_t Bias = ((int32_t)0x00800000) + Offset;
+
+// Swaps the 16-bit halves of the raw word to get the 24-bit AD7766 word, then
+// converts to signed and removes the offset
+#define AD7766_SPI_WORD_TO_SAMPLE(Raw) \
+    ((int32_t)(((((Raw) & 0x0000FFFFU) << 8) | ((Raw) >> 24)) ^ 0x00800000U) - Bias)
+
+    while (NumSamples >= 4)
+    {
+        Raw0 = pAdcBlockIn[0];
+        Raw1 = pAdcBlockIn[1];
+        Raw2 = pAdcBlockIn[2];
+        Raw3 = pAdcBlockIn[3];
+
+        EchoDiff |= (Raw0 ^ AD7766_SPI_ECHO_BYTE_EXPECTED) |
+                    (Raw1 ^ AD7766_SPI_ECHO_BYTE_EXPECTED) |
+                    (Raw2 ^ AD7766_SPI_ECHO_BYTE_EXPECTED) |
+                    (Raw3 ^ AD7766_SPI_ECHO_BYTE_EXPECTED);
+
+        pSampleBlockOut[0] = AD7766_SPI_WORD_TO_SAMPLE(Raw0);
+        pSampleBlockOut[1] = AD7766_SPI_WORD_TO_SAMPLE(Raw1);
+        pSampleBlockOut[2] = AD7766_SPI_WORD_TO_SAMPLE(Raw2);
+        pSampleBlockOut[3] = AD7766_SPI_WORD_TO_SAMPLE(Raw3);
+
+        pAdcBlockIn += 4;
+        pSampleBlockOut += 4;
+        NumSamples -= 4;
+    }
+
+    while (NumSamples > 0)
+    {
+        Raw0 = *pAdcBlockIn++;
+        EchoDiff |= Raw0 ^ AD7766_SPI_ECHO_BYTE_EXPECTED;
+        *pSampleBlockOut++ = AD7766_SPI_WORD_TO_SAMPLE(Raw0);
+        NumSamples--;
+    }
+
+#undef AD7766_SPI_WORD_TO_SAMPLE
+
+    if ((EchoDiff & AD7766_SPI_ECHO_BYTE_MASK) != 0)
+    {
+        AD7766_SetError(AD7766ERROR_SPI_ECHO_BYTE_MISMATCH);
+        return false;
+    }
+
+    return true;
+#endif // PUSHBUTTON_LOOPBACK_TESTING
+}
+
 /*
  * AD7766_MaxBlockMillisecs
  *
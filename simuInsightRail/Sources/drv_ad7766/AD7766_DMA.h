@@ -32,6 +32,12 @@ extern "C" {
 // handling seem to work OK at this rate. Have NOT tested at 110ksps yet.
 #define AD7766_DMA_DRIVER_MAX_SAMPLES_PER_SEC  (110000U)
 
+// Each raw 32-bit DSPI EDMA word holds the 24-bit AD7766 sample with its 2 x
+// 16-bit halves reversed, plus the daisy-chain echo byte - see
+// AD7766_PreProcessRawSpiIntoSampleVal()
+#define AD7766_SPI_ECHO_BYTE_MASK       (0x00FF0000U)
+#define AD7766_SPI_ECHO_BYTE_EXPECTED   (0x00B30000U)
+
 //..............................................................................
 
 void AD7766_Init(void);
@@ -42,6 +48,9 @@ bool AD7766_FinishSampling(void);
 uint16_t AD7766_GetCurrentBlockNum(void);
 bool AD7766_PreProcessRawSpiIntoSampleVal(uint32_t AdcRawValIn,
                                           int32_t *pSampleValOut);
+bool AD7766_PreProcessRawSpiBlock(const uint32_t *pAdcBlockIn,
+                                  int32_t *pSampleBlockOut,
+                                  int32_t Offset, uint32_t NumSamples);
 uint32_t AD7766_MaxBlockMillisecs(uint32_t ADCSamplesPerSec);
 
 //..............................................................................
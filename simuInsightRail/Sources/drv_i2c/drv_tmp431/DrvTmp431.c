@@ -259,7 +259,7 @@ bool tmp431Valid(int localOrRemote, float *pTemperature)
 {
 	int nValidReadings = 0;
 	float correctedTemp, temps[MAX_SAMPLES][MAX_SENSORS];
-	const char msg[] = "Temperature read error was = %d corrected to %d";
+	static const char msg[] = "Temperature read error was = %d corrected to %d";
 
 	if(!isnan(*pTemperature))
 	{
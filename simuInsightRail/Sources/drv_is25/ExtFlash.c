@@ -114,7 +114,8 @@ const dataSetConfig_t dataSetConfig[MAX_NO_OF_DATA_RECORD_TYPES] =
 #define DATASET_START_OF_PAGE_NO(dataSet, recordType)	((EXTFLASH_DATASET_START_ADDR / EXTFLASH_PAGE_SIZE_BYTES) + dataSetConfig[recordType].noOfPagesOffset + (MAX_NO_OF_PAGES_PER_SET * dataSet))
 #define DATASET_START_ADDR(dataSet, recordType)			(DATASET_START_OF_PAGE_NO(dataSet, recordType) * EXTFLASH_PAGE_SIZE_BYTES)
 #define DATASET_MAX_NO_OF_PAGES(recordType)				(dataSetConfig[recordType].maxNoOfPages)
-#define DATASET_MRD_ADDR(dataSet, recordType)			(DATASET_START_ADDR(dataSet, IS25_MEASURED_DATA) + 0x100 + (recordType * sizeof(measureRecordDetails_t)))
+#define DATASET_MRD_OFFSET								(0x100)	// the measurement record is stored before it
+#define DATASET_MRD_ADDR(dataSet, recordType)			(DATASET_START_ADDR(dataSet, IS25_MEASURED_DATA) + DATASET_MRD_OFFSET + (recordType * sizeof(measureRecordDetails_t)))
 #define DATASET_TYPE_DESC(recordType)					(dataSetConfig[recordType].desc)
 
 /*
@@ -130,6 +131,11 @@ typedef enum
     ExtFlashEvt_write,			// write block data to flash
     ExtFlashEvt_read,			// read block data from flash
     ExtFlashEvt_erase,			// erase a complete 'dataset'
+    ExtFlashEvt_streamOpen,		// start a streamed write of block data
+    ExtFlashEvt_streamWrite,	// append to the streamed block data
+    ExtFlashEvt_streamClose,	// finish the streamed write, and record its size + CRC
+    ExtFlashEvt_readStreamOpen,	// start a streamed read of block data
+    ExtFlashEvt_readStream,		// read the next piece of the streamed block data
 } eExtFlashEventDescriptor_t;
 
 typedef struct {
@@ -140,6 +146,28 @@ typedef struct {
 
 #define EVENTQUEUE_NR_ELEMENTS_EXT_FLASH      (2)
 
+// state of the (single) streamed write, only used in the flash task
+typedef struct {
+	bool open;
+	uint32_t recordType;
+	uint16_t dataSetNo;
+	uint32_t bytesWritten;
+	uint32_t bytesProgrammed;		// including a failed write, erased again if the stream is abandoned
+	crc32Context_t crc;
+	int errCode;					// first error of the stream, reported on close
+} extFlashStream_t;
+
+// state of the (single) streamed read, only used in the flash task
+typedef struct {
+	bool open;
+	uint32_t recordType;
+	uint16_t dataSetNo;
+	uint32_t totalNumberOfBytes;
+	uint32_t crcCheckSum;
+	uint32_t bytesRead;
+	crc32Context_t crc;
+} extFlashReadStream_t;
+
 extern RTC_Type * const g_rtcBase[RTC_INSTANCE_COUNT];
 
 // private function prototypes go here
@@ -156,6 +184,12 @@ static int extFlash_ReadData(uint8_t* destAddress,
 							uint16_t dataSetNo);
 
 static int extFlash_EraseDataSet(uint16_t dataSetNo);
+static int extFlash_StreamOpen(uint32_t recordType, uint16_t dataSetNo);
+static int extFlash_StreamWriteData(uint8_t* dataAddr, uint32_t dataLength);
+static int extFlash_StreamClose(bool commit);
+static int extFlash_StreamErase(void);
+static int extFlash_ReadStreamOpen(uint32_t recordType, uint16_t dataSetNo);
+static int extFlash_ReadStreamData(uint8_t* destAddress, uint32_t maxNrOfBytes);
 static bool GetFlashVersion(uint32_t *version, uint8_t *formatted);
 
 // Functional Api's
@@ -166,6 +200,9 @@ static QueueHandle_t _EventQueue_extFlash;
 
 static tExtFlashHandle extFlashHandle = { .EventQueue_extFlashRep=NULL} ;
 
+static extFlashStream_t extFlashStream = { .open = false };
+static extFlashReadStream_t extFlashReadStream = { .open = false };
+
 static const char *extFlashErrorStrings[] = {
     FOREACH_ERROR(GENERATE_STRING)
 };
@@ -259,6 +296,34 @@ static void taskExtFlash( void *pvParameters )
 				errCode = extFlash_EraseDataSet(rxEvent.ReqData.eraseReq.dataSet);
 				break;
 
+			case ExtFlashEvt_streamOpen:
+				errCode = extFlash_StreamOpen(
+				rxEvent.ReqData.writeReq.dataType,
+				rxEvent.ReqData.writeReq.dataSet);
+				break;
+
+			case ExtFlashEvt_streamWrite:
+				errCode = extFlash_StreamWriteData(
+				rxEvent.ReqData.writeReq.address,
+				rxEvent.ReqData.writeReq.length);
+				break;
+
+			case ExtFlashEvt_streamClose:
+				errCode = extFlash_StreamClose(rxEvent.ReqData.streamCloseReq.commit);
+				break;
+
+			case ExtFlashEvt_readStreamOpen:
+				errCode = extFlash_ReadStreamOpen(
+				rxEvent.ReqData.readReq.dataType,
+				rxEvent.ReqData.readReq.dataSet);
+				break;
+
+			case ExtFlashEvt_readStream:
+				errCode = extFlash_ReadStreamData(
+				rxEvent.ReqData.readReq.address,
+				rxEvent.ReqData.readReq.length);
+				break;
+
 			default:
 				errCode = -extFlashErr_unknownRequest;
 				LOG_DBG( LOG_LEVEL_APP, "taskExtFlash(): unknown request type : %d\n",rxEvent.Descriptor);
@@ -352,6 +417,7 @@ static int extFlash_WriteData(uint8_t* dataAddr,
 							uint16_t dataSetNo)
 {
 	measureRecordDetails_t mrd;
+	crc32Context_t crc;
 
 	if (dataSetNo > MAX_NUMBER_OF_DATASETS)
 	{
@@ -369,7 +435,9 @@ static int extFlash_WriteData(uint8_t* dataAddr,
 	}
 
 	// check that the data length does not exceed that allocated block space
-	if(dataLength > (DATASET_MAX_NO_OF_PAGES(recordType) * EXTFLASH_PAGE_SIZE_BYTES))
+	// (or for the measurement record, overwrite the MRDs)
+	if((dataLength > (DATASET_MAX_NO_OF_PAGES(recordType) * EXTFLASH_PAGE_SIZE_BYTES)) ||
+	   ((recordType == IS25_MEASURED_DATA) && (dataLength > DATASET_MRD_OFFSET)))
 	{	// TODO - Handle this case
 		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR - dataLength exceeds allowed limit\n", __func__);
 		return -extFlashErr_flashAddressOutOfRange;
@@ -386,15 +454,16 @@ static int extFlash_WriteData(uint8_t* dataAddr,
 		return -extFlashErr_flashDriverEraseFailure;
 	}
 
-	// write the data to the measurement set block
-	if(!IS25_WriteBytes(DATASET_START_ADDR(dataSetNo, recordType), dataAddr, dataLength))
+	// write the data to the measurement set block, calculating the CRC as it goes
+	crc32_ctxInit(&crc);
+	if(!IS25_WriteBytesCrc(DATASET_START_ADDR(dataSetNo, recordType), dataAddr, dataLength, &crc))
 	{   //TODO - Handle this case
 		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR - IS25_WriteBytes failed\n", __func__);
 		return -extFlashErr_flashDriverWriteFailure;
 	}
 
 	// write size + CRC
-	mrd.crcCheckSum = crc32_hardware((void *)dataAddr,  dataLength);
+	mrd.crcCheckSum = crc32_ctxFinish(&crc);
 	mrd.totalNumberOfBytes = dataLength;
 	if(!IS25_WriteBytes(DATASET_MRD_ADDR(dataSetNo, recordType), (uint8_t*)&mrd, sizeof(mrd)))
 	{
@@ -404,8 +473,278 @@ static int extFlash_WriteData(uint8_t* dataAddr,
 	return mrd.totalNumberOfBytes;
 }
 
+/*
+ * @function extFlash_ReadStreamOpen()
+ *
+ * @desc	Start a streamed read of a data block, which is then read in
+ *			pieces by extFlash_ReadStreamData(). Any read stream still open is abandoned
+ *
+ * @params  recordType  - the identity of the source data ex. Raw data
+ *
+ * @params  dataSetNo  - The index number of the dataset to read
+ *
+ * @return int variable - Returns # of bytes in the data block or error code
+ *
+ */
+static int extFlash_ReadStreamOpen(uint32_t recordType, uint16_t dataSetNo)
+{
+	measureRecordDetails_t mrd;
+
+	extFlashReadStream.open = false;
+
+	if (dataSetNo > MAX_NUMBER_OF_DATASETS)
+	{
+		return -extFlashErr_dataSetIndexOutOfRange;
+	}
+
+	if (recordType > IS25_MEASURED_DATA)
+	{
+		return -extFlashErr_recordTypeOutOfRange;
+	}
+
+	if(!IS25_ReadBytes(DATASET_MRD_ADDR(dataSetNo, recordType), (uint8_t*)&mrd, sizeof(mrd)))
+	{
+		return -extFlashErr_flashMRDRead;
+	}
+
+	if((mrd.totalNumberOfBytes == 0x00) ||
+	   (mrd.totalNumberOfBytes > (DATASET_MAX_NO_OF_PAGES(recordType) * EXTFLASH_PAGE_SIZE_BYTES)))
+	{
+		return -extFlashErr_flashDriverReadFailure;
+	}
+
+	extFlashReadStream.recordType = recordType;
+	extFlashReadStream.dataSetNo = dataSetNo;
+	extFlashReadStream.totalNumberOfBytes = mrd.totalNumberOfBytes;
+	extFlashReadStream.crcCheckSum = mrd.crcCheckSum;
+	extFlashReadStream.bytesRead = 0;
+	crc32_ctxInit(&extFlashReadStream.crc);
+	extFlashReadStream.open = true;
+
+	return mrd.totalNumberOfBytes;
+}
+
+/*
+ * @function extFlash_ReadStreamData()
+ *
+ * @desc	Read the next piece of the open read stream, calculating the CRC as
+ *			it goes. The CRC is verified with the last piece, so a damaged data
+ *			block fails before all of it has been passed on
+ *
+ * @params	destAddress	- pointer to the return destination address
+ *
+ * @params  maxNrOfBytes - no more than these should be read
+ *
+ * @return int variable - Returns # of bytes read (0 at the end of the data) or error code
+ *
+ */
+static int extFlash_ReadStreamData(uint8_t* destAddress, uint32_t maxNrOfBytes)
+{
+	uint32_t length = extFlashReadStream.totalNumberOfBytes - extFlashReadStream.bytesRead;
+
+	if (!extFlashReadStream.open)
+	{
+		return -extFlashErr_streamNotOpen;
+	}
+
+	if (length > maxNrOfBytes)
+	{
+		length = maxNrOfBytes;
+	}
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	if(!IS25_ReadBytesCrc(DATASET_START_ADDR(extFlashReadStream.dataSetNo, extFlashReadStream.recordType) + extFlashReadStream.bytesRead,
+						  destAddress, length, &extFlashReadStream.crc))
+	{
+		extFlashReadStream.open = false;
+		return -extFlashErr_flashDriverReadFailure;
+	}
+
+	extFlashReadStream.bytesRead += length;
+	if ((extFlashReadStream.bytesRead == extFlashReadStream.totalNumberOfBytes) &&
+		(extFlashReadStream.crcCheckSum != crc32_ctxFinish(&extFlashReadStream.crc)))
+	{
+		extFlashReadStream.open = false;
+		return -extFlashErr_crcErrorRead;
+	}
+
+	return length;
+}
+
 
 
+/*
+ * @function extFlash_StreamOpen()
+ *
+ * @desc	Start a streamed write of a data block, which is then written in
+ *			pieces by extFlash_StreamWriteData(). Any stream still open is abandoned
+ *			and its data erased
+ *
+ * @params  recordType  - the identity of the source data ex. Raw data
+ *
+ * @params  dataSetNo  - The index number of the dataset to write
+ *
+ * @return int variable - Returns success or error code
+ *
+ */
+static int extFlash_StreamOpen(uint32_t recordType, uint16_t dataSetNo)
+{
+	measureRecordDetails_t mrd;
+
+	if (extFlashStream.open)
+	{
+		(void)extFlash_StreamErase();
+		extFlashStream.open = false;
+	}
+
+	if (dataSetNo > MAX_NUMBER_OF_DATASETS)
+	{
+		return -extFlashErr_dataSetIndexOutOfRange;
+	}
+
+	if (recordType > IS25_MEASURED_DATA)
+	{
+		return -extFlashErr_recordTypeOutOfRange;
+	}
+
+	if(!IS25_ReadBytes(DATASET_MRD_ADDR(dataSetNo, recordType), (uint8_t*)&mrd, sizeof(mrd)))
+	{
+		return -extFlashErr_flashMRDRead;
+	}
+
+	if (MEMORY_ERASE_STATE != mrd.totalNumberOfBytes)
+	{
+		return -extFlashErr_flashDriverEraseFailure;
+	}
+
+	extFlashStream.recordType = recordType;
+	extFlashStream.dataSetNo = dataSetNo;
+	extFlashStream.bytesWritten = 0;
+	extFlashStream.bytesProgrammed = 0;
+	crc32_ctxInit(&extFlashStream.crc);
+	extFlashStream.errCode = extFlashErr_noError;
+	extFlashStream.open = true;
+
+	return extFlashErr_noError;
+}
+
+/*
+ * @function extFlash_StreamWriteData()
+ *
+ * @desc	Append data to the open stream. After an error the rest of the
+ *			stream is ignored, and the error is returned by extFlash_StreamClose()
+ *
+ * @params	dataAddr	- pointer to the data to write to flash
+ *
+ * @params  dataLength  - how many bytes.
+ *
+ * @return int variable - Returns success or error code
+ *
+ */
+static int extFlash_StreamWriteData(uint8_t* dataAddr, uint32_t dataLength)
+{
+	if (!extFlashStream.open)
+	{
+		return -extFlashErr_streamNotOpen;
+	}
+
+	if (extFlashStream.errCode != extFlashErr_noError)
+	{
+		return extFlashStream.errCode;
+	}
+
+	// check that the data length does not exceed that allocated block space
+	if((extFlashStream.bytesWritten + dataLength) > (DATASET_MAX_NO_OF_PAGES(extFlashStream.recordType) * EXTFLASH_PAGE_SIZE_BYTES))
+	{
+		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR - stream length exceeds allowed limit\n", __func__);
+		extFlashStream.errCode = -extFlashErr_flashAddressOutOfRange;
+		return extFlashStream.errCode;
+	}
+
+	extFlashStream.bytesProgrammed = extFlashStream.bytesWritten + dataLength;
+	if(!IS25_WriteBytesCrc(DATASET_START_ADDR(extFlashStream.dataSetNo, extFlashStream.recordType) + extFlashStream.bytesWritten,
+						   dataAddr, dataLength, &extFlashStream.crc))
+	{
+		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR - IS25_WriteBytes failed\n", __func__);
+		extFlashStream.errCode = -extFlashErr_flashDriverWriteFailure;
+		return extFlashStream.errCode;
+	}
+
+	extFlashStream.bytesWritten += dataLength;
+
+	return extFlashErr_noError;
+}
+
+/*
+ * @function extFlash_StreamClose()
+ *
+ * @desc	Finish the open stream. If it is committed without errors its size
+ *			and CRC are written to the MRD, otherwise the data is erased, as the
+ *			next erase of the dataset skips a record with an erased MRD
+ *
+ * @params	commit		- true to record the data, false to abandon it
+ *
+ * @return int variable - Returns # of bytes recorded, or error code
+ *
+ */
+static int extFlash_StreamClose(bool commit)
+{
+	measureRecordDetails_t mrd;
+
+	if (!extFlashStream.open)
+	{
+		return -extFlashErr_streamNotOpen;
+	}
+	extFlashStream.open = false;
+
+	if ((extFlashStream.errCode != extFlashErr_noError) || !commit)
+	{
+		int errCode = extFlash_StreamErase();
+
+		return (extFlashStream.errCode != extFlashErr_noError) ? extFlashStream.errCode : errCode;
+	}
+
+	// write size + CRC
+	mrd.crcCheckSum = crc32_ctxFinish(&extFlashStream.crc);
+	mrd.totalNumberOfBytes = extFlashStream.bytesWritten;
+	if(!IS25_WriteBytes(DATASET_MRD_ADDR(extFlashStream.dataSetNo, extFlashStream.recordType), (uint8_t*)&mrd, sizeof(mrd)))
+	{
+		return -extFlashErr_flashMRDWrite;
+	}
+
+	return mrd.totalNumberOfBytes;
+}
+
+/*
+ * @function extFlash_StreamErase()
+ *
+ * @desc	Erase the pages the stream has programmed, so that its record is
+ *			left erased like its MRD
+ *
+ * @return int variable - Returns success or error code
+ *
+ */
+static int extFlash_StreamErase(void)
+{
+	if (extFlashStream.bytesProgrammed == 0)
+	{
+		return extFlashErr_noError;
+	}
+
+	if(!IS25_PerformSectorErase(DATASET_START_ADDR(extFlashStream.dataSetNo, extFlashStream.recordType),
+								extFlashStream.bytesProgrammed))
+	{
+		LOG_DBG( LOG_LEVEL_APP, "%s(): ERROR - IS25_PerformSectorErase failed\n", __func__);
+		return -extFlashErr_flashDriverEraseFailure;
+	}
+	extFlashStream.bytesProgrammed = 0;
+
+	return extFlashErr_noError;
+}
+
 /*
  * @function extFlash_EraseDataSet()
  *
@@ -425,6 +764,12 @@ static int extFlash_EraseDataSet( uint16_t dataSetNo)
 
 	measureRecordDetails_t mrd[MAX_NO_OF_DATA_RECORD_TYPES];
 
+	// a streamed read of this dataset cannot continue
+	if (extFlashReadStream.dataSetNo == dataSetNo)
+	{
+		extFlashReadStream.open = false;
+	}
+
 	if(!IS25_ReadBytes(DATASET_MRD_ADDR(dataSetNo, IS25_RAW_SAMPLED_DATA), (uint8_t*)&mrd, sizeof(mrd)))
 	{
 		return -extFlashErr_flashMRDRead;
@@ -484,6 +829,7 @@ static int extFlash_ReadData(uint8_t* destAddress,
 							uint16_t dataSetNo)		// move on to next data block if possible
 {
 	measureRecordDetails_t mrd;
+	crc32Context_t crc;
 
 	if (dataSetNo > MAX_NUMBER_OF_DATASETS)
 	{
@@ -505,15 +851,15 @@ static int extFlash_ReadData(uint8_t* destAddress,
 		return -extFlashErr_flashDriverReadFailure;
 	}
 
-	// read the data
-	if(!IS25_ReadBytes(DATASET_START_ADDR(dataSetNo, recordType), destAddress, mrd.totalNumberOfBytes))
+	// read the data, calculating the CRC as it goes
+	crc32_ctxInit(&crc);
+	if(!IS25_ReadBytesCrc(DATASET_START_ADDR(dataSetNo, recordType), destAddress, mrd.totalNumberOfBytes, &crc))
 	{
 		return -extFlashErr_flashDriverReadFailure;
 	}
 
 	// verify checksum
-	uint32_t crc = crc32_hardware((void *)destAddress,  mrd.totalNumberOfBytes);
-	if(mrd.crcCheckSum != crc)
+	if(mrd.crcCheckSum != crc32_ctxFinish(&crc))
 	{
 		// OK, we failed the record CRC so report an error
 		return -extFlashErr_crcErrorRead;
@@ -740,6 +1086,152 @@ int extFlash_erase(tExtFlashHandle * handle, uint16_t dataSet, uint32_t maxWaitM
 	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
 }
 
+/*
+ * extFlash_streamOpen
+ *
+ * @brief           start a streamed write of a dataset element, its data is then passed in pieces with extFlash_streamWrite()
+ *                  and finished with extFlash_streamClose(). Only one stream can be open at a time.
+ *
+ * @param handle    handle which hold local task data for interfacing with the  task, NULL for 'fire and forget'
+ *
+ * @param dataType  what dataset element
+ *
+ * @param dataSet   index of the dataset where it must be written in flash
+ *
+ * @param maxWaitMs max time to wait in milliseconds, when zero, and a handle is provided, the user must use the waitReady function to know it is ready/failed
+ *
+ * @return          no error or error code
+ */
+int extFlash_streamOpen(tExtFlashHandle * handle, uint32_t dataType, uint16_t dataSet, uint32_t maxWaitMs)
+{
+    // Execute  request
+    ExtFlashEvent_t event =
+    {
+    	.Descriptor = ExtFlashEvt_streamOpen,
+		.replyQueue = NULL,
+	    .ReqData.writeReq.dataType = dataType,
+	    .ReqData.writeReq.dataSet = dataSet
+    };
+
+	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
+}
+
+/*
+ * extFlash_streamWrite
+ *
+ * @brief           append to the open stream. The source memory must not be changed until the write is ready,
+ *                  an error will also be returned by extFlash_streamClose()
+ *
+ * @param handle    handle which hold local task data for interfacing with the  task, NULL for 'fire and forget'
+ *
+ * @param src_p     processor memory start location to read
+ *
+ * @param length    length in bytes to write
+ *
+ * @param maxWaitMs max time to wait in milliseconds, when zero, and a handle is provided, the user must use the waitReady function to know it is ready/failed
+ *
+ * @return          no error or error code
+ */
+int extFlash_streamWrite(tExtFlashHandle * handle, uint8_t * src_p, uint32_t length, uint32_t maxWaitMs)
+{
+    // Execute  request
+    ExtFlashEvent_t event =
+    {
+    	.Descriptor = ExtFlashEvt_streamWrite,
+		.replyQueue = NULL,
+	    .ReqData.writeReq.address = src_p,
+	    .ReqData.writeReq.length = length
+    };
+
+	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
+}
+
+/*
+ * extFlash_streamClose
+ *
+ * @brief           finish the open stream, after any writes still queued
+ *
+ * @param handle    handle which hold local task data for interfacing with the  task, NULL for 'fire and forget'
+ *
+ * @param commit    true to record the streamed data's size and CRC, false to abandon it and erase its data (e.g. sampling failed)
+ *
+ * @param maxWaitMs max time to wait in milliseconds, when zero, and a handle is provided, the user must use the waitReady function to know it is ready/failed
+ *
+ * @return          # of bytes recorded, or error code of the first failure in the stream
+ */
+int extFlash_streamClose(tExtFlashHandle * handle, bool commit, uint32_t maxWaitMs)
+{
+    // Execute  request
+    ExtFlashEvent_t event =
+    {
+    	.Descriptor = ExtFlashEvt_streamClose,
+		.replyQueue = NULL,
+	    .ReqData.streamCloseReq.commit = commit
+    };
+
+	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
+}
+
+/*
+ * extFlash_readStreamOpen
+ *
+ * @brief           start a streamed read of a dataset element, its data is then read in pieces with extFlash_readStream(),
+ *                  so it needs no buffer for the whole element. Only one read stream can be open at a time.
+ *
+ * @param handle    handle which hold local task data for interfacing with the  task
+ *
+ * @param dataType  what dataset element
+ *
+ * @param dataSet   index of the dataset where it must be read from
+ *
+ * @param maxWaitMs max time to wait in milliseconds, when zero, and a handle is provided, the user must use the waitReady function to know it is ready/failed
+ *
+ * @return          # of bytes in the dataset element or error code
+ */
+int extFlash_readStreamOpen(tExtFlashHandle * handle, uint32_t dataType, uint16_t dataSet, uint32_t maxWaitMs)
+{
+    // Execute  request
+    ExtFlashEvent_t event =
+    {
+    	.Descriptor = ExtFlashEvt_readStreamOpen,
+		.replyQueue = NULL,
+	    .ReqData.readReq.dataType = dataType,
+	    .ReqData.readReq.dataSet = dataSet
+    };
+
+	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
+}
+
+/*
+ * extFlash_readStream
+ *
+ * @brief           read the next piece of the open read stream. The element's CRC is checked when its last byte is read,
+ *                  and a mismatch fails that read.
+ *
+ * @param handle    handle which hold local task data for interfacing with the  task
+ *
+ * @param dst_p     processor memory start location to write
+ *
+ * @param maxLength maximum length in bytes to read
+ *
+ * @param maxWaitMs max time to wait in milliseconds, when zero, and a handle is provided, the user must use the waitReady function to know it is ready/failed
+ *
+ * @return          # of bytes read (0 at the end of the element) or error code
+ */
+int extFlash_readStream(tExtFlashHandle * handle, uint8_t * dst_p, uint32_t maxLength, uint32_t maxWaitMs)
+{
+    // Execute  request
+    ExtFlashEvent_t event =
+    {
+    	.Descriptor = ExtFlashEvt_readStream,
+		.replyQueue = NULL,
+	    .ReqData.readReq.address = dst_p,
+	    .ReqData.readReq.length = maxLength
+    };
+
+	return sendSimpleCommand(handle, &event, ( maxWaitMs + portTICK_PERIOD_MS -1 ) /  portTICK_PERIOD_MS);
+}
+
 /*
  * extFlash_getMeasureSetInfo
  *
@@ -1487,6 +1979,45 @@ bool fetchCommsData(bool copyBoth)
 	return retval;
 }
 
+/*
+ * storeTaskStats
+ *
+ * @brief	Captures the CPU time and stack high-water mark of every task so
+ * 			far this wakeup, and stores them to the external flash.
+ *
+ * @return	true - If the data write is successful,
+ * 			false - otherwise.
+ */
+bool storeTaskStats(void)
+{
+	static tTaskStatsRecord taskStats;// not on the stack of the caller
+
+	bool retval = TaskStats_Capture(&taskStats);
+	if(retval)
+	{
+		taskStats.crc = crc32_hardware((void *)&taskStats, offsetof(tTaskStatsRecord, crc));
+		retval = IS25_PerformSectorErase(EXTFLASH_TASKSTATS_ADDR, sizeof(taskStats)) &&
+				 IS25_WriteBytes(EXTFLASH_TASKSTATS_ADDR, (uint8_t*)&taskStats, sizeof(taskStats));
+	}
+	return retval;
+}
+
+/*
+ * fetchTaskStats
+ *
+ * @brief	Fetches the task statistics stored by the last wakeup.
+ *
+ * @param	pRecord - RETURNS the task statistics
+ *
+ * @return	true - If the data read is successful,
+ * 			false - otherwise.
+ */
+bool fetchTaskStats(tTaskStatsRecord *pRecord)
+{
+	return IS25_ReadBytes(EXTFLASH_TASKSTATS_ADDR, (uint8_t*)pRecord, sizeof(*pRecord)) &&
+		   (pRecord->crc == crc32_hardware((void *)pRecord, offsetof(tTaskStatsRecord, crc)));
+}
+
 /**
  * Versions 1.2.x, 1.3.x & 1.4.x have an external flash formatted to implement a flash
  * file system with a directory and measurement sets. The structure is shown below:
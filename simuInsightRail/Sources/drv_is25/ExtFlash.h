@@ -15,6 +15,7 @@ extern "C" {
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "drv_is25.h"
+#include "TaskStats.h"
 
 
 
@@ -101,6 +102,8 @@ enum {
 #define EXTFLASH_COMMS_START_ADDR			(EXTFLASH_GATED_START_ADDR + GATED_MAX_SIZE_BYTES)
 #define COMMS_SECTORS						(4)
 #define COMMS_MAX_SIZE_BYTES				(IS25_SECTOR_SIZE_BYTES * COMMS_SECTORS)
+// the task statistics of the last wakeup, in the second COMMS sector
+#define EXTFLASH_TASKSTATS_ADDR				(EXTFLASH_COMMS_START_ADDR + IS25_SECTOR_SIZE_BYTES)
 
 #define EXTFLASH_DATASET_START_ADDR			(EXTFLASH_COMMS_START_ADDR + COMMS_MAX_SIZE_BYTES)
 
@@ -150,6 +153,7 @@ typedef enum
         EXT_FLASH_ERROR(extFlashErr_recordTypeOutOfRange)  \
         EXT_FLASH_ERROR(extFlashErr_crcErrorRead)  \
         EXT_FLASH_ERROR(extFlashErr_queueAccessError)  \
+        EXT_FLASH_ERROR(extFlashErr_streamNotOpen)  \
         EXT_FLASH_ERROR(extFlashErr_unknownRequest)  \
 
 #define GENERATE_ENUM(err) err,
@@ -202,6 +206,11 @@ typedef struct
     uint16_t dataSet;            //! dataSet index
 } tExtFlashEraseReq;
 
+typedef struct
+{
+    bool commit;                 //! true to record the stream's size + CRC, false to abandon it and erase its data
+} tExtFlashStreamCloseReq;
+
 
 
 // placeholder for when we have parameters for a request
@@ -210,6 +219,7 @@ typedef  union {
     tExtFlashWriteReq   writeReq;
     tExtFlashReadReq    readReq;
     tExtFlashEraseReq   eraseReq;
+    tExtFlashStreamCloseReq streamCloseReq;
     // tExtFlashWhateverReq whateverReq;
 } tExtFlashReqData;
 
@@ -260,6 +270,15 @@ int extFlash_write(tExtFlashHandle * handle, uint8_t * src_p, uint32_t length,
 int extFlash_read(tExtFlashHandle * handle, uint8_t * dst_p, uint32_t maxLength,  uint32_t dataType, uint16_t dataSet, uint32_t maxWaitMs);
 const char *extFlash_ErrorString(int errCode);
 
+// streamed write of a dataset element, in pieces, e.g. while it is being sampled
+int extFlash_streamOpen(tExtFlashHandle * handle, uint32_t dataType, uint16_t dataSet, uint32_t maxWaitMs);
+int extFlash_streamWrite(tExtFlashHandle * handle, uint8_t * src_p, uint32_t length, uint32_t maxWaitMs);
+int extFlash_streamClose(tExtFlashHandle * handle, bool commit, uint32_t maxWaitMs);
+
+// streamed read of a dataset element, in pieces, e.g. while it is being uploaded
+int extFlash_readStreamOpen(tExtFlashHandle * handle, uint32_t dataType, uint16_t dataSet, uint32_t maxWaitMs);
+int extFlash_readStream(tExtFlashHandle * handle, uint8_t * dst_p, uint32_t maxLength, uint32_t maxWaitMs);
+
 uint16_t extFlash_getMeasureSetInfo(uint16_t measureSet);
 void extFlash_commsRecordUpgrade();
 
@@ -277,6 +296,8 @@ void ExtFlash_printGatedMeasurement(uint16_t inx, bool display);
 
 bool storeCommsData(void);
 bool fetchCommsData(bool copyBoth);
+bool storeTaskStats(void);
+bool fetchTaskStats(tTaskStatsRecord *pRecord);
 char *gatingReason(uint32_t reason);
 
 #endif /* SOURCES_EXTFLASH_H_ */
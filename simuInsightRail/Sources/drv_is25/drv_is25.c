@@ -20,6 +20,12 @@ extern "C" {
 #include "log.h"
 
 #include "drv_is25.h"
+#include "Trace.h"
+#ifndef _MSC_VER
+#include "Resources.h"
+#include "fsl_clock_manager.h"
+#include "CS1.h"
+#endif
 
 #define IS25_512_MBIT_PRODUCT_ID_MAX_ADDR	(0x4000000)
 #define IS25_128_MBIT_PRODUCT_ID_MAX_ADDR	(0x1000000)
@@ -40,6 +46,7 @@ static void FlashExtInitIOLines(void);
 // defines derived from the IS25LP128 and IS25LP512 datasheets
 
 #define IS25_NORD					0x03		// Normal Read Mode
+#define IS25_FRD					0x0B		// Fast Read Mode
 #define IS25_PP						0x02		// Input Page Program
 #define IS25_SER					0xD7		// Sector Erase
 #define IS25_BER32					0x52		// Block Erase 32KByte
@@ -63,6 +70,13 @@ static void FlashExtInitIOLines(void);
 
 #define IS25_A24_A25_MASK (0x03000000)
 
+// reads longer than the transfer buffer go straight into the caller's buffer, up to this many bytes per transfer
+#define IS25_BULK_READ_MAX_BYTES    (16384)
+// fast read command, address and dummy byte
+#define IS25_FRD_HEADER_BYTES       (5)
+// sleep between status reads while a page programs, about the typical page program time
+#define IS25_PAGE_PROG_POLL_US      (200)
+
 // is25 command structures
 // read and write go parallel when using spi, so output and input map the same
 // if input and output bufferpointers in the SPI transfer are the same, input buffer is replaced by the output buffer contents.
@@ -279,7 +293,13 @@ static bool DoTransfer( void* volatile txBuf, void* volatile rxBuf, uint16_t len
 	bool bFlashOK = true;
 	//uint32_t wordsTransfer = 0;
 	dspi_status_t dspiResult;
-	uint32_t timeout = 10;        // TODO - base timeout on baudrate
+	uint32_t timeout = 10;
+
+	// allow for the time on the wire of the longer (bulk read) transfers
+	if (is25FlashStatus.calculatedBaudRate)
+	{
+		timeout += (length * 8 * 1000) / is25FlashStatus.calculatedBaudRate;
+	}
 
 
 	dspiResult =  DSPI_DRV_EdmaMasterTransferBlocking(DSPI_MASTER_INSTANCE,
@@ -393,6 +413,98 @@ static bool pollingWait( uint8_t statusBitsXor, uint8_t statusBitsAnd, uint32_t
     return condition;
 }
 
+#ifndef _MSC_VER
+// task sleeping on the sub-tick timer, NULL when none
+static TaskHandle_t pitWaitTask = NULL;
+
+/*!
+ * PIT1_IRQHandler
+ *
+ * @brief       one-shot of the sub-tick timer expired, wake the waiting task
+ */
+void PIT1_IRQHandler(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    PIT_TCTRL(DRVPIT_TIMERID_IS25) = 0;
+    PIT_TFLG(DRVPIT_TIMERID_IS25) = PIT_TFLG_TIF_MASK;
+    if (pitWaitTask != NULL)
+    {
+        vTaskNotifyGiveFromISR(pitWaitTask, &xHigherPriorityTaskWoken);
+    }
+    portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+}
+
+/*!
+ * SubTickSleep
+ *
+ * @brief       sleeps the calling task for a time shorter than a tick on a one-shot
+ *              of the PIT timer, which notifies the task when it expires.
+ *              A spurious notification left by a late interrupt only wakes the
+ *              task's next notify wait early, and those all re-check their condition
+ *
+ * @param       us - time to sleep in micro seconds
+ */
+static void SubTickSleep(uint32_t us)
+{
+    CS1_CriticalVariable();
+
+    CS1_EnterCritical();
+    pitWaitTask = xTaskGetCurrentTaskHandle();
+    PIT_LDVAL(DRVPIT_TIMERID_IS25) = (CLOCK_SYS_GetBusClockFreq() / 1000000U) * us - 1;
+    PIT_TFLG(DRVPIT_TIMERID_IS25) = PIT_TFLG_TIF_MASK;
+    PIT_TCTRL(DRVPIT_TIMERID_IS25) = PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
+    CS1_ExitCritical();
+
+    // the tick timeout is only a backstop, should the interrupt not come
+    (void)ulTaskNotifyTake(pdTRUE, 2);
+
+    CS1_EnterCritical();
+    PIT_TCTRL(DRVPIT_TIMERID_IS25) = 0;
+    pitWaitTask = NULL;
+    CS1_ExitCritical();
+}
+#endif
+
+/*!
+ * programWait
+ *
+ * @brief       waits for the WEL bit to clear after a page program, sleeping
+ *              IS25_PAGE_PROG_POLL_US on the sub-tick timer between status reads,
+ *              so the CPU is free while the page programs and the end of it is
+ *              still picked up soon after. The simulator polls once per tick.
+ *
+ * @param       maxWaitMs - maximum time the page program should take
+ *
+ * @return      true when the WEL bit cleared within maxWaitMs
+ */
+static bool programWait(uint32_t maxWaitMs)
+{
+#ifdef _MSC_VER
+    return pollingWait(IS25_STATUS_WEL, IS25_STATUS_WEL, 0, 1, maxWaitMs);
+#else
+    uint32_t polls = (maxWaitMs * 1000U) / IS25_PAGE_PROG_POLL_US + 1;
+    bool condition = false;
+    bool rc_ok = true;
+
+    while (polls-- > 0 && !condition && rc_ok)
+    {
+        t_rdsr rdsr;
+
+        SubTickSleep(IS25_PAGE_PROG_POLL_US);
+
+        rdsr.cmd = IS25_RDSR;
+        rdsr.status = 0;
+        rc_ok = DoTransfer( (void * volatile) &rdsr, (void * volatile) &rdsr, sizeof(rdsr));
+        if (rc_ok) {
+            condition = (rdsr.status ^ IS25_STATUS_WEL) & IS25_STATUS_WEL;
+        }
+    }
+
+    return condition;
+#endif
+}
+
 
 /*!
  * PerformWriteEnable
@@ -414,8 +526,9 @@ static bool PerformWriteEnable()
     {
         // now verify that WEL bit  [1] is set
         // try to read the Status Register 0x05 bit 1
-        // operation takes typical 2ms, max is 15ms (take 5 extra) (datasheet: tW Write Status Register time 2 15 ms)
-        rc_ok = pollingWait( 0x00 , IS25_STATUS_WEL, 2 , 1, 15+5);
+        // the latch is set as soon as the command completes (tW, 2 to 15ms, is for writing the status register, which
+        // this is not), so check straight away, allowing a few full speed re-reads
+        rc_ok = pollingWait( 0x00 , IS25_STATUS_WEL, 0 , 0, 1);
     }
 
     return rc_ok;
@@ -577,6 +690,48 @@ bool IS25_PerformSectorErase(uint32_t startAddress, uint32_t numBytes)
     return rc_ok;
 }
 
+/*!
+ * StagePage
+ *
+ * @brief       Fill the transfer buffer with the page program command for the
+ *              data up to the next page boundary, and add the data to the CRC
+ *
+ * @param       addr - flash address to program
+ *
+ * @param		data - pointer to the data to be programmed
+ *
+ * @param		length - the remaining data length
+ *
+ * @param		crc_p - CRC to update with the data, or NULL
+ *
+ * @returns     number of data bytes staged
+ */
+static uint32_t StagePage(uint32_t addr, const uint8_t* data, uint32_t length, crc32Context_t* crc_p)
+{
+	uint32_t transfer_count;
+
+	// take care of the wrap around in the page buffer address, see device manual chapter 8.7 PAGE PROGRAM OPERATION
+	transfer_count = 0x100 - (addr & 0xff); // is25 page size is 0x100 bytes
+	if (transfer_count > length)
+	{
+		transfer_count = length;
+	}
+
+	// only the command, address and data bytes are transferred, so no need to pad the rest of the buffer
+	cab.cmd = IS25_PP;
+	cab.address[0] = (addr>>16) & 0xff;
+	cab.address[1] = (addr>> 8) & 0xff;
+	cab.address[2] =  addr      & 0xff;
+	memcpy( (void *) cab.data, data, transfer_count);
+
+	if (crc_p)
+	{
+		crc32_ctxUpdate(crc_p, data, transfer_count);
+	}
+
+	return transfer_count;
+}
+
 /*!
  * IS25_WriteBytes
  *
@@ -593,6 +748,30 @@ bool IS25_PerformSectorErase(uint32_t startAddress, uint32_t numBytes)
  * @returns     true or false - true = completed transfer ok
  */
 bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length)
+{
+    return IS25_WriteBytesCrc(addr, data, length, NULL);
+}
+
+/*!
+ * IS25_WriteBytesCrc
+ *
+ * @brief       As IS25_WriteBytes(), also adding the data to a CRC.
+ *              Each page is staged for transfer (and added to the CRC) while
+ *              the previous one is programming. The flash is polled flat out
+ *              for about the typical program time, and the task only sleeps
+ *              if the programming takes longer
+ *
+ * @param       addr - starting address of the page to be programmed
+ *
+ * @param		data - pointer to the data to be programmed
+ *
+ * @param		length - the data length
+ *
+ * @param		crc_p - CRC to update with the data, or NULL
+ *
+ * @returns     true or false - true = completed transfer ok
+ */
+bool IS25_WriteBytesCrc(uint32_t addr, uint8_t* data, uint32_t length, crc32Context_t* crc_p)
 {
     if ( data == NULL )
     {
@@ -610,8 +789,12 @@ bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length)
     {
     	uint32_t maxTimeout_msec = GetOpTimeout(eFLASH_OP_PAGE_PROG);
         uint32_t current_segment = 0;
+        uint32_t transfer_count;
         PerformBankAddressWrite(0);
 
+        // the first page is staged up front, each following one while the previous one programs
+        transfer_count = StagePage(addr, data, length, crc_p);
+
     	// loop over all data until done
         while (rc_ok && length>0)
         {
@@ -623,40 +806,33 @@ bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length)
 
         	if(rc_ok)
         	{
-				uint32_t transfer_count;
-				// take care of the wrap around in the page buffer address, see device manual chapter 8.7 PAGE PROGRAM OPERATION
-				transfer_count = 0x100 - (addr & 0xff); // is25 page size is 0x100 bytes
-				if (transfer_count > length)
-				{
-					transfer_count = length;
-				}
+				TRACE_ENTER(TRACE_IS25_PAGE_PROG);
 
 				rc_ok = PerformWriteEnable();        // set the Write Enable Latch - you cannot do a write action without doing this first
 				if(rc_ok == true)
 				{
-					memset( (void *) &cab, 0xff, sizeof(cab));// 0xff is the erased state of the flash
-
-					cab.cmd = IS25_PP;
-					cab.address[0] = (addr>>16) & 0xff;
-					cab.address[1] = (addr>> 8) & 0xff;
-					cab.address[2] =  addr      & 0xff;
-
-					// copy over the data
-					memcpy( (void *) cab.data, data, transfer_count);
 					rc_ok = DoTransfer((void * volatile) &cab, (void * volatile) &cab, transfer_count + sizeof(cab.cmd) + sizeof(cab.address));
 
 					if (rc_ok)
 					{
-						// now wait until the  WEL bit  [1] is cleared again (happens after the erase is finished)
-						// try to read the Status Register 0x05 bit 1
-						// operation takes typical 0.2 ms, max is 1ms (take 1 milli seconds extra)
-						rc_ok = pollingWait( IS25_STATUS_WEL , IS25_STATUS_WEL, 0, 0, maxTimeout_msec);
-
 						addr += transfer_count;
 						data += transfer_count;
 						length -= transfer_count;
+
+						// the page is now programming from the flash's own buffer, so cab is free for the next one
+						if (length > 0)
+						{
+							transfer_count = StagePage(addr, data, length, crc_p);
+						}
+
+						// now wait until the  WEL bit  [1] is cleared again (happens after the programming is finished)
+						// operation takes typical 0.2 ms, max is 1 or 2ms depending on the part. The Status Register 0x05
+						// is read every 0.2ms, sleeping on the sub-tick timer in between, allowing 1ms extra on the maximum
+						rc_ok = programWait(maxTimeout_msec + 1);
 					}
 				}
+
+				TRACE_EXIT(TRACE_IS25_PAGE_PROG);
         	}
         }
         IS25_GiveMutex();
@@ -667,6 +843,99 @@ bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length)
 
 
 
+/*!
+ * ReadChunk
+ *
+ * @brief       Read up to a page of data through the transfer buffer
+ *
+ * @param       addr - flash address to read from
+ *
+ * @param		data - pointer to the destination
+ *
+ * @param		length - the data length, no more than the transfer buffer holds
+ *
+ * @returns     true or false - true = completed transfer ok
+ */
+static bool ReadChunk(uint32_t addr, uint8_t* data, uint32_t length)
+{
+	bool rc_ok;
+
+	cab.cmd = IS25_NORD;
+	cab.address[0] = (addr>>16) & 0xff;
+	cab.address[1] = (addr>> 8) & 0xff;
+	cab.address[2] =  addr      & 0xff;
+
+	rc_ok = DoTransfer((void * volatile) &cab, (void * volatile) &cab, length + sizeof(cab.cmd) + sizeof(cab.address));
+	if (rc_ok)
+	{
+		memcpy(data, (void *) cab.data, length);
+	}
+
+	return rc_ok;
+}
+
+/*!
+ * ReadBulk
+ *
+ * @brief       Read many pages of data with a single fast read command,
+ *              received straight into the destination.
+ *              The command goes out from the same buffer the data comes back
+ *              in, so it occupies the IS25_FRD_HEADER_BYTES in front of the
+ *              data. If those already hold data read earlier (bLeadIn) they
+ *              are saved and put back, otherwise the command is sent from the
+ *              start of the destination for the data after the first
+ *              IS25_FRD_HEADER_BYTES, and those are read separately
+ *
+ * @param       addr - flash address to read from, all in the same bank
+ *
+ * @param		data - pointer to the destination
+ *
+ * @param		length - the data length, more than IS25_FRD_HEADER_BYTES
+ *
+ * @param		bLeadIn - the IS25_FRD_HEADER_BYTES in front of data are
+ *                        part of the destination
+ *
+ * @returns     true or false - true = completed transfer ok
+ */
+static bool ReadBulk(uint32_t addr, uint8_t* data, uint32_t length, bool bLeadIn)
+{
+	uint8_t saved[IS25_FRD_HEADER_BYTES];
+	uint8_t* buf_p = data;
+	uint32_t cmdAddr = addr;
+	uint32_t transfer_count = length;
+	bool rc_ok;
+
+	if (bLeadIn)
+	{
+		buf_p = data - IS25_FRD_HEADER_BYTES;
+		memcpy(saved, buf_p, sizeof(saved));
+		transfer_count += IS25_FRD_HEADER_BYTES;
+	}
+	else
+	{
+		cmdAddr += IS25_FRD_HEADER_BYTES;
+	}
+
+	buf_p[0] = IS25_FRD;
+	buf_p[1] = (cmdAddr>>16) & 0xff;
+	buf_p[2] = (cmdAddr>> 8) & 0xff;
+	buf_p[3] =  cmdAddr      & 0xff;
+	buf_p[4] = 0;		// dummy byte
+
+	rc_ok = DoTransfer((void * volatile) buf_p, (void * volatile) buf_p, transfer_count);
+
+	if (bLeadIn)
+	{
+		memcpy(buf_p, saved, sizeof(saved));
+	}
+	else if (rc_ok)
+	{
+		rc_ok = ReadChunk(addr, data, IS25_FRD_HEADER_BYTES);
+	}
+
+	return rc_ok;
+}
+
 /*!
  * IS25_ReadBytes
  *
@@ -682,6 +951,29 @@ bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length)
  */
 
 bool IS25_ReadBytes(uint32_t addr, uint8_t* data, uint32_t length)
+{
+    return IS25_ReadBytesCrc(addr, data, length, NULL);
+}
+
+/*!
+ * IS25_ReadBytesCrc
+ *
+ * @brief       As IS25_ReadBytes(), also adding the data to a CRC as each
+ *              chunk is read.
+ *              Reads longer than a page are done with fast read commands
+ *              spanning many pages, received straight into the caller's buffer
+ *
+ * @param       addr - starting address of the page to be read
+ *
+ * @param		data - pointer to the data to be programmed
+ *
+ * @param		length - the data length
+ *
+ * @param		crc_p - CRC to update with the data, or NULL
+ *
+ * @returns     true or false - true = completed transfer ok
+ */
+bool IS25_ReadBytesCrc(uint32_t addr, uint8_t* data, uint32_t length, crc32Context_t* crc_p)
 {
     if ( data == NULL )
     {
@@ -698,6 +990,7 @@ bool IS25_ReadBytes(uint32_t addr, uint8_t* data, uint32_t length)
     if(rc_ok)
     {
     	uint32_t current_segment = 0;
+    	uint8_t* start = data;
     	PerformBankAddressWrite(0);
 
         while (rc_ok && length>0)
@@ -710,23 +1003,32 @@ bool IS25_ReadBytes(uint32_t addr, uint8_t* data, uint32_t length)
 
         	if(rc_ok)
         	{
-				uint32_t transfer_count;
-				memset( (void *) & cab, 0, sizeof(cab));
-				cab.cmd = IS25_NORD;
-
-				cab.address[0] = (addr>>16) & 0xff;
-				cab.address[1] = (addr>> 8) & 0xff;
-				cab.address[2] =  addr      & 0xff;
-
-				transfer_count = sizeof(cab.data);
+				// a single read must not run over into the next bank
+				uint32_t transfer_count = ((addr & IS25_A24_A25_MASK) + (1 << 24)) - addr;
+				if (transfer_count > IS25_BULK_READ_MAX_BYTES)
+				{
+					transfer_count = IS25_BULK_READ_MAX_BYTES;
+				}
 				if (length < transfer_count)
 				{
 					transfer_count = length;
 				}
-				rc_ok = DoTransfer((void * volatile) &cab, (void * volatile) &cab, transfer_count + sizeof(cab.cmd) + sizeof(cab.address));
+
+				if (transfer_count > sizeof(cab.data))
+				{
+					rc_ok = ReadBulk(addr, data, transfer_count, ((data - start) >= IS25_FRD_HEADER_BYTES));
+				}
+				else
+				{
+					rc_ok = ReadChunk(addr, data, transfer_count);
+				}
+
 				if(rc_ok )
 				{
-					memcpy(data, (void *) cab.data, transfer_count);
+					if (crc_p)
+					{
+						crc32_ctxUpdate(crc_p, data, transfer_count);
+					}
 					addr += transfer_count;
 					length -= transfer_count;
 					data += transfer_count;
@@ -892,6 +1194,13 @@ bool IS25_Init(uint32_t baudrate, uint32_t * calculatedBaudrate_p)
 
 	if (rc_ok)
 	{
+#ifndef _MSC_VER
+		// the sub-tick timer for the page program waits
+		SIM_SCGC6 |= SIM_SCGC6_PIT_MASK;
+		PIT_MCR &= ~PIT_MCR_MDIS_MASK;
+		PIT_TCTRL(DRVPIT_TIMERID_IS25) = 0;
+		NVIC_EnableIRQ(PIT1_IRQn);
+#endif
 		FlashExtInitIOLines();
 		// Configure FLASH_CSn for direct control from SPI peripheral
 		pinConfigDigitalOut(FLASH_CSn, kPortMuxAlt2, 0, false);
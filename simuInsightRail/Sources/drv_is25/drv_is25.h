@@ -13,6 +13,8 @@ extern "C" {
 #ifndef SOURCES_DRV_IS25_H_
 #define SOURCES_DRV_IS25_H_
 
+#include "crc.h"
+
 #define IS25_TRANSFER_BAUDRATE      (3072000U)     /*! Transfer clock rate, note any faster and we get read issues */
 
 #define IS25_SECTOR_SIZE_BYTES 		(4096)
@@ -30,7 +32,9 @@ bool IS25_Terminate();
 bool IS25_ReadProductIdentity(uint8_t* id);
 bool IS25_ReadManufacturerId(uint8_t* pManufacturerIDOut, uint8_t* pDeviceIDOut);
 bool IS25_WriteBytes(uint32_t addr, uint8_t* data, uint32_t length);
+bool IS25_WriteBytesCrc(uint32_t addr, uint8_t* data, uint32_t length, crc32Context_t* crc_p);
 bool IS25_ReadBytes(uint32_t addr, uint8_t* data, uint32_t length);
+bool IS25_ReadBytesCrc(uint32_t addr, uint8_t* data, uint32_t length, crc32Context_t* crc_p);
 bool IS25_PerformSectorErase(uint32_t startAddress, uint32_t numBytes);
 bool IS25_PerformChipErase(void);
 
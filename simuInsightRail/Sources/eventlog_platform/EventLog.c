@@ -34,12 +34,34 @@ extern "C" {
  *
  *      Use CLI for further help. See EventLogHelp [ Note: Enable DEBUGPRINTKEY in ConfigErrLog.h]
  *
+ *      Staging:- EventLog_In() does not program the flash itself, it appends the entry to a ring in RAM that is
+ *                kept over a warm reset (__eventlog_ram), in the units of its record, as it is to go to flash. The low priority EVENTLOG task commits the entries to
+ *                flash in batches, when half the ring is filled or EVENTLOG_COMMIT_DELAY_MS after the first one.
+ *                EventLog_Flush() commits them straight away, as does EventLog_InitFlashData() before reading.
+ *                When the ring is full an entry is dropped, and counted, rather than committed by the caller.
+ *                The task does not commit while a measurement is sampling, as the interrupts are disabled while
+ *                the flash is programmed, and once done it erases the next sector ahead of the write pointer,
+ *                so that a commit does not have to. The log so keeps a sector less of the oldest records.
+ *                An entry is programmed a phrase at a time, with the interrupts enabled in between, and the first
+ *                phrase (checksum and tag) last, which so marks the entry as committed. An entry broken off by a
+ *                reset is left without a tag, it is skipped and committed again from the RAM ring.
+ *
+ *      Records:- a record takes 1 to 4 units of EVENTLOG_UNIT_SIZE bytes, as many as it needs, given by its tag,
+ *                and is not split over sectors. When the format is a constant in the application image, the record
+ *                keeps the format address, a hash of the format and the arguments (tEventLog_binary), and it is
+ *                only formatted when read, by EventLog_formatMessage(). Other formats, arguments that do not fit
+ *                and the PMIC entries are formatted into a text record as before.
+ *                The 128 byte text records of the earlier format (HASH_TAG) are read as they are, and the log
+ *                carries on after them.
+ *
  */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "freeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 
 #include "EventLog.h"
@@ -52,6 +74,9 @@ extern "C" {
 #include "fsl_rtc_hal.h"
 #include "UnitTest.h"
 #include "configBootloader.h"
+#include "xTaskDefs.h"
+#include "xTaskMeasure.h"
+#include "linker.h"
 
 #ifdef CONFIG_PLATFORM_EVENT_LOG
 
@@ -59,10 +84,14 @@ extern "C" {
 #define USE_EVENTLOG_MUTEX
 
 #define EMPTY_8		0xFF
-#define EMPTY_64	0xFFFFFFFFFFFFFFFFLLU
-#define ZERO_64		0x0000000000000000LLU
-#define HASH_TAG 	0xA5
-#define MSG_SIZE	0x38
+#define HASH_TAG 	0xA5	// a text record of MAXERRLOGFRAMELENGTH bytes, the earlier format
+#define TAG_TEXT	0xD0	// | units, a text record
+#define TAG_BINARY	0xC0	// | units, a tEventLog_binary record
+#define TAG_KIND(tag)	((tag) & 0xF0)
+#define TAG_UNITS(tag)	((tag) & 0x0F)
+
+#define EVENTLOG_MAX_UNITS	(MAXERRLOGFRAMELENGTH / EVENTLOG_UNIT_SIZE)
+#define EVENTLOG_UNITS		(SYS_FLASH_ERRLOG_SIZE / EVENTLOG_UNIT_SIZE)
 
 #define SYS_FLASH_ERRLOG_SIZE (uint32_t)__eventlog_size
 #define SYS_FLASH_ERRLOG_ADDRESS (uint32_t)__event_log
@@ -71,16 +100,74 @@ extern "C" {
 #define ERRLOG_SECTORS (SYS_FLASH_ERRLOG_SIZE/SYS_FLASH_SECTOR_SIZE)
 
 #define SYS_FLASH_ERRLOG_ADDR(sector) (SYS_FLASH_ERRLOG_ADDRESS + (sector * SYS_FLASH_SECTOR_SIZE))
-
-typedef uint64_t fill_t;
+#define UNITS_PER_SECTOR (SYS_FLASH_SECTOR_SIZE / EVENTLOG_UNIT_SIZE)
+
+// the arguments a conversion of a format takes
+typedef enum {
+    ARG_NONE = 0,	// %%
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONGLONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_POINTER,
+    ARG_STRING,
+    ARG_UNSUPPORTED
+} tArgClass;
+
+typedef union {
+    int i;
+    long l;
+    long long ll;
+    size_t z;
+    double d;
+    void *p;
+} tArgValue;
+
+static const uint8_t argSize[] = {
+    [ARG_INT] = sizeof(int),
+    [ARG_LONG] = sizeof(long),
+    [ARG_LONGLONG] = sizeof(long long),
+    [ARG_SIZE] = sizeof(size_t),
+    [ARG_DOUBLE] = sizeof(double),
+    [ARG_POINTER] = sizeof(void *),
+};
 
 #if defined(USE_EVENTLOG_MUTEX)
 #define EVENT_LOG_MAX_WAIT_MS (100)
 static SemaphoreHandle_t xEventlogMutex = NULL;
 #endif
 
+#define EVENTLOG_COMMIT_DELAY_MS	(10000)
+#define EVENTLOG_MEASURE_POLL_MS	(1000)	// how often the task looks whether the measurement is done
+#define EVENTLOG_RAM_MAGIC			(0x45564C52)	// "EVLR"
+
 static bool writeToFlash(uint32_t *dest, uint32_t *src, uint32_t len);
 
+/*
+ * The entries not yet committed to flash, in RAM kept over a warm reset.
+ * An entry takes the units of its record, as in flash, and is not split
+ * over the end of the ring: the units left there when the largest record
+ * does not fit are skipped, marked by an empty tag. head and tail count the
+ * units appended and committed, dropped the entries that did not fit, the
+ * ring is valid when magic and check match.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    uint32_t check;
+    uint8_t units[][EVENTLOG_UNIT_SIZE];
+} tEventLogRam;
+
+#define EVENTLOG_RAM ((tEventLogRam *)__eventlog_ram)
+#define EVENTLOG_RAM_UNITS (((uint32_t)__eventlog_ram_size - sizeof(tEventLogRam)) / EVENTLOG_UNIT_SIZE)
+#define EVENTLOG_RAM_ENTRY(count) ((tEventLog_inFlash *)EVENTLOG_RAM->units[(count) % EVENTLOG_RAM_UNITS])
+
+static SemaphoreHandle_t xEventlogCommitSem = NULL;
+static TaskHandle_t _TaskHandle_EventLog = NULL;
+
 /*
  * This is a shared resource, access must be protected by a semaphore
  */
@@ -101,20 +188,405 @@ static const char EventLogHelp[] = {
 		"eventlog 10 <no entries>: Write a log sample <no entries> times\r\n"
 		"eventlog 11 <sector>: Erase sector <sector>\r\n"
 		"eventlog 12: Initialise eventlog\r\n"
+		"eventlog 14: Commit the entries in RAM to flash\r\n"
 };
 
 static const char msg4[] = "Vibration level(0.%d) above threshold";
 static const char msg10[] = "Node shutdown by exceeding max on time";
 static bool quiet = false;
 
+/*
+ * EventLog_entrySize:- the size of a record, from its tag
+ * Return value:- size in bytes, 0 when it is not a record
+ */
+uint32_t EventLog_entrySize(const tEventLog_inFlash * addrEventLog)
+{
+    uint8_t tag = addrEventLog->logHeader.tag;
+
+    if(tag == HASH_TAG)
+    {
+        return MAXERRLOGFRAMELENGTH;
+    }
+    if(((TAG_KIND(tag) == TAG_TEXT) || (TAG_KIND(tag) == TAG_BINARY)) &&
+       (TAG_UNITS(tag) >= 1) && (TAG_UNITS(tag) <= EVENTLOG_MAX_UNITS))
+    {
+        return TAG_UNITS(tag) * EVENTLOG_UNIT_SIZE;
+    }
+    return 0;
+}
+
 static bool validChecksum(uint8_t *addr)
 {
+    uint32_t size = EventLog_entrySize((tEventLog_inFlash *)addr);
     uint8_t crc = 0xFF;
-    for(int i = 1; i < sizeof(tEventLog_inFlash); i++)
+
+    for(int i = 1; i < size; i++)
     {
         crc ^= addr[i];
     }
-    return (crc == *addr);
+    return (size > 0) && (crc == *addr);
+}
+
+static void setChecksum(tEventLog_inFlash *pEventLog)
+{
+    uint8_t *p = (uint8_t *)&pEventLog->logHeader.tag;
+    uint32_t size = EventLog_entrySize(pEventLog);
+
+    pEventLog->logHeader.crc = 0xFF;
+    for(int i = 0; i < size - 1; i++)
+    {
+        pEventLog->logHeader.crc ^= p[i];
+    }
+}
+
+/*
+ * constFormat:- is the format a constant of the application image, that is still there to be read
+ * Return value:- bool
+ */
+static bool constFormat(const char *fmt)
+{
+#ifdef _MSC_VER
+    // the simulator cannot tell its constants apart, the callers pass constant formats
+    return (fmt != NULL);
+#else
+    return (((uint32_t)fmt - (uint32_t)__app_origin) < (uint32_t)__app_image_size);
+#endif
+}
+
+/*
+ * formatHash:- FNV-1a hash of a format, to tell it has not changed since it was logged
+ * Return value:- hash
+ */
+static uint32_t formatHash(const char *fmt)
+{
+    uint32_t hash = 2166136261u;
+
+    while(*fmt)
+    {
+        hash = (hash ^ (uint8_t)*fmt++) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * nextConversion:- find the next conversion of a format
+ * parameters: fmt -> the format, from where to look
+ *             pSpec -> set to the start of the conversion, its '%'
+ *             pClass -> set to the argument the conversion takes
+ * Return value:- the format after the conversion, NULL when there are no more
+ */
+static const char *nextConversion(const char *fmt, const char **pSpec, tArgClass *pClass)
+{
+    int longs = 0;
+    bool sized = false;
+
+    fmt = strchr(fmt, '%');
+    if(fmt == NULL)
+    {
+        return NULL;
+    }
+    *pSpec = fmt++;
+
+    // flags, width and precision, but not those given by an argument ('*')
+    fmt += strspn(fmt, "-+ #0");
+    fmt += strspn(fmt, "0123456789.");
+    for(; (*fmt == 'h') || (*fmt == 'l') || (*fmt == 'j') || (*fmt == 'z') || (*fmt == 't'); fmt++)
+    {
+        longs += (*fmt == 'l') ? 1 : ((*fmt == 'j') ? 2 : 0);
+        sized |= (*fmt == 'z') || (*fmt == 't');
+    }
+
+    switch(*fmt)
+    {
+    case '%':
+        *pClass = ARG_NONE;
+        break;
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        *pClass = sized ? ARG_SIZE : ((longs >= 2) ? ARG_LONGLONG : ((longs == 1) ? ARG_LONG : ARG_INT));
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        *pClass = ARG_DOUBLE;
+        break;
+    case 'p':
+        *pClass = ARG_POINTER;
+        break;
+    case 's':
+        *pClass = (longs == 0) ? ARG_STRING : ARG_UNSUPPORTED;
+        break;
+    default:
+        *pClass = ARG_UNSUPPORTED;
+        return fmt;
+    }
+    return fmt + 1;
+}
+
+/*
+ * packFormat:- keep the format and its arguments in a record, to be formatted when read
+ * Return value:- size of the record, 0 when the format is not a constant or the arguments do not fit
+ */
+static uint32_t packFormat(tEventLog_inFlash *pEventLog, const char *fmt, va_list ap)
+{
+    tEventLog_binary *pBinary = (tEventLog_binary *)pEventLog->logMsg;
+    uint32_t length = 0;
+    const char *spec;
+    tArgClass argClass;
+    tArgValue value;
+
+    if(!constFormat(fmt))
+    {
+        return 0;
+    }
+
+    for(const char *p = fmt; (p = nextConversion(p, &spec, &argClass)) != NULL; )
+    {
+        uint32_t size = argSize[argClass];
+        const void *src = &value;
+
+        switch(argClass)
+        {
+        case ARG_NONE:
+            break;
+        case ARG_INT:
+            value.i = va_arg(ap, int);
+            break;
+        case ARG_LONG:
+            value.l = va_arg(ap, long);
+            break;
+        case ARG_LONGLONG:
+            value.ll = va_arg(ap, long long);
+            break;
+        case ARG_SIZE:
+            value.z = va_arg(ap, size_t);
+            break;
+        case ARG_DOUBLE:
+            value.d = va_arg(ap, double);
+            break;
+        case ARG_POINTER:
+            value.p = va_arg(ap, void *);
+            break;
+        case ARG_STRING:
+            src = va_arg(ap, const char *);
+            if(src == NULL)
+            {
+                src = "(null)";
+            }
+            size = strlen(src) + 1;
+            break;
+        default:
+            return 0;
+        }
+        if((length + size) > sizeof(pBinary->args))
+        {
+            return 0;
+        }
+        memcpy(&pBinary->args[length], src, size);
+        length += size;
+    }
+
+    pBinary->fmt = fmt;
+    pBinary->fmtId = formatHash(fmt);
+    pBinary->argLength = length;
+    return sizeof(struct errLog_header) + offsetof(tEventLog_binary, args) + length;
+}
+
+/*
+ * appendf:- format to the end of a string, as far as it fits
+ */
+static void appendf(char *buf, uint32_t size, uint32_t *pLen, const char *fmt, ...)
+{
+    va_list ap;
+    int count;
+
+    va_start(ap, fmt);
+    count = vsnprintf(&buf[*pLen], size - *pLen, fmt, ap);
+    va_end(ap);
+    if(count > 0)
+    {
+        *pLen = ((*pLen + count) < size) ? (*pLen + count) : (size - 1);
+    }
+}
+
+/*
+ * formatBinary:- format a record kept as format and arguments
+ * Return value:- pass/fail (bool), fails when the format is not there any more, or does not match the arguments
+ */
+static bool formatBinary(const tEventLog_binary *pBinary, char *buf, uint32_t size, uint32_t *pLen)
+{
+    const uint8_t *arg = pBinary->args;
+    const uint8_t *end = &pBinary->args[pBinary->argLength];
+    const char *fmt = pBinary->fmt;
+    const char *next, *spec;
+    tArgClass argClass;
+    tArgValue value;
+    char conversion[16];
+
+    // after a firmware update the format may have moved
+    if((pBinary->argLength > sizeof(pBinary->args)) || !constFormat(fmt) || (formatHash(fmt) != pBinary->fmtId))
+    {
+        return false;
+    }
+
+    for(; (next = nextConversion(fmt, &spec, &argClass)) != NULL; fmt = next)
+    {
+        if((argClass == ARG_UNSUPPORTED) || ((next - spec) >= sizeof(conversion)))
+        {
+            return false;
+        }
+        appendf(buf, size, pLen, "%.*s", (int)(spec - fmt), fmt);
+        memcpy(conversion, spec, next - spec);
+        conversion[next - spec] = '\0';
+
+        if(argClass == ARG_STRING)
+        {
+            const uint8_t *nul = memchr(arg, '\0', end - arg);
+            if(nul == NULL)
+            {
+                return false;
+            }
+            appendf(buf, size, pLen, conversion, (const char *)arg);
+            arg = nul + 1;
+            continue;
+        }
+        if((end - arg) < argSize[argClass])
+        {
+            return false;
+        }
+        memcpy(&value, arg, argSize[argClass]);
+        arg += argSize[argClass];
+
+        switch(argClass)
+        {
+        case ARG_NONE:
+            appendf(buf, size, pLen, "%%");
+            break;
+        case ARG_INT:
+            appendf(buf, size, pLen, conversion, value.i);
+            break;
+        case ARG_LONG:
+            appendf(buf, size, pLen, conversion, value.l);
+            break;
+        case ARG_LONGLONG:
+            appendf(buf, size, pLen, conversion, value.ll);
+            break;
+        case ARG_SIZE:
+            appendf(buf, size, pLen, conversion, value.z);
+            break;
+        case ARG_DOUBLE:
+            appendf(buf, size, pLen, conversion, value.d);
+            break;
+        default:
+            appendf(buf, size, pLen, conversion, value.p);
+            break;
+        }
+    }
+    appendf(buf, size, pLen, "%s", fmt);
+    return (arg == end);
+}
+
+/*
+ * EventLog_formatMessage:- the message of a record, formatted when it was kept as format and arguments
+ *                          When the format cannot be read, it gives its address, hash and the arguments
+ *                          in hex, to be formatted with the map of the image that logged it
+ * Return value:- length of the message
+ */
+uint32_t EventLog_formatMessage(const tEventLog_inFlash * addrEventLog, char * buf, uint32_t size)
+{
+    uint32_t len = 0;
+
+    if(size == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+
+    if(TAG_KIND(addrEventLog->logHeader.tag) == TAG_BINARY)
+    {
+        const tEventLog_binary *pBinary = (const tEventLog_binary *)addrEventLog->logMsg;
+
+        if(!formatBinary(pBinary, buf, size, &len))
+        {
+            len = 0;
+            appendf(buf, size, &len, "fmt %p #%08x:", pBinary->fmt, pBinary->fmtId);
+            for(int i = 0; (i < pBinary->argLength) && (i < sizeof(pBinary->args)); i++)
+            {
+                appendf(buf, size, &len, " %02x", pBinary->args[i]);
+            }
+        }
+    }
+    else
+    {
+        uint32_t textSize = EventLog_entrySize(addrEventLog) - sizeof(struct errLog_header);
+        appendf(buf, size, &len, "%.*s", (int)((textSize < MAXLOGSTRINGLENGTH) ? textSize : MAXLOGSTRINGLENGTH),
+                addrEventLog->logMsg);
+    }
+    return len;
+}
+
+static void setRamCheck(void)
+{
+    EVENTLOG_RAM->check = ~(EVENTLOG_RAM->magic ^ EVENTLOG_RAM->head ^ EVENTLOG_RAM->tail ^ EVENTLOG_RAM->dropped);
+}
+
+/*
+ * initRam:- keep the entries in the RAM ring when it is valid (a warm reset), else start empty
+ * Return value:- None
+ */
+static void initRam(void)
+{
+    if((EVENTLOG_RAM->magic != EVENTLOG_RAM_MAGIC) ||
+       (EVENTLOG_RAM->check != ~(EVENTLOG_RAM->magic ^ EVENTLOG_RAM->head ^ EVENTLOG_RAM->tail ^ EVENTLOG_RAM->dropped)) ||
+       ((EVENTLOG_RAM->head - EVENTLOG_RAM->tail) > EVENTLOG_RAM_UNITS))
+    {
+        EVENTLOG_RAM->magic = EVENTLOG_RAM_MAGIC;
+        EVENTLOG_RAM->head = EVENTLOG_RAM->tail = 0;
+        EVENTLOG_RAM->dropped = 0;
+        setRamCheck();
+    }
+}
+
+/*
+ * ramSkip:- the units left at the end of the RAM ring, when the largest record does not fit in before it
+ * Return value:- number of units
+ */
+static uint32_t ramSkip(void)
+{
+    uint32_t index = EVENTLOG_RAM->head % EVENTLOG_RAM_UNITS;
+
+    return ((index + EVENTLOG_MAX_UNITS) > EVENTLOG_RAM_UNITS) ? (EVENTLOG_RAM_UNITS - index) : 0;
+}
+
+/*
+ * ramHasRoom:- whether the largest record can be appended to the RAM ring
+ * Return value:- true when it can
+ */
+static bool ramHasRoom(void)
+{
+    return ((EVENTLOG_RAM->head - EVENTLOG_RAM->tail) + ramSkip() + EVENTLOG_MAX_UNITS) <= EVENTLOG_RAM_UNITS;
+}
+
+/*
+ * ramEntryUnits:- the units of the entry in the RAM ring at <count>, the units skipped
+ * to the end of the ring for a skip marker or a damaged tag, no more than are pending
+ * Return value:- number of units, *pSize the size of the record, 0 when it is not one
+ */
+static uint32_t ramEntryUnits(uint32_t count, uint32_t *pSize)
+{
+    uint32_t index = count % EVENTLOG_RAM_UNITS;
+    uint32_t units;
+
+    *pSize = EventLog_entrySize(EVENTLOG_RAM_ENTRY(count));
+    units = *pSize / EVENTLOG_UNIT_SIZE;
+    if((units == 0) || ((index + units) > EVENTLOG_RAM_UNITS))
+    {
+        *pSize = 0;
+        units = EVENTLOG_RAM_UNITS - index;
+    }
+    if(units > (EVENTLOG_RAM->head - count))
+    {
+        *pSize = 0;
+        units = EVENTLOG_RAM->head - count;
+    }
+    return units;
 }
 
 /*
@@ -144,6 +616,9 @@ static char *UTCToString(uint32_t seconds)
  */
 void EventLog_printLogEntry(tEventLog_inFlash * addrEventLog)
 {
+	static char message[MAXLOGSTRINGLENGTH + 32];
+
+	EventLog_formatMessage(addrEventLog, message, sizeof(message));
 	printf("\naddrEventLog = %08x\n", addrEventLog);
 	printf("idefTimestamp = 0x%016llx %s.%03d\n",
 			addrEventLog->logHeader.unixTimestamp,
@@ -152,7 +627,7 @@ void EventLog_printLogEntry(tEventLog_inFlash * addrEventLog)
 	printf("compNumber = %d, eventCode = %d, sevLvl = %d\n",
 			addrEventLog->logHeader.compNumber, addrEventLog->logHeader.eventCode,
 			addrEventLog->logHeader.sevLvl);
-	printf("Message = %s\n", addrEventLog->logMsg);
+	printf("Message = %s\n", message);
 }
 
 static bool irqDisabledDrvFlashEraseSector(uint32_t sector)
@@ -160,7 +635,7 @@ static bool irqDisabledDrvFlashEraseSector(uint32_t sector)
 	bool rc_ok = true;
 
 	// if it's already blank don't bother (hopefully saves wear and tear)
-    if(!blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDR(sector), SYS_FLASH_ERRLOG_SIZE))
+    if(!blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDR(sector), SYS_FLASH_SECTOR_SIZE))
     {
 		__disable_irq();// we may run in the same flash bank as the one we are erasing/programming, then interrupts may not execute code inside this bank !
 		rc_ok = DrvFlashEraseSector(((uint32_t *)SYS_FLASH_ERRLOG_ADDR(sector)), SYS_FLASH_SECTOR_SIZE);
@@ -178,10 +653,10 @@ static bool irqDisabledDrvFlashEraseSector(uint32_t sector)
 }
 
 /*
- * EventLog_Clear:- to Clear the record from the Memory (only to be called from the CLI !!)
+ * clearFlash:- erase the log in flash
  * Return value:- None
  */
-void EventLog_Clear(void)
+static void clearFlash(void)
 {
     bool rc_ok=true;
 
@@ -210,6 +685,17 @@ void EventLog_Clear(void)
     }
 }
 
+/*
+ * EventLog_Clear:- to Clear the record from the Memory, with the entries not yet committed
+ * Return value:- None
+ */
+void EventLog_Clear(void)
+{
+    clearFlash();
+    EVENTLOG_RAM->tail = EVENTLOG_RAM->head;
+    setRamCheck();
+}
+
 ///*
 // * PrintMem:- To print the address and size of the allocated flash memory for erelog (From Linker script)
 // * Return value:- None
@@ -231,155 +717,401 @@ static void PrintMem(void)
     		recEventLogFlashData.lastId);
 }
 
+/*
+ * nextUnit:- the address <units> units on in the log, wrapping round
+ * Return value:- address
+ */
+static tEventLog_inFlash *nextUnit(tEventLog_inFlash *pEventLog, uint32_t units)
+{
+    uint32_t addr = (uint32_t)pEventLog + (units * EVENTLOG_UNIT_SIZE);
+
+    if(addr >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
+    {
+        addr = SYS_FLASH_ERRLOG_ADDRESS;
+    }
+    return (tEventLog_inFlash *)addr;
+}
+
+/*
+ * advanceWrite:- move the write pointer on by <units>, erasing the sector it enters
+ * Return value:- pass/fail of the erase (bool)
+ */
+static bool advanceWrite(uint32_t units)
+{
+    bool rc_ok = true;
+    uint32_t dest;
+
+    recEventLogFlashData.write = nextUnit(recEventLogFlashData.write, units);
+    dest = (uint32_t)recEventLogFlashData.write;
+    if(((dest - SYS_FLASH_ERRLOG_ADDRESS) % SYS_FLASH_SECTOR_SIZE) == 0)
+    {
+        int sector = ((dest - SYS_FLASH_ERRLOG_ADDRESS) / SYS_FLASH_SECTOR_SIZE);
+        rc_ok = irqDisabledDrvFlashEraseSector(sector);
+        if((SYS_FLASH_ERRLOG_ADDR(sector) + SYS_FLASH_SECTOR_SIZE) >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
+        {
+            recEventLogFlashData.start = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS;
+        }
+        else
+        {
+        	recEventLogFlashData.start = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDR(++sector);
+        }
+    }
+    return rc_ok;
+}
+
+/*
+ * commitOldest:- commit the oldest entry of the RAM ring to flash, the mutex must be held
+ * Return value:- pass/fail (bool)
+ */
+static bool commitOldest(void)
+{
+    tEventLog_inFlash *pEventLog = EVENTLOG_RAM_ENTRY(EVENTLOG_RAM->tail);
+    uint32_t size;
+    uint32_t units = ramEntryUnits(EVENTLOG_RAM->tail, &size);
+    bool rc_ok = true;
+
+    // skipped units are passed over, an entry damaged in RAM (a reset while it was appended) is dropped
+    if((size > 0) && validChecksum((uint8_t *)pEventLog))
+    {
+        // numbered in the order committed, so also after a reset
+        pEventLog->logHeader.id = recEventLogFlashData.lastId + 1;
+        setChecksum(pEventLog);
+
+        // a record is not split over sectors, and units left part programmed by a reset cannot be programmed again
+        for(int i = 0; (i < EVENTLOG_UNITS) &&
+                       (((SYS_FLASH_SECTOR_SIZE - (((uint32_t)recEventLogFlashData.write - SYS_FLASH_ERRLOG_ADDRESS) % SYS_FLASH_SECTOR_SIZE)) < size) ||
+                        !blank_check((uint8_t *)recEventLogFlashData.write, size)); i++)
+        {
+            advanceWrite(1);
+        }
+
+        rc_ok = writeToFlash((uint32_t *)recEventLogFlashData.write, (uint32_t *)pEventLog, size);
+        recEventLogFlashData.lastId++;
+        if(!advanceWrite(size / EVENTLOG_UNIT_SIZE))
+        {
+            rc_ok = false;
+        }
+    }
+
+    EVENTLOG_RAM->tail += units;
+    setRamCheck();
+    return rc_ok;
+}
+
+/*
+ * commitAll:- commit the entries of the RAM ring to flash, the mutex must be held
+ * Return value:- pass/fail (bool)
+ */
+static bool commitAll(void)
+{
+    bool rc_ok = true;
+
+    while(EVENTLOG_RAM->tail != EVENTLOG_RAM->head)
+    {
+        if(!commitOldest())
+        {
+            rc_ok = false;
+        }
+    }
+    return rc_ok;
+}
+
 //
 /* Global call
- * EventLog_In:- to record the Eventor in Flash Memory.
- * After recording the time stamp, call writeEventLogToFlash`
- * Return value:- None
+ * EventLog_In:- to record the Eventor, in the RAM ring to be committed to Flash Memory.
+ * Return value:- pass/fail (bool), fail when the ring is full and the entry is dropped
  *
  */
 bool EventLog_In(uint16_t eventcode, uint16_t compNum, uint8_t sevlevel,  const char *fmt, ...)
 {
-    tEventLog_inFlash dtEventLog;
-    bool rc_ok = true;
+    tEventLog_inFlash *pEventLog;
+    uint32_t pending, skip, size = 0;
     va_list ap;
 
 #if defined(USE_EVENTLOG_MUTEX)
     xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
 #endif
 
-    dtEventLog.logHeader.id = ++recEventLogFlashData.lastId;
-    dtEventLog.logHeader.unixTimestamp = ConfigSvcData_GetIDEFTime(); // unix timestamp using idef
-    dtEventLog.logHeader.eventCode = eventcode;
-    dtEventLog.logHeader.sevLvl = sevlevel;
-    dtEventLog.logHeader.compNumber = compNum;
-    dtEventLog.logHeader.tag = HASH_TAG; // Default value
+    // no room, the entry is dropped, committing here would disable the interrupts in the caller's time
+    if(!ramHasRoom())
+    {
+        EVENTLOG_RAM->dropped++;
+        setRamCheck();
+#if defined(USE_EVENTLOG_MUTEX)
+        xSemaphoreGive(xEventlogMutex);
+#endif
+        return false;
+    }
+
+    // the record is formatted in place, so goes to the start of the ring when the largest one does not fit before its end
+    pending = EVENTLOG_RAM->head - EVENTLOG_RAM->tail;
+    skip = ramSkip();
+    if(skip > 0)
+    {
+        EVENTLOG_RAM_ENTRY(EVENTLOG_RAM->head)->logHeader.tag = EMPTY_8;
+        EVENTLOG_RAM->head += skip;
+        setRamCheck();
+    }
+
+    pEventLog = EVENTLOG_RAM_ENTRY(EVENTLOG_RAM->head);
+    pEventLog->logHeader.id = 0;	// set when committed
+    pEventLog->logHeader.unixTimestamp = ConfigSvcData_GetIDEFTime(); // unix timestamp using idef
+    pEventLog->logHeader.eventCode = eventcode;
+    pEventLog->logHeader.sevLvl = sevlevel;
+    pEventLog->logHeader.compNumber = compNum;
 
-    memset(dtEventLog.logMsg, EMPTY_8, MAXLOGSTRINGLENGTH);
+    memset(pEventLog->logMsg, EMPTY_8, MAXLOGSTRINGLENGTH);
     va_start(ap, fmt);
     if((compNum == LOG_LEVEL_PMIC) && (eventcode >= PMIC_EVENTLOG_BAND))
     {
-    	dtEventLog.logHeader.unixTimestamp = (uint64_t)va_arg(ap, uint32_t) * 10000000ULL;
-    	strcpy(dtEventLog.logMsg, fmt);
+    	pEventLog->logHeader.unixTimestamp = (uint64_t)va_arg(ap, uint32_t) * 10000000ULL;
+    	strncpy(pEventLog->logMsg, fmt, sizeof(pEventLog->logMsg) - 1);
+    	pEventLog->logMsg[sizeof(pEventLog->logMsg)-1] = '\0';
     }
-    else
+    else if((size = packFormat(pEventLog, fmt, ap)) == 0)
     {
-        int count = vsnprintf(dtEventLog.logMsg, sizeof(dtEventLog.logMsg), fmt, ap);
+        // not a constant format, or the arguments do not fit, it is formatted now
+        memset(pEventLog->logMsg, EMPTY_8, MAXLOGSTRINGLENGTH);
+        va_end(ap);
+        va_start(ap, fmt);
+        int count = vsnprintf(pEventLog->logMsg, sizeof(pEventLog->logMsg), fmt, ap);
         if(count >= (MAXLOGSTRINGLENGTH - 1))
         {
-             dtEventLog.logMsg[sizeof(dtEventLog.logMsg)-1] = '\0';
+             pEventLog->logMsg[sizeof(pEventLog->logMsg)-1] = '\0';
         }
     }
     va_end(ap);
-     uint8_t *p = (uint8_t *)&dtEventLog.logHeader.tag;
-    dtEventLog.logHeader.crc = 0xFF;
-    for(int i = 0; i < sizeof(dtEventLog) - 1; i++)
+
+    if(size > 0)
+    {
+        pEventLog->logHeader.tag = TAG_BINARY | ((size + EVENTLOG_UNIT_SIZE - 1) / EVENTLOG_UNIT_SIZE);
+    }
+    else
     {
-        dtEventLog.logHeader.crc ^= p[i];
+        size = sizeof(struct errLog_header) + strlen(pEventLog->logMsg) + 1;
+        pEventLog->logHeader.tag = TAG_TEXT | ((size + EVENTLOG_UNIT_SIZE - 1) / EVENTLOG_UNIT_SIZE);
     }
+    setChecksum(pEventLog);
 
 #ifdef DEBUG
     if (!quiet && dbg_logging)
     {
+        static char message[MAXLOGSTRINGLENGTH + 32];
+
         //there is an event and some logging is on, we better also print it out here
+        EventLog_formatMessage(pEventLog, message, sizeof(message));
         printf("\nEvent: ");
-        ConfigSvcData_PrintIDEFTime(dtEventLog.logHeader.unixTimestamp);
+        ConfigSvcData_PrintIDEFTime(pEventLog->logHeader.unixTimestamp);
         printf(" code:%d comp:%d level:%d,\n       \"%s\"\n",
-                dtEventLog.logHeader.eventCode,
-                dtEventLog.logHeader.compNumber,
-                dtEventLog.logHeader.sevLvl,
-                dtEventLog.logMsg);
+                pEventLog->logHeader.eventCode,
+                pEventLog->logHeader.compNumber,
+                pEventLog->logHeader.sevLvl,
+                message);
     }
 #endif
-    uint32_t dest = (uint32_t)(recEventLogFlashData.write);
-    rc_ok = writeToFlash((uint32_t *)dest, (uint32_t*)&dtEventLog, sizeof(dtEventLog));
-    dest = (uint32_t)++recEventLogFlashData.write;
-    if(dest >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
+    EVENTLOG_RAM->head += EventLog_entrySize(pEventLog) / EVENTLOG_UNIT_SIZE;
+    setRamCheck();
+#if defined(USE_EVENTLOG_MUTEX)
+    xSemaphoreGive(xEventlogMutex);
+#endif
+
+    // wake the commit task for the first entry, and when half the ring is filled
+    if((xEventlogCommitSem != NULL) &&
+       ((pending == 0) || ((pending < (EVENTLOG_RAM_UNITS / 2)) && ((EVENTLOG_RAM->head - EVENTLOG_RAM->tail) >= (EVENTLOG_RAM_UNITS / 2)))))
     {
-        recEventLogFlashData.write = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS;
-        dest = (uint32_t)recEventLogFlashData.write;
+        xSemaphoreGive(xEventlogCommitSem);
     }
-    if((dest % SYS_FLASH_SECTOR_SIZE) == 0)
+
+    return true;
+}
+
+/*
+ * EventLog_pendingSize:- the size of the entries in RAM, not yet committed to the Flash Memory
+ * Return value:- size in bytes, as records
+ */
+uint32_t EventLog_pendingSize(void)
+{
+    uint32_t size = 0;
+    uint32_t entrySize;
+
+#if defined(USE_EVENTLOG_MUTEX)
+    xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+    for(uint32_t i = EVENTLOG_RAM->tail; i != EVENTLOG_RAM->head; )
     {
-        int sector = ((dest - SYS_FLASH_ERRLOG_ADDRESS) / SYS_FLASH_SECTOR_SIZE);
-        rc_ok = irqDisabledDrvFlashEraseSector(sector);
-        if((SYS_FLASH_ERRLOG_ADDR(sector) + SYS_FLASH_SECTOR_SIZE) >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
+        i += ramEntryUnits(i, &entrySize);
+        size += entrySize;
+    }
+#if defined(USE_EVENTLOG_MUTEX)
+    xSemaphoreGive(xEventlogMutex);
+#endif
+    return size;
+}
+
+/*
+ * commitEntries:- commit the entries in RAM to the Flash Memory
+ * parameters: whenIdle -> stop when a measurement is sampling
+ * Return value:- pass/fail (bool), fail also when stopped
+ */
+static bool commitEntries(bool whenIdle)
+{
+    bool rc_ok = true;
+
+    // an entry at a time, so EventLog_In() is not held up for the whole batch
+    for(;;)
+    {
+        if(whenIdle && Measure_IsSamplingInProgress())
         {
-            recEventLogFlashData.start = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS;
+            return false;
         }
-        else
+#if defined(USE_EVENTLOG_MUTEX)
+        xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+        bool done = (EVENTLOG_RAM->tail == EVENTLOG_RAM->head);
+        if(!done && !commitOldest())
         {
-        	recEventLogFlashData.start = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDR(++sector);
+            rc_ok = false;
+        }
+#if defined(USE_EVENTLOG_MUTEX)
+        xSemaphoreGive(xEventlogMutex);
+#endif
+        if(done)
+        {
+            break;
+        }
+    }
+    return rc_ok;
+}
+
+/*
+ * EventLog_Flush:- commit the entries in RAM to the Flash Memory
+ * Return value:- pass/fail (bool)
+ */
+bool EventLog_Flush(void)
+{
+    return commitEntries(false);
+}
+
+/*
+ * eraseAhead:- erase the sector after the one being written, when it is not blank, so the commit
+ * entering it does not have to. The oldest records, in that sector, are lost now rather than then.
+ * Return value:- pass/fail of the erase (bool)
+ */
+static bool eraseAhead(void)
+{
+    uint32_t sector, start;
+    bool rc_ok = true;
+
+#if defined(USE_EVENTLOG_MUTEX)
+    xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+    sector = ((((uint32_t)recEventLogFlashData.write - SYS_FLASH_ERRLOG_ADDRESS) / SYS_FLASH_SECTOR_SIZE) + 1) % ERRLOG_SECTORS;
+    start = (uint32_t)recEventLogFlashData.start;
+    if(!Measure_IsSamplingInProgress() && !blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDR(sector), SYS_FLASH_SECTOR_SIZE))
+    {
+        rc_ok = irqDisabledDrvFlashEraseSector(sector);
+        if((start >= SYS_FLASH_ERRLOG_ADDR(sector)) && (start < (SYS_FLASH_ERRLOG_ADDR(sector) + SYS_FLASH_SECTOR_SIZE)))
+        {
+            recEventLogFlashData.start = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDR((sector + 1) % ERRLOG_SECTORS);
         }
     }
 #if defined(USE_EVENTLOG_MUTEX)
     xSemaphoreGive(xEventlogMutex);
 #endif
-
     return rc_ok;
 }
 
+/*
+ * taskEventLog:- commits the entries in RAM in batches, the full ring is not waited for
+ * longer than EVENTLOG_COMMIT_DELAY_MS after the first entry, nor commits while a
+ * measurement is sampling. Then erases ahead and logs the entries dropped, if any.
+ */
+static void taskEventLog(void *pvParameters)
+{
+    uint32_t dropped;
+
+    for(;;)
+    {
+        xSemaphoreTake(xEventlogCommitSem, portMAX_DELAY);
+        xSemaphoreTake(xEventlogCommitSem, EVENTLOG_COMMIT_DELAY_MS/portTICK_PERIOD_MS);
+        // not while measuring, the interrupts are disabled while the flash is programmed
+        while(!commitEntries(true) && Measure_IsSamplingInProgress())
+        {
+            vTaskDelay(EVENTLOG_MEASURE_POLL_MS/portTICK_PERIOD_MS);
+        }
+        eraseAhead();
+
+#if defined(USE_EVENTLOG_MUTEX)
+        xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+        dropped = EVENTLOG_RAM->dropped;
+        EVENTLOG_RAM->dropped = 0;
+        setRamCheck();
+#if defined(USE_EVENTLOG_MUTEX)
+        xSemaphoreGive(xEventlogMutex);
+#endif
+        if(dropped > 0)
+        {
+            LOG_EVENT(0, LOG_NUM_APP, ERRLOGWARN, "Event log full, %u entries dropped", (unsigned)dropped);
+        }
+    }
+}
+
 /*
  * writeToFlash:- to write the record into the Flash
- * parameters: refcopy -> source address
- *             sector -> Current sector info
- *             totsum  -> Count of address in the sector which will be starting address of the sector to be written
+ * parameters: dest -> destination address, blank
+ *             src -> source address
  *             len ->  Length of the record to be written
+ *
+ * The record is programmed a phrase at a time, with the interrupts enabled in between,
+ * from the end, so the first phrase (with checksum and tag) marks it as complete.
  * Return value:- pass/fail (bool)
  */
 
 static bool writeToFlash(uint32_t *dest, uint32_t *src, uint32_t len)
 {
-    // we may run in the same flash bank as the one we are erasing/programming,
-    // then interrupts may not execute code inside this bank !
-    __disable_irq();
-    bool rc_ok = DrvFlashProgram((uint32_t *)dest, (uint32_t *)src, (uint32_t)len);
-    __enable_irq();
-    if (rc_ok)
+    bool rc_ok = true;
+    uint32_t offset = (len + PGM_SIZE_BYTE - 1) & ~(PGM_SIZE_BYTE - 1);
+
+    while (rc_ok && (offset > 0))
     {
-        // lets verify the data
+        offset -= PGM_SIZE_BYTE;
+
+        // we may run in the same flash bank as the one we are erasing/programming,
+        // then interrupts may not execute code inside this bank !
         __disable_irq();
-        rc_ok = DrvFlashVerify((uint32_t *)dest, (uint32_t *)src, len, 0);
-   	    __enable_irq();
-#ifdef DEBUGPRINTKEY
-   		if(rc_ok)
+        rc_ok = DrvFlashProgram((uint32_t *)((uint8_t *)dest + offset), (uint32_t *)((uint8_t *)src + offset), PGM_SIZE_BYTE);
+        __enable_irq();
+        if (rc_ok)
         {
-          //Do not report in event log
-            printf("%s() flash verify at %08x %s\n", __func__, dest, (rc_ok) ? "passed" : "failed");
+            // lets verify the data
+            __disable_irq();
+            rc_ok = DrvFlashVerify((uint32_t *)((uint8_t *)dest + offset), (uint32_t *)((uint8_t *)src + offset), PGM_SIZE_BYTE, 0);
+            __enable_irq();
         }
-#endif
     }
-    else
-    {
-        //Do not report in event log
 #ifdef DEBUGPRINTKEY
-        printf("%s() flash write at %08x failed\n", __func__, dest);
+    printf("%s() flash write at %08x %s\n", __func__, dest, (rc_ok) ? "passed" : "failed");
 #endif
+    if (!rc_ok)
+    {
+        //Do not report in event log
         /*recommended to erase the flash. If Write is not successful, the SDK Flash driver will corrupt the memory address which will make an hard fault during reading
          * To avoid that, i have gone with erasing optionof the sector*/
         irqDisabledDrvFlashEraseSector(0);
-        rc_ok =false;
     }
     return rc_ok;
 
 }
 
 /*
- * EventLog_InitFlashData:- Point to the last record. Get the last written sector and address(tosum)
- *                       Point to the last read location [If you have already read, then it points to last read time stamp recorded
- *                                                       If you have not read at all, then it will point to the last written time stamp]
+ * scanFlash:- Point to the last record. Get the last written sector and address(tosum)
+ *             Point to the last read location [If you have already read, then it points to last read time stamp recorded
+ *                                             If you have not read at all, then it will point to the last written time stamp]
  * Return value:- None
  */
-void EventLog_InitFlashData(void)
+static void scanFlash(void)
 {
-#if defined(USE_EVENTLOG_MUTEX)
-    if(xEventlogMutex == NULL)
-    {
-    	xEventlogMutex = xSemaphoreCreateMutex();
-    }
-
-    xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
-#endif
     // set up the structure
     recEventLogFlashData.start = recEventLogFlashData.write = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDR(0);
     recEventLogFlashData.lastId = 0;
@@ -387,54 +1119,83 @@ void EventLog_InitFlashData(void)
     // take the easy way out if eventlog is erased
     if(blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDRESS, SYS_FLASH_ERRLOG_SIZE))
     {
-		#if defined(USE_EVENTLOG_MUTEX)
-		xSemaphoreGive(xEventlogMutex);
-		#endif
     	return;
     }
 
     uint32_t loId = 0xFFFF, hiId = 0;
     for (int sector = 0; sector < ERRLOG_SECTORS; sector++)
     {
-        // check the starting address of the sector
-        // if found empty then sector is empty else find the starting address
-        tEventLog_inFlash * pEventLog = (tEventLog_inFlash *)(SYS_FLASH_ERRLOG_ADDR(sector));
-        for(int i = 0; i < (SYS_FLASH_SECTOR_SIZE/sizeof(tEventLog_inFlash)); i++)
+        // walk the records of the sector, a unit at a time over those that are not
+        for(uint32_t offset = 0; offset < SYS_FLASH_SECTOR_SIZE; )
         {
-        	if(*(fill_t*)&pEventLog[i] == EMPTY_64)
-        	{
-        		break;
-        	}
-            if((pEventLog[i].logHeader.tag != HASH_TAG) || !validChecksum((uint8_t*)&pEventLog[i]))
+            tEventLog_inFlash * pEventLog = (tEventLog_inFlash *)(SYS_FLASH_ERRLOG_ADDR(sector) + offset);
+            uint32_t size = EventLog_entrySize(pEventLog);
+
+            // empty, or not committed (broken off by a reset)
+            if((size == 0) || ((offset + size) > SYS_FLASH_SECTOR_SIZE) || !validChecksum((uint8_t*)pEventLog))
             {
-            	EventLog_Clear();
-            	return;
+                offset += EVENTLOG_UNIT_SIZE;
+                continue;
             }
-            if(pEventLog[i].logHeader.id < loId)
+            if(pEventLog->logHeader.id < loId)
             {
-                loId = pEventLog[i].logHeader.id;
-                recEventLogFlashData.start = &pEventLog[i];
+                loId = pEventLog->logHeader.id;
+                recEventLogFlashData.start = pEventLog;
             }
-            if(pEventLog[i].logHeader.id > hiId)
+            if(pEventLog->logHeader.id > hiId)
             {
-                hiId = pEventLog[i].logHeader.id;
-                if((uint32_t)&pEventLog[i+1] >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
-                {
-                    recEventLogFlashData.write = (tEventLog_inFlash*)SYS_FLASH_ERRLOG_ADDRESS;
-                }
-                else
-                {
-                    recEventLogFlashData.write = &pEventLog[i+1];
-                }
+                hiId = pEventLog->logHeader.id;
+                recEventLogFlashData.write = nextUnit(pEventLog, size / EVENTLOG_UNIT_SIZE);
             }
+            offset += size;
         }
     }
     recEventLogFlashData.lastId = hiId;
+}
+
+/*
+ * EventLog_InitFlashData:- Find the records in flash, and commit those in RAM after them, so all can be read
+ * Return value:- None
+ */
+void EventLog_InitFlashData(void)
+{
+#if defined(USE_EVENTLOG_MUTEX)
+    if(xEventlogMutex == NULL)
+    {
+    	xEventlogMutex = xSemaphoreCreateMutex();
+    }
+
+    xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+    scanFlash();
+    commitAll();
 #if defined(USE_EVENTLOG_MUTEX)
     xSemaphoreGive(xEventlogMutex);
 #endif
 }
 
+/*
+ * EventLog_Init:- Set up the event log, with the entries kept in RAM over a warm reset,
+ * and start the task committing them
+ * Return value:- None
+ */
+void EventLog_Init(void)
+{
+    initRam();
+    EventLog_InitFlashData();
+
+    if(xEventlogCommitSem == NULL)
+    {
+        xEventlogCommitSem = xSemaphoreCreateBinary();
+        xTaskCreate( taskEventLog,                // Task function name
+                     "EVENTLOG",                  // Task name string
+                     STACKSIZE_XTASK_EVENTLOG,    // Allocated stack size on FreeRTOS heap
+                     NULL,                        // (void*)pvParams
+                     PRIORITY_XTASK_EVENTLOG,     // Task priority
+                     &_TaskHandle_EventLog );     // Task handle
+    }
+}
+
 /* Global call
  * EventLog_getLog:- to write the record into the Flash[ This function also updates the starting address]
  * parameters: addrEventLog -> Gives the source address
@@ -449,9 +1210,15 @@ bool EventLog_getLog(tEventLog_inFlash ** addrEventLog)
     {
     	*addrEventLog = recEventLogFlashData.start;
     }
-    else if((uint32_t)++*addrEventLog >= (SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_ERRLOG_SIZE))
+    else
+    {
+        *addrEventLog = nextUnit(*addrEventLog, EventLog_entrySize(*addrEventLog) / EVENTLOG_UNIT_SIZE);
+    }
+
+    // skip the empty units at the end of a sector, and those of commits broken off by a reset
+    while((*addrEventLog != recEventLogFlashData.write) && !validChecksum((uint8_t *)*addrEventLog))
     {
-        *addrEventLog = (tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS;
+        *addrEventLog = nextUnit(*addrEventLog, 1);
     }
     return (*addrEventLog != recEventLogFlashData.write);
 }
@@ -470,6 +1237,18 @@ bool cliExtHelpEventLog(uint32_t argc, uint8_t * argv[], uint32_t * argi)
 static int init_suite1(void)
 {
 	quiet = true;
+
+	// the tests commit and erase themselves, the task is held between its commits
+	if(_TaskHandle_EventLog != NULL)
+	{
+#if defined(USE_EVENTLOG_MUTEX)
+		xSemaphoreTake(xEventlogMutex, EVENT_LOG_MAX_WAIT_MS/portTICK_PERIOD_MS);
+#endif
+		vTaskSuspend(_TaskHandle_EventLog);
+#if defined(USE_EVENTLOG_MUTEX)
+		xSemaphoreGive(xEventlogMutex);
+#endif
+	}
 	return 0;
 }
 
@@ -480,6 +1259,10 @@ static int clean_suite1(void)
 {
 	quiet = false;
 	EventLog_Clear();
+	if(_TaskHandle_EventLog != NULL)
+	{
+		vTaskResume(_TaskHandle_EventLog);
+	}
 	return 0;
 }
 
@@ -494,11 +1277,13 @@ static int clean_suite1(void)
  */
 static void testLogEntry(uint32_t addr)
 {
-	// validate a log entry by checking the size, tag, string and filler
+	char message[MAXLOGSTRINGLENGTH];
+
+	// validate a log entry by checking the checksum, tag (a unit, formatted when read) and message
 	CU_ASSERT_TRUE(validChecksum((uint8_t*)addr));
-	CU_ASSERT_EQUAL(HASH_TAG, *(uint8_t*)(addr+1));
-	CU_ASSERT_EQUAL(0, strcmp((char*)(addr+sizeof(struct errLog_header)), msg10));
-	CU_ASSERT_EQUAL(EMPTY_8, *(uint8_t*)(addr+0x37));
+	CU_ASSERT_EQUAL((TAG_BINARY | 1), *(uint8_t*)(addr+1));
+	EventLog_formatMessage((tEventLog_inFlash *)addr, message, sizeof(message));
+	CU_ASSERT_EQUAL(0, strcmp(message, msg10));
 }
 
 /*
@@ -615,7 +1400,7 @@ static void testLog2()
 	// write one log entry and validate it
 	testLogWriteMultiple(1, true);
 	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS);
-	CU_ASSERT_EQUAL((SYS_FLASH_ERRLOG_ADDRESS + sizeof(tEventLog_inFlash)), (uint32_t)recEventLogFlashData.write);
+	CU_ASSERT_EQUAL((SYS_FLASH_ERRLOG_ADDRESS + EVENTLOG_UNIT_SIZE), (uint32_t)recEventLogFlashData.write);
 	CU_ASSERT_EQUAL(1, recEventLogFlashData.lastId);
 }
 
@@ -624,10 +1409,11 @@ static void testLog2()
  *
  * @desc	performs the following:
  *          1) clears event log flash
- *          2) write padding entries
- *          3) writes enough records to fill the first sector - 48 bytes
- *          4) reinitialise the flash structures
- *          5) write a single log entry at the sector crossover and validate
+ *          2) write a padded entry of 3 units
+ *          3) writes enough records to fill the first sector but a unit
+ *          4) write another padded entry, which goes to the second sector, not split
+ *          5) clear the second sector and reinitialise the flash structures
+ *          6) write a single log entry at the sector crossover and validate
  *
  * @param	none
  *
@@ -638,20 +1424,18 @@ static void testLog3()
 	// erase the event log flash
 	testLog1();
 
-	// write some padding event logs
+	// write a padded event log
 	testLogPadded(53);
+	CU_ASSERT_EQUAL(3 * EVENTLOG_UNIT_SIZE, EventLog_entrySize((tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS));
 
-	// check that the EMPTY padding is in
-	CU_ASSERT_EQUAL(0xffff, *(uint16_t*)(SYS_FLASH_ERRLOG_ADDRESS+0x46));
+	// fill the first sector but a unit
+	testLogWriteMultiple(UNITS_PER_SECTOR - 4, true);
 
-	// write multiple records to the first sector including 8 bytes of the last entry in the second
-	testLogWriteMultiple(32, true);
-
-	// check last entry bridges the sectors
-	testLogEntry(SYS_FLASH_ERRLOG_ADDR(1));
-
-	// check that the EMPTY padding is in
-	CU_ASSERT_EQUAL(0xff, *(uint8_t*)(SYS_FLASH_ERRLOG_ADDR(1) + 0x37));
+	// the next padded entry does not fit, the unit is left empty
+	testLogPadded(53);
+	CU_ASSERT_TRUE(blank_check((uint8_t*)(SYS_FLASH_ERRLOG_ADDR(1) - EVENTLOG_UNIT_SIZE), EVENTLOG_UNIT_SIZE));
+	CU_ASSERT_EQUAL(3 * EVENTLOG_UNIT_SIZE, EventLog_entrySize((tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDR(1)));
+	testLogEntryCount(true, UNITS_PER_SECTOR - 2);
 
 	// clear the start of the second sector
 	CU_ASSERT_TRUE(irqDisabledDrvFlashEraseSector(1));
@@ -662,7 +1446,7 @@ static void testLog3()
 	// now write another entry
 	testLogWriteMultiple(1, true);
 
-	// check log entry is at sector 1 + 8
+	// check log entry is at the start of sector 1
 	testLogEntry(SYS_FLASH_ERRLOG_ADDR(1));
 }
 
@@ -686,13 +1470,13 @@ static void testLog4()
 	testLog1();
 
 	// write sufficient log entries to cause a roll over
-	testLogWriteMultiple((SYS_FLASH_ERRLOG_SIZE/sizeof(tEventLog_inFlash))+1, true);
+	testLogWriteMultiple(EVENTLOG_UNITS+1, true);
 
 	// check that the first entry is valid
 	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS);
 
 	// check that the rest of the flash is erased
-	CU_ASSERT_TRUE(blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDRESS+0x38, SYS_FLASH_SECTOR_SIZE-0x38));
+	CU_ASSERT_TRUE(blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDRESS+EVENTLOG_UNIT_SIZE, SYS_FLASH_SECTOR_SIZE-EVENTLOG_UNIT_SIZE));
 
 	// reinitialise the event log
 	EventLog_InitFlashData();
@@ -701,7 +1485,7 @@ static void testLog4()
 	testLogWriteMultiple(1, true);
 
 	// check we add a new entry correctly
-	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS+sizeof(tEventLog_inFlash));
+	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS+EVENTLOG_UNIT_SIZE);
 }
 
 /*
@@ -760,7 +1544,7 @@ static void testLog6()
 	testLog1();
 
 	// fill the first sector plus one entry in the second
-	testLogWriteMultiple((SYS_FLASH_SECTOR_SIZE/sizeof(tEventLog_inFlash))+1, true);
+	testLogWriteMultiple(UNITS_PER_SECTOR+1, true);
 
 	// write 112 character log
 	uint32_t args = 1;
@@ -789,9 +1573,9 @@ static void testLog6()
  *
  * @desc	performs the following:
  *          1) clears event log flash
- *          2) write (146*3)+1 log entries to wrap round twice
- *          3) validate single log entry at start of log
- *          4) initialise & check for 73 entries in the log
+ *          2) write a one unit entry more than the log holds, the last wraps round to sector 0, erasing it
+ *          3) validate that entry at the start of the log
+ *          4) check for the entries of the other sectors and that one in the log
  *
  * @param	none
  *
@@ -802,18 +1586,18 @@ static void testLog7()
 	// erase the event log flash
 	testLog1();
 
-	// write multiple records to the first sector including 8 bytes of the last entry in the second
-	int noRecs = ((SYS_FLASH_SECTOR_SIZE/sizeof(tEventLog_inFlash)) * ERRLOG_SECTORS) + 1;
+	// fill the log with one unit records, and one more that wraps round to the start
+	int noRecs = EVENTLOG_UNITS + 1;
 	testLogWriteMultiple(noRecs, true);
 
-	// check log entry is at sector 1 + 8
+	// check the last log entry is at the start of sector 0
 	testLogEntry(SYS_FLASH_ERRLOG_ADDR(0));
 
 	// check for the correct eventCode
-	CU_ASSERT_EQUAL((900 + noRecs - 1), *(uint16_t*)(SYS_FLASH_ERRLOG_ADDRESS+0x4));
+	CU_ASSERT_EQUAL((900 + noRecs - 1), ((tEventLog_inFlash *)SYS_FLASH_ERRLOG_ADDRESS)->logHeader.eventCode);
 
-	// check we have only 74 entries now
-	testLogEntryCount(true, ((SYS_FLASH_SECTOR_SIZE/sizeof(tEventLog_inFlash)) * (ERRLOG_SECTORS - 1)) + 1);
+	// check we have the entries of the other sectors, and that one
+	testLogEntryCount(true, (UNITS_PER_SECTOR * (ERRLOG_SECTORS - 1)) + 1);
 }
 
 /*
@@ -836,7 +1620,7 @@ static void testLog8()
 	testLog1();
 
 	// write multiple records to wrap around the available space
-	testLogWriteMultiple(SYS_FLASH_ERRLOG_SIZE/sizeof(tEventLog_inFlash), true);
+	testLogWriteMultiple(EVENTLOG_UNITS, true);
 
 	// check the pointers
 	CU_ASSERT_EQUAL(SYS_FLASH_ERRLOG_ADDRESS, (uint32_t)recEventLogFlashData.write);
@@ -850,6 +1634,118 @@ static void testLog8()
 	CU_ASSERT_EQUAL((SYS_FLASH_ERRLOG_ADDRESS + SYS_FLASH_SECTOR_SIZE), (uint32_t)recEventLogFlashData.start);
 }
 
+/*
+ * testLog10
+ *
+ * @desc	performs the following:
+ *          1) clears event log flash
+ *          2) writes 2 entries and checks they are held in RAM, not in flash
+ *          3) commits them and validates them in flash
+ *          4) programs only the last phrase of the next unit, as a commit broken off by a reset
+ *          5) initialise, write an entry and check it goes after the broken off unit, which is skipped
+ *
+ * @param	none
+ *
+ * @returns	none
+ */
+static void testLog10()
+{
+	// erase the event log flash
+	testLog1();
+
+	LOG_EVENT(900, LOG_NUM_APP, ERRLOGDEBUG, msg10);
+	LOG_EVENT(901, LOG_NUM_APP, ERRLOGDEBUG, msg10);
+	// a unit each, in RAM as in flash
+	CU_ASSERT_EQUAL(2, EVENTLOG_RAM->head - EVENTLOG_RAM->tail);
+	CU_ASSERT_EQUAL(2 * EVENTLOG_UNIT_SIZE, EventLog_pendingSize());
+	CU_ASSERT_TRUE(blank_check((uint8_t*)SYS_FLASH_ERRLOG_ADDRESS, SYS_FLASH_ERRLOG_SIZE));
+
+	CU_ASSERT_TRUE(EventLog_Flush());
+	CU_ASSERT_EQUAL(0, EVENTLOG_RAM->head - EVENTLOG_RAM->tail);
+	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS);
+	testLogEntry(SYS_FLASH_ERRLOG_ADDRESS + EVENTLOG_UNIT_SIZE);
+
+	// the commit of the third entry broken off after its last phrase
+	uint32_t torn = SYS_FLASH_ERRLOG_ADDRESS + (2 * EVENTLOG_UNIT_SIZE);
+	__disable_irq();
+	CU_ASSERT_TRUE(DrvFlashProgram((uint32_t *)(torn + EVENTLOG_UNIT_SIZE - PGM_SIZE_BYTE),
+								   (uint32_t *)(SYS_FLASH_ERRLOG_ADDRESS + EVENTLOG_UNIT_SIZE - PGM_SIZE_BYTE), PGM_SIZE_BYTE));
+	__enable_irq();
+	testLogEntryCount(true, 2);
+
+	testLogWriteMultiple(1, true);
+	testLogEntry(torn + EVENTLOG_UNIT_SIZE);
+	testLogEntryCount(true, 3);
+}
+
+/*
+ * testLog11
+ *
+ * @desc	performs the following:
+ *          1) clears event log flash and writes a record of the earlier format
+ *          2) initialise, and write a record kept as format and arguments, check it formats as printf would
+ *          3) write a record with a string argument too long to keep, check it is formatted now as text
+ *          4) read back the 3 records
+ *          5) check a record whose format has changed gives the format address, hash and arguments
+ *
+ * @param	none
+ *
+ * @returns	none
+ */
+static void testLog11()
+{
+	static const char fmt[] = "%s: %d %u 0x%08x %lld %c %5.1f%%";
+	tEventLog_inFlash entry, *addrEventLog = NULL;
+	char message[MAXLOGSTRINGLENGTH], expected[MAXLOGSTRINGLENGTH];
+	char longArg[MAXLOGSTRINGLENGTH - 1];
+
+	// erase the event log flash
+	testLog1();
+
+	// a record of the earlier format, still read after the upgrade
+	memset(&entry, EMPTY_8, sizeof(entry));
+	entry.logHeader.tag = HASH_TAG;
+	entry.logHeader.id = 7;
+	entry.logHeader.eventCode = 1111;
+	strcpy(entry.logMsg, msg10);
+	setChecksum(&entry);
+	CU_ASSERT_TRUE(writeToFlash((uint32_t *)SYS_FLASH_ERRLOG_ADDRESS, (uint32_t *)&entry, sizeof(entry)));
+	EventLog_InitFlashData();
+	CU_ASSERT_EQUAL(7, recEventLogFlashData.lastId);
+	CU_ASSERT_EQUAL(SYS_FLASH_ERRLOG_ADDRESS + MAXERRLOGFRAMELENGTH, (uint32_t)recEventLogFlashData.write);
+
+	LOG_EVENT(1, LOG_NUM_APP, ERRLOGDEBUG, fmt, "arg", -5, 7u, 0xBEEF, -123456789012LL, 'x', 2.25);
+	memset(longArg, 'L', sizeof(longArg) - 1);
+	longArg[sizeof(longArg) - 1] = '\0';
+	LOG_EVENT(2, LOG_NUM_APP, ERRLOGDEBUG, "%s", longArg);
+	CU_ASSERT_TRUE(EventLog_Flush());
+
+	CU_ASSERT_TRUE(EventLog_getLog(&addrEventLog));
+	CU_ASSERT_EQUAL(8, addrEventLog->logHeader.id);
+	CU_ASSERT_EQUAL(TAG_BINARY, TAG_KIND(addrEventLog->logHeader.tag));
+	snprintf(expected, sizeof(expected), fmt, "arg", -5, 7u, 0xBEEF, -123456789012LL, 'x', 2.25);
+	EventLog_formatMessage(addrEventLog, message, sizeof(message));
+	CU_ASSERT_EQUAL(0, strcmp(message, expected));
+	entry = *addrEventLog;
+
+	CU_ASSERT_TRUE(EventLog_getLog(&addrEventLog));
+	CU_ASSERT_EQUAL(TAG_TEXT, TAG_KIND(addrEventLog->logHeader.tag));
+	EventLog_formatMessage(addrEventLog, message, sizeof(message));
+	CU_ASSERT_EQUAL(0, strcmp(message, longArg));
+
+	testLogEntryCount(true, 3);
+	addrEventLog = NULL;
+	CU_ASSERT_TRUE(EventLog_getLog(&addrEventLog));
+	EventLog_formatMessage(addrEventLog, message, sizeof(message));
+	CU_ASSERT_EQUAL(0, strcmp(message, msg10));
+
+	// as after a firmware update, the format is not the one logged
+	((tEventLog_binary *)entry.logMsg)->fmtId++;
+	EventLog_formatMessage(&entry, message, sizeof(message));
+	CU_ASSERT_EQUAL(0, strncmp(message, "fmt ", 4));
+	CU_ASSERT_PTR_NOT_NULL(strstr(message, " 61 72 67 00"));
+}
+
 #if 0
 /*
  * testLog9
@@ -956,6 +1852,8 @@ CUnit_suite_t UTeventlog = {
 				{"test 7", testLog7},
 				{"test 8", testLog8},
 				//{"test 9", testLog9},
+				{"test 10", testLog10},
+				{"test 11", testLog11},
 				{ NULL, NULL }
 		}
 };
@@ -963,6 +1861,7 @@ CUnit_suite_t UTeventlog = {
 bool cliEventLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
 {
     bool rc_ok = true;
+    bool commit = false;	// commit what the command logged, to be read back at once
     if (args > 0)
     {
         switch(argi[0])
@@ -994,21 +1893,25 @@ bool cliEventLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
 
         case 4:
         	LOG_EVENT(1111, 222, ERRLOGWARN, msg4, 6); //36--  padding 40
+        	commit = true;
         	break;
 
         case 5:
         	LOG_EVENT(6666, 777, ERRLOGFATAL, "Watch dog reset @0x%08X. External power supply voltage drop", 0x12345678); //51--padding 56
+        	commit = true;
         	break;
 
          case 7:
             //char test[]="GPS Modem activation failure. State received and processed is not the same. Please check the modem connection1234";
             LOG_EVENT(7654, 456, ERRLOGMINOR, "GPS Modem activation failure. State received and processed is not the same. Please check the modem connection1234");//113
+            commit = true;
             break;
 
         case 8:
             if (args==5)
             {
-            	LOG_EVENT(argi[1], argi[2], argi[3], (char*)argv[4]);
+            	LOG_EVENT(argi[1], argi[2], argi[3], "%s", (char*)argv[4]);
+            	commit = true;
             }
             break;
 
@@ -1032,8 +1935,14 @@ bool cliEventLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
         	{
         		for(int i = 0; i < argi[1]; i++)
         		{
+        			// more than the ring holds, commit as it fills
+        			if(!ramHasRoom())
+        			{
+        				EventLog_Flush();
+        			}
        				LOG_EVENT( (((args > 2) && argi[2]) ? 900 + i : 1), LOG_NUM_APP, ERRLOGDEBUG, msg10);
         		}
+        		commit = true;
         	}
         	break;
 
@@ -1063,10 +1972,20 @@ bool cliEventLog( uint32_t args, uint8_t * argv[], uint32_t * argi)
 					printf("blank check failed\n");
 			}
         	break;
+        case 14: // commit the entries in RAM
+        	printf("%d units in RAM, %d entries dropped\n", EVENTLOG_RAM->head - EVENTLOG_RAM->tail, EVENTLOG_RAM->dropped);
+        	rc_ok = EventLog_Flush();
+        	break;
+
         default:
        	    printf((char*)EventLogHelp);
         	break;
         }
+
+        if(commit)
+        {
+        	EventLog_Flush();
+        }
     }
     return rc_ok;
 }
@@ -31,6 +31,7 @@ typedef enum {
 } tEventLogSevlvl;
 
 #define MAXERRLOGFRAMELENGTH 128 //128 bytes in total
+#define EVENTLOG_UNIT_SIZE 32 // records take 1 to 4 units of the flash
 
 #define PMIC_EVENTLOG_BAND 3000
 
@@ -52,9 +53,17 @@ struct errLog_header {
 
 typedef struct {
     struct errLog_header logHeader;
-    char            logMsg[ MAXLOGSTRINGLENGTH];
+    char            logMsg[ MAXLOGSTRINGLENGTH];	// the text, or a tEventLog_binary
 }tEventLog_inFlash;
 
+// a record formatted when it is read, in place of logMsg
+typedef struct {
+    const char *    fmt;		// the format, in the application image
+    uint32_t        fmtId;		// hash of the format, it is not formatted when that has changed
+    uint8_t         argLength;
+    uint8_t         args[ MAXLOGSTRINGLENGTH - sizeof(const char *) - sizeof(uint32_t) - sizeof(uint8_t)];	// packed, strings copied in
+}tEventLog_binary;
+
 typedef struct {
     struct errLog_fixedpart {
         uint8_t             frameLength;
@@ -72,9 +81,14 @@ typedef struct {
 
 
 bool EventLog_In(uint16_t eventcode, uint16_t compNum, uint8_t sevlevel, const char *fmt,  ...);
+void EventLog_Init(void);
 void EventLog_InitFlashData(void);
+bool EventLog_Flush(void);
+uint32_t EventLog_pendingSize(void);
 bool EventLog_getLog(tEventLog_inFlash ** addrEventLog);
 void EventLog_printLogEntry(tEventLog_inFlash * addrEventLog);
+uint32_t EventLog_entrySize(const tEventLog_inFlash * addrEventLog);
+uint32_t EventLog_formatMessage(const tEventLog_inFlash * addrEventLog, char * buf, uint32_t size);
 void EventLog_Clear(void);
 bool cliExtHelpEventLog(uint32_t argc, uint8_t * argv[], uint32_t * argi);
 bool cliEventLog( uint32_t args, uint8_t * argv[], uint32_t * argi);
@@ -71,6 +71,17 @@ static bool checkreturn buf_write(pb_ostream_t *stream, const uint8_t *buf, size
     return true;
 }
 
+#ifndef PB_BUFFER_ONLY
+/* Same as buf_write, its address marks a single pass buffer stream. */
+static bool checkreturn buf_write_single_pass(pb_ostream_t *stream, const uint8_t *buf, size_t count)
+{
+    uint8_t *dest = (uint8_t*)stream->state;
+    memcpy(dest, buf, count);
+    stream->state = dest + count;
+    return true;
+}
+#endif
+
 pb_ostream_t pb_ostream_from_buffer(uint8_t *buf, size_t bufsize)
 {
     pb_ostream_t stream;
@@ -88,6 +99,17 @@ pb_ostream_t pb_ostream_from_buffer(uint8_t *buf, size_t bufsize)
     return stream;
 }
 
+pb_ostream_t pb_ostream_from_buffer_single_pass(uint8_t *buf, size_t bufsize)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, bufsize);
+#ifdef PB_BUFFER_ONLY
+    stream.callback = (void*)2; /* Just a marker value */
+#else
+    stream.callback = &buf_write_single_pass;
+#endif
+    return stream;
+}
+
 bool checkreturn pb_write(pb_ostream_t *stream, const uint8_t *buf, size_t count)
 {
     if (stream->callback != NULL)
@@ -525,13 +547,96 @@ bool checkreturn pb_encode_string(pb_ostream_t *stream, const uint8_t *buffer, s
     return pb_write(stream, buffer, size);
 }
 
+/* Number of bytes of the varint encoding of value. */
+static size_t varint_size(uint64_t value)
+{
+    size_t size = 1;
+    
+    while (value > 0x7F)
+    {
+        value >>= 7;
+        size++;
+    }
+    
+    return size;
+}
+
+/* Encode a submessage straight into a single pass buffer stream.
+ * Room for the length is reserved first, as many bytes as the longest
+ * submessage that still fits the stream together with its length needs.
+ * That is one byte fewer than the room left would take when the longest
+ * submessage is just below a varint boundary. Once the submessage is
+ * written the length is filled in, and when it takes fewer bytes than
+ * reserved the submessage is moved down over the spare ones. */
+static bool checkreturn encode_submessage_single_pass(pb_ostream_t *stream, const pb_field_t fields[], const void *src_struct)
+{
+    pb_ostream_t substream;
+    uint8_t *start = (uint8_t*)stream->state;
+    size_t left;
+    size_t reserved;
+    size_t size;
+    size_t value;
+    size_t i;
+    bool status;
+    
+    if (stream->bytes_written >= stream->max_size)
+        PB_RETURN_ERROR(stream, "stream full");
+    
+    left = stream->max_size - stream->bytes_written;
+    reserved = varint_size(left - varint_size(left - 1));
+    
+    substream.callback = stream->callback;
+    substream.state = start + reserved;
+    substream.max_size = left - reserved;
+    substream.bytes_written = 0;
+#ifndef PB_NO_ERRMSG
+    substream.errmsg = NULL;
+#endif
+    
+    status = pb_encode(&substream, fields, src_struct);
+    
+#ifndef PB_NO_ERRMSG
+    stream->errmsg = substream.errmsg;
+#endif
+    if (!status)
+        return false;
+    
+    /* Back-patch the length, then close the gap to the submessage. */
+    size = substream.bytes_written;
+    if (varint_size(size) > reserved)
+        PB_RETURN_ERROR(stream, "stream full");
+    
+    value = size;
+    i = 0;
+    while (value > 0x7F)
+    {
+        start[i++] = (uint8_t)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    start[i++] = (uint8_t)value;
+    
+    if (i < reserved)
+        memmove(start + i, start + reserved, size);
+    
+    stream->state = start + i + size;
+    stream->bytes_written += i + size;
+    return true;
+}
+
 bool checkreturn pb_encode_submessage(pb_ostream_t *stream, const pb_field_t fields[], const void *src_struct)
 {
-    /* First calculate the message size using a non-writing substream. */
     pb_ostream_t substream = PB_OSTREAM_SIZING;
     size_t size;
     bool status;
     
+#ifdef PB_BUFFER_ONLY
+    if (stream->callback == (void*)2)
+#else
+    if (stream->callback == &buf_write_single_pass)
+#endif
+        return encode_submessage_single_pass(stream, fields, src_struct);
+    
+    /* First calculate the message size using a non-writing substream. */
     if (!pb_encode(&substream, fields, src_struct))
     {
 #ifndef PB_NO_ERRMSG
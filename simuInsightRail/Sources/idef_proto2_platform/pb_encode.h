@@ -88,6 +88,15 @@ bool pb_get_encoded_size(size_t *size, const pb_field_t fields[], const void *sr
  */
 pb_ostream_t pb_ostream_from_buffer(uint8_t *buf, size_t bufsize);
 
+/* Same as pb_ostream_from_buffer, but submessages are encoded in one pass
+ * instead of two. Room for the submessage length is reserved in the buffer,
+ * the submessage is encoded after it and the length is filled in afterwards,
+ * moving the submessage down when the length takes fewer bytes than reserved.
+ * The encoded data is the same, but callbacks of submessage fields are called
+ * once instead of twice, which pays off when they fetch or convert data.
+ */
+pb_ostream_t pb_ostream_from_buffer_single_pass(uint8_t *buf, size_t bufsize);
+
 /* Pseudo-stream for measuring the size of a message without actually storing
  * the encoded data.
  * 
@@ -143,7 +152,8 @@ bool pb_encode_fixed64(pb_ostream_t *stream, const void *value);
 /* Encode a submessage field.
  * You need to pass the pb_field_t array and pointer to struct, just like
  * with pb_encode(). This internally encodes the submessage twice, first to
- * calculate message size and then to actually write it out.
+ * calculate message size and then to actually write it out, except on a
+ * stream from pb_ostream_from_buffer_single_pass().
  */
 bool pb_encode_submessage(pb_ostream_t *stream, const pb_field_t fields[], const void *src_struct);
 
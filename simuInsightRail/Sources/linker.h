@@ -40,6 +40,8 @@ extern uint32_t __loader_origin[],
  				__device_calib_size,
  				__event_log[],
 				__eventlog_size,
+				__eventlog_ram[],
+				__eventlog_ram_size,
  				__bootcfg[],
  				__bootcfg_size,
 				__ota_mgmnt_data[],
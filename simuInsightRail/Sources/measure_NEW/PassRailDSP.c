@@ -28,7 +28,10 @@ extern "C" {
  *
  *     - Wheel-flat output sample rate requirements: 256sps, 512sps, 1280sps
  *
- *     - This DSP implementation uses the CMSIS-DSP library functions
+ *     - This DSP implementation uses the CMSIS-DSP library functions, apart
+ *       from the decimation filters which use the symmetry-folding engine in
+ *       PassRailDecimFilt.c (bit-exact with arm_fir_decimate_q31(), but with
+ *       half the multiplies)
  *
  *     - The ADC block size into the DSP chain is currently 128 samples - see
  *       ADC_SAMPLES_PER_BLOCK in the AD7766 driver firmware module
@@ -43,6 +46,33 @@ extern "C" {
  *
  *                                <----- Enveloper ----->   <------ Decimation ------->
  *
+ * Multiple outputs from a single ADC capture:
+ *     - After DC removal, the ADC stream can be fanned out to up to
+ *       PASSRAILDSP_MAX_OUTPUTS independent enveloper + decimation chains
+ *       (see PassRailDsp_InitMulti() / PassRailDsp_ProcessBlockMulti()).
+ *       Each chain has its own smoother state and decimator states, and
+ *       writes into its own output buffer
+ *
+ *     - All chains of one capture share the ADC sampling rate and analog
+ *       filter setting, so only chains with the same front-end configuration
+ *       can be combined - see PassRailMeasure_MeasIdsShareCapture()
+ *
+ * Fused front-end (per 128-sample ADC block, at up to 51200sps):
+ *     - PassRailDsp_ProcessAdcBlockMulti() takes the raw AD7766 SPI words,
+ *       and converts them to signed samples, checks the SPI echo bytes and
+ *       removes the DC offset, all in one unrolled pass (see
+ *       AD7766_PreProcessRawSpiBlock()). The result is written back in-place
+ *       and shared by all the output chains
+ *
+ *     - Each chain's rectifier and smoothing filter are then a single fused
+ *       pass (DspEnveloper()), which writes straight into the stage 1
+ *       decimator's state buffer (see DecimFilt_GetInputBuffer()), or into
+ *       the chain's output buffer if there is no decimation
+ *
+ *     - So each sample is read and written twice before decimation, rather
+ *       than once each by separate conversion, DC removal, rectification,
+ *       smoothing and copying passes
+ *
  *
  * AD7766-1 sampling rates selection:
  *     - AD7766-1 16x oversampling ADC requires an MCLK of 16x the required
@@ -90,8 +120,11 @@ extern "C" {
 #include "Resources.h"
 #include "arm_math.h"
 #include "PassRailDSP.h"
+#include "PassRailDecimFilt.h"
 #include "AdcApiDefs.h"
+#include "AD7766_DMA.h"
 #include "PinConfig.h"
+#include "Trace.h"
 
 
 //******************************************************************************
@@ -104,9 +137,6 @@ extern "C" {
 
 //..............................................................................
 
-static EnveloperEnum g_DspEnveloperID = ENV_NONE;
-
-//..............................................................................
 // Enveloping filter
 // Enveloping filter coefficients (from Colin's e-mail of 2/8/2016, and
 // Bart's "Envelope smoother filter calculator" spreadsheet implementing the
@@ -121,10 +151,6 @@ int32_t VibEnvFiltCoeffs[2] = {504164117, -1139155413};
 // Wheel-flats: for 10240sps, 200Hz cutoff
 int32_t WflatEnvFiltCoeffs[2] = {124150186, -1899183275};
 
-static int64_t g_EnvFilterState = 0; // 64-bit to maintain precision
-
-static int32_t g_EnvOutBuf[ADC_SAMPLES_PER_BLOCK];
-
 //..............................................................................
 // Decimation filter chains
 //
@@ -137,22 +163,22 @@ static int32_t g_EnvOutBuf[ADC_SAMPLES_PER_BLOCK];
 // From
 // enveloper
 //  |
-//  | 51200 |----------|  51200  |=============|  5120   |=============|  1280
-//  ------->| Block    |-------->| Decim VibA1 |-------->| Decim VibA2 |------->
-//     128  | resizer  | 160 |   |    /10      |   16    |     /4      |   4
-//          |----------|     |   |=============|         |=============|
-//                           |
-//                           |
-//                           |   |=============|  5120   |=============|  2560
-//                           |-->| Decim VibB1 |-------->| Decim VibB2 |------->
-//                           |   |    /10      |   16    |      /2     |   8
-//                           |   |=============|         |=============|
-//                           |
-//                           |
-//                           |   |=============|  10240  |=============|  5120
-//                           --->| Decim VibC1 |-------->| Decim VibC2 |------->
-//                               |     /5      |   32    |      /2     |   16
-//                               |=============|         |=============|
+//  | 51200            |=============|  5120   |=============|  1280
+//  ------------------>| Decim VibA1 |-------->| Decim VibA2 |------->
+//     128       |     |    /10      |  12-13  |     /4      |  3-4
+//               |     |=============|         |=============|
+//               |
+//               |
+//               |     |=============|  5120   |=============|  2560
+//               |---->| Decim VibB1 |-------->| Decim VibB2 |------->
+//               |     |    /10      |  12-13  |      /2     |  6-7
+//               |     |=============|         |=============|
+//               |
+//               |
+//               |     |=============|  10240  |=============|  5120
+//               ----->| Decim VibC1 |-------->| Decim VibC2 |------->
+//                     |     /5      |  25-26  |      /2     |  12-13
+//                     |=============|         |=============|
 //
 //
 // IMPORTANT: Block sizes:
@@ -160,20 +186,16 @@ static int32_t g_EnvOutBuf[ADC_SAMPLES_PER_BLOCK];
 //       are a power of 2 - currently, the sample block size from the ADC is
 //       128 - see ADC_SAMPLES_PER_BLOCK in the AD7766 driver firmware module
 //
-//     - The CMSIS-DSP decimation functions (e.g. arm_fir_decimate_init_q31() /
-//       arm_fir_decimate_q31() etc) require that the decimator input block
-//       sizes are a multiple of the decimation factor
-//
-//     - The first-stage decimators require factors of /10 and /5. However,
-//       because ADC_SAMPLES_PER_BLOCK cannot be evenly divided by 10 or 5,
-//       then the CMSIS-DSP decimation functions (which require their input
-//       block sizes to be a multiple of their decimation ratios) cannot
-//       directly accept the ADC block size
+//     - The first-stage decimators require factors of /10 and /5, which
+//       ADC_SAMPLES_PER_BLOCK cannot be evenly divided by. The decimators
+//       (see PassRailDecimFilt.c) therefore stream: each keeps a phase
+//       counter, so accepts input blocks of any length and produces an
+//       output for every Factor'th input sample of the overall stream. The
+//       ADC blocks are decimated directly, and every block produces output
+//       (the numbers of samples per block shown above vary by one)
 //
-//     - Therefore, the block resizer buffer is used at the beginning of the
-//       chain. This generates block sizes of 160 (DECIMFILT1_BLOCKSIZE),
-//       which means that all the following decimation filter block sizes are
-//       multiples of their decimation factors
+//     - The stage 2 input block size is the largest stage 1 output count,
+//       i.e. ADC_SAMPLES_PER_BLOCK / (smallest stage 1 factor), rounded up
 //
 
 // Decimation filter VibA1
@@ -367,22 +389,22 @@ static const q31_t VibDecimFiltC2_Coeffs[] =
 // From
 // enveloper
 //  |
-//  | 10240 |----------|  10240  |===============|  1024   |===============|  256
-//  ------->| Block    |-------->| Decim WflatA1 |-------->| Decim WflatA2 |------->
-//     128  | resizer  | 160 |   |     /10       |   16    |       /4      |   4
-//          |----------|     |   |===============|         |===============|
-//                           |
-//                           |
-//                           |   |===============|  1024   |===============|  512
-//                           |-->| Decim WflatB1 |-------->| Decim WflatB2 |------->
-//                           |   |      /10      |   16    |       /2      |   8
-//                           |   |===============|         |===============|
-//                           |
-//                           |
-//                           |   |===============|  2560   |===============|  1280
-//                           --->| Decim WflatC1 |-------->| Decim WflatC2 |------->
-//                               |       /4      |   40    |       /2      |   20
-//                               |===============|         |===============|
+//  | 10240            |===============|  1024   |===============|  256
+//  ------------------>| Decim WflatA1 |-------->| Decim WflatA2 |------->
+//     128       |     |     /10       |  12-13  |       /4      |  3-4
+//               |     |===============|         |===============|
+//               |
+//               |
+//               |     |===============|  1024   |===============|  512
+//               |---->| Decim WflatB1 |-------->| Decim WflatB2 |------->
+//               |     |      /10      |  12-13  |       /2      |  6-7
+//               |     |===============|         |===============|
+//               |
+//               |
+//               |     |===============|  2560   |===============|  1280
+//               ----->| Decim WflatC1 |-------->| Decim WflatC2 |------->
+//                     |       /4      |   32    |       /2      |   16
+//                     |===============|         |===============|
 //
 //
 // Decimation filter WflatA1
@@ -588,7 +610,7 @@ typedef struct
     uint8_t NumTaps;
     uint8_t Factor;
     const q31_t *pCoeffs;
-    uint32_t BlockSize;
+    uint32_t BlockSize; // Largest input block size
 } DecimFiltConfigType;
 
 static struct
@@ -608,8 +630,6 @@ static struct
     {DECIMCHAIN_WFLATS_1280, DECIMFILT_WFLATS_C1, DECIMFILT_WFLATS_C2}
 };
 
-static DecimChainEnum g_DecimChainID = DECIMCHAIN_NONE;
-
 //**********************************************************
 // IMPORTANT: The following macros ** MUST ** be set to the
 // largest corresponding field values in the
@@ -617,19 +637,18 @@ static DecimChainEnum g_DecimChainID = DECIMCHAIN_NONE;
 // N.B. Run-time checking of this is implemented in PassRailDsp_Init().
 // TODO: Can this be done at build time somehow?
 //**********************************************************
-#define DECIMFILT1_BLOCKSIZE          (160)
+#define DECIMFILT1_BLOCKSIZE          (ADC_SAMPLES_PER_BLOCK)
 #define DECIMFILT1_LARGEST_NUM_TAPS   (150)
-#if (DECIMFILT1_BLOCKSIZE < ADC_SAMPLES_PER_BLOCK)
-#error "BUILD ERROR: DECIMFILT1_BLOCKSIZE is less than ADC_SAMPLES_PER_BLOCK"
-#endif
 
-#define DECIMFILT2_LARGEST_BLOCKSIZE  (40)
-#define DECIMFILT2_LARGEST_NUM_TAPS   (150)
+// Stage 1 output counts per ADC block, rounded up, for the stage 1
+// decimation factors of /10, /5 and /4
+#define DECIM1_OUT_SAMPLES(Factor)    ((DECIMFILT1_BLOCKSIZE + (Factor) - 1) / (Factor))
 
-// Decimation filter instances - only 2 needed because will only be 1 filter
-// chain used at a time
-static arm_fir_decimate_instance_q31 DecimFilt1;
-static arm_fir_decimate_instance_q31 DecimFilt2;
+#define DECIMFILT2_LARGEST_BLOCKSIZE  (DECIM1_OUT_SAMPLES(4))
+#define DECIMFILT2_LARGEST_NUM_TAPS   (150)
+#if (DECIMFILT1_LARGEST_NUM_TAPS > DECIMFILT_MAX_TAPS) || (DECIMFILT2_LARGEST_NUM_TAPS > DECIMFILT_MAX_TAPS)
+#error "BUILD ERROR: Decimation filter taps exceed DECIMFILT_MAX_TAPS"
+#endif
 
 // Decimation filter configurations
 static DecimFiltConfigType DecimFiltConfigs[] =
@@ -643,49 +662,54 @@ static DecimFiltConfigType DecimFiltConfigs[] =
     // Stage  ID                   NumTaps                                      Factor  pCoeffs                  BlockSize
     // Vibration
     {  1,     DECIMFILT_VIB_A1,    ARRAY_NUM_ELEMENTS(VibDecimFiltA1_Coeffs),   10,     VibDecimFiltA1_Coeffs,   DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_VIB_A2,    ARRAY_NUM_ELEMENTS(VibDecimFiltA2_Coeffs),   4,      VibDecimFiltA2_Coeffs,   16},
+    {  2,     DECIMFILT_VIB_A2,    ARRAY_NUM_ELEMENTS(VibDecimFiltA2_Coeffs),   4,      VibDecimFiltA2_Coeffs,   DECIM1_OUT_SAMPLES(10)},
 
     {  1,     DECIMFILT_VIB_B1,    ARRAY_NUM_ELEMENTS(VibDecimFiltB1_Coeffs),   10,     VibDecimFiltB1_Coeffs,   DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_VIB_B2,    ARRAY_NUM_ELEMENTS(VibDecimFiltB2_Coeffs),   2,      VibDecimFiltB2_Coeffs,   16},
+    {  2,     DECIMFILT_VIB_B2,    ARRAY_NUM_ELEMENTS(VibDecimFiltB2_Coeffs),   2,      VibDecimFiltB2_Coeffs,   DECIM1_OUT_SAMPLES(10)},
 
     {  1,     DECIMFILT_VIB_C1,    ARRAY_NUM_ELEMENTS(VibDecimFiltC1_Coeffs),   5,      VibDecimFiltC1_Coeffs,   DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_VIB_C2,    ARRAY_NUM_ELEMENTS(VibDecimFiltC2_Coeffs),   2,      VibDecimFiltC2_Coeffs,   32},
+    {  2,     DECIMFILT_VIB_C2,    ARRAY_NUM_ELEMENTS(VibDecimFiltC2_Coeffs),   2,      VibDecimFiltC2_Coeffs,   DECIM1_OUT_SAMPLES(5)},
 
     // Wheel-flats
     {  1,     DECIMFILT_WFLATS_A1, ARRAY_NUM_ELEMENTS(WflatDecimFiltA1_Coeffs), 10,     WflatDecimFiltA1_Coeffs, DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_WFLATS_A2, ARRAY_NUM_ELEMENTS(WflatDecimFiltA2_Coeffs), 4,      WflatDecimFiltA2_Coeffs, 16},
+    {  2,     DECIMFILT_WFLATS_A2, ARRAY_NUM_ELEMENTS(WflatDecimFiltA2_Coeffs), 4,      WflatDecimFiltA2_Coeffs, DECIM1_OUT_SAMPLES(10)},
 
     {  1,     DECIMFILT_WFLATS_B1, ARRAY_NUM_ELEMENTS(WflatDecimFiltB1_Coeffs), 10,     WflatDecimFiltB1_Coeffs, DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_WFLATS_B2, ARRAY_NUM_ELEMENTS(WflatDecimFiltB2_Coeffs), 2,      WflatDecimFiltB2_Coeffs, 16},
+    {  2,     DECIMFILT_WFLATS_B2, ARRAY_NUM_ELEMENTS(WflatDecimFiltB2_Coeffs), 2,      WflatDecimFiltB2_Coeffs, DECIM1_OUT_SAMPLES(10)},
 
     {  1,     DECIMFILT_WFLATS_C1, ARRAY_NUM_ELEMENTS(WflatDecimFiltC1_Coeffs), 4,      WflatDecimFiltC1_Coeffs, DECIMFILT1_BLOCKSIZE},
-    {  2,     DECIMFILT_WFLATS_C2, ARRAY_NUM_ELEMENTS(WflatDecimFiltC2_Coeffs), 2,      WflatDecimFiltC2_Coeffs, 40},
+    {  2,     DECIMFILT_WFLATS_C2, ARRAY_NUM_ELEMENTS(WflatDecimFiltC2_Coeffs), 2,      WflatDecimFiltC2_Coeffs, DECIM1_OUT_SAMPLES(4)},
 };
 
-// Decimation filter configurations - these hold the configurations for the
-// two filters of the current decimation filter chain, copied from the
-// DecimFiltConfigs[] list above
-static DecimFiltConfigType g_DecimFilt1Config;
-static DecimFiltConfigType g_DecimFilt2Config;
-
-// Block resizer buffer - see the BlockResizer_XXX() functions
-#define BLOCK_RESIZER_BUF_SIZE  (2 * ADC_SAMPLES_PER_BLOCK)
-static struct
-{
-    int32_t Buf[BLOCK_RESIZER_BUF_SIZE];
-    uint16_t SamplesInBuf;
-} g_BlockResizer =
+// DSP output chain - holds everything which is specific to one enveloper +
+// decimation chain, so that several chains can be run concurrently from the
+// same ADC input blocks
+typedef struct
 {
-    .SamplesInBuf = 0
-};
-
-// Define the state buffers. Their sizes need to be (numTaps + blockSize - 1)
-// word - see arm_fir_decimate_init_q31() documentation. These sizes need to be
-// the ** MAXIMUM ** size required across all 6 filter chains.
-static q31_t DecimFilt1StateBuf[DECIMFILT1_BLOCKSIZE + DECIMFILT1_LARGEST_NUM_TAPS - 1];
-static q31_t DecimFilt2StateBuf[DECIMFILT2_LARGEST_BLOCKSIZE + DECIMFILT2_LARGEST_NUM_TAPS - 1];
-
-// Define the decimation inter-stage buffer
+    EnveloperEnum EnveloperID;
+    DecimChainEnum DecimChainID;
+
+    int64_t EnvFilterState; // 64-bit to maintain precision
+
+    // Decimation filter instances, and their configurations copied from the
+    // DecimFiltConfigs[] list above
+    DecimFiltInstanceType DecimFilt1;
+    DecimFiltInstanceType DecimFilt2;
+    DecimFiltConfigType DecimFilt1Config;
+    DecimFiltConfigType DecimFilt2Config;
+
+    // Define the state buffers. Their sizes need to be (numTaps + blockSize - 1)
+    // word - see DecimFilt_Init() documentation. These sizes need to
+    // be the ** MAXIMUM ** size required across all 6 filter chains.
+    q31_t DecimFilt1StateBuf[DECIMFILT1_BLOCKSIZE + DECIMFILT1_LARGEST_NUM_TAPS - 1];
+    q31_t DecimFilt2StateBuf[DECIMFILT2_LARGEST_BLOCKSIZE + DECIMFILT2_LARGEST_NUM_TAPS - 1];
+} DspChainType;
+
+static DspChainType g_DspChains[PASSRAILDSP_MAX_OUTPUTS];
+static uint8_t g_NumDspChains = 0;
+
+// Define the decimation inter-stage buffer (shared - only used transiently
+// while each chain is processed)
 static int32_t g_DecimInterstageBuf[DECIMFILT2_LARGEST_BLOCKSIZE];
 
 static int32_t g_nNumSettlingSamples;
@@ -697,10 +721,19 @@ bool g_bDisableDcFilter = 0;
 
 static void DspEnvSmootherFilt(int32_t *pCoeffs, int64_t *pState,
                                int32_t *pSampleBlock, uint32_t BlockSize);
-static void BlockResizer_Reset(void);
-static bool BlockResizer_Put(int32_t *pSampleBlock);
-static bool BlockResizer_OutputGetPtr(int32_t **ppOutputBlockPtr);
-static void BlockResizer_OutputFinish(void);
+static void DspEnveloper(const int32_t *pCoeffs, int64_t *pState,
+                         const int32_t *pSampleBlockIn,
+                         int32_t *pSampleBlockOut, uint32_t BlockSize);
+static bool DspChain_Init(DspChainType *pChain, EnveloperEnum EnveloperID,
+                          DecimChainEnum DecimChainID);
+static bool DspProcessBlock(int32_t *pSampleBlockIn,
+                            bool bRawSpiWords,
+                            int32_t *pSampleBlocksOut[],
+                            uint32_t NumOutputSamples[],
+                            uint8_t NumChains);
+static void DspChain_ProcessBlock(DspChainType *pChain, int32_t *pSampleBlockIn,
+                                  int32_t *pSampleBlockOut,
+                                  uint32_t *pNumOutputSamples);
 
 int32_t *SinePlusMinus50_GetAdcBlock128(void);
 static void CalcMean(const int32_t* pnSampleBlock, int32_t nNumSamples);
@@ -723,11 +756,40 @@ static void RemoveDC(int32_t *pSampleBlock, int32_t nNumSamples);
  */
 bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
 {
-    g_DspEnveloperID = EnveloperID;
+    PassRailDspOutputType Output;
+
+    Output.EnveloperID = EnveloperID;
+    Output.DecimChainID = DecimChainID;
+
+    return PassRailDsp_InitMulti(&Output, 1);
+}
+
+/*
+ * PassRailDsp_InitMulti
+ *
+ * @desc    Initialises the DSP for a single sampling burst which feeds
+ *          several enveloper + decimation chains from the same ADC samples.
+ *          Needs to be called before every sampling burst.
+ *          N.B. The DC removal / settling stage is common to all chains.
+ *
+ * @param   pOutputs: Array of NumOutputs enveloper & decimation chain IDs,
+ *          one per required output stream
+ * @param   NumOutputs: 1 to PASSRAILDSP_MAX_OUTPUTS
+ *
+ * @returns true if initialised OK, false otherwise
+ */
+bool PassRailDsp_InitMulti(const PassRailDspOutputType *pOutputs,
+                           uint8_t NumOutputs)
+{
     uint8_t i;
-    uint8_t DecimChainArrayIndex = 0;
-    arm_status DspStatus;
-    bool bOK;
+
+    g_NumDspChains = 0;
+
+    if ((pOutputs == NULL) || (NumOutputs == 0) ||
+        (NumOutputs > PASSRAILDSP_MAX_OUTPUTS))
+    {
+        return false;
+    }
 
     g_nMean = 0;
     g_nMeanCount = 0;
@@ -770,10 +832,44 @@ bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
         }
     }
 
+    for (i = 0; i < NumOutputs; i++)
+    {
+        if (!DspChain_Init(&g_DspChains[i], pOutputs[i].EnveloperID,
+                           pOutputs[i].DecimChainID))
+        {
+            return false;
+        }
+    }
+
+    g_NumDspChains = NumOutputs;
+
+    return true;
+}
+
+/*
+ * DspChain_Init
+ *
+ * @desc    Initialises a single enveloper + decimation output chain.
+ *
+ * @param   pChain: Chain to initialise
+ * @param   EnveloperID: Specifies enveloper type required
+ * @param   DecimChainID: Specifies decimation filter chain required
+ *
+ * @returns true if initialised OK, false otherwise
+ */
+static bool DspChain_Init(DspChainType *pChain, EnveloperEnum EnveloperID,
+                          DecimChainEnum DecimChainID)
+{
+    uint8_t i;
+    uint8_t DecimChainArrayIndex = 0;
+    bool bOK;
+
+    pChain->EnveloperID = EnveloperID;
+
     // Initialise the envelope smoother filter
-    g_EnvFilterState = 0;
+    pChain->EnvFilterState = 0;
 
-    g_DecimChainID = DECIMCHAIN_NONE;
+    pChain->DecimChainID = DECIMCHAIN_NONE;
 
     if (DecimChainID == DECIMCHAIN_NONE)
     {
@@ -781,9 +877,6 @@ bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
     }
     else
     {
-        // Reset the block resizer buffer
-        BlockResizer_Reset();
-
         // Identify the decimation filter chain required
         bOK = false;
         for (i = 0; i < ARRAY_NUM_ELEMENTS(DecimChains); i++)
@@ -791,7 +884,7 @@ bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
             if (DecimChains[i].ID == DecimChainID)
             {
                 DecimChainArrayIndex = i;
-                g_DecimChainID = DecimChainID;
+                pChain->DecimChainID = DecimChainID;
                 bOK = true;
                 break;
             }
@@ -808,14 +901,14 @@ bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
                 if (DecimFiltConfigs[i].ID ==
                                     DecimChains[DecimChainArrayIndex].Stage1FiltID)
                 {
-                    g_DecimFilt1Config = DecimFiltConfigs[i];
+                    pChain->DecimFilt1Config = DecimFiltConfigs[i];
                     bStage1Found = true;
                 }
 
                 if (DecimFiltConfigs[i].ID ==
                                     DecimChains[DecimChainArrayIndex].Stage2FiltID)
                 {
-                    g_DecimFilt2Config = DecimFiltConfigs[i];
+                    pChain->DecimFilt2Config = DecimFiltConfigs[i];
                     bStage2Found = true;
                 }
             }
@@ -829,25 +922,20 @@ bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID)
         // Initialise the decimation filters
         if (bOK)
         {
-            bOK = false;
-            DspStatus = arm_fir_decimate_init_q31(&DecimFilt1,
-                                                  g_DecimFilt1Config.NumTaps,
-                                                  g_DecimFilt1Config.Factor,
-                                                  (q31_t *)g_DecimFilt1Config.pCoeffs,
-                                                  DecimFilt1StateBuf,
-                                                  g_DecimFilt1Config.BlockSize);
-            if (DspStatus == ARM_MATH_SUCCESS)
+            bOK = DecimFilt_Init(&pChain->DecimFilt1,
+                                 pChain->DecimFilt1Config.NumTaps,
+                                 pChain->DecimFilt1Config.Factor,
+                                 pChain->DecimFilt1Config.pCoeffs,
+                                 pChain->DecimFilt1StateBuf,
+                                 pChain->DecimFilt1Config.BlockSize);
+            if (bOK)
             {
-                DspStatus = arm_fir_decimate_init_q31(&DecimFilt2,
-                                                      g_DecimFilt2Config.NumTaps,
-                                                      g_DecimFilt2Config.Factor,
-                                                      (q31_t *)g_DecimFilt2Config.pCoeffs,
-                                                      DecimFilt2StateBuf,
-                                                      g_DecimFilt2Config.BlockSize);
-                if (DspStatus == ARM_MATH_SUCCESS)
-                {
-                    bOK = true;
-                }
+                bOK = DecimFilt_Init(&pChain->DecimFilt2,
+                                     pChain->DecimFilt2Config.NumTaps,
+                                     pChain->DecimFilt2Config.Factor,
+                                     pChain->DecimFilt2Config.pCoeffs,
+                                     pChain->DecimFilt2StateBuf,
+                                     pChain->DecimFilt2Config.BlockSize);
             }
         }
     }
@@ -929,6 +1017,103 @@ void getMeanValues( int32_t * meanp, uint32_t * meanCountp)
     if (meanCountp) *meanCountp = g_bDisableDcFilter ? 0 : g_nMeanCount;
 }
 
+/*
+ * PassRailDsp_GetDecimFilt
+ *
+ * @desc    Gets a decimation filter's parameters from the DecimFiltConfigs[]
+ *          list, e.g. so that the unit tests can run every production filter.
+ *
+ * @param   Index: 0-based index into the list
+ * @param   ppCoeffs: RETURNS the filter coefficients
+ * @param   pNumTaps: RETURNS the number of taps
+ * @param   pFactor: RETURNS the decimation factor
+ * @param   pBlockSize: RETURNS the input block size
+ *
+ * @returns true if Index is valid, false once past the end of the list
+ */
+bool PassRailDsp_GetDecimFilt(uint8_t Index, const int32_t **ppCoeffs,
+                              uint16_t *pNumTaps, uint8_t *pFactor,
+                              uint32_t *pBlockSize)
+{
+    if (Index >= ARRAY_NUM_ELEMENTS(DecimFiltConfigs))
+    {
+        return false;
+    }
+
+    *ppCoeffs = DecimFiltConfigs[Index].pCoeffs;
+    *pNumTaps = DecimFiltConfigs[Index].NumTaps;
+    *pFactor = DecimFiltConfigs[Index].Factor;
+    *pBlockSize = DecimFiltConfigs[Index].BlockSize;
+
+    return true;
+}
+
+/*
+ * PassRailDsp_GetDecimChainFilts
+ *
+ * @desc    Gets the stage 1 and stage 2 decimation filters of a decimation
+ *          chain, as indexes for PassRailDsp_GetDecimFilt().
+ *
+ * @param   DecimChainID: Decimation chain
+ * @param   pStage1Index: RETURNS the stage 1 filter index
+ * @param   pStage2Index: RETURNS the stage 2 filter index
+ *
+ * @returns true if found, false if DecimChainID has no decimation filters
+ */
+bool PassRailDsp_GetDecimChainFilts(DecimChainEnum DecimChainID,
+                                    uint8_t *pStage1Index,
+                                    uint8_t *pStage2Index)
+{
+    uint8_t i;
+    uint8_t j;
+    uint8_t NumFound = 0;
+
+    for (i = 0; i < ARRAY_NUM_ELEMENTS(DecimChains); i++)
+    {
+        if (DecimChains[i].ID == DecimChainID)
+        {
+            for (j = 0; j < ARRAY_NUM_ELEMENTS(DecimFiltConfigs); j++)
+            {
+                if (DecimFiltConfigs[j].ID == DecimChains[i].Stage1FiltID)
+                {
+                    *pStage1Index = j;
+                    NumFound++;
+                }
+                if (DecimFiltConfigs[j].ID == DecimChains[i].Stage2FiltID)
+                {
+                    *pStage2Index = j;
+                    NumFound++;
+                }
+            }
+            break;
+        }
+    }
+
+    return (NumFound == 2);
+}
+
+/*
+ * PassRailDsp_GetEnvFiltCoeffs
+ *
+ * @desc    Gets the 2 x smoothing filter coefficients of an enveloper.
+ *
+ * @param   EnveloperID: Enveloper
+ *
+ * @returns Coefficients, or NULL for ENV_NONE
+ */
+const int32_t *PassRailDsp_GetEnvFiltCoeffs(EnveloperEnum EnveloperID)
+{
+    if (EnveloperID == ENV_VIB)
+    {
+        return VibEnvFiltCoeffs;
+    }
+    if (EnveloperID == ENV_WFLATS)
+    {
+        return WflatEnvFiltCoeffs;
+    }
+    return NULL;
+}
+
 /*
  * PassRailDsp_ProcessBlock
  *
@@ -938,11 +1123,12 @@ void getMeanValues( int32_t * meanp, uint32_t * meanCountp)
  *            - The number of output samples will generally be less than the
  *              number of input samples, due to decimation. However, it will
  *              never be greater
- *            - This function internally converts the input blocks of size
- *              ADC_SAMPLES_PER_BLOCK into blocks of size DECIMFILT1_BLOCKSIZE
- *              (in the block resizer buffer), to help cater for the CMSIS-DSP
- *              requirement for each decimation filter's input block size to
- *              a multiple of its decimation factor
+ *            - The decimators stream, so every input block produces output,
+ *              but the number of output samples can vary by one between
+ *              blocks when ADC_SAMPLES_PER_BLOCK isn't a multiple of the
+ *              overall decimation factor
+ *            - Only processes the first output chain if PassRailDsp_InitMulti()
+ *              was used with several outputs
  *
  * @param   pSampleBlockIn: Sample input buffer of size ADC_SAMPLES_PER_BLOCK
  * @param   pSampleBlockOut: Sample output buffer
@@ -954,11 +1140,91 @@ void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
                               int32_t *pSampleBlockOut,
                               uint32_t *pNumOutputSamples)
 {
-    uint32_t i;
-    int32_t *pDecim1InputBlock;
-    bool bOK;
+    *pNumOutputSamples = 0;
+
+    DspProcessBlock(pSampleBlockIn, false, &pSampleBlockOut, pNumOutputSamples,
+                    (g_NumDspChains > 0) ? 1 : 0);
+}
+
+/*
+ * PassRailDsp_ProcessBlockMulti
+ *
+ * @desc    Performs the passenger-rail-specific DSP processing of a single
+ *          block of incoming ADC_SAMPLES_PER_BLOCK samples, feeding the block
+ *          through every output chain set up by PassRailDsp_InitMulti().
+ *          The DC removal is done once (in-place in pSampleBlockIn), then
+ *          each chain envelopes and decimates it into its own output buffer.
+ *
+ * @param   pSampleBlockIn: Sample input buffer of size ADC_SAMPLES_PER_BLOCK
+ * @param   pSampleBlocksOut: Array of output buffer pointers, one per output
+ *          chain. Each buffer must hold ADC_SAMPLES_PER_BLOCK samples
+ * @param   NumOutputSamples: RETURNS the number of output samples produced
+ *          for each output chain (zero while settling)
+ *
+ * @returns -
+ */
+void PassRailDsp_ProcessBlockMulti(int32_t *pSampleBlockIn,
+                                   int32_t *pSampleBlocksOut[],
+                                   uint32_t NumOutputSamples[])
+{
+    DspProcessBlock(pSampleBlockIn, false, pSampleBlocksOut, NumOutputSamples,
+                    g_NumDspChains);
+}
+
+/*
+ * PassRailDsp_ProcessAdcBlockMulti
+ *
+ * @desc    As PassRailDsp_ProcessBlockMulti(), but takes a block of raw
+ *          AD7766 SPI words, as received from the ADC driver. The SPI word
+ *          conversion, echo byte check and DC removal are fused into a single
+ *          pass, which writes the clean samples back into pAdcBlock.
+ *          N.B. The block is still processed if there's an echo byte
+ *          mismatch, because the waveform is wanted for error diagnostics.
+ *
+ * @param   pAdcBlock: Block of ADC_SAMPLES_PER_BLOCK raw AD7766 SPI words -
+ *          overwritten with the DC-removed sample values
+ * @param   pSampleBlocksOut: Array of output buffer pointers, one per output
+ *          chain. Each buffer must hold ADC_SAMPLES_PER_BLOCK samples
+ * @param   NumOutputSamples: RETURNS the number of output samples produced
+ *          for each output chain (zero while settling)
+ *
+ * @returns true if OK, false if the SPI echo bytes were wrong
+ */
+bool PassRailDsp_ProcessAdcBlockMulti(uint32_t *pAdcBlock,
+                                      int32_t *pSampleBlocksOut[],
+                                      uint32_t NumOutputSamples[])
+{
+    return DspProcessBlock((int32_t *)pAdcBlock, true, pSampleBlocksOut,
+                           NumOutputSamples, g_NumDspChains);
+}
 
-    bOK = false;
+/*
+ * DspProcessBlock
+ *
+ * @desc    Common implementation of PassRailDsp_ProcessBlock(),
+ *          PassRailDsp_ProcessBlockMulti() and
+ *          PassRailDsp_ProcessAdcBlockMulti() - runs the settling / DC
+ *          removal stage, then the first NumChains output chains.
+ *
+ * @param   pSampleBlockIn: Sample input buffer of size ADC_SAMPLES_PER_BLOCK
+ * @param   bRawSpiWords: true if pSampleBlockIn holds raw AD7766 SPI words,
+ *          which are then converted in-place along with the DC removal
+ * @param   pSampleBlocksOut: Array of NumChains output buffer pointers
+ * @param   NumOutputSamples: RETURNS the number of output samples per chain
+ * @param   NumChains: Number of output chains to run
+ *
+ * @returns false if raw SPI words had echo byte errors, true otherwise
+ */
+static bool DspProcessBlock(int32_t *pSampleBlockIn,
+                            bool bRawSpiWords,
+                            int32_t *pSampleBlocksOut[],
+                            uint32_t NumOutputSamples[],
+                            uint8_t NumChains)
+{
+    uint8_t Chan;
+    int32_t DcOffset;
+    bool bOK = true;
+    TRACE_ENTER(TRACE_DSP_BLOCK);
 
     // NOTE: For ADC input sample value scaling considerations, see the comments
     // at the top of this file.
@@ -966,11 +1232,24 @@ void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
 //#define INJECT_SINE_PLUSMINUS50
 #ifdef INJECT_SINE_PLUSMINUS50
     pSampleBlockIn = SinePlusMinus50_GetAdcBlock128();
+    bRawSpiWords = false;
 #endif // INJECT_SINE_PLUSMINUS50
 
+    for (Chan = 0; Chan < NumChains; Chan++)
+    {
+        NumOutputSamples[Chan] = 0;
+    }
+
     //Have we settled?
     if (g_nNumSettlingSamples > 0)
 	{
+		if (bRawSpiWords)
+		{
+			bOK = AD7766_PreProcessRawSpiBlock((uint32_t *)pSampleBlockIn,
+			                                   pSampleBlockIn, 0,
+			                                   ADC_SAMPLES_PER_BLOCK);
+		}
+
     	//While settling, we calculate the running mean
 		CalcMean(pSampleBlockIn, ADC_SAMPLES_PER_BLOCK);
 
@@ -987,124 +1266,157 @@ void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
 	else //We've settled so commence with DSP processing
 	{
 		//Always remove DC component
-		if(!g_bDisableDcFilter) RemoveDC(pSampleBlockIn, ADC_SAMPLES_PER_BLOCK);
+		DcOffset = g_bDisableDcFilter ? 0 : g_nMean;
+		if (bRawSpiWords)
+		{
+			// Fused with the SPI word conversion
+			bOK = AD7766_PreProcessRawSpiBlock((uint32_t *)pSampleBlockIn,
+			                                   pSampleBlockIn, DcOffset,
+			                                   ADC_SAMPLES_PER_BLOCK);
+		}
+		else if (DcOffset != 0)
+		{
+			RemoveDC(pSampleBlockIn, ADC_SAMPLES_PER_BLOCK);
+		}
 
-		//..........................................................................
-		// Enveloper (rectifier + first-order lowpass smoothing filter)
+		// Fan the DC-removed block out to each of the output chains
+		for (Chan = 0; Chan < NumChains; Chan++)
+		{
+			DspChain_ProcessBlock(&g_DspChains[Chan], pSampleBlockIn,
+			                      pSampleBlocksOut[Chan], &NumOutputSamples[Chan]);
+		}
+	}
+
+    TRACE_EXIT(TRACE_DSP_BLOCK);
+    return bOK;
+}
+
+/*
+ * DspChain_ProcessBlock
+ *
+ * @desc    Runs one DC-removed block of ADC_SAMPLES_PER_BLOCK samples through
+ *          a single enveloper + decimation output chain. pSampleBlockIn is
+ *          not modified, so it can be fed to several chains in turn.
+ *
+ * @param   pChain: Output chain to run
+ * @param   pSampleBlockIn: Sample input buffer of size ADC_SAMPLES_PER_BLOCK
+ * @param   pSampleBlockOut: Sample output buffer
+ * @param   pNumOutputSamples: RETURNS the number of output samples produced
+ *
+ * @returns -
+ */
+static void DspChain_ProcessBlock(DspChainType *pChain, int32_t *pSampleBlockIn,
+                                  int32_t *pSampleBlockOut,
+                                  uint32_t *pNumOutputSamples)
+{
+    uint32_t i;
+    EnveloperEnum EnveloperID = pChain->EnveloperID;
+    DecimChainEnum DecimChainID = pChain->DecimChainID;
+    int32_t *pEnvCoeffs;
+    int32_t *pEnvOut;
+
+	//..........................................................................
+	// Enveloper (rectifier + first-order lowpass smoothing filter)
 
 //#define BYPASS_ENVELOPER
 #ifdef BYPASS_ENVELOPER
-		g_DspEnveloperID = ENV_NONE;
+	EnveloperID = ENV_NONE;
 #endif
 
-		if (g_DspEnveloperID != ENV_NONE)
-		{
-			// Rectification
+//#define BYPASS_DECIMATION
+#ifdef BYPASS_DECIMATION
+	DecimChainID = DECIMCHAIN_NONE;
+#endif
+
+	// The enveloper writes straight into the stage 1 decimator's input, or
+	// into the output buffer if there's no decimation
+	if (DecimChainID == DECIMCHAIN_NONE)
+	{
+		pEnvOut = pSampleBlockOut;
+	}
+	else
+	{
+		pEnvOut = DecimFilt_GetInputBuffer(&pChain->DecimFilt1);
+	}
+
+	if (EnveloperID == ENV_VIB)
+	{
+		pEnvCoeffs = VibEnvFiltCoeffs;
+	}
+	else if (EnveloperID == ENV_WFLATS)
+	{
+		pEnvCoeffs = WflatEnvFiltCoeffs;
+	}
+	else
+	{
+		pEnvCoeffs = NULL;
+	}
+
+	if (pEnvCoeffs != NULL)
+	{
+		// Rectification
 #define DO_RECTIFICATION
 #ifdef DO_RECTIFICATION
-			// Rectify
-			arm_abs_q31(pSampleBlockIn, g_EnvOutBuf, ADC_SAMPLES_PER_BLOCK);
+		// Rectify and smooth in a single pass
+		DspEnveloper(pEnvCoeffs, &pChain->EnvFilterState, pSampleBlockIn,
+		             pEnvOut, ADC_SAMPLES_PER_BLOCK);
 #else
-			// Bypass rectifier
-			for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
-			{
-				g_EnvOutBuf[i] = pSampleBlockIn[i];
-			}
-#endif
-
-			// Smoothing filter
-			if (g_DspEnveloperID == ENV_VIB)
-			{
-			DspEnvSmootherFilt(VibEnvFiltCoeffs, &g_EnvFilterState,
-							   g_EnvOutBuf, ADC_SAMPLES_PER_BLOCK);
-			}
-			else if (g_DspEnveloperID == ENV_WFLATS)
-			{
-			DspEnvSmootherFilt(WflatEnvFiltCoeffs, &g_EnvFilterState,
-							   g_EnvOutBuf, ADC_SAMPLES_PER_BLOCK);
-			}
-			else
-			{
-				// TODO: ERROR
-			}
+		// Bypass rectifier
+		for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+		{
+			pEnvOut[i] = pSampleBlockIn[i];
 		}
-		else
+		DspEnvSmootherFilt(pEnvCoeffs, &pChain->EnvFilterState,
+						   pEnvOut, ADC_SAMPLES_PER_BLOCK);
+#endif
+	}
+	else if (DecimChainID == DECIMCHAIN_NONE)
+	{
+		// No enveloper - pass directly through
+		for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
 		{
-			// No enveloper - pass directly through
-			for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
-			{
-				g_EnvOutBuf[i] = pSampleBlockIn[i];
-			}
+			pEnvOut[i] = pSampleBlockIn[i];
 		}
+	}
+	else
+	{
+		// No enveloper - DecimFilt_Process() copies the input block itself
+		pEnvOut = pSampleBlockIn;
+	}
 
-		//..........................................................................
-		// Decimation filter chain
-		*pNumOutputSamples = 0;
+	//..........................................................................
+	// Decimation filter chain
+	*pNumOutputSamples = 0;
 
-//#define BYPASS_DECIMATION
-#ifdef BYPASS_DECIMATION
-		g_DecimChainID = DECIMCHAIN_NONE;
-#endif
+	if (DecimChainID == DECIMCHAIN_NONE)
+	{
+		// No decimation chain - the enveloper output is already in
+		// pSampleBlockOut
+		*pNumOutputSamples = ADC_SAMPLES_PER_BLOCK;
+	}
+	else
+	{
+		// Stage 1 decimation filter - consumes the ADC-sized block directly
+		uint32_t NumDecim1OutputSamples;
+		NumDecim1OutputSamples = DecimFilt_Process(&pChain->DecimFilt1, pEnvOut,
+												   ADC_SAMPLES_PER_BLOCK,
+												   g_DecimInterstageBuf);
 
-		if (g_DecimChainID == DECIMCHAIN_NONE)
-		{
-			// No decimation chain - just pass straight through
-			for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
-			{
-				pSampleBlockOut[i] = g_EnvOutBuf[i];
-			}
-			*pNumOutputSamples = ADC_SAMPLES_PER_BLOCK;
-
-			bOK = true;
-		}
-		else
-		{
-			// Perform block resizing for upcoming decimation - resizes from
-			// ADC_SAMPLES_PER_BLOCK (128) to DECIMFILT1_BLOCKSIZE (160)
-			// N.B. Not every pass will result in an output block, because the output
-			// block size is larger than the input block size
-			bOK = BlockResizer_Put(g_EnvOutBuf);
-			if (bOK)
-			{
-				// If sufficient samples available in resizer buffer, then process a
-				// block of them through the decimation chain
-				if (BlockResizer_OutputGetPtr(&pDecim1InputBlock))
-				{
-					// Stage 1 decimation filter
-					arm_fir_decimate_q31(&DecimFilt1, pDecim1InputBlock,
-										 g_DecimInterstageBuf, g_DecimFilt1Config.BlockSize);
-
-						// Stage 2 decimation filter
+			// Stage 2 decimation filter
 //#define DECIMCHAIN_BYPASS_STAGE2
 #ifdef DECIMCHAIN_BYPASS_STAGE2
-					uint16_t DecimFilt1OutputBlockSize = g_DecimFilt1Config.BlockSize / g_DecimFilt1Config.Factor;
-					for (i = 0; i < DecimFilt1OutputBlockSize; i++)
-					{
-						//******** TODO: Add buffer overrun protection
-
-						pSampleBlockOut[i] = g_DecimInterstageBuf[i];
-					}
-					*pNumOutputSamples = DecimFilt1OutputBlockSize;
+		for (i = 0; i < NumDecim1OutputSamples; i++)
+		{
+			pSampleBlockOut[i] = g_DecimInterstageBuf[i];
+		}
+		*pNumOutputSamples = NumDecim1OutputSamples;
 #else
 
-					arm_fir_decimate_q31(&DecimFilt2, g_DecimInterstageBuf,
-										 pSampleBlockOut, g_DecimFilt2Config.BlockSize);
-
-					// Indicate the number of output samples this time around
-					*pNumOutputSamples = g_DecimFilt2Config.BlockSize / g_DecimFilt2Config.Factor;
+		// Indicate the number of output samples this time around
+		*pNumOutputSamples = DecimFilt_Process(&pChain->DecimFilt2, g_DecimInterstageBuf,
+											   NumDecim1OutputSamples,
+											   pSampleBlockOut);
 #endif
-
-					// Finish the current block resizer output cycle
-					BlockResizer_OutputFinish();
-
-					// TODO: Set better size for pSampleBlockOut buffer - it's g_DspOutSampleBuf[]
-				}
-			}
-			else
-			{
-				// ERROR: BlockResizer_Put() failed
-			}
-		}
 	}
 }
 
@@ -1119,9 +1431,9 @@ void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
  *
  *          TODO: Experimental to begin with. This code was adapted from the
  *          Microlog's Enveloper() function - however, this code only
- *          implements the smoothing filter (not the rectification) - this
- *          is probably less efficient overall, but allows this filter
- *          to be tested separately.
+ *          implements the smoothing filter (not the rectification), which
+ *          allows this filter to be tested separately. The real-time chain
+ *          uses the fused DspEnveloper() instead.
  *
  * @param
  *
@@ -1148,103 +1460,69 @@ static void DspEnvSmootherFilt(int32_t *pCoeffs, int64_t *pState,
 }
 
 /*
- * BlockResizer_Reset
+ * DspEnveloper
  *
- * @desc
- *          - Input block size = 128 (ADC_SAMPLES_PER_BLOCK)
- *          - Output block size = 160 (DECIMFILT1_BLOCKSIZE)
- *          - Buffer size needs to be 2 x input block size so that can accept
- *            worst-case of 2 x full back-to-back input blocks
+ * @desc    Fused enveloper - rectifies each sample (as arm_abs_q31()) and
+ *          runs it through the DspEnvSmootherFilt() smoothing filter, in a
+ *          single pass from pSampleBlockIn to pSampleBlockOut. Bit-exact with
+ *          arm_abs_q31() followed by DspEnvSmootherFilt(). The filter state
+ *          is kept in a local variable, and the loop is unrolled by 4 (the
+ *          filter recursion means the samples are still done in order).
+ *          IMPORTANT: *pState must be persistent across calls, and must be
+ *          initialised to 0 upon each new sampling commencement.
  *
- * @param
+ * @param   pCoeffs: The 2 x smoothing filter coefficients
+ * @param   pState: Smoothing filter state
+ * @param   pSampleBlockIn: DC-removed input samples
+ * @param   pSampleBlockOut: Enveloped output samples (can be the same buffer
+ *          as pSampleBlockIn)
+ * @param   BlockSize: Number of samples
  *
  * @returns -
  */
-static void BlockResizer_Reset(void)
+static void DspEnveloper(const int32_t *pCoeffs, int64_t *pState,
+                         const int32_t *pSampleBlockIn,
+                         int32_t *pSampleBlockOut, uint32_t BlockSize)
 {
-    g_BlockResizer.SamplesInBuf = 0;
-}
-
-/*
- * BlockResizer_Put
- *
- * @desc    Puts a sample block of size ADC_SAMPLES_PER_BLOCK into the block
- *          resizer
- *
- * @param   pSampleBlock: Input sample block of size ADC_SAMPLES_PER_BLOCK
- *
- * @returns true if OK, false if insufficient room - THIS IS AN ERROR because
- *          should never overflow if used properly
- */
-static bool BlockResizer_Put(int32_t *pSampleBlock)
-{
-    uint16_t i;
-
-    // If room in buffer (N.B. buffer has size of 2 x ADC_SAMPLES_PER_BLOCK),
-    // then append new block into buffer
-    if (g_BlockResizer.SamplesInBuf <= ADC_SAMPLES_PER_BLOCK) // Also provides buffer overrun protection
+    int64_t Coeff0 = pCoeffs[0];
+    int64_t Coeff1 = pCoeffs[1];
+    int64_t State = *pState;
+    int64_t SampleInTimesCoeff0;
+    int32_t In;
+    int32_t Out;
+
+// Rectify (saturating, as arm_abs_q31()), then smooth - see
+// DspEnvSmootherFilt() for the smoothing filter details
+#define DSP_ENVELOPER_SAMPLE(Index) \
+    In = pSampleBlockIn[Index]; \
+    In = (In > 0) ? In : (q31_t)__QSUB(0, In); \
+    SampleInTimesCoeff0 = (int64_t)In * Coeff0; \
+    Out = (int32_t)((SampleInTimesCoeff0 + State) >> 31); \
+    State = SampleInTimesCoeff0 - ((int64_t)Out * Coeff1); \
+    pSampleBlockOut[Index] = Out
+
+    while (BlockSize >= 4)
     {
-        for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
-        {
-            g_BlockResizer.Buf[g_BlockResizer.SamplesInBuf + i] = pSampleBlock[i];
-        }
-        g_BlockResizer.SamplesInBuf += ADC_SAMPLES_PER_BLOCK;
-        return true;
+        DSP_ENVELOPER_SAMPLE(0);
+        DSP_ENVELOPER_SAMPLE(1);
+        DSP_ENVELOPER_SAMPLE(2);
+        DSP_ENVELOPER_SAMPLE(3);
+        pSampleBlockIn += 4;
+        pSampleBlockOut += 4;
+        BlockSize -= 4;
     }
 
-    return false;
-}
-
-/*
- * BlockResizer_OutputGetPtr
- *
- * @desc    Checks if DECIMFILT1_BLOCKSIZE samples are available in the block
- *          resizer, and if so then provides a pointer to the block of samples.
- *
- * @param   **ppOutputBlockPtr: Written with address of block resizer's
- *          internal buffer where the output block is available
- *
- * @returns true if enough samples are available, false if not
- */
-static bool BlockResizer_OutputGetPtr(int32_t **ppOutputBlockPtr)
-{
-    if (g_BlockResizer.SamplesInBuf >= DECIMFILT1_BLOCKSIZE)
+    while (BlockSize > 0)
     {
-        *ppOutputBlockPtr = g_BlockResizer.Buf;
-        return true;
+        DSP_ENVELOPER_SAMPLE(0);
+        pSampleBlockIn++;
+        pSampleBlockOut++;
+        BlockSize--;
     }
-    return false;
-}
 
-/*
- * BlockResizer_OutputFinish
- *
- * @desc    Must be called once BlockResizer_OutputGetPtr() has been successful
- *          and the output block usage has completed. Adjusts the internal
- *          buffering.
- *
- * @param   -
- *
- * @returns -
- */
-static void BlockResizer_OutputFinish(void)
-{
-    uint16_t i;
-
-    if (g_BlockResizer.SamplesInBuf <= BLOCK_RESIZER_BUF_SIZE)  // Buffer overrun protection
-    {
-        // If extra samples remaining in the buffer after use, then copy them
-        // to beginning of buffer and adjust control variable
-        if (g_BlockResizer.SamplesInBuf >= DECIMFILT1_BLOCKSIZE)
-        {
-            for (i = 0; i < (g_BlockResizer.SamplesInBuf - DECIMFILT1_BLOCKSIZE); i++)
-            {
-                g_BlockResizer.Buf[i] = g_BlockResizer.Buf[DECIMFILT1_BLOCKSIZE + i];
-            }
+#undef DSP_ENVELOPER_SAMPLE
 
-            g_BlockResizer.SamplesInBuf -= DECIMFILT1_BLOCKSIZE;
-        }
-    }
+    *pState = State;
 }
 
 //******************************************************************************
@@ -1318,17 +1596,6 @@ int32_t *SinePlusMinus50_GetAdcBlock128(void)
 
 #if 0
 
-static int32_t g_TestBlock[ADC_SAMPLES_PER_BLOCK];
-static volatile bool g_bResultOK;
-static volatile int32_t *g_pOutputBlock;
-static volatile int32_t g_InputVal = 0;
-static volatile int32_t g_OutputVal = 0;
-static volatile bool g_bBlockResizerError = false;
-
-// Test functions
-void BlockResizer_TEST(void);
-
-
 /*
  * PassRailDsp_TEST
  *
@@ -1340,90 +1607,11 @@ void BlockResizer_TEST(void);
  */
 void PassRailDsp_TEST(void)
 {
-    //BlockResizer_TEST();
 
 }
 
 
 
-/*
- * BlockResizer_TEST
- *
- * @desc    Tests the block resizer by putting input blocks (of size
- *          ADC_SAMPLES_PER_BLOCK = 128) with incrementing sample values into
- *          the block resizer, and checking that the output blocks (of size
- *          DECIMFILT1_BLOCKSIZE = 160) match this.
- *
- *          To use it, set up a breakpoint where indicated near the end of the
- *          function - if it fires then something has gone wrong.
- *
- * @param   -
- *
- * @returns -
- */
-static void BlockResizer_TEST(void)
-{
-    uint16_t i;
-
-    //..........................................................................
-    // Test the block resizer
-    BlockResizer_Reset();
-
-    g_InputVal = 0;
-    g_OutputVal = 0;
-    g_bBlockResizerError = false;
-
-    while(1)
-    {
-        //......................................................................
-        // Put an input block - number the values so can track
-        for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
-        {
-            g_TestBlock[i] = g_InputVal;
-            g_InputVal++;
-        }
-        g_bResultOK = BlockResizer_Put(g_TestBlock);
-        if (!g_bResultOK)
-        {
-            // ERROR: The "put" operation failed - should never happen if block
-            // resizer is used correctly
-            g_bBlockResizerError = true;
-        }
-
-        //......................................................................
-        // Get an output block, if available
-        g_bResultOK = BlockResizer_OutputGetPtr(&g_pOutputBlock);
-        if (g_bResultOK)
-        {
-            // Output block is now available - check it
-            for (i = 0; i < DECIMFILT1_BLOCKSIZE; i++)
-            {
-                if (g_pOutputBlock[i] == g_OutputVal)
-                {
-                    g_OutputVal++;
-                }
-                else
-                {
-                    // ERROR: Output sample sequence didn't match input sample sequence
-                    g_bBlockResizerError = true;
-                }
-            }
-
-            // Finish the current output block's handling
-            BlockResizer_OutputFinish();
-        }
-
-        //......................................................................
-
-        if (g_bBlockResizerError)
-        {
-            g_InputVal = 999;   // Breakpointable
-            break;
-        }
-    }
-}
-
-
 #endif // 0
 
 //******************************************************************************
@@ -52,12 +52,38 @@ typedef enum
 
 } DecimChainEnum;
 
+// Maximum number of enveloper + decimation chains which can be fed
+// concurrently from a single ADC input stream
+#define PASSRAILDSP_MAX_OUTPUTS     (3)
+
+typedef struct
+{
+    EnveloperEnum EnveloperID;
+    DecimChainEnum DecimChainID;
+} PassRailDspOutputType;
+
 //..............................................................................
 
 bool PassRailDsp_Init(EnveloperEnum EnveloperID, DecimChainEnum DecimChainID);
+bool PassRailDsp_InitMulti(const PassRailDspOutputType *pOutputs,
+                           uint8_t NumOutputs);
 void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
                               int32_t *pSampleBlockOut,
                               uint32_t *pNumOutputSamples);
+void PassRailDsp_ProcessBlockMulti(int32_t *pSampleBlockIn,
+                                   int32_t *pSampleBlocksOut[],
+                                   uint32_t NumOutputSamples[]);
+bool PassRailDsp_ProcessAdcBlockMulti(uint32_t *pAdcBlock,
+                                      int32_t *pSampleBlocksOut[],
+                                      uint32_t NumOutputSamples[]);
+
+bool PassRailDsp_GetDecimFilt(uint8_t Index, const int32_t **ppCoeffs,
+                              uint16_t *pNumTaps, uint8_t *pFactor,
+                              uint32_t *pBlockSize);
+bool PassRailDsp_GetDecimChainFilts(DecimChainEnum DecimChainID,
+                                    uint8_t *pStage1Index,
+                                    uint8_t *pStage2Index);
+const int32_t *PassRailDsp_GetEnvFiltCoeffs(EnveloperEnum EnveloperID);
 
 // Test functions
 void PassRailDsp_TEST(void);
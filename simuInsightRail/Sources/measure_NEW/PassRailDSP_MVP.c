@@ -18,6 +18,7 @@ extern "C" {
 #include "arm_math.h"
 #include "PassRailDSP_MVP.h"
 #include "AdcApiDefs.h"
+#include "AD7766_DMA.h"
 #include "PinConfig.h"
 
 //******************************************************************************
@@ -442,6 +443,76 @@ void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
     //..........................................................................
 }
 
+/*
+ * PassRailDsp_InitMulti
+ *
+ * @desc    Multi-output interface for compatibility with the new DSP - the
+ *          MVP DSP only supports a single output (NumOutputs must be 1).
+ *
+ * @param   pOutputs: Enveloper & decimation chain of the single output
+ * @param   NumOutputs: Must be 1
+ *
+ * @returns true if initialised OK, false otherwise
+ */
+bool PassRailDsp_InitMulti(const PassRailDspOutputType *pOutputs,
+                           uint8_t NumOutputs)
+{
+    if ((pOutputs == NULL) || (NumOutputs != 1))
+    {
+        return false;
+    }
+
+    return PassRailDsp_Init(pOutputs[0].EnveloperID, pOutputs[0].DecimChainID);
+}
+
+/*
+ * PassRailDsp_ProcessBlockMulti
+ *
+ * @desc    Multi-output interface for compatibility with the new DSP - only
+ *          the single output is produced.
+ *
+ * @param   pSampleBlockIn: Sample input buffer of size ADC_SAMPLES_PER_BLOCK
+ * @param   pSampleBlocksOut: Array holding the single output buffer pointer
+ * @param   NumOutputSamples: RETURNS the number of output samples produced
+ *
+ * @returns -
+ */
+void PassRailDsp_ProcessBlockMulti(int32_t *pSampleBlockIn,
+                                   int32_t *pSampleBlocksOut[],
+                                   uint32_t NumOutputSamples[])
+{
+    NumOutputSamples[0] = 0;
+    PassRailDsp_ProcessBlock(pSampleBlockIn, pSampleBlocksOut[0],
+                             &NumOutputSamples[0]);
+}
+
+/*
+ * PassRailDsp_ProcessAdcBlockMulti
+ *
+ * @desc    Raw AD7766 SPI word interface for compatibility with the new DSP -
+ *          converts the block in-place, then processes it as
+ *          PassRailDsp_ProcessBlockMulti().
+ *
+ * @param   pAdcBlock: Block of ADC_SAMPLES_PER_BLOCK raw AD7766 SPI words
+ * @param   pSampleBlocksOut: Array holding the single output buffer pointer
+ * @param   NumOutputSamples: RETURNS the number of output samples produced
+ *
+ * @returns true if OK, false if the SPI echo bytes were wrong
+ */
+bool PassRailDsp_ProcessAdcBlockMulti(uint32_t *pAdcBlock,
+                                      int32_t *pSampleBlocksOut[],
+                                      uint32_t NumOutputSamples[])
+{
+    bool bOK;
+
+    bOK = AD7766_PreProcessRawSpiBlock(pAdcBlock, (int32_t *)pAdcBlock, 0,
+                                       ADC_SAMPLES_PER_BLOCK);
+    PassRailDsp_ProcessBlockMulti((int32_t *)pAdcBlock, pSampleBlocksOut,
+                                  NumOutputSamples);
+
+    return bOK;
+}
+
 /*
  * DspEnvSmootherFilt
  *
@@ -47,12 +47,29 @@ typedef enum
 #endif // 0
 } DecimChainEnum;
 
+// The MVP DSP only supports a single output chain per ADC capture
+#define PASSRAILDSP_MAX_OUTPUTS     (1)
+
+typedef struct
+{
+    EnveloperEnum EnveloperID;
+    DecimChainEnum DecimChainID;
+} PassRailDspOutputType;
+
 //..............................................................................
 
 bool PassRailDsp_Init(EnveloperEnum Enveloper, DecimChainEnum Decimation);
+bool PassRailDsp_InitMulti(const PassRailDspOutputType *pOutputs,
+                           uint8_t NumOutputs);
 void PassRailDsp_ProcessBlock(int32_t *pSampleBlockIn,
                               int32_t *pSampleBlockOut,
                               uint32_t *pNumOutputSamples);
+void PassRailDsp_ProcessBlockMulti(int32_t *pSampleBlockIn,
+                                   int32_t *pSampleBlocksOut[],
+                                   uint32_t NumOutputSamples[]);
+bool PassRailDsp_ProcessAdcBlockMulti(uint32_t *pAdcBlock,
+                                      int32_t *pSampleBlocksOut[],
+                                      uint32_t NumOutputSamples[]);
 
 //..............................................................................
 
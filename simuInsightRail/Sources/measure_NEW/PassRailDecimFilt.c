@@ -0,0 +1,344 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailDecimFilt.c
+ *
+ * Description: Q31 FIR decimation filter engine for the passenger-rail DSP
+ *              chain.
+ *
+ * -----------------------------------------------------------------------------
+ * Design notes
+ * -----------------------------------------------------------------------------
+ *
+ *     - All the decimation filters in PassRailDSP.c are linear-phase, i.e.
+ *       their coefficients are symmetric: h[k] == h[NumTaps - 1 - k]. The
+ *       generic arm_fir_decimate_q31() does one multiply-accumulate per tap,
+ *       whereas this engine folds each symmetric pair of taps:
+ *
+ *           h[k] * x[a] + h[k] * x[b]  ==  h[k] * (x[a] + x[b])
+ *
+ *       which halves the number of multiplies (and coefficient loads)
+ *
+ *     - Decimation is done polyphase-style, as for arm_fir_decimate_q31():
+ *       only every Factor'th output sample is computed - the filter window
+ *       steps through the state buffer by Factor samples per output
+ *
+ *     - Folded taps with a zero coefficient (every other tap of a half-band
+ *       filter) are skipped entirely, via a list of the non-zero folded taps
+ *       built by DecimFilt_Init(). Filters without zero taps use a straight
+ *       pointer loop instead, avoiding the extra index lookups
+ *
+ *     - Non-symmetric coefficient sets are still supported, using a plain
+ *       multiply-accumulate per tap
+ *
+ *     - Results are BIT-EXACT with arm_fir_decimate_q31(): both accumulate
+ *       exact 64-bit products and return (q31_t)(Accumulator >> 31), and the
+ *       order of integer additions makes no difference. This relies on the
+ *       pre-addition x[a] + x[b] not overflowing 32 bits, which is guaranteed
+ *       by the DSP chain's input scaling - the 24-bit ADC values are
+ *       right-justified in the 32-bit words (see PassRailDSP.c), which
+ *       arm_fir_decimate_q31() requires anyway to avoid accumulator overflow
+ *
+ *     - Streaming: unlike arm_fir_decimate_q31(), input blocks can be any
+ *       length up to MaxBlockSize - they don't need to be a multiple of the
+ *       decimation factor. A phase counter tracks how far through the current
+ *       decimation period the input stream is, so e.g. 128-sample ADC blocks
+ *       can be fed straight into a /10 stage, giving 12 or 13 outputs per
+ *       block. The output sample stream is identical to feeding the same
+ *       input through arm_fir_decimate_q31() in Factor-multiple blocks
+ *
+ *     - The state buffer holds the previous (NumTaps - 1) input samples,
+ *       followed by the current input block, as for arm_fir_decimate_q31().
+ *       The previous DSP stage can write the input block straight into the
+ *       state buffer (see DecimFilt_GetInputBuffer()), saving a copy
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "PassRailDecimFilt.h"
+
+//..............................................................................
+
+static q63_t DecimFilt_MacFolded(const DecimFiltInstanceType *pFilt,
+                                 const q31_t *pWindow);
+static q63_t DecimFilt_MacFoldedSparse(const DecimFiltInstanceType *pFilt,
+                                       const q31_t *pWindow);
+static q63_t DecimFilt_Mac(const DecimFiltInstanceType *pFilt,
+                           const q31_t *pWindow);
+
+//..............................................................................
+
+/*
+ * DecimFilt_Init
+ *
+ * @desc    Initialises a decimation filter instance, in the same way as
+ *          arm_fir_decimate_init_q31(). Also analyses the coefficients for
+ *          symmetry and zero taps, to select the fastest evaluation method.
+ *          The state buffer and phase are cleared.
+ *
+ * @param   pFilt: Filter instance to initialise
+ * @param   NumTaps: Number of filter coefficients, up to DECIMFILT_MAX_TAPS
+ * @param   Factor: Decimation factor
+ * @param   pCoeffs: Filter coefficients (must stay valid while in use)
+ * @param   pState: State buffer of (NumTaps + MaxBlockSize - 1) words
+ * @param   MaxBlockSize: Largest number of input samples per
+ *          DecimFilt_Process() call
+ *
+ * @returns true if initialised OK, false for invalid parameters
+ */
+bool DecimFilt_Init(DecimFiltInstanceType *pFilt, uint16_t NumTaps,
+                    uint8_t Factor, const q31_t *pCoeffs, q31_t *pState,
+                    uint32_t MaxBlockSize)
+{
+    uint16_t i;
+
+    if ((pFilt == NULL) || (pCoeffs == NULL) || (pState == NULL) ||
+        (NumTaps == 0) || (NumTaps > DECIMFILT_MAX_TAPS) ||
+        (Factor == 0) || (MaxBlockSize == 0))
+    {
+        return false;
+    }
+
+    pFilt->NumTaps = NumTaps;
+    pFilt->Factor = Factor;
+    pFilt->pCoeffs = pCoeffs;
+    pFilt->pState = pState;
+    pFilt->MaxBlockSize = MaxBlockSize;
+    pFilt->Phase = 0;
+
+    memset(pState, 0, (NumTaps + MaxBlockSize - 1) * sizeof(q31_t));
+
+    // Check for coefficient symmetry
+    pFilt->bSymmetric = true;
+    for (i = 0; i < (NumTaps / 2); i++)
+    {
+        if (pCoeffs[i] != pCoeffs[NumTaps - 1 - i])
+        {
+            pFilt->bSymmetric = false;
+            break;
+        }
+    }
+
+    // List the non-zero folded taps
+    pFilt->bHasZeroTaps = false;
+    pFilt->NumNonZeroFoldedTaps = 0;
+    if (pFilt->bSymmetric)
+    {
+        for (i = 0; i < (NumTaps / 2); i++)
+        {
+            if (pCoeffs[i] != 0)
+            {
+                pFilt->NonZeroFoldedTaps[pFilt->NumNonZeroFoldedTaps++] = (uint8_t)i;
+            }
+            else
+            {
+                pFilt->bHasZeroTaps = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * DecimFilt_Process
+ *
+ * @desc    Filters and decimates a block of input samples of any length, up
+ *          to MaxBlockSize. An output sample is produced for every Factor'th
+ *          input sample in the overall stream, so the number of outputs per
+ *          call varies by one when NumInputSamples isn't a multiple of Factor.
+ *
+ * @param   pFilt: Filter instance
+ * @param   pSrc: NumInputSamples input samples - can be the buffer returned
+ *          by DecimFilt_GetInputBuffer(), to avoid copying the block
+ * @param   NumInputSamples: 0 to MaxBlockSize
+ * @param   pDst: Buffer for up to ((NumInputSamples / Factor) + 1) output
+ *          samples
+ *
+ * @returns The number of output samples written to pDst
+ */
+uint32_t DecimFilt_Process(DecimFiltInstanceType *pFilt, const q31_t *pSrc,
+                           uint32_t NumInputSamples, q31_t *pDst)
+{
+    uint32_t NumHistory = pFilt->NumTaps - 1;
+    uint32_t NumOutputs = 0;
+    uint32_t LastSample;
+    q63_t Acc;
+
+    if (NumInputSamples > pFilt->MaxBlockSize)
+    {
+        NumInputSamples = pFilt->MaxBlockSize;
+    }
+
+    // Append the new input block after the history samples, unless the caller
+    // has already written it there
+    if (pSrc != &pFilt->pState[NumHistory])
+    {
+        memcpy(&pFilt->pState[NumHistory], pSrc, NumInputSamples * sizeof(q31_t));
+    }
+
+    // An output is produced on the first input sample of each decimation
+    // period (as for arm_fir_decimate_q31()), with its filter window ending
+    // on that sample. The window for the input block's sample n starts at
+    // pState[n].
+    for (LastSample = (pFilt->Factor - pFilt->Phase) % pFilt->Factor;
+         LastSample < NumInputSamples;
+         LastSample += pFilt->Factor)
+    {
+        if (!pFilt->bSymmetric)
+        {
+            Acc = DecimFilt_Mac(pFilt, &pFilt->pState[LastSample]);
+        }
+        else if (pFilt->bHasZeroTaps)
+        {
+            Acc = DecimFilt_MacFoldedSparse(pFilt, &pFilt->pState[LastSample]);
+        }
+        else
+        {
+            Acc = DecimFilt_MacFolded(pFilt, &pFilt->pState[LastSample]);
+        }
+
+        pDst[NumOutputs++] = (q31_t)(Acc >> 31);
+    }
+
+    pFilt->Phase = (uint8_t)((pFilt->Phase + NumInputSamples) % pFilt->Factor);
+
+    // Keep the last (NumTaps - 1) samples as history for the next block
+    memmove(pFilt->pState, &pFilt->pState[NumInputSamples],
+            NumHistory * sizeof(q31_t));
+
+    return NumOutputs;
+}
+
+/*
+ * DecimFilt_GetInputBuffer
+ *
+ * @desc    Gets the position in the state buffer where the next input block
+ *          goes, so that a preceding processing stage can write its output
+ *          there directly and then pass it to DecimFilt_Process(), rather
+ *          than DecimFilt_Process() copying it in.
+ *
+ * @param   pFilt: Filter instance
+ *
+ * @returns Buffer for up to MaxBlockSize input samples
+ */
+q31_t *DecimFilt_GetInputBuffer(DecimFiltInstanceType *pFilt)
+{
+    return &pFilt->pState[pFilt->NumTaps - 1];
+}
+
+/*
+ * DecimFilt_MacFolded
+ *
+ * @desc    Computes one output accumulator for a symmetric filter, summing
+ *          each mirrored pair of samples before multiplying. Unrolled by 2.
+ *
+ * @param   pFilt: Filter instance
+ * @param   pWindow: First (oldest) of the NumTaps samples in the window
+ *
+ * @returns 64-bit accumulator
+ */
+static q63_t DecimFilt_MacFolded(const DecimFiltInstanceType *pFilt,
+                                 const q31_t *pWindow)
+{
+    const q31_t *pLo = pWindow;
+    const q31_t *pHi = pWindow + pFilt->NumTaps - 1;
+    const q31_t *pCoeff = pFilt->pCoeffs;
+    uint32_t PairCnt = pFilt->NumTaps >> 1;
+    q63_t Acc = 0;
+
+    while (PairCnt >= 2)
+    {
+        Acc += (q63_t)(pLo[0] + pHi[0]) * pCoeff[0];
+        Acc += (q63_t)(pLo[1] + pHi[-1]) * pCoeff[1];
+        pLo += 2;
+        pHi -= 2;
+        pCoeff += 2;
+        PairCnt -= 2;
+    }
+
+    if (PairCnt > 0)
+    {
+        Acc += (q63_t)(*pLo++ + *pHi) * *pCoeff++;
+    }
+
+    // Odd number of taps - centre tap has no partner
+    if (pFilt->NumTaps & 1)
+    {
+        Acc += (q63_t)*pLo * *pCoeff;
+    }
+
+    return Acc;
+}
+
+/*
+ * DecimFilt_MacFoldedSparse
+ *
+ * @desc    As DecimFilt_MacFolded(), but only evaluates the non-zero folded
+ *          taps (e.g. for half-band filters).
+ *
+ * @param   pFilt: Filter instance
+ * @param   pWindow: First (oldest) of the NumTaps samples in the window
+ *
+ * @returns 64-bit accumulator
+ */
+static q63_t DecimFilt_MacFoldedSparse(const DecimFiltInstanceType *pFilt,
+                                       const q31_t *pWindow)
+{
+    const q31_t *pHi = pWindow + pFilt->NumTaps - 1;
+    const q31_t *pCoeffs = pFilt->pCoeffs;
+    uint32_t i;
+    uint32_t Tap;
+    q63_t Acc = 0;
+
+    for (i = 0; i < pFilt->NumNonZeroFoldedTaps; i++)
+    {
+        Tap = pFilt->NonZeroFoldedTaps[i];
+        Acc += (q63_t)(pWindow[Tap] + *(pHi - Tap)) * pCoeffs[Tap];
+    }
+
+    if (pFilt->NumTaps & 1)
+    {
+        Tap = pFilt->NumTaps >> 1;
+        Acc += (q63_t)pWindow[Tap] * pCoeffs[Tap];
+    }
+
+    return Acc;
+}
+
+/*
+ * DecimFilt_Mac
+ *
+ * @desc    Computes one output accumulator for a non-symmetric filter, with
+ *          a plain multiply-accumulate per tap.
+ *          N.B. Coefficients are in time-reversed order, as for
+ *          arm_fir_decimate_q31().
+ *
+ * @param   pFilt: Filter instance
+ * @param   pWindow: First (oldest) of the NumTaps samples in the window
+ *
+ * @returns 64-bit accumulator
+ */
+static q63_t DecimFilt_Mac(const DecimFiltInstanceType *pFilt,
+                           const q31_t *pWindow)
+{
+    const q31_t *pCoeff = pFilt->pCoeffs;
+    uint32_t TapCnt = pFilt->NumTaps;
+    q63_t Acc = 0;
+
+    while (TapCnt > 0)
+    {
+        Acc += (q63_t)*pWindow++ * *pCoeff++;
+        TapCnt--;
+    }
+
+    return Acc;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
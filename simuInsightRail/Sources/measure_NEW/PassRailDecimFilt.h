@@ -0,0 +1,64 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailDecimFilt.h
+ *
+ * Description: Q31 FIR decimation filter engine for the passenger-rail DSP
+ *              chain - a drop-in replacement for arm_fir_decimate_q31()
+ *              which exploits linear-phase coefficient symmetry.
+ */
+
+#ifndef PASSRAILDECIMFILT_H_
+#define PASSRAILDECIMFILT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arm_math.h"
+
+//..............................................................................
+
+// Largest number of taps supported by the engine
+#define DECIMFILT_MAX_TAPS          (150)
+
+typedef struct
+{
+    uint16_t NumTaps;
+    uint8_t Factor;
+    const q31_t *pCoeffs;
+    q31_t *pState;              // (NumTaps + MaxBlockSize - 1) words
+    uint32_t MaxBlockSize;
+
+    // Position in the current decimation period (input samples consumed
+    // modulo Factor), so that input blocks of any length can be streamed
+    uint8_t Phase;
+
+    // Symmetric (linear-phase) filters are folded: each pair of taps with
+    // equal coefficients is summed before the multiply
+    bool bSymmetric;
+
+    // If any folded tap has a zero coefficient (e.g. half-band filters), then
+    // only the non-zero folded taps listed here are evaluated
+    bool bHasZeroTaps;
+    uint8_t NumNonZeroFoldedTaps;
+    uint8_t NonZeroFoldedTaps[DECIMFILT_MAX_TAPS / 2];
+} DecimFiltInstanceType;
+
+//..............................................................................
+
+bool DecimFilt_Init(DecimFiltInstanceType *pFilt, uint16_t NumTaps,
+                    uint8_t Factor, const q31_t *pCoeffs, q31_t *pState,
+                    uint32_t MaxBlockSize);
+q31_t *DecimFilt_GetInputBuffer(DecimFiltInstanceType *pFilt);
+uint32_t DecimFilt_Process(DecimFiltInstanceType *pFilt, const q31_t *pSrc,
+                           uint32_t NumInputSamples, q31_t *pDst);
+
+//..............................................................................
+
+#endif // PASSRAILDECIMFILT_H_
+
+
+#ifdef __cplusplus
+}
+#endif
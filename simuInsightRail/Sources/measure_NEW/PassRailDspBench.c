@@ -0,0 +1,682 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailDspBench.c
+ *
+ * Description: Throughput, numerical quality and golden-output regression
+ *              benchmark for the passenger-rail DSP chains.
+ *
+ * -----------------------------------------------------------------------------
+ * Notes
+ * -----------------------------------------------------------------------------
+ *
+ *     - Only built with CONFIG_PLATFORM_DSPBENCH, which is defined for the
+ *       simulator build (the host build of this project, where arm_math.h
+ *       supplies portable versions of the CMSIS intrinsics). Define it for a
+ *       benchmark build of the target to get cycle counts - see the
+ *       "dspbench" CLI command
+ *
+ *     - Each of the six decimation chains is run with its enveloper, for
+ *       DSPBENCH_NUM_BLOCKS ADC blocks, through the real-time entry point
+ *       PassRailDsp_ProcessAdcBlockMulti() - i.e. starting from raw AD7766
+ *       SPI words, exactly as the measurement task does
+ *
+ *     - The stimulus is either built in (integer-only, so identical on every
+ *       platform), or a recorded ADC capture, e.g. from "sample <n> raw25600"
+ *
+ *     - Throughput: on the target, the DWT cycle counter gives cycles per
+ *       output sample, and the MCU load needed at the chain's ADC rate - this
+ *       is what sizes the MCU clock against the sampling rates. In the
+ *       simulator, only the elapsed time is available
+ *
+ *     - Numerical quality: the same input is run through a double-precision
+ *       model of the chain (DC removal using the DSP's own settled mean,
+ *       rectifier, smoothing filter, both decimation stages), and the SNR of
+ *       the Q31 output relative to it is reported. The decimation chain's
+ *       passband ripple is calculated from the Q31 coefficients
+ *
+ *     - Regression: a digest of each chain's output for the built-in stimulus
+ *       is compared against the golden values in DspBenchChains[]. Any DSP
+ *       change which is meant to be bit-exact must keep these matching; a
+ *       change which deliberately alters the output must update them (after
+ *       checking the SNR and ripple figures)
+ *
+ *     - IMPORTANT: Re-initialises the DSP, so must not be run while sampling
+ *       (the CLI command checks Measure_IsSamplingInProgress())
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "Resources.h"
+#include "arm_math.h"
+#include "AdcApiDefs.h"
+#include "AD7766_DMA.h"
+#include "PassRailDSP.h"
+#include "PassRailDecimFilt.h"
+#include "PassRailDspBench.h"
+
+//******************************************************************************
+#if defined(PASSRAIL_DSP_NEW) && defined(CONFIG_PLATFORM_DSPBENCH)
+//******************************************************************************
+
+#define ARRAY_NUM_ELEMENTS(ArrayName)  (sizeof(ArrayName) / sizeof(ArrayName[0]))
+
+// The smallest overall decimation factor is /8 (/4 then /2)
+#define DSPBENCH_MAX_OUTPUT_SAMPLES  (((DSPBENCH_NUM_BLOCKS * ADC_SAMPLES_PER_BLOCK) / 8) + 2)
+
+// Number of frequencies evaluated across the passband for the ripple
+#define DSPBENCH_RIPPLE_NUM_FREQS    (64)
+
+#define Q31_SCALE                    (2147483648.0)
+
+// Width the chain names are padded to in the printed results
+#define DSPBENCH_NAME_WIDTH          (10)
+
+//..............................................................................
+
+static const struct
+{
+    DecimChainEnum DecimChainID;
+    EnveloperEnum EnveloperID;
+    char *pName;
+    uint32_t AdcSamplesPerSec;
+    uint32_t PassbandHz;            // From the filter designs in PassRailDSP.c
+    uint32_t GoldenNumOutputSamples;
+    uint32_t GoldenDigest;
+} DspBenchChains[] =
+{
+//   DecimChainID            EnveloperID  pName         AdcSps  Passband  Golden outputs & digest
+    {DECIMCHAIN_VIB_1280,    ENV_VIB,     "vib1280",    51200,  500,      199,  0x8A88FE15},
+    {DECIMCHAIN_VIB_2560,    ENV_VIB,     "vib2560",    51200,  1000,     397,  0x7519C9F8},
+    {DECIMCHAIN_VIB_5120,    ENV_VIB,     "vib5120",    51200,  2000,     794,  0x7198B78E},
+    {DECIMCHAIN_WFLATS_256,  ENV_WFLATS,  "wflats256",  10240,  100,      199,  0xFC38E895},
+    {DECIMCHAIN_WFLATS_512,  ENV_WFLATS,  "wflats512",  10240,  200,      397,  0xC151FD87},
+    {DECIMCHAIN_WFLATS_1280, ENV_WFLATS,  "wflats1280", 10240,  500,      992,  0xAD2C8B6B},
+};
+
+typedef struct
+{
+    const int32_t *pRecordedSamples;
+    uint32_t NumRecordedSamples;
+    uint32_t Pos;
+    uint32_t Seed;
+} DspBenchStimulusType;
+
+// Double-precision streaming model of one decimation stage
+typedef struct
+{
+    const int32_t *pCoeffs;
+    uint16_t NumTaps;
+    uint8_t Factor;
+    uint8_t Phase;
+    uint16_t Newest;
+    double History[DECIMFILT_MAX_TAPS];
+} DspBenchRefDecimType;
+
+static uint32_t g_DspBenchAdcBlock[ADC_SAMPLES_PER_BLOCK];
+static int32_t g_DspBenchBlockOut[ADC_SAMPLES_PER_BLOCK];
+static int32_t g_DspBenchOutput[DSPBENCH_MAX_OUTPUT_SAMPLES];
+static DspBenchRefDecimType g_DspBenchRefStage1;
+static DspBenchRefDecimType g_DspBenchRefStage2;
+
+//..............................................................................
+
+static void DspBench_StimulusStart(DspBenchStimulusType *pStimulus,
+                                   const int32_t *pRecordedSamples,
+                                   uint32_t NumRecordedSamples);
+static int32_t DspBench_NextSample(DspBenchStimulusType *pStimulus);
+static uint32_t DspBench_SampleToSpiWord(int32_t Sample);
+static void DspBench_PrintName(const char *pName);
+static void DspBench_TimerStart(void);
+static uint32_t DspBench_TimerStop(float *pSeconds);
+static void DspBench_RefDecimInit(DspBenchRefDecimType *pRef, uint8_t FiltIndex);
+static bool DspBench_RefDecimProcess(DspBenchRefDecimType *pRef, double In,
+                                     double *pOut);
+static float DspBench_PassbandRippleDb(uint8_t Stage1Index,
+                                       uint8_t Stage2Index,
+                                       uint32_t AdcSamplesPerSec,
+                                       uint32_t PassbandHz);
+static double DspBench_FirGain(const int32_t *pCoeffs, uint16_t NumTaps,
+                               double NormFreq);
+
+//..............................................................................
+
+/*
+ * PassRailDspBench_RunAll
+ *
+ * @desc    Runs the benchmark on all six decimation chains, optionally
+ *          printing a line of results per chain.
+ *
+ * @param   pRecordedSamples: Recorded signed ADC samples to use as the
+ *          stimulus (looped as needed), or NULL for the built-in stimulus
+ * @param   NumRecordedSamples: Number of recorded samples
+ * @param   bPrint: true to print the results
+ *
+ * @returns true if every chain ran, and (for the built-in stimulus) every
+ *          output matched its golden digest
+ */
+bool PassRailDspBench_RunAll(const int32_t *pRecordedSamples,
+                             uint32_t NumRecordedSamples, bool bPrint)
+{
+    DspBenchResultType Result;
+    bool bAllOK = true;
+    uint8_t i;
+
+    for (i = 0; i < ARRAY_NUM_ELEMENTS(DspBenchChains); i++)
+    {
+        if (!PassRailDspBench_RunChain(DspBenchChains[i].DecimChainID,
+                                       pRecordedSamples, NumRecordedSamples,
+                                       &Result))
+        {
+            bAllOK = false;
+            if (bPrint)
+            {
+                DspBench_PrintName(DspBenchChains[i].pName);
+                printf("FAILED TO RUN\n");
+            }
+            continue;
+        }
+
+        if ((pRecordedSamples == NULL) && !Result.bGoldenOK)
+        {
+            bAllOK = false;
+        }
+
+        if (bPrint)
+        {
+            DspBench_PrintName(DspBenchChains[i].pName);
+            printf("%u in, %u out, %.3f Msps",
+                   (unsigned int)Result.NumInputSamples,
+                   (unsigned int)Result.NumOutputSamples,
+                   (Result.Seconds > 0.0f) ?
+                       (Result.NumInputSamples / Result.Seconds) / 1.0e6f : 0.0f);
+            if (Result.Cycles != 0)
+            {
+                printf(", %u cycles/out, load %.1f%%",
+                       (unsigned int)Result.CyclesPerOutputSample,
+                       Result.LoadPercent);
+            }
+            printf(", SNR %.1fdB, ripple %.3fdB, digest %08X %s\n",
+                   Result.SnrDb, Result.PassbandRippleDb,
+                   (unsigned int)Result.OutputDigest,
+                   (pRecordedSamples != NULL) ? "(recorded input)" :
+                   (Result.bGoldenOK ? "golden OK" : "GOLDEN MISMATCH"));
+        }
+    }
+
+    return bAllOK;
+}
+
+/*
+ * PassRailDspBench_RunChain
+ *
+ * @desc    Runs DSPBENCH_NUM_BLOCKS ADC blocks through one decimation chain
+ *          (with its enveloper), timing the DSP, then compares the output
+ *          with a double-precision model of the chain.
+ *
+ * @param   DecimChainID: Chain to run
+ * @param   pRecordedSamples: Recorded signed ADC samples to use as the
+ *          stimulus (looped as needed), or NULL for the built-in stimulus
+ * @param   NumRecordedSamples: Number of recorded samples
+ * @param   pResult: RETURNS the results
+ *
+ * @returns true if the chain ran OK
+ */
+bool PassRailDspBench_RunChain(DecimChainEnum DecimChainID,
+                               const int32_t *pRecordedSamples,
+                               uint32_t NumRecordedSamples,
+                               DspBenchResultType *pResult)
+{
+    PassRailDspOutputType Output;
+    DspBenchStimulusType Stimulus;
+    int32_t *pBlocksOut[1];
+    uint32_t NumOut[1];
+    uint32_t Block;
+    uint32_t i;
+    uint8_t ChainIndex;
+    uint8_t Stage1Index;
+    uint8_t Stage2Index;
+    uint32_t NumOutputSamples = 0;
+    uint32_t Elapsed = 0;
+    uint32_t Digest;
+    float Seconds = 0.0f;
+    float BlockSeconds;
+    const int32_t *pEnvCoeffs;
+    int32_t Mean;
+    uint32_t MeanCount;
+    double EnvCoeff0;
+    double EnvCoeff1;
+    double EnvState = 0.0;
+    double Env;
+    double Decim1Out;
+    double Ref;
+    double SignalPower = 0.0;
+    double ErrorPower = 0.0;
+    uint32_t RefIndex = 0;
+
+    memset(pResult, 0, sizeof(*pResult));
+
+    for (ChainIndex = 0; ChainIndex < ARRAY_NUM_ELEMENTS(DspBenchChains); ChainIndex++)
+    {
+        if (DspBenchChains[ChainIndex].DecimChainID == DecimChainID)
+        {
+            break;
+        }
+    }
+    if ((ChainIndex >= ARRAY_NUM_ELEMENTS(DspBenchChains)) ||
+        ((pRecordedSamples != NULL) && (NumRecordedSamples == 0)) ||
+        !PassRailDsp_GetDecimChainFilts(DecimChainID, &Stage1Index, &Stage2Index))
+    {
+        return false;
+    }
+
+    Output.EnveloperID = DspBenchChains[ChainIndex].EnveloperID;
+    Output.DecimChainID = DecimChainID;
+    if (!PassRailDsp_InitMulti(&Output, 1))
+    {
+        return false;
+    }
+
+    //..........................................................................
+    // Timed run through the real-time DSP entry point
+    pBlocksOut[0] = g_DspBenchBlockOut;
+    DspBench_StimulusStart(&Stimulus, pRecordedSamples, NumRecordedSamples);
+    for (Block = 0; Block < DSPBENCH_NUM_BLOCKS; Block++)
+    {
+        for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+        {
+            g_DspBenchAdcBlock[i] = DspBench_SampleToSpiWord(DspBench_NextSample(&Stimulus));
+        }
+
+        DspBench_TimerStart();
+        PassRailDsp_ProcessAdcBlockMulti(g_DspBenchAdcBlock, pBlocksOut, NumOut);
+        Elapsed += DspBench_TimerStop(&BlockSeconds);
+        Seconds += BlockSeconds;
+
+        for (i = 0; (i < NumOut[0]) && (NumOutputSamples < DSPBENCH_MAX_OUTPUT_SAMPLES); i++)
+        {
+            g_DspBenchOutput[NumOutputSamples++] = g_DspBenchBlockOut[i];
+        }
+    }
+
+    pResult->DecimChainID = DecimChainID;
+    pResult->AdcSamplesPerSec = DspBenchChains[ChainIndex].AdcSamplesPerSec;
+    pResult->NumInputSamples = DSPBENCH_NUM_BLOCKS * ADC_SAMPLES_PER_BLOCK;
+    pResult->NumOutputSamples = NumOutputSamples;
+    pResult->Seconds = Seconds;
+    pResult->Cycles = Elapsed;
+    if (NumOutputSamples > 0)
+    {
+        pResult->CyclesPerOutputSample = Elapsed / NumOutputSamples;
+    }
+#ifndef _MSC_VER
+    pResult->LoadPercent = (100.0f * (float)Elapsed * pResult->AdcSamplesPerSec) /
+                           ((float)pResult->NumInputSamples * SystemCoreClock);
+#endif
+
+    // FNV-1a digest of the output samples, byte order independent
+    Digest = 2166136261u;
+    for (i = 0; i < NumOutputSamples; i++)
+    {
+        uint8_t Byte;
+        for (Byte = 0; Byte < 4; Byte++)
+        {
+            Digest ^= (((uint32_t)g_DspBenchOutput[i]) >> (Byte * 8)) & 0xFFu;
+            Digest *= 16777619u;
+        }
+    }
+    pResult->OutputDigest = Digest;
+    pResult->bGoldenOK = (NumOutputSamples == DspBenchChains[ChainIndex].GoldenNumOutputSamples) &&
+                         (Digest == DspBenchChains[ChainIndex].GoldenDigest);
+
+    //..........................................................................
+    // Double-precision model of the same chain, on the same input. The DC
+    // mean is frozen once the DSP has settled, so use the DSP's own value
+    getMeanValues(&Mean, &MeanCount);
+    pEnvCoeffs = PassRailDsp_GetEnvFiltCoeffs(DspBenchChains[ChainIndex].EnveloperID);
+    EnvCoeff0 = pEnvCoeffs[0] / Q31_SCALE;
+    EnvCoeff1 = pEnvCoeffs[1] / Q31_SCALE;
+    DspBench_RefDecimInit(&g_DspBenchRefStage1, Stage1Index);
+    DspBench_RefDecimInit(&g_DspBenchRefStage2, Stage2Index);
+
+    DspBench_StimulusStart(&Stimulus, pRecordedSamples, NumRecordedSamples);
+    for (i = 0; i < pResult->NumInputSamples; i++)
+    {
+        Env = (double)DspBench_NextSample(&Stimulus);
+
+        // The DSP's first 2 blocks are used for settling
+        if (i < (2 * ADC_SAMPLES_PER_BLOCK))
+        {
+            continue;
+        }
+
+        Env = fabs(Env - Mean);
+        Ref = (EnvCoeff0 * Env) + EnvState;
+        EnvState = (EnvCoeff0 * Env) - (EnvCoeff1 * Ref);
+
+        if (DspBench_RefDecimProcess(&g_DspBenchRefStage1, Ref, &Decim1Out) &&
+            DspBench_RefDecimProcess(&g_DspBenchRefStage2, Decim1Out, &Ref) &&
+            (RefIndex < NumOutputSamples))
+        {
+            SignalPower += Ref * Ref;
+            ErrorPower += (g_DspBenchOutput[RefIndex] - Ref) * (g_DspBenchOutput[RefIndex] - Ref);
+            RefIndex++;
+        }
+    }
+
+    if (ErrorPower > 0.0)
+    {
+        pResult->SnrDb = (float)(10.0 * log10(SignalPower / ErrorPower));
+    }
+    else
+    {
+        pResult->SnrDb = 999.0f;
+    }
+
+    pResult->PassbandRippleDb = DspBench_PassbandRippleDb(Stage1Index, Stage2Index,
+                                                          pResult->AdcSamplesPerSec,
+                                                          DspBenchChains[ChainIndex].PassbandHz);
+
+    return (RefIndex == NumOutputSamples);
+}
+
+/*
+ * DspBench_StimulusStart
+ *
+ * @desc    (Re)starts the stimulus sample stream from the beginning.
+ *
+ * @param   pStimulus: Stimulus state
+ * @param   pRecordedSamples: Recorded samples, or NULL for built-in stimulus
+ * @param   NumRecordedSamples: Number of recorded samples
+ *
+ * @returns -
+ */
+static void DspBench_StimulusStart(DspBenchStimulusType *pStimulus,
+                                   const int32_t *pRecordedSamples,
+                                   uint32_t NumRecordedSamples)
+{
+    pStimulus->pRecordedSamples = pRecordedSamples;
+    pStimulus->NumRecordedSamples = NumRecordedSamples;
+    pStimulus->Pos = 0;
+    pStimulus->Seed = 12345;
+}
+
+/*
+ * DspBench_NextSample
+ *
+ * @desc    Gets the next stimulus sample. The built-in stimulus is a DC
+ *          offset, plus a triangle wave, plus pseudo-random noise - all
+ *          integer, so that it's identical on every platform - within the
+ *          AD7766's 24-bit range.
+ *
+ * @param   pStimulus: Stimulus state
+ *
+ * @returns Signed 24-bit sample value
+ */
+static int32_t DspBench_NextSample(DspBenchStimulusType *pStimulus)
+{
+    int32_t Triangle;
+    uint32_t TrianglePhase;
+
+    if (pStimulus->pRecordedSamples != NULL)
+    {
+        return pStimulus->pRecordedSamples[pStimulus->Pos++ % pStimulus->NumRecordedSamples];
+    }
+
+    // 194-sample period triangle, +/-1.5M
+    TrianglePhase = pStimulus->Pos++ % 194;
+    Triangle = (TrianglePhase < 97) ? (int32_t)TrianglePhase : (int32_t)(194 - TrianglePhase);
+    Triangle = (Triangle * 30928) - 1500000;
+
+    pStimulus->Seed = (pStimulus->Seed * 1664525u) + 1013904223u;
+
+    return 200000 + Triangle + (((int32_t)pStimulus->Seed) >> 11);
+}
+
+/*
+ * DspBench_SampleToSpiWord
+ *
+ * @desc    Packs a signed 24-bit sample into a raw AD7766 SPI word, as
+ *          received by the AD7766 driver - see
+ *          AD7766_PreProcessRawSpiIntoSampleVal() for the layout.
+ *
+ * @param   Sample: Signed 24-bit sample
+ *
+ * @returns Raw SPI word
+ */
+static uint32_t DspBench_SampleToSpiWord(int32_t Sample)
+{
+    uint32_t Word24 = ((uint32_t)Sample) & 0x00FFFFFFU;
+
+    return ((Word24 >> 8) & 0x0000FFFFU) | AD7766_SPI_ECHO_BYTE_EXPECTED |
+           ((Word24 & 0xFFU) << 24);
+}
+
+/*
+ * DspBench_PrintName
+ *
+ * @desc    Prints a chain name padded to DSPBENCH_NAME_WIDTH and its
+ *          separator. The padding is done by hand, as printgdf has no
+ *          left-justify flag.
+ *
+ * @param   pName: Chain name
+ *
+ * @returns -
+ */
+static void DspBench_PrintName(const char *pName)
+{
+    size_t Len;
+
+    printf("%s", pName);
+    for (Len = strlen(pName); Len < DSPBENCH_NAME_WIDTH; Len++)
+    {
+        printf(" ");
+    }
+    printf(": ");
+}
+
+/*
+ * DspBench_TimerStart
+ *
+ * @desc    Starts timing - the DWT cycle counter on the target, or the C
+ *          library clock in the simulator.
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+#ifdef _MSC_VER
+static clock_t g_DspBenchStartClock;
+#else
+static uint32_t g_DspBenchStartCycles;
+#endif
+
+static void DspBench_TimerStart(void)
+{
+#ifdef _MSC_VER
+    g_DspBenchStartClock = clock();
+#else
+    // The cycle counter is not reset, the trace points time with it too
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    g_DspBenchStartCycles = DWT->CYCCNT;
+#endif
+}
+
+/*
+ * DspBench_TimerStop
+ *
+ * @desc    Stops timing.
+ *
+ * @param   pSeconds: RETURNS the elapsed time
+ *
+ * @returns Elapsed cycles on the target, 0 in the simulator
+ */
+static uint32_t DspBench_TimerStop(float *pSeconds)
+{
+#ifdef _MSC_VER
+    *pSeconds = (float)(clock() - g_DspBenchStartClock) / CLOCKS_PER_SEC;
+    return 0;
+#else
+    uint32_t Cycles = DWT->CYCCNT - g_DspBenchStartCycles;
+
+    *pSeconds = (float)Cycles / SystemCoreClock;
+    return Cycles;
+#endif
+}
+
+/*
+ * DspBench_RefDecimInit
+ *
+ * @desc    Initialises a double-precision model of a decimation stage.
+ *
+ * @param   pRef: Model state
+ * @param   FiltIndex: Filter index for PassRailDsp_GetDecimFilt()
+ *
+ * @returns -
+ */
+static void DspBench_RefDecimInit(DspBenchRefDecimType *pRef, uint8_t FiltIndex)
+{
+    uint32_t BlockSize;
+
+    memset(pRef, 0, sizeof(*pRef));
+    PassRailDsp_GetDecimFilt(FiltIndex, &pRef->pCoeffs, &pRef->NumTaps,
+                             &pRef->Factor, &BlockSize);
+}
+
+/*
+ * DspBench_RefDecimProcess
+ *
+ * @desc    Feeds one sample into a decimation stage model. As for
+ *          arm_fir_decimate_q31(), an output is produced on the first sample
+ *          of each decimation period, using the coefficients in time-reversed
+ *          order.
+ *
+ * @param   pRef: Model state
+ * @param   In: Input sample
+ * @param   pOut: RETURNS the output sample, if there is one
+ *
+ * @returns true if an output sample was produced
+ */
+static bool DspBench_RefDecimProcess(DspBenchRefDecimType *pRef, double In,
+                                     double *pOut)
+{
+    uint16_t k;
+    uint16_t Pos;
+    double Acc = 0.0;
+    bool bOutput = (pRef->Phase == 0);
+
+    pRef->Newest = (pRef->Newest + 1) % pRef->NumTaps;
+    pRef->History[pRef->Newest] = In;
+    pRef->Phase = (pRef->Phase + 1) % pRef->Factor;
+
+    if (bOutput)
+    {
+        // Oldest sample in the window first
+        Pos = pRef->Newest;
+        for (k = 0; k < pRef->NumTaps; k++)
+        {
+            Pos = (Pos + 1) % pRef->NumTaps;
+            Acc += pRef->History[Pos] * (pRef->pCoeffs[k] / Q31_SCALE);
+        }
+        *pOut = Acc;
+    }
+
+    return bOutput;
+}
+
+/*
+ * DspBench_PassbandRippleDb
+ *
+ * @desc    Calculates the peak-to-peak passband ripple of a 2-stage
+ *          decimation chain, from its Q31 coefficients.
+ *
+ * @param   Stage1Index: Stage 1 filter index for PassRailDsp_GetDecimFilt()
+ * @param   Stage2Index: Stage 2 filter index
+ * @param   AdcSamplesPerSec: Stage 1 input sampling rate
+ * @param   PassbandHz: Passband upper edge
+ *
+ * @returns Ripple in dB
+ */
+static float DspBench_PassbandRippleDb(uint8_t Stage1Index,
+                                       uint8_t Stage2Index,
+                                       uint32_t AdcSamplesPerSec,
+                                       uint32_t PassbandHz)
+{
+    const int32_t *pCoeffs1;
+    const int32_t *pCoeffs2;
+    uint16_t NumTaps1;
+    uint16_t NumTaps2;
+    uint8_t Factor1;
+    uint8_t Factor2;
+    uint32_t BlockSize;
+    uint32_t i;
+    double Freq;
+    double Gain;
+    double MinGain = 1.0e9;
+    double MaxGain = 0.0;
+
+    PassRailDsp_GetDecimFilt(Stage1Index, &pCoeffs1, &NumTaps1, &Factor1, &BlockSize);
+    PassRailDsp_GetDecimFilt(Stage2Index, &pCoeffs2, &NumTaps2, &Factor2, &BlockSize);
+
+    for (i = 0; i <= DSPBENCH_RIPPLE_NUM_FREQS; i++)
+    {
+        Freq = ((double)PassbandHz * i) / DSPBENCH_RIPPLE_NUM_FREQS;
+        Gain = DspBench_FirGain(pCoeffs1, NumTaps1, Freq / AdcSamplesPerSec) *
+               DspBench_FirGain(pCoeffs2, NumTaps2,
+                                (Freq * Factor1) / AdcSamplesPerSec);
+        if (Gain < MinGain)
+        {
+            MinGain = Gain;
+        }
+        if (Gain > MaxGain)
+        {
+            MaxGain = Gain;
+        }
+    }
+
+    return (float)(20.0 * log10(MaxGain / MinGain));
+}
+
+/*
+ * DspBench_FirGain
+ *
+ * @desc    Calculates the magnitude response of a Q31 FIR filter.
+ *
+ * @param   pCoeffs: Coefficients
+ * @param   NumTaps: Number of coefficients
+ * @param   NormFreq: Frequency as a fraction of the sampling rate
+ *
+ * @returns Linear gain
+ */
+static double DspBench_FirGain(const int32_t *pCoeffs, uint16_t NumTaps,
+                               double NormFreq)
+{
+    const double TwoPi = 6.283185307179586;
+    double Re = 0.0;
+    double Im = 0.0;
+    uint16_t k;
+
+    for (k = 0; k < NumTaps; k++)
+    {
+        Re += (pCoeffs[k] / Q31_SCALE) * cos(TwoPi * NormFreq * k);
+        Im -= (pCoeffs[k] / Q31_SCALE) * sin(TwoPi * NormFreq * k);
+    }
+
+    return sqrt((Re * Re) + (Im * Im));
+}
+
+//******************************************************************************
+#endif // PASSRAIL_DSP_NEW && CONFIG_PLATFORM_DSPBENCH
+//******************************************************************************
+
+
+#ifdef __cplusplus
+}
+#endif
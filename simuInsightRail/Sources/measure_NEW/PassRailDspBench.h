@@ -0,0 +1,73 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailDspBench.h
+ *
+ * Description: Throughput, numerical quality and golden-output regression
+ *              benchmark for the passenger-rail DSP chains.
+ */
+
+#ifndef PASSRAILDSPBENCH_H_
+#define PASSRAILDSPBENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Resources.h"
+#include "configFeatures.h"
+#include "PassRailDSP.h"
+
+//******************************************************************************
+#if defined(PASSRAIL_DSP_NEW) && defined(CONFIG_PLATFORM_DSPBENCH)
+//******************************************************************************
+
+// Number of ADC blocks fed through each chain, including the DSP's DC
+// settling blocks
+#define DSPBENCH_NUM_BLOCKS         (64)
+
+typedef struct
+{
+    DecimChainEnum DecimChainID;
+    uint32_t AdcSamplesPerSec;
+    uint32_t NumInputSamples;
+    uint32_t NumOutputSamples;
+
+    // Processing time of the whole run. Cycles are only available on the
+    // target (DWT cycle counter), and are 0 in the simulator
+    float Seconds;
+    uint32_t Cycles;
+    uint32_t CyclesPerOutputSample;
+    // Share of the MCU needed to keep up with the chain's ADC rate
+    float LoadPercent;
+
+    // Output vs. a double-precision reference of the same chain
+    float SnrDb;
+    // Decimation chain passband ripple, from the Q31 coefficients
+    float PassbandRippleDb;
+
+    // Digest of the output samples, and whether it matches the stored golden
+    // output (only for the built-in stimulus)
+    uint32_t OutputDigest;
+    bool bGoldenOK;
+} DspBenchResultType;
+
+//..............................................................................
+
+bool PassRailDspBench_RunChain(DecimChainEnum DecimChainID,
+                               const int32_t *pRecordedSamples,
+                               uint32_t NumRecordedSamples,
+                               DspBenchResultType *pResult);
+bool PassRailDspBench_RunAll(const int32_t *pRecordedSamples,
+                             uint32_t NumRecordedSamples, bool bPrint);
+
+//******************************************************************************
+#endif // PASSRAIL_DSP_NEW && CONFIG_PLATFORM_DSPBENCH
+//******************************************************************************
+
+#endif // PASSRAILDSPBENCH_H_
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,540 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailFeatures.c
+ *
+ * Description: Streaming waveform feature extraction.
+ *
+ * -----------------------------------------------------------------------------
+ * Notes
+ * -----------------------------------------------------------------------------
+ *
+ *     - Fed with each block of output samples as it is written to the sample
+ *       buffer (see xTaskMeasure.c), so that the features are ready as soon
+ *       as sampling finishes, without another pass over the waveform
+ *
+ *     - Statistics: each block's mean and central moment sums are calculated
+ *       in single precision (2 passes over the block, with the samples
+ *       normalised to +/-1.0 so that 4th powers can't overflow), then merged
+ *       into the running double precision sums using the pairwise update
+ *       formulas of Chan et al. / Pebay - so there's little double precision
+ *       work per sample, and no loss of precision from large DC offsets
+ *
+ *     - Spectrum: Welch method - Hann-windowed FEATURES_FFT_LEN frames with
+ *       50% overlap, each with its own mean removed, and the power spectra
+ *       summed. Band, order and peak features are derived from the averaged
+ *       spectrum only when the results are requested, so that the wheel
+ *       rotation rate measured after sampling can be used for the orders
+ *
+ *     - RAM: the frames are read back from the waveform buffer the samples
+ *       are stored in, rather than copied per output, and the real-valued
+ *       frame is transformed as a complex FFT of half the length, so the
+ *       shared working buffers are only FEATURES_FFT_LEN values in all
+ *
+ *     - Energies are scaled so that they sum to the waveform's variance
+ *       (Parseval), so they're directly comparable with Rms
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "PassRailFeatures.h"
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+
+//..............................................................................
+
+#define FEATURES_Q31_SCALE          (2147483648.0f)
+#define FEATURES_PI                 (3.14159265358979f)
+
+// Sum of the squared Hann window values, for FEATURES_FFT_LEN points
+#define FEATURES_HANN_POWER_SUM     ((3.0f * FEATURES_FFT_LEN) / 8.0f)
+
+// Complex FFT length of the half-length real transform
+#define FEATURES_HALF_LEN           (FEATURES_FFT_LEN / 2)
+
+// cos(2 * pi * k / FEATURES_FFT_LEN) for k = 0 to FEATURES_FFT_LEN/2 - 1,
+// also used for the sines and the Hann window
+static float g_FeaturesCosTable[FEATURES_FFT_LEN / 2];
+static bool g_bFeaturesCosTableReady = false;
+
+// FFT working buffers, shared between all feature states - the even frame
+// samples in the real parts and the odd ones in the imaginary parts
+static float g_FeaturesFftRe[FEATURES_HALF_LEN];
+static float g_FeaturesFftIm[FEATURES_HALF_LEN];
+
+//..............................................................................
+
+static void Features_AddSamples(FeaturesStateType *pState,
+                                const int32_t *pSamples, uint32_t NumSamples);
+static void Features_AddFrame(FeaturesStateType *pState,
+                              const int32_t *pWaveform, uint32_t WaveformLen,
+                              uint32_t FrameStart);
+static float Features_Cos(uint32_t k);
+static float Features_Sin(uint32_t k);
+static void Features_Fft(float *pRe, float *pIm);
+
+//..............................................................................
+
+/*
+ * PassRailFeatures_Init
+ *
+ * @desc    Initialises a feature state, ready for a new waveform.
+ *
+ * @param   pState: Feature state
+ *
+ * @returns -
+ */
+void PassRailFeatures_Init(FeaturesStateType *pState)
+{
+    uint32_t k;
+
+    memset(pState, 0, sizeof(*pState));
+    pState->NextFrameEnd = FEATURES_FFT_LEN;
+
+    if (!g_bFeaturesCosTableReady)
+    {
+        for (k = 0; k < (FEATURES_FFT_LEN / 2); k++)
+        {
+            g_FeaturesCosTable[k] = cosf((2.0f * FEATURES_PI * k) / FEATURES_FFT_LEN);
+        }
+        g_bFeaturesCosTableReady = true;
+    }
+}
+
+/*
+ * PassRailFeatures_ProcessBlock
+ *
+ * @desc    Adds the newest samples of a waveform to the features. The waveform
+ *          is held in a buffer used as a ring, sample n at
+ *          pWaveform[n % WaveformLen], and the spectrum frames are read back
+ *          from it - so it must still hold the FEATURES_FFT_LEN - 1 samples
+ *          before the new ones.
+ *
+ * @param   pState: Feature state
+ * @param   pWaveform: Waveform buffer
+ * @param   WaveformLen: Waveform buffer length, at least NumSamples +
+ *          FEATURES_FFT_LEN - 1 (for a buffer holding the whole waveform, any
+ *          length which doesn't wrap it)
+ * @param   NumSamples: Number of new samples - any number
+ *
+ * @returns -
+ */
+void PassRailFeatures_ProcessBlock(FeaturesStateType *pState,
+                                   const int32_t *pWaveform,
+                                   uint32_t WaveformLen,
+                                   uint32_t NumSamples)
+{
+    uint32_t Index;
+    uint32_t Run;
+
+    if (NumSamples == 0)
+    {
+        return;
+    }
+
+    // The new samples, as up to 2 runs either side of the end of the ring
+    Index = pState->NumSamples % WaveformLen;
+    while (NumSamples > 0)
+    {
+        Run = WaveformLen - Index;
+        if (Run > NumSamples)
+        {
+            Run = NumSamples;
+        }
+        Features_AddSamples(pState, &pWaveform[Index], Run);
+        NumSamples -= Run;
+        Index = 0;
+    }
+
+    // The frames they complete
+    while (pState->NumSamples >= pState->NextFrameEnd)
+    {
+        Features_AddFrame(pState, pWaveform, WaveformLen,
+                          pState->NextFrameEnd - FEATURES_FFT_LEN);
+        pState->NextFrameEnd += FEATURES_FFT_LEN / 2;
+    }
+}
+
+/*
+ * PassRailFeatures_GetResults
+ *
+ * @desc    Calculates the features of the waveform so far. Doesn't change the
+ *          state, so can be called at any time.
+ *
+ * @param   pState: Feature state
+ * @param   SamplesPerSec: Sampling rate of the waveform
+ * @param   WheelHz: Wheel rotation rate, or 0 if unknown
+ * @param   pFeatures: RETURNS the features
+ *
+ * @returns true if OK, false if no samples, or invalid sampling rate
+ */
+bool PassRailFeatures_GetResults(const FeaturesStateType *pState,
+                                 uint32_t SamplesPerSec, float WheelHz,
+                                 FeaturesType *pFeatures)
+{
+    uint32_t Bin;
+    uint32_t Index;
+    uint32_t p;
+    float BinHz;
+    float BinFreq;
+    float Energy;
+    float Scale;
+    double Variance;
+    double MeanSquare;
+
+    memset(pFeatures, 0, sizeof(*pFeatures));
+
+    if ((pState->NumSamples == 0) || (SamplesPerSec == 0))
+    {
+        return false;
+    }
+
+    //..........................................................................
+    // Statistics
+    Variance = pState->M2 / pState->NumSamples;
+    MeanSquare = Variance + (pState->Mean * pState->Mean);
+
+    pFeatures->NumSamples = pState->NumSamples;
+    pFeatures->Mean = (float)(pState->Mean * FEATURES_Q31_SCALE);
+    pFeatures->Rms = (float)(sqrt(MeanSquare) * FEATURES_Q31_SCALE);
+    pFeatures->Peak = (float)pState->PeakAbs;
+    if (pFeatures->Rms > 0.0f)
+    {
+        pFeatures->CrestFactor = pFeatures->Peak / pFeatures->Rms;
+    }
+    if (pState->M2 > 0.0)
+    {
+        pFeatures->Kurtosis = (float)((pState->NumSamples * pState->M4) / (pState->M2 * pState->M2));
+    }
+
+    //..........................................................................
+    // Spectral features, from the averaged one-sided power spectrum
+    pFeatures->WheelHz = WheelHz;
+    if (pState->NumFrames == 0)
+    {
+        return true;
+    }
+
+    BinHz = (float)SamplesPerSec / FEATURES_FFT_LEN;
+    Scale = (FEATURES_Q31_SCALE * FEATURES_Q31_SCALE) /
+            (pState->NumFrames * FEATURES_FFT_LEN * FEATURES_HANN_POWER_SUM);
+
+    for (Bin = 1; Bin < FEATURES_NUM_BINS; Bin++)
+    {
+        // Both sides of the spectrum, except at Nyquist
+        Energy = pState->PowerSum[Bin] * Scale * ((Bin < (FEATURES_NUM_BINS - 1)) ? 2.0f : 1.0f);
+        BinFreq = Bin * BinHz;
+
+        Index = (Bin * FEATURES_NUM_BANDS) / (FEATURES_FFT_LEN / 2);
+        pFeatures->BandEnergy[(Index < FEATURES_NUM_BANDS) ? Index : (FEATURES_NUM_BANDS - 1)] += Energy;
+
+        if (WheelHz > 0.0f)
+        {
+            // Order k covers (k - 0.5) to (k + 0.5) x wheel rotation rate
+            Index = (uint32_t)((BinFreq / WheelHz) + 0.5f);
+            if ((Index >= 1) && (Index <= FEATURES_NUM_ORDERS))
+            {
+                pFeatures->OrderEnergy[Index - 1] += Energy;
+            }
+        }
+
+        // Local maxima, kept sorted largest first
+        if ((Bin < (FEATURES_NUM_BINS - 1)) &&
+            (pState->PowerSum[Bin] > pState->PowerSum[Bin - 1]) &&
+            (pState->PowerSum[Bin] >= pState->PowerSum[Bin + 1]))
+        {
+            for (p = FEATURES_NUM_PEAKS; (p > 0) && (Energy > pFeatures->PeakEnergy[p - 1]); p--)
+            {
+                if (p < FEATURES_NUM_PEAKS)
+                {
+                    pFeatures->PeakEnergy[p] = pFeatures->PeakEnergy[p - 1];
+                    pFeatures->PeakHz[p] = pFeatures->PeakHz[p - 1];
+                }
+            }
+            if (p < FEATURES_NUM_PEAKS)
+            {
+                pFeatures->PeakEnergy[p] = Energy;
+                pFeatures->PeakHz[p] = BinFreq;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Features_AddSamples
+ *
+ * @desc    Adds contiguous samples to the peak and the central moment sums.
+ *
+ * @param   pState: Feature state
+ * @param   pSamples: Samples
+ * @param   NumSamples: Number of samples, > 0
+ *
+ * @returns -
+ */
+static void Features_AddSamples(FeaturesStateType *pState,
+                                const int32_t *pSamples, uint32_t NumSamples)
+{
+    uint32_t i;
+    uint32_t Abs;
+    int64_t Sum = 0;
+    float BlockMean;
+    float Dev;
+    float Dev2;
+    float BlockM2 = 0.0f;
+    float BlockM3 = 0.0f;
+    float BlockM4 = 0.0f;
+    double NumA;
+    double NumB;
+    double Num;
+    double Delta;
+    double Delta2;
+
+    // Pass 1: peak and block mean
+    for (i = 0; i < NumSamples; i++)
+    {
+        Abs = (pSamples[i] < 0) ? (0U - (uint32_t)pSamples[i]) : (uint32_t)pSamples[i];
+        if (Abs > pState->PeakAbs)
+        {
+            pState->PeakAbs = Abs;
+        }
+
+        Sum += pSamples[i];
+    }
+    BlockMean = (float)(((double)Sum / NumSamples) / FEATURES_Q31_SCALE);
+
+    // Pass 2: block central moment sums
+    for (i = 0; i < NumSamples; i++)
+    {
+        Dev = ((float)pSamples[i] / FEATURES_Q31_SCALE) - BlockMean;
+        Dev2 = Dev * Dev;
+        BlockM2 += Dev2;
+        BlockM3 += Dev2 * Dev;
+        BlockM4 += Dev2 * Dev2;
+    }
+
+    // Merge into the running sums
+    NumA = pState->NumSamples;
+    NumB = NumSamples;
+    Num = NumA + NumB;
+    Delta = BlockMean - pState->Mean;
+    Delta2 = Delta * Delta;
+
+    pState->M4 += BlockM4 +
+                  ((Delta2 * Delta2 * NumA * NumB * ((NumA * NumA) - (NumA * NumB) + (NumB * NumB))) / (Num * Num * Num)) +
+                  ((6.0 * Delta2 * ((NumA * NumA * BlockM2) + (NumB * NumB * pState->M2))) / (Num * Num)) +
+                  ((4.0 * Delta * ((NumA * BlockM3) - (NumB * pState->M3))) / Num);
+    pState->M3 += BlockM3 +
+                  ((Delta2 * Delta * NumA * NumB * (NumA - NumB)) / (Num * Num)) +
+                  ((3.0 * Delta * ((NumA * BlockM2) - (NumB * pState->M2))) / Num);
+    pState->M2 += BlockM2 + ((Delta2 * NumA * NumB) / Num);
+    pState->Mean += (Delta * NumB) / Num;
+    pState->NumSamples += NumSamples;
+}
+
+/*
+ * Features_AddFrame
+ *
+ * @desc    Adds the power spectrum of a frame of the waveform to the sum. The
+ *          frame's FEATURES_FFT_LEN real samples x[n] are transformed as the
+ *          FEATURES_HALF_LEN point complex sequence z[m] = x[2m] + i.x[2m+1],
+ *          whose spectrum Z[k] is then split into the even and odd sample
+ *          spectra to give X[k] = E[k] + exp(-2.pi.i.k/N).O[k], with
+ *          E[k] = (Z[k] + Z*[N/2-k]) / 2 and O[k] = (Z[k] - Z*[N/2-k]) / 2i.
+ *
+ * @param   pState: Feature state
+ * @param   pWaveform: Waveform buffer, as for PassRailFeatures_ProcessBlock()
+ * @param   WaveformLen: Waveform buffer length
+ * @param   FrameStart: Waveform sample number of the first frame sample
+ *
+ * @returns -
+ */
+static void Features_AddFrame(FeaturesStateType *pState,
+                              const int32_t *pWaveform, uint32_t WaveformLen,
+                              uint32_t FrameStart)
+{
+    uint32_t n;
+    uint32_t k;
+    uint32_t Index;
+    int64_t Sum = 0;
+    float Mean;
+    float ZRe;
+    float ZIm;
+    float ZcRe;
+    float ZcIm;
+    float ERe;
+    float EIm;
+    float ORe;
+    float OIm;
+    float WRe;
+    float WIm;
+    float XRe;
+    float XIm;
+
+    Index = FrameStart % WaveformLen;
+    for (n = 0; n < FEATURES_FFT_LEN; n++)
+    {
+        Sum += pWaveform[Index];
+        if (++Index >= WaveformLen)
+        {
+            Index = 0;
+        }
+    }
+    Mean = (float)((double)Sum / FEATURES_FFT_LEN);
+
+    // Hann window: 0.5 - 0.5 * cos(2 * pi * n / N), even samples to the real
+    // parts and odd samples to the imaginary parts
+    Index = FrameStart % WaveformLen;
+    for (n = 0; n < FEATURES_FFT_LEN; n++)
+    {
+        XRe = (((float)pWaveform[Index] - Mean) / FEATURES_Q31_SCALE) *
+              (0.5f - (0.5f * Features_Cos(n)));
+        if ((n & 1) == 0)
+        {
+            g_FeaturesFftRe[n >> 1] = XRe;
+        }
+        else
+        {
+            g_FeaturesFftIm[n >> 1] = XRe;
+        }
+        if (++Index >= WaveformLen)
+        {
+            Index = 0;
+        }
+    }
+
+    Features_Fft(g_FeaturesFftRe, g_FeaturesFftIm);
+
+    for (k = 0; k < FEATURES_NUM_BINS; k++)
+    {
+        ZRe = g_FeaturesFftRe[k % FEATURES_HALF_LEN];
+        ZIm = g_FeaturesFftIm[k % FEATURES_HALF_LEN];
+        ZcRe = g_FeaturesFftRe[(FEATURES_HALF_LEN - k) % FEATURES_HALF_LEN];
+        ZcIm = -g_FeaturesFftIm[(FEATURES_HALF_LEN - k) % FEATURES_HALF_LEN];
+
+        ERe = 0.5f * (ZRe + ZcRe);
+        EIm = 0.5f * (ZIm + ZcIm);
+        ORe = 0.5f * (ZIm - ZcIm);
+        OIm = 0.5f * (ZcRe - ZRe);
+
+        WRe = Features_Cos(k);
+        WIm = -Features_Sin(k);
+        XRe = ERe + (WRe * ORe) - (WIm * OIm);
+        XIm = EIm + (WRe * OIm) + (WIm * ORe);
+
+        pState->PowerSum[k] += (XRe * XRe) + (XIm * XIm);
+    }
+    pState->NumFrames++;
+}
+
+/*
+ * Features_Cos
+ *
+ * @desc    cos(2 * pi * k / FEATURES_FFT_LEN), from the table.
+ *
+ * @param   k: 0 to FEATURES_FFT_LEN - 1
+ *
+ * @returns Cosine
+ */
+static float Features_Cos(uint32_t k)
+{
+    if (k < (FEATURES_FFT_LEN / 2))
+    {
+        return g_FeaturesCosTable[k];
+    }
+    return -g_FeaturesCosTable[k - (FEATURES_FFT_LEN / 2)];
+}
+
+/*
+ * Features_Sin
+ *
+ * @desc    sin(2 * pi * k / FEATURES_FFT_LEN), from the cosine table.
+ *
+ * @param   k: 0 to FEATURES_FFT_LEN/2
+ *
+ * @returns Sine
+ */
+static float Features_Sin(uint32_t k)
+{
+    if (k < (FEATURES_FFT_LEN / 4))
+    {
+        return g_FeaturesCosTable[(FEATURES_FFT_LEN / 4) - k];
+    }
+    return g_FeaturesCosTable[k - (FEATURES_FFT_LEN / 4)];
+}
+
+/*
+ * Features_Fft
+ *
+ * @desc    In-place radix-2 decimation-in-time FFT of FEATURES_HALF_LEN
+ *          points.
+ *
+ * @param   pRe: Real parts
+ * @param   pIm: Imaginary parts
+ *
+ * @returns -
+ */
+static void Features_Fft(float *pRe, float *pIm)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t Bit;
+    uint32_t Len;
+    uint32_t Half;
+    uint32_t Step;
+    uint32_t k;
+    float Tmp;
+    float WRe;
+    float WIm;
+    float TRe;
+    float TIm;
+
+    // Bit-reversed reordering
+    for (i = 1, j = 0; i < FEATURES_HALF_LEN; i++)
+    {
+        for (Bit = FEATURES_HALF_LEN >> 1; (j & Bit) != 0; Bit >>= 1)
+        {
+            j ^= Bit;
+        }
+        j |= Bit;
+        if (i < j)
+        {
+            Tmp = pRe[i]; pRe[i] = pRe[j]; pRe[j] = Tmp;
+            Tmp = pIm[i]; pIm[i] = pIm[j]; pIm[j] = Tmp;
+        }
+    }
+
+    // Butterflies, with twiddle factors exp(-2 * pi * i * j / Len), i.e.
+    // cosine table entries j * FEATURES_FFT_LEN / Len
+    for (Len = 2; Len <= FEATURES_HALF_LEN; Len <<= 1)
+    {
+        Half = Len >> 1;
+        Step = FEATURES_FFT_LEN / Len;
+        for (i = 0; i < FEATURES_HALF_LEN; i += Len)
+        {
+            for (j = 0, k = 0; j < Half; j++, k += Step)
+            {
+                WRe = g_FeaturesCosTable[k];
+                WIm = -Features_Sin(k);
+                TRe = (WRe * pRe[i + j + Half]) - (WIm * pIm[i + j + Half]);
+                TIm = (WRe * pIm[i + j + Half]) + (WIm * pRe[i + j + Half]);
+                pRe[i + j + Half] = pRe[i + j] - TRe;
+                pIm[i + j + Half] = pIm[i + j] - TIm;
+                pRe[i + j] += TRe;
+                pIm[i + j] += TIm;
+            }
+        }
+    }
+}
+
+#endif // CONFIG_PLATFORM_WAVE_FEATURES
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * PassRailFeatures.h
+ *
+ * Description: Streaming waveform feature extraction - statistics and a
+ *              Welch-averaged spectrum, computed incrementally while the
+ *              samples are captured.
+ */
+
+#ifndef PASSRAILFEATURES_H_
+#define PASSRAILFEATURES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configFeatures.h"
+
+//..............................................................................
+
+// FFT length (power of 2) - frames overlap by half. 512 gives order
+// resolution of about 1 bin per order at the highest output rates
+#define FEATURES_FFT_LEN            (512)
+#define FEATURES_NUM_BINS           ((FEATURES_FFT_LEN / 2) + 1)
+
+// Equal-width frequency bands from 0Hz to the Nyquist frequency
+#define FEATURES_NUM_BANDS          (4)
+// Wheel rotation orders 1 to FEATURES_NUM_ORDERS
+#define FEATURES_NUM_ORDERS         (4)
+// Largest spectral peaks
+#define FEATURES_NUM_PEAKS          (4)
+
+// Streaming state - samples are normalised to +/-1.0 (i.e. Q31) internally.
+// The frames are read back from the caller's waveform buffer, so there's no
+// per-output copy of them
+typedef struct
+{
+    uint32_t NumSamples;
+    uint32_t PeakAbs;
+
+    // Central moment sums, merged block by block
+    double Mean;
+    double M2;
+    double M3;
+    double M4;
+
+    // Sample count at which the next frame is complete, and the sum of the
+    // frames' power spectra
+    uint32_t NextFrameEnd;
+    uint16_t NumFrames;
+    float PowerSum[FEATURES_NUM_BINS];
+} FeaturesStateType;
+
+// Features, in sample units
+typedef struct
+{
+    uint32_t NumSamples;
+    float Mean;
+    float Rms;
+    float Peak;
+    float CrestFactor;
+    float Kurtosis;             // Non-excess, i.e. 3.0 for Gaussian noise
+
+    // Mean-square of the waveform (after DC removal) in each band / around
+    // each order. Orders are all zero if the wheel rotation rate is unknown
+    float BandEnergy[FEATURES_NUM_BANDS];
+    float OrderEnergy[FEATURES_NUM_ORDERS];
+    float WheelHz;
+
+    // Largest spectral peaks, largest first (frequency 0 if none)
+    float PeakHz[FEATURES_NUM_PEAKS];
+    float PeakEnergy[FEATURES_NUM_PEAKS];
+} FeaturesType;
+
+//..............................................................................
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+void PassRailFeatures_Init(FeaturesStateType *pState);
+void PassRailFeatures_ProcessBlock(FeaturesStateType *pState,
+                                   const int32_t *pWaveform,
+                                   uint32_t WaveformLen,
+                                   uint32_t NumSamples);
+bool PassRailFeatures_GetResults(const FeaturesStateType *pState,
+                                 uint32_t SamplesPerSec, float WheelHz,
+                                 FeaturesType *pFeatures);
+#endif // CONFIG_PLATFORM_WAVE_FEATURES
+
+#endif // PASSRAILFEATURES_H_
+
+
+#ifdef __cplusplus
+}
+#endif
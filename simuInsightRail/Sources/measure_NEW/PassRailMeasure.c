@@ -157,6 +157,29 @@ AnalogFiltEnum PassRailMeasure_GetAnalogFiltForMeasId(tMeasId MeasId)
     return ANALOGFILT_UNDEFINED;
 }
 
+/*
+ * PassRailMeasure_MeasIdsShareCapture
+ *
+ * @desc    Checks whether two measurement IDs can be produced from the same
+ *          ADC capture, i.e. whether they use the same analog filter setting
+ *          and ADC sampling rate (they can then differ only in their
+ *          enveloper and decimation chain).
+ *
+ * @param   MeasId1, MeasId2: Measurement IDs to compare
+ *
+ * @returns true if both IDs exist in the table and share a capture, false
+ *          otherwise
+ */
+bool PassRailMeasure_MeasIdsShareCapture(tMeasId MeasId1, tMeasId MeasId2)
+{
+    uint32_t AdcSps1 = PassRailMeasure_GetAdcSpsForMeasId(MeasId1);
+
+    return ((AdcSps1 != 0) &&
+            (AdcSps1 == PassRailMeasure_GetAdcSpsForMeasId(MeasId2)) &&
+            (PassRailMeasure_GetAnalogFiltForMeasId(MeasId1) ==
+             PassRailMeasure_GetAnalogFiltForMeasId(MeasId2)));
+}
+
 /*
  * PassRailMeasure_PrepareSampling
  *
@@ -176,24 +199,81 @@ AnalogFiltEnum PassRailMeasure_GetAnalogFiltForMeasId(tMeasId MeasId)
 bool PassRailMeasure_PrepareSampling(tMeasId MeasId,
                                      uint32_t *pAdcSamplesPerSecRet,
                                      uint32_t *pDspAdcSettlingSamplesRet)
+{
+    return PassRailMeasure_PrepareSamplingMulti(&MeasId, 1,
+                                                pAdcSamplesPerSecRet,
+                                                pDspAdcSettlingSamplesRet);
+}
+
+/*
+ * PassRailMeasure_PrepareSamplingMulti
+ *
+ * @desc    As PassRailMeasure_PrepareSampling(), but for a single ADC capture
+ *          which produces several output streams (one per measurement ID).
+ *          All the measurement IDs must share the same analog filter and ADC
+ *          sampling rate - see PassRailMeasure_MeasIdsShareCapture(). The
+ *          DSP settling time returned is the longest of the chains.
+ *
+ * @param   pMeasIds: Array of measurement IDs
+ * @param   NumMeasIds: 1 to PASSRAILDSP_MAX_OUTPUTS
+ * @param   *pAdcSamplesPerSecRet: Filled with return value of ADC samples/sec
+ *          required
+ * @param   *pDspSettlingSamplesRet: Filled with return value of # of DSP
+ *          settling samples required
+ *
+ * @returns true if successful, false otherwise
+ */
+bool PassRailMeasure_PrepareSamplingMulti(const tMeasId *pMeasIds,
+                                          uint8_t NumMeasIds,
+                                          uint32_t *pAdcSamplesPerSecRet,
+                                          uint32_t *pDspAdcSettlingSamplesRet)
 {
     uint8_t i;
-    uint8_t MeasTableIndex;
+    uint8_t Output;
+    uint8_t MeasTableIndex[PASSRAILDSP_MAX_OUTPUTS];
+    PassRailDspOutputType DspOutputs[PASSRAILDSP_MAX_OUTPUTS];
+    uint32_t DspAdcSettlingSamples = 0;
     bool bOK;
 
-    bOK = false;
-    for (i = 0; i < (sizeof(MeasTable) / sizeof(MeasTable[0])); i++)
+    *pAdcSamplesPerSecRet = 0;
+    *pDspAdcSettlingSamplesRet = 0;
+
+    if ((NumMeasIds == 0) || (NumMeasIds > PASSRAILDSP_MAX_OUTPUTS))
     {
-        if (MeasTable[i].MeasId == MeasId)
+        return false;
+    }
+
+    bOK = true;
+    for (Output = 0; bOK && (Output < NumMeasIds); Output++)
+    {
+        bOK = false;
+        for (i = 0; i < (sizeof(MeasTable) / sizeof(MeasTable[0])); i++)
         {
-            bOK = true;
-            MeasTableIndex = i;
-            break;
+            if (MeasTable[i].MeasId == pMeasIds[Output])
+            {
+                bOK = true;
+                MeasTableIndex[Output] = i;
+                break;
+            }
+        }
+
+        // All outputs must come from the same analog front-end setup
+        if (bOK && (Output > 0))
+        {
+            bOK = PassRailMeasure_MeasIdsShareCapture(pMeasIds[0], pMeasIds[Output]);
+        }
+
+        if (bOK)
+        {
+            DspOutputs[Output].EnveloperID = MeasTable[MeasTableIndex[Output]].EnveloperID;
+            DspOutputs[Output].DecimChainID = MeasTable[MeasTableIndex[Output]].DecimChainID;
+            if (MeasTable[MeasTableIndex[Output]].DspAdcSettlingSamples > DspAdcSettlingSamples)
+            {
+                DspAdcSettlingSamples = MeasTable[MeasTableIndex[Output]].DspAdcSettlingSamples;
+            }
         }
     }
 
-    *pAdcSamplesPerSecRet = 0;
-    *pDspAdcSettlingSamplesRet = 0;
     if (bOK)
     {
         bOK = false;
@@ -202,16 +282,15 @@ bool PassRailMeasure_PrepareSampling(tMeasId MeasId,
         powerAnalogOn();
     	// REV4 hardware requires double the gain
     	AnalogGainSelect(Device_GetHardwareVersion() >= HW_PASSRAIL_REV4);
-        if (AnalogFiltSelect(MeasTable[MeasTableIndex].AnalogFiltID))
+        if (AnalogFiltSelect(MeasTable[MeasTableIndex[0]].AnalogFiltID))
         {
             // Op-amp signal chain settling delay - allow 500ms (according to HW engineers)
             vTaskDelay(500 / portTICK_PERIOD_MS);
 
-            *pAdcSamplesPerSecRet = MeasTable[MeasTableIndex].ADCSamplesPerSec;
-            *pDspAdcSettlingSamplesRet = MeasTable[MeasTableIndex].DspAdcSettlingSamples;
+            *pAdcSamplesPerSecRet = MeasTable[MeasTableIndex[0]].ADCSamplesPerSec;
+            *pDspAdcSettlingSamplesRet = DspAdcSettlingSamples;
 
-            bOK = PassRailDsp_Init(MeasTable[MeasTableIndex].EnveloperID,
-                                   MeasTable[MeasTableIndex].DecimChainID);
+            bOK = PassRailDsp_InitMulti(DspOutputs, NumMeasIds);
         }
     }
 
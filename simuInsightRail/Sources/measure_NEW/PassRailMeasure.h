@@ -47,6 +47,11 @@ typedef enum
 bool PassRailMeasure_PrepareSampling(tMeasId MeasId,
                                      uint32_t *pAdcSamplesPerSecRet,
                                      uint32_t *pDspAdcSettlingSamplesRet);
+bool PassRailMeasure_PrepareSamplingMulti(const tMeasId *pMeasIds,
+                                          uint8_t NumMeasIds,
+                                          uint32_t *pAdcSamplesPerSecRet,
+                                          uint32_t *pDspAdcSettlingSamplesRet);
+bool PassRailMeasure_MeasIdsShareCapture(tMeasId MeasId1, tMeasId MeasId2);
 void PassRailMeasure_PostSampling(void);
 uint32_t PassRailMeasure_GetAdcSpsForMeasId(tMeasId MeasId);
 AnalogFiltEnum PassRailMeasure_GetAnalogFiltForMeasId(tMeasId MeasId);
@@ -27,12 +27,20 @@ extern "C" {
 #include "AdcApiDefs.h"
 #include "AD7766_DMA.h"
 #include "PowerControl.h"
+#include "configFeatures.h"
+#include "PassRailFeatures.h"
+#include "Trace.h"
 
 #ifdef PASSRAIL_DSP_NEW
 #include "PassRailDSP.h"
 #else
 #include "PassRailDSP_MVP.h"
 #endif
+
+#if (MEASURE_MAX_OUTPUTS > PASSRAILDSP_MAX_OUTPUTS) && defined(PASSRAIL_DSP_NEW)
+#error "BUILD ERROR: MEASURE_MAX_OUTPUTS is larger than PASSRAILDSP_MAX_OUTPUTS"
+#endif
+
 #ifdef FCC_TEST_BUILD
 #include "FCCTest/FccTest.h"
 #endif
@@ -88,10 +96,12 @@ static long AdcBlockTimerID = 0;
 static struct
 {
     bool bRawAdcSampling;
-    tMeasId MeasId;
-    uint32_t NumOutputSamples;
+    uint8_t NumOutputs;
+    tMeasId MeasIds[MEASURE_MAX_OUTPUTS];
+    uint32_t NumOutputSamples[MEASURE_MAX_OUTPUTS];
     uint32_t AdcSamplesPerSecIfRawAdc;
     tMeasureCallback pMeasureCallback;
+    tMeasureSegmentCallback pSegmentCallback;   // NULL unless streamed
 } g_MeasurementRequest;
 
 static bool g_bMeasureSamplingIsInProgress = false;
@@ -100,9 +110,23 @@ static bool g_bMeasureSamplingIsInProgress = false;
 // samples are internally handled as ADC_SAMPLES_PER_BLOCK samples at a time)
 static uint32_t g_DspSettlingNumAdcSamples = 0;
 
-static uint32_t g_OutputSampleCount = 0;
+// Per-output sample counts, and start offsets of each output's region in
+// g_pSampleBuffer[] (outputs are laid out back-to-back). A streamed output
+// instead cycles through two segments at the start of g_pSampleBuffer[]
+static uint32_t g_OutputSampleCount[MEASURE_MAX_OUTPUTS];
+static uint32_t g_OutputBufOffset[MEASURE_MAX_OUTPUTS];
 
-static int32_t g_DspOutSampleBuf[ADC_SAMPLES_PER_BLOCK];
+static int32_t g_DspOutSampleBuf[MEASURE_MAX_OUTPUTS][ADC_SAMPLES_PER_BLOCK];
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+// Waveform features of each output, updated as its samples are stored (the
+// spectrum frames are read back from g_pSampleBuffer[], so a streamed
+// output's two segments must hold a segment and a frame)
+#if (MEASURE_STREAM_SEGMENT_SAMPLES < (FEATURES_FFT_LEN - 1))
+#error "MEASURE_STREAM_SEGMENT_SAMPLES too small for the feature frames"
+#endif
+static FeaturesStateType g_OutputFeatures[MEASURE_MAX_OUTPUTS];
+#endif
 
 static volatile MeasureErrorEnum g_MeasureError = MEASUREERROR_NONE;
 static volatile uint16_t g_MeasureErrorBlockNum = 0;
@@ -113,10 +137,18 @@ static void HandleMeasureStart(void);
 static void HandleMeasureAdcRealTimeBlock(uint32_t *pAdcBlock);
 static void HandleMeasureAdcBlockTimeout(void);
 
+static bool Measure_QueueStart(bool bRawAdcSampling,
+                               const tMeasId *pMeasIds,
+                               const uint32_t *pNumOutputSamples,
+                               uint8_t NumOutputs,
+                               uint32_t AdcSamplesPerSecIfRawAdc,
+                               tMeasureSegmentCallback pSegmentCallback,
+                               tMeasureCallback pCallback);
 static void Measure_CallbackCall(void);
-static bool Measure_ConvertAdcBlockToSampleBlock(uint32_t *pAdcBlockIn,
-                                                 int32_t *pSampleBlockOut);
-static bool Measure_DoRealTimeDSPToOutputBuf(int32_t *pSampleBlock);
+static uint32_t Measure_OutputBufIndex(uint8_t Output, uint32_t *pRoom);
+static bool Measure_StreamSamplesStored(void);
+static bool Measure_DoRealTimeDSPToOutputBuf(uint32_t *pAdcBlock,
+                                             bool bRawSpiWords);
 static void Measure_AdcISRCallback(tAdcBlockData AdcBlockData);
 static void AdcBlockTimeoutCallback(TimerHandle_t pxTimer);
 static void Measure_SetError(MeasureErrorEnum MeasureError);
@@ -250,10 +282,156 @@ bool Measure_Start(bool bRawAdcSampling,
                    uint32_t NumOutputSamples,
                    uint32_t AdcSamplesPerSecIfRawAdc,
                    tMeasureCallback pCallback) // TODO: Callback is hacky for now - improve eventually
+{
+    return Measure_QueueStart(bRawAdcSampling, &MeasId, &NumOutputSamples, 1,
+                              AdcSamplesPerSecIfRawAdc, NULL, pCallback);
+}
+
+/*
+ * Measure_StartMulti
+ *
+ * @desc    Requests an immediate start of a single ADC capture which produces
+ *          several output streams at once, one per measurement ID - e.g. the
+ *          same vibration capture run through several decimation chains.
+ *          All the measurement IDs must share the same analog filter and ADC
+ *          sampling rate (see PassRailMeasure_MeasIdsShareCapture()).
+ *          The outputs are written back-to-back into g_pSampleBuffer[] - use
+ *          Measure_GetOutputBuffer() to find each one after completion.
+ *          Sampling completes when every output has its requested samples.
+ *
+ * @param   pMeasIds: Array of NumOutputs measurement IDs
+ * @param   pNumOutputSamples: Array of NumOutputs output sample counts
+ * @param   NumOutputs: 1 to MEASURE_MAX_OUTPUTS
+ * @param   pCallBackFunc: Pointer to sampling-complete callback with
+ *          tMeasureCallback signature
+ *
+ * @returns true if the measurement request is accepted and queued, false for
+ *          any error
+ */
+bool Measure_StartMulti(const tMeasId *pMeasIds,
+                        const uint32_t *pNumOutputSamples,
+                        uint8_t NumOutputs,
+                        tMeasureCallback pCallback)
+{
+    return Measure_QueueStart(false, pMeasIds, pNumOutputSamples, NumOutputs,
+                              0, NULL, pCallback);
+}
+
+/*
+ * Measure_StartStreamed
+ *
+ * @desc    Requests an immediate start of a single-output measurement whose
+ *          samples are handed on while sampling, so the number of samples is
+ *          not limited by the sample buffer size. The output is stored in two
+ *          segments of MEASURE_STREAM_SEGMENT_SAMPLES in g_pSampleBuffer[]
+ *          in turn, and pSegmentCallback is called (from the measurement
+ *          task) as each one fills, and for the final part-filled one - it
+ *          must have finished with a segment by the time the other segment
+ *          is full, e.g. by queueing it to the external flash task.
+ *          Measure_GetOutputBuffer() is not available for a streamed output.
+ *
+ * @param   MeasId: Measurement ID of type tMeasId
+ * @param   NumOutputSamples: Number of output samples required
+ * @param   pSegmentCallback: Pointer to segment callback with
+ *          tMeasureSegmentCallback signature
+ * @param   pCallBackFunc: Pointer to sampling-complete callback with
+ *          tMeasureCallback signature
+ *
+ * @returns true if the measurement request is accepted and queued, false for
+ *          any error
+ */
+bool Measure_StartStreamed(tMeasId MeasId,
+                           uint32_t NumOutputSamples,
+                           tMeasureSegmentCallback pSegmentCallback,
+                           tMeasureCallback pCallback)
+{
+    if (pSegmentCallback == NULL)
+    {
+        return false;
+    }
+
+    return Measure_QueueStart(false, &MeasId, &NumOutputSamples, 1, 0,
+                              pSegmentCallback, pCallback);
+}
+
+/*
+ * Measure_GetOutputBuffer
+ *
+ * @desc    Gets the start of an output stream's samples in g_pSampleBuffer[],
+ *          for the most recent Measure_Start() / Measure_StartMulti().
+ *
+ * @param   OutputIndex: Index of the output, in the order the measurement IDs
+ *          were passed to Measure_StartMulti()
+ *
+ * @returns Pointer to the output's first sample, or NULL if no such output
+ *          (or if streamed)
+ */
+int32_t *Measure_GetOutputBuffer(uint8_t OutputIndex)
+{
+    if ((OutputIndex >= g_MeasurementRequest.NumOutputs) ||
+        (g_MeasurementRequest.pSegmentCallback != NULL))
+    {
+        return NULL;
+    }
+
+    return &g_pSampleBuffer[g_OutputBufOffset[OutputIndex]];
+}
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+/*
+ * Measure_GetOutputFeatures
+ *
+ * @desc    Gets the waveform features of an output stream, which are
+ *          calculated while sampling, for the most recent Measure_Start() /
+ *          Measure_StartMulti().
+ *
+ * @param   OutputIndex: Index of the output, in the order the measurement IDs
+ *          were passed to Measure_StartMulti()
+ * @param   SamplesPerSec: The output's sampling rate
+ * @param   WheelHz: Wheel rotation rate for the order features, or 0 if
+ *          unknown
+ * @param   pFeatures: RETURNS the features
+ *
+ * @returns true if OK, false if no such output or no samples
+ */
+bool Measure_GetOutputFeatures(uint8_t OutputIndex, uint32_t SamplesPerSec,
+                               float WheelHz, FeaturesType *pFeatures)
+{
+    if (OutputIndex >= g_MeasurementRequest.NumOutputs)
+    {
+        return false;
+    }
+
+    return PassRailFeatures_GetResults(&g_OutputFeatures[OutputIndex],
+                                       SamplesPerSec, WheelHz, pFeatures);
+}
+#endif // CONFIG_PLATFORM_WAVE_FEATURES
+
+/*
+ * Measure_QueueStart
+ *
+ * @desc    Common implementation of Measure_Start(), Measure_StartMulti()
+ *          and Measure_StartStreamed(). Validates and stores the request, then
+ *          queues the start event.
+ *
+ * @param   See Measure_Start(), Measure_StartMulti() and
+ *          Measure_StartStreamed()
+ *
+ * @returns true if the measurement request is accepted and queued, false for
+ *          any error
+ */
+static bool Measure_QueueStart(bool bRawAdcSampling,
+                               const tMeasId *pMeasIds,
+                               const uint32_t *pNumOutputSamples,
+                               uint8_t NumOutputs,
+                               uint32_t AdcSamplesPerSecIfRawAdc,
+                               tMeasureSegmentCallback pSegmentCallback,
+                               tMeasureCallback pCallback)
 {
     bool rval = false;
     tMeasureEvent startMeasureEvent;
     uint32_t i;
+    uint32_t TotalOutputSamples = 0;
 
 #ifdef SAMPLING_EXEC_TIME_EN
     g_nStartSamplingTick = xTaskGetTickCount();
@@ -268,6 +446,24 @@ bool Measure_Start(bool bRawAdcSampling,
     //*********************************************
     //*********************************************
 
+    // Raw ADC sampling bypasses the DSP, so can only have a single output,
+    // as can streaming. Unless streamed, the outputs must all fit in the
+    // sample buffer together.
+    if ((NumOutputs == 0) || (NumOutputs > MEASURE_MAX_OUTPUTS) ||
+        ((bRawAdcSampling || (pSegmentCallback != NULL)) && (NumOutputs != 1)))
+    {
+        return false;
+    }
+    for (i = 0; i < NumOutputs; i++)
+    {
+        TotalOutputSamples += pNumOutputSamples[i];
+    }
+    if ((pSegmentCallback == NULL) &&
+        (TotalOutputSamples > SAMPLE_BUFFER_SIZE_WORDS))
+    {
+        return false;
+    }
+
 #if 0
     // TODO
 
@@ -299,10 +495,18 @@ bool Measure_Start(bool bRawAdcSampling,
 
     // Store the sampling request parameters
     g_MeasurementRequest.bRawAdcSampling = bRawAdcSampling;
-    g_MeasurementRequest.MeasId = MeasId;
-    g_MeasurementRequest.NumOutputSamples = NumOutputSamples;
+    g_MeasurementRequest.NumOutputs = NumOutputs;
+    TotalOutputSamples = 0;
+    for (i = 0; i < NumOutputs; i++)
+    {
+        g_MeasurementRequest.MeasIds[i] = pMeasIds[i];
+        g_MeasurementRequest.NumOutputSamples[i] = pNumOutputSamples[i];
+        g_OutputBufOffset[i] = TotalOutputSamples;
+        TotalOutputSamples += pNumOutputSamples[i];
+    }
     g_MeasurementRequest.AdcSamplesPerSecIfRawAdc = AdcSamplesPerSecIfRawAdc;
     g_MeasurementRequest.pMeasureCallback = pCallback;
+    g_MeasurementRequest.pSegmentCallback = pSegmentCallback;
 
     // Create measurement start event (only a simple trigger event, doesn't
     // contain any data)
@@ -334,13 +538,21 @@ bool Measure_Start(bool bRawAdcSampling,
  */
 static void HandleMeasureStart(void)
 {
-    g_OutputSampleCount = 0;
     uint32_t AdcSamplesPerSec;
     uint32_t BlockTimeoutMillisecs;
+    uint8_t i;
     bool bOK;
 
     // N.B. All required sampling request parameters are in g_MeasurementRequest
 
+    for (i = 0; i < MEASURE_MAX_OUTPUTS; i++)
+    {
+        g_OutputSampleCount[i] = 0;
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+        PassRailFeatures_Init(&g_OutputFeatures[i]);
+#endif
+    }
+
     bOK = true;
     g_DspSettlingNumAdcSamples = 0;
     if (!g_MeasurementRequest.bRawAdcSampling)
@@ -348,9 +560,10 @@ static void HandleMeasureStart(void)
         // Normal signal chain sampling - perform pre-sampling setup
         // (includes analog hardware power, gain & filter setup), and get
         // required ADC samples/sec and # of DSP settling samples
-        bOK = PassRailMeasure_PrepareSampling(g_MeasurementRequest.MeasId,
-                                              &AdcSamplesPerSec,
-                                              &g_DspSettlingNumAdcSamples);
+        bOK = PassRailMeasure_PrepareSamplingMulti(g_MeasurementRequest.MeasIds,
+                                                   g_MeasurementRequest.NumOutputs,
+                                                   &AdcSamplesPerSec,
+                                                   &g_DspSettlingNumAdcSamples);
 //#define TESTSIGNALGEORGE
 #ifdef TESTSIGNALGEORGE
         // testsignal injection init by george
@@ -422,6 +635,8 @@ static void HandleMeasureAdcRealTimeBlock(uint32_t *pAdcBlock)
 
     if (g_bMeasureSamplingIsInProgress)
     {
+        TRACE_ENTER(TRACE_ADC_BLOCK);
+
         //***************************************
         // TODO: FOR TESTING ONLY
         //GPIO_DRV_SetPinOutput(TEST_IO2);
@@ -432,20 +647,13 @@ static void HandleMeasureAdcRealTimeBlock(uint32_t *pAdcBlock)
             void calcSimulAmSignal(uint32_t samples, int32_t * out);
             calcSimulAmSignal(ADC_SAMPLES_PER_BLOCK, pAdcBlock);
         }
+        bStopSampling = Measure_DoRealTimeDSPToOutputBuf(pAdcBlock, false);
 #else
-        // Convert the raw uint32_t Adc words received over SPI into clean sample
-        // values - can do in-place in the ping-pong buffers to save RAM - need to
-        // typecast buffer to int32_t
-        if (!Measure_ConvertAdcBlockToSampleBlock(pAdcBlock,
-                                                  (int32_t *)pAdcBlock))
-        {
-            Measure_SetError(MEASUREERROR_ADC_TO_SAMPLE_BLOCK_CONVERT);
-            // N.B. Do NOT stop sampling here if error, because want waveform for
-            // error diagnostics
-        }
+        // Convert the raw uint32_t Adc words received over SPI into clean
+        // sample values and perform real-time DSP on them - the conversion is
+        // fused into the DSP's first pass, in-place in the ping-pong buffers
+        bStopSampling = Measure_DoRealTimeDSPToOutputBuf(pAdcBlock, true);
 #endif
-        // Perform real-time DSP on the sample block (typecasting needed again)
-        bStopSampling = Measure_DoRealTimeDSPToOutputBuf((int32_t *)pAdcBlock);
 
         //***************************************
         // TODO: FOR TESTING ONLY
@@ -479,6 +687,8 @@ static void HandleMeasureAdcRealTimeBlock(uint32_t *pAdcBlock)
             // Call callback (higher-level task must then call Measure_GetErrorInfo())
             Measure_CallbackCall();
         }
+
+        TRACE_EXIT(TRACE_ADC_BLOCK);
     }
 }
 
@@ -513,6 +723,22 @@ static void HandleMeasureAdcBlockTimeout(void)
     }
 }
 
+/*
+ * Measure_IsSamplingInProgress
+ *
+ * @desc    Indicates whether the ADC is sampling, i.e. from the start of
+ *          sampling until the last block has been processed or sampling is
+ *          aborted.
+ *
+ * @param   -
+ *
+ * @returns true while sampling
+ */
+bool Measure_IsSamplingInProgress(void)
+{
+    return g_bMeasureSamplingIsInProgress;
+}
+
 /*
  * Measure_CallbackCall
  *
@@ -576,102 +802,104 @@ bool Measure_GetErrorInfo(MeasureErrorInfoType *pMeasureErrorInfo)
 
 
 /*
- * Measure_ConvertAdcBlockToSampleBlock
+ * Measure_DoRealTimeDSPToOutputBuf
  *
- * @desc    Converts a block of raw ADC SPI input words into signed sample
- *          values, and checks that the AD7766 SPI echo bytes in the block are
- *          all OK. Input and output blocks can be the same buffer if required,
- *          but would need typecasting.
+ * @desc    Performs the required real-time DSP on pAdcBlock of size
+ *          ADC_SAMPLES_PER_BLOCK, and appends each output chain's samples to
+ *          its region of the sample buffer (or, if streamed, to its current
+ *          segment, handing on each segment as it fills).
+ *          Where an output's region has room for a whole block's worth of
+ *          samples, the DSP writes straight into it, otherwise (and while
+ *          settling) it writes into g_DspOutSampleBuf[] and the samples are
+ *          copied across up to the requested number. The stored samples
+ *          are also added to the output's waveform features.
  *
- * @param   pAdcBlockIn: Block of unsigned uint32_t raw ADC input words
- *          pSampleBlockOut: Block of signed int32_t clean sample value outputs
+ * @param   pAdcBlock: Block of samples to process - overwritten in-place
+ * @param   bRawSpiWords: true if pAdcBlock holds raw AD7766 SPI words,
+ *          which are converted (and checked) as part of the DSP, or false if
+ *          it already holds signed sample values
  *
- * @returns true if all OK, false if problem
+ * @returns true once every output has its requested number of samples, or
+ *          the samples can't be stored, false otherwise
  */
-static bool Measure_ConvertAdcBlockToSampleBlock(uint32_t *pAdcBlockIn,
-                                                 int32_t *pSampleBlockOut)
+static bool Measure_DoRealTimeDSPToOutputBuf(uint32_t *pAdcBlock,
+                                             bool bRawSpiWords)
 {
     uint32_t i;
-    bool bOK = true;
+    uint8_t Output;
+    bool bRequestedOutputSamplesDone = false;
+    bool bConvertOK = true;
+    bool bDirectToSampleBuf[MEASURE_MAX_OUTPUTS];
+    uint32_t NumOutputSamples[MEASURE_MAX_OUTPUTS] = {0};
+    int32_t *pDspOutSampleBufs[MEASURE_MAX_OUTPUTS];
+    uint32_t BufIndex;
+    uint32_t BufRoom;
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+    uint32_t PrevSampleCount;
+#endif
+    bool bStoreFailed = false;
+    const bool bStreamed = (g_MeasurementRequest.pSegmentCallback != NULL);
 
-#if 1
-    for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+    // Choose each output's DSP output buffer
+    for (Output = 0; Output < MEASURE_MAX_OUTPUTS; Output++)
     {
-        if (!AD7766_PreProcessRawSpiIntoSampleVal(pAdcBlockIn[i],
-                                                  &(pSampleBlockOut[i])))
+        bDirectToSampleBuf[Output] = false;
+        pDspOutSampleBufs[Output] = g_DspOutSampleBuf[Output];
+
+        if ((g_DspSettlingNumAdcSamples == 0) &&
+            (Output < g_MeasurementRequest.NumOutputs))
         {
-            bOK = false;
-            // N.B. Do NOT break here - still want waveform for error diagnosis
+            BufIndex = Measure_OutputBufIndex(Output, &BufRoom);
+            if (((g_MeasurementRequest.NumOutputSamples[Output] -
+                  g_OutputSampleCount[Output]) >= ADC_SAMPLES_PER_BLOCK) &&
+                (BufRoom >= ADC_SAMPLES_PER_BLOCK))
+            {
+                bDirectToSampleBuf[Output] = true;
+                pDspOutSampleBufs[Output] = &g_pSampleBuffer[BufIndex];
+            }
         }
     }
-#else
-
-    // TODO: george :when sample rates become higher, then consider this for speed
-    // loop unrolling the adc format conversion
-    uint32_t NumSamples = ADC_SAMPLES_PER_BLOCK;
-    i=0;
-    while (NumSamples >= 4 ) {
-        // just an experiment by george
-        union u16i32 { uint16_t u16[2];
-              int32_t i32;
-        } tmp;
-        tmp.i32 = (int32_t) pAdcBlockIn[i];
-        pSampleBlockOut[i++] = ((int32_t)  (tmp.i32<<16) | (int32_t) (tmp.u16[1] /* & 0xff00 */))>>8  ;
-        tmp.i32 = (int32_t) pAdcBlockIn[i];
-        pSampleBlockOut[i++] = ((int32_t)  (tmp.i32<<16) | (int32_t) (tmp.u16[1] /* & 0xff00 */))>>8  ;
-        tmp.i32 = (int32_t) pAdcBlockIn[i];
-        pSampleBlockOut[i++] = ((int32_t)  (tmp.i32<<16) | (int32_t) (tmp.u16[1] /* & 0xff00 */))>>8  ;
-        tmp.i32 = (int32_t) pAdcBlockIn[i];
-        pSampleBlockOut[i++] = ((int32_t)  (tmp.i32<<16) | (int32_t) (tmp.u16[1] /* & 0xff00 */))>>8  ;
-        NumSamples -=4 ;
-    }
-    while (NumSamples) {
-         // just an experiment by george
-         union u16i32 { uint16_t u16[2];
-               int32_t i32;
-         } tmp;
-         tmp.i32 = (int32_t) pAdcBlockIn[i];
-         pSampleBlockOut[i++] = ((int32_t)  (tmp.i32<<16) | (int32_t) (tmp.u16[1] /* & 0xff00 */))>>8  ;
-         NumSamples -= 1;
-    }
-
-#endif
-
-    return bOK;
-}
-
-/*
- * Measure_DoRealTimeDSPToOutputBuf
- *
- * @desc    Performs the required real-time DSP on pSampleBlock of size
- *          ADC_SAMPLES_PER_BLOCK.
- *
- * @param   pSampleBlock: Block of samples to process
- *
- * @returns true if ADC_SAMPLES_PER_BLOCK samples have been successfully
- *          processed, false if overruns the sample output buffer
- */
-static bool Measure_DoRealTimeDSPToOutputBuf(int32_t *pSampleBlock)
-{
-    uint32_t i;
-    bool bRequestedOutputSamplesDone = false;
-    uint32_t NumOutputSamples = 0;
 
-    // Process input samples into DSP sample buffer
+    // Process input samples into DSP sample buffers
     if (!g_MeasurementRequest.bRawAdcSampling)
     {
         // Normal measurement-ID-based sampling, so do DSP
-        PassRailDsp_ProcessBlock(pSampleBlock, g_DspOutSampleBuf,
-                                 &NumOutputSamples);
+        if (bRawSpiWords)
+        {
+            bConvertOK = PassRailDsp_ProcessAdcBlockMulti(pAdcBlock,
+                                                          pDspOutSampleBufs,
+                                                          NumOutputSamples);
+        }
+        else
+        {
+            PassRailDsp_ProcessBlockMulti((int32_t *)pAdcBlock,
+                                          pDspOutSampleBufs, NumOutputSamples);
+        }
     }
     else
     {
         // Raw AD7766 sampling - do NOT do DSP
-        for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+        if (bRawSpiWords)
+        {
+            bConvertOK = AD7766_PreProcessRawSpiBlock(pAdcBlock,
+                                                      pDspOutSampleBufs[0], 0,
+                                                      ADC_SAMPLES_PER_BLOCK);
+        }
+        else
         {
-            g_DspOutSampleBuf[i] = pSampleBlock[i];
+            for (i = 0; i < ADC_SAMPLES_PER_BLOCK; i++)
+            {
+                pDspOutSampleBufs[0][i] = (int32_t)pAdcBlock[i];
+            }
         }
-        NumOutputSamples = ADC_SAMPLES_PER_BLOCK;
+        NumOutputSamples[0] = ADC_SAMPLES_PER_BLOCK;
+    }
+
+    if (!bConvertOK)
+    {
+        Measure_SetError(MEASUREERROR_ADC_TO_SAMPLE_BLOCK_CONVERT);
+        // N.B. Do NOT stop sampling here if error, because want waveform for
+        // error diagnostics
     }
 
     // If in DSP settling time then ignore sampling block, otherwise write
@@ -690,39 +918,165 @@ static bool Measure_DoRealTimeDSPToOutputBuf(int32_t *pSampleBlock)
     }
     else
     {
-        // Transfer DSP sample buffer into output sample buffer
-        for (i = 0; i < NumOutputSamples; i++)
-        {
-            if (g_OutputSampleCount < SAMPLE_BUFFER_SIZE_WORDS)  // Buffer overrun protection
-            {
-                g_pSampleBuffer[g_OutputSampleCount] = g_DspOutSampleBuf[i];
+        bRequestedOutputSamplesDone = true;
 
-                g_OutputSampleCount++;
-                if (g_OutputSampleCount >= g_MeasurementRequest.NumOutputSamples)
-	                {
-                    bRequestedOutputSamplesDone = true;
-#ifdef SAMPLING_EXEC_TIME_EN
-                    g_nStopSamplingTick = xTaskGetTickCount();
+        for (Output = 0; Output < g_MeasurementRequest.NumOutputs; Output++)
+        {
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+            PrevSampleCount = g_OutputSampleCount[Output];
 #endif
-                    break;
+
+            if (bDirectToSampleBuf[Output])
+            {
+                // Samples are already in place (N.B. they can at most
+                // complete a streamed segment, not cross into the next)
+                g_OutputSampleCount[Output] += NumOutputSamples[Output];
+                if (bStreamed)
+                {
+                    bStoreFailed = !Measure_StreamSamplesStored();
                 }
             }
             else
             {
-                // ERROR: Sample buffer overrun
-                // ******************** TODO: Indicate this error
-                // NOTE: The following lines might not yet be correct - just
-                // dumped here for now
-                // bRequestedOutputSamplesDone = true;
-                // g_SamplingResultCode = SAMPLINGRESULT_RAW_SAMPLE_BUFFER_OVERRUN;
-                break;
+                // Transfer DSP sample buffer into output sample buffer,
+                // stopping each output once it has its requested samples
+                for (i = 0; (i < NumOutputSamples[Output]) && !bStoreFailed &&
+                            (g_OutputSampleCount[Output] < g_MeasurementRequest.NumOutputSamples[Output]); i++)
+                {
+                    BufIndex = Measure_OutputBufIndex(Output, &BufRoom);
+                    if (BufRoom > 0)  // Buffer overrun protection
+                    {
+                        g_pSampleBuffer[BufIndex] = g_DspOutSampleBuf[Output][i];
+                        g_OutputSampleCount[Output]++;
+                        if (bStreamed)
+                        {
+                            bStoreFailed = !Measure_StreamSamplesStored();
+                        }
+                    }
+                    else
+                    {
+                        // Can't happen, as the request is checked against the
+                        // sample buffer size, but don't hang waiting for
+                        // samples which can't be stored
+                        Measure_SetError(MEASUREERROR_SAMPLE_BUFFER_OVERRUN);
+                        bStoreFailed = true;
+                    }
+                }
+            }
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+            // Update the output's features with its newly-stored samples
+            // (a streamed output's features are updated segment by segment)
+            if (!bStreamed)
+            {
+                PassRailFeatures_ProcessBlock(&g_OutputFeatures[Output],
+                                              &g_pSampleBuffer[g_OutputBufOffset[Output]],
+                                              g_MeasurementRequest.NumOutputSamples[Output],
+                                              g_OutputSampleCount[Output] - PrevSampleCount);
+            }
+#endif
+
+            if (g_OutputSampleCount[Output] < g_MeasurementRequest.NumOutputSamples[Output])
+            {
+                bRequestedOutputSamplesDone = false;
             }
         }
+
+        if (bStoreFailed)
+        {
+            // Stop sampling - the error has been recorded
+            bRequestedOutputSamplesDone = true;
+        }
+
+#ifdef SAMPLING_EXEC_TIME_EN
+        if (bRequestedOutputSamplesDone)
+        {
+            g_nStopSamplingTick = xTaskGetTickCount();
+        }
+#endif
     }
 
     return bRequestedOutputSamplesDone;
 }
 
+/*
+ * Measure_OutputBufIndex
+ *
+ * @desc    Gets where an output's next sample is stored in g_pSampleBuffer[],
+ *          and how many samples can be stored contiguously from there.
+ *
+ * @param   Output: Output index
+ * @param   pRoom: RETURNS the number of samples there is room for - up to the
+ *          end of the current segment if streamed, otherwise up to the end of
+ *          the sample buffer
+ *
+ * @returns Index in g_pSampleBuffer[]
+ */
+static uint32_t Measure_OutputBufIndex(uint8_t Output, uint32_t *pRoom)
+{
+    uint32_t BufIndex;
+
+    if (g_MeasurementRequest.pSegmentCallback != NULL)
+    {
+        BufIndex = g_OutputSampleCount[Output] % (2 * MEASURE_STREAM_SEGMENT_SAMPLES);
+        *pRoom = MEASURE_STREAM_SEGMENT_SAMPLES -
+                 (g_OutputSampleCount[Output] % MEASURE_STREAM_SEGMENT_SAMPLES);
+    }
+    else
+    {
+        BufIndex = g_OutputBufOffset[Output] + g_OutputSampleCount[Output];
+        *pRoom = (BufIndex < SAMPLE_BUFFER_SIZE_WORDS) ?
+                 (SAMPLE_BUFFER_SIZE_WORDS - BufIndex) : 0;
+    }
+
+    return BufIndex;
+}
+
+/*
+ * Measure_StreamSamplesStored
+ *
+ * @desc    Called as samples are stored for a streamed output - hands on the
+ *          current segment if it is now full, or if the output is complete,
+ *          and adds it to the output's waveform features.
+ *
+ * @param   -
+ *
+ * @returns true if OK, false if the segment callback failed to take the
+ *          segment (sampling must then stop)
+ */
+static bool Measure_StreamSamplesStored(void)
+{
+    const uint32_t SampleCount = g_OutputSampleCount[0];
+    const bool bFinal = (SampleCount >= g_MeasurementRequest.NumOutputSamples[0]);
+    uint32_t SegmentStart;
+    const int32_t *pSegment;
+
+    if (((SampleCount % MEASURE_STREAM_SEGMENT_SAMPLES) != 0) && !bFinal)
+    {
+        return true;
+    }
+
+    SegmentStart = ((SampleCount - 1) / MEASURE_STREAM_SEGMENT_SAMPLES) *
+                   MEASURE_STREAM_SEGMENT_SAMPLES;
+    pSegment = &g_pSampleBuffer[SegmentStart % (2 * MEASURE_STREAM_SEGMENT_SAMPLES)];
+
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+    PassRailFeatures_ProcessBlock(&g_OutputFeatures[0], g_pSampleBuffer,
+                                  2 * MEASURE_STREAM_SEGMENT_SAMPLES,
+                                  SampleCount - SegmentStart);
+#endif
+
+    if (!g_MeasurementRequest.pSegmentCallback(pSegment,
+                                               SampleCount - SegmentStart,
+                                               bFinal))
+    {
+        Measure_SetError(MEASUREERROR_STREAM_OVERRUN);
+        return false;
+    }
+
+    return true;
+}
+
 /*
  * Measure_AdcISRCallback
  *
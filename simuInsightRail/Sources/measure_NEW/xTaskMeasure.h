@@ -19,6 +19,18 @@ extern "C" {
 #include "PassRailMeasure.h"
 #include "AD7766_Common.h"
 #include "AdcApiDefs.h"
+#include "PassRailFeatures.h"
+
+//..............................................................................
+// Defines
+
+// Maximum number of output streams which can be produced from one ADC capture
+// (see Measure_StartMulti()) - must not exceed PASSRAILDSP_MAX_OUTPUTS
+#define MEASURE_MAX_OUTPUTS     (3)
+
+// Segment length of a streamed measurement (see Measure_StartStreamed()) -
+// two segments are used, so must not exceed half of SAMPLE_BUFFER_SIZE_WORDS
+#define MEASURE_STREAM_SEGMENT_SAMPLES  (4096)
 
 //..............................................................................
 // Types
@@ -30,6 +42,8 @@ typedef enum
     MEASUREERROR_STARTSAMPLING,
     MEASUREERROR_FINISHSAMPLING,
     MEASUREERROR_BLOCKTIMEOUT,
+    MEASUREERROR_SAMPLE_BUFFER_OVERRUN,
+    MEASUREERROR_STREAM_OVERRUN,
 } MeasureErrorEnum;
 
 typedef struct
@@ -42,6 +56,14 @@ typedef struct
 
 typedef void (*tMeasureCallback)(void);
 
+// Called from the measurement task with each filled segment of a streamed
+// measurement - bFinal is set for the last one, which may be partly filled.
+// The segment's samples are only kept until the next segment is full, as the
+// segment after that is written over them.
+// Return false if the segment can't be taken, which stops sampling.
+typedef bool (*tMeasureSegmentCallback)(const int32_t *pSamples,
+                                        uint32_t NumSamples, bool bFinal);
+
 //..............................................................................
 // Functions
 
@@ -54,7 +76,21 @@ bool Measure_Start(bool bRawAdcSampling,
                    uint32_t NumOutputSamples,
                    uint32_t AdcSamplesPerSecIfRawAdc,
                    tMeasureCallback pCallback);
+bool Measure_StartMulti(const tMeasId *pMeasIds,
+                        const uint32_t *pNumOutputSamples,
+                        uint8_t NumOutputs,
+                        tMeasureCallback pCallback);
+bool Measure_StartStreamed(tMeasId MeasId,
+                           uint32_t NumOutputSamples,
+                           tMeasureSegmentCallback pSegmentCallback,
+                           tMeasureCallback pCallback);
+int32_t *Measure_GetOutputBuffer(uint8_t OutputIndex);
+#ifdef CONFIG_PLATFORM_WAVE_FEATURES
+bool Measure_GetOutputFeatures(uint8_t OutputIndex, uint32_t SamplesPerSec,
+                               float WheelHz, FeaturesType *pFeatures);
+#endif
 bool Measure_GetErrorInfo(MeasureErrorInfoType *pMeasureErrorInfo);
+bool Measure_IsSamplingInProgress(void);
 
 //..............................................................................
 
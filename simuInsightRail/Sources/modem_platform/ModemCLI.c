@@ -92,7 +92,6 @@ static void result_read(uint8_t * str, uint32_t len, void  *mem)
 	modemStatus.atCommand.ATcopyptr = mem;
 	modemStatus.atCommand.ATcopycount = COPY_SIZE;
 	modemStatus.atCommand.AtCommandState = ATfread;
-	setIgnoreLF(true);
 }
 
 static bool cliModemCopy( uint32_t args, uint8_t * argv[], uint32_t * argi)
@@ -21,6 +21,7 @@ extern "C" {
 #include <portmacro.h>
 #include <FreeRTOS.h>
 #include <semphr.h>
+#include <task.h>
 #include <string.h>
 
 #include "xTaskmodem.h"
@@ -31,23 +32,37 @@ extern "C" {
 #include "fsl_device_registers.h"
 #include "fsl_uart_hal.h"
 #include "fsl_sim_hal.h"
+#include "fsl_edma_driver.h"
 #include "DrvUart.h"
 
 #include "ModemIo.h"
 
 #include "CS1.h"
 
-#define DIRTY_RTS_HACK
-
 /*
  * Macros
  */
-// maximum tcp packet is 1500 bytes
-#ifdef DIRTY_RTS_HACK
-#define MODEM_MAXRXBUF (32)
-#else
-#define MODEM_MAXRXBUF (128)
-#endif
+// The eDMA writes the received characters round this ring, the destination
+// modulo wraps it, so the size must be a power of 2 and match the modulo below.
+// A maximum tcp packet is 1500 bytes, the reader takes them out long before.
+#define MODEM_RXRING_SIZE   (1024)
+#define MODEM_RXRING_MASK   (MODEM_RXRING_SIZE - 1)
+#define MODEM_RXRING_MODULO (kEDMAModulo1Kbytes)
+
+// Flow control: the fill level is only checked on the half/full DMA interrupts
+// (every MODEM_RXRING_SIZE/2 bytes) and at the end of a burst, so the receive
+// DMA request is switched off when more than this is waiting at such a point,
+// the uart fifo then fills and the hardware deasserts RTS.
+// The margin covers the characters arriving before the interrupt is serviced.
+#define MODEM_RXRING_PAUSE  ((MODEM_RXRING_SIZE / 2) - 64)
+// and switched on again when the reader has taken it down to this
+#define MODEM_RXRING_RESUME (MODEM_RXRING_SIZE / 4)
+
+// Segments waiting for the transmit eDMA, each goes out in one or more major loops
+// (the major loop count is 15 bits)
+#define MODEM_TXQUEUE_LEN       (8)
+#define MODEM_TXDMA_MAX_MAJOR   (0x7FFF)
+
 /*
  * Types
  */
@@ -65,42 +80,68 @@ extern "C" {
 
 
 
-/* RX buffer */
-static struct {
-#ifdef DIRTY_RTS_HACK
-    volatile TickType_t tickCountAtFifoFull;
+/* RX ring, filled by the eDMA, the write index is derived from the DMA major loop count */
+#ifdef _MSC_VER
+static uint8_t __declspec(align(1024)) rxRingData[MODEM_RXRING_SIZE];
+#else
+static uint8_t rxRingData[MODEM_RXRING_SIZE] __attribute__((aligned(MODEM_RXRING_SIZE)));
 #endif
-    volatile uint16_t cnt;// beware, on arm thumb 32 bit units are not atomic !
-    uint16_t in;
-    uint16_t out;
-    uint8_t data[MODEM_MAXRXBUF];
-} rxBuf;
-
-static const uint16_t fifoSizeLookup[] = {
-        1,
-        4,
-        8,
-        16,
-        32,
-        64,
-        128,
-        1 // reserved
-};
 
+static struct {
+    uint32_t out;                   // only moved by the reader
+    volatile bool paused;           // receive DMA request off, RTS held by the uart
+    volatile bool idleOff;          // idle line interrupt off until characters arrive after the idle
+    uint32_t idleIn;                // ring write index at that idle
+    volatile bool abort;
+    volatile TaskHandle_t reader;   // task blocked in ModemIo_Read, notified from the isr's
+    volatile uint32_t wanted;       // the number of characters it still waits for
+    bool edmaReady;
+    edma_chn_state_t edmaState;
+} rxRing = {
+		.out = 0,
+		.paused = false,
+		.idleOff = false,
+		.idleIn = 0,
+		.abort = false,
+		.reader = NULL,
+		.wanted = 0,
+		.edmaReady = false
+};
 
+/* TX queue, the eDMA works through the segments from head to tail */
+static struct {
+    struct {
+        const uint8_t *data;
+        uint32_t len;
+        tModemIoWriteDone done;
+        void *param;
+        bool cancelled;             // done already called, skipped (or stopped when on the wire)
+    } seg[MODEM_TXQUEUE_LEN];
+    volatile uint32_t head;         // segment on the wire, moved by the isr
+    volatile uint32_t tail;         // next free segment, moved by the writers
+    uint32_t sent;                  // of the head segment, before the current major loop
+    uint32_t chunk;                 // in the current major loop
+    TickType_t started;             // when the head segment went on the wire
+    volatile bool running;
+    SemaphoreHandle_t space;        // counts the free segments
+    bool edmaReady;
+    edma_chn_state_t edmaState;
+} txQueue = {
+		.head = 0,
+		.tail = 0,
+		.running = false,
+		.space = NULL,
+		.edmaReady = false
+};
 
-/* TX buffer */
+/* Modem_writeBlock, the blocking write on top of the queue */
 static struct {
-    volatile uint32_t cnt;// beware, on arm thumb 32 bit unit operations are not atomic !
-    uint8_t *data;
+    volatile uint32_t written;
     bool busy;
-    bool notifyWhenDone;
     SemaphoreHandle_t writeBlockDone;
 } txState = {
-		.cnt = 0,
-		.data = NULL,
+		.written = 0,
 		.busy = false,
-		.notifyWhenDone = false,
 		.writeBlockDone = NULL
 };
 
@@ -110,6 +151,7 @@ static struct {
 // Debug variables, to see if, and when how often this happens.
 uint32_t MODEM_uart_err_count = 0;
 uint32_t MODEM_rx_fifo_overrun = 0;
+uint32_t MODEM_rx_pause_count = 0;
 
 /*
  * Function definition
@@ -130,7 +172,73 @@ static void Modem_UART_Init(uint32_t instance, uint32_t baudRate )
 
 	MODEM_uartBase = base; // for later use in the Rx and tx handling routines
 
+	CS1_CriticalVariable();
+	CS1_EnterCritical();
+
 	DrvUart_Init(instance, baudRate, kUartParityDisabled, true /* , 7, 8 */); // irq prio moved to resources.c
+
+	// received characters go to the ring by DMA, the cpu only gets the idle line interrupt at the end of a burst
+	UART_HAL_SetRxDmaCmd(base, true);
+	UART_HAL_SetIntMode(base, kUartIntIdleLine, true);
+	// and sent from the transmit queue by DMA, TDRE raises the DMA requests
+	UART_HAL_SetTxDmaCmd(base, true);
+
+	CS1_ExitCritical();
+}
+
+/*
+ * Modem_RxEdmaConfig
+ *
+ * @desc    sets up the eDMA channel to copy every received character from the uart
+ *          data register round the rx ring, endlessly (the major loop is one pass of the ring)
+ *          with a half and full interrupt, so the ring is looked at at least every half ring.
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+static void Modem_RxEdmaConfig()
+{
+    edma_transfer_config_t TcdConfig;
+    edma_software_tcd_t SoftwareTcd;
+
+    memset(&TcdConfig, 0, sizeof(edma_transfer_config_t));
+
+    TcdConfig.srcAddr = UART_HAL_GetDataRegAddr(MODEM_uartBase);
+    TcdConfig.srcTransferSize = kEDMATransferSize_1Bytes;
+    TcdConfig.srcOffset = 0;
+    TcdConfig.srcLastAddrAdjust = 0;
+    TcdConfig.srcModulo = kEDMAModuloDisable;
+
+    // IMPORTANT: rxRingData[] must be aligned to its size for the modulo wrap
+    TcdConfig.destAddr = (uint32_t)rxRingData;
+    TcdConfig.destTransferSize = kEDMATransferSize_1Bytes;
+    TcdConfig.destOffset = 1;
+    TcdConfig.destLastAddrAdjust = 0;
+    TcdConfig.destModulo = MODEM_RXRING_MODULO;
+
+    TcdConfig.minorLoopCount = 1;
+    TcdConfig.majorLoopCount = MODEM_RXRING_SIZE;
+
+    memset(&SoftwareTcd, 0, sizeof(edma_software_tcd_t));
+    // N.B. enables the "fully-complete" interrupt, and keeps the request enabled at the end of the major loop
+    EDMA_DRV_PrepareDescriptorTransfer(&rxRing.edmaState, &SoftwareTcd, &TcdConfig, true, false);
+    EDMA_HAL_STCDSetHalfCompleteIntCmd(&SoftwareTcd, true);
+    EDMA_DRV_PushDescriptorToReg(&rxRing.edmaState, &SoftwareTcd);
+}
+
+/*
+ * Modem_RxRingIn
+ *
+ * @desc    the ring index the DMA writes the next character to
+ *
+ * @param   -
+ *
+ * @returns write index
+ */
+static uint32_t Modem_RxRingIn()
+{
+    return (MODEM_RXRING_SIZE - EDMA_DRV_GetUnfinishedBytes(&rxRing.edmaState)) & MODEM_RXRING_MASK;
 }
 
 
@@ -140,140 +248,234 @@ static void Modem_UART_Init(uint32_t instance, uint32_t baudRate )
 
 
 /*
- * MODEM_InterruptRx
- *
- * @desc    handles the UART receive interrupts
- *          puts them in a software fifo (when room)
+ * Modem_RxIdleRearm
  *
+ * @desc    switches the idle line interrupt on again when it was switched off at an idle
+ *          and characters have come into the ring since (so the DMA has cleared the flag).
+ *          Not while paused, resuming switches it on. Called with interrupts masked.
  *
  * @param   -
  *
- * @returns -
+ * @returns true when switched on
  */
-static bool ignoreLF = false;
-
-void setIgnoreLF(bool bIgnoreLF)
+static bool Modem_RxIdleRearm()
 {
-	ignoreLF= bIgnoreLF;
+    if (rxRing.idleOff && !rxRing.paused && (Modem_RxRingIn() != rxRing.idleIn)) {
+        rxRing.idleOff = false;
+        MODEM_uartBase->C2 |= UART_C2_ILIE_MASK;
+        return true;
+    }
+    return false;
 }
 
-static BaseType_t Modem_InterruptRx()
+/*
+ * Modem_RxEventISR
+ *
+ * @desc    called when characters may have arrived in the ring (half/full DMA interrupt, idle line)
+ *          applies the flow control, and wakes up whoever should handle them:
+ *          the task blocked in ModemIo_Read when there is one, otherwise the modem task.
+ *
+ * @param   idle    the line went idle, so no more characters to wait for
+ *
+ * @returns higher priority task woken
+ */
+static BaseType_t Modem_RxEventISR(bool idle)
 {
-    bool sendEvent = false;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t count = Modem_UART_GetCharsInRxBuf();
 
+    if (!rxRing.paused && (count >= MODEM_RXRING_PAUSE)) {
+        // hw flow control, stop the DMA requests and let the uart hardware control the RTS line
+        UART_CLR_C2(MODEM_uartBase, UART_C2_RIE_MASK | UART_C2_ILIE_MASK);
+        rxRing.paused = true;
+        MODEM_rx_pause_count++;
+    }
 
-    // and now make more efficient use of the hardware fifo
-     if (rxBuf.cnt>=MODEM_MAXRXBUF) {
-    	 // hw flow control
-    	 // stop the rx interrupts, and let the uart hardware control the flow control lines
-    	 UART_CLR_C2(MODEM_uartBase, UART_C2_RIE_MASK ); /* Disable RX interrupt */
-
-    	 // below code was for no flow control
-    	 //UART_RD_D(MODEM_uartBase);/* Read an 8-bit character from the receiver */
-         //MODEM_rx_fifo_overrun++;
-#ifdef DIRTY_RTS_HACK
-    	 rxBuf.tickCountAtFifoFull = xTaskGetTickCountFromISR();
-#endif
-    	 // if we are full, in ATCOMMAND mode, it may be nice to notify the task (again)
-    	 sendEvent = (modemStatus.ioState == MODEMIOSTATE_ATCOMMAND);
-     } else {
-         while ( (rxBuf.cnt<MODEM_MAXRXBUF) &&  (UART_RD_S1(MODEM_uartBase) & UART_S1_RDRF_MASK )) {
-        	rxBuf.data[rxBuf.in]=UART_RD_D(MODEM_uartBase);/* Read an 8-bit character from the receiver */
-        	//when in AT command mode, scan for the end of the line '\n', then it is time to send an event to the higher task
-        	if ( !sendEvent && !ignoreLF && (modemStatus.ioState == MODEMIOSTATE_ATCOMMAND)) {
-        		sendEvent = (rxBuf.data[rxBuf.in] == '\n' || (rxBuf.cnt==(MODEM_MAXRXBUF-1)));
-        	}
-
-            rxBuf.in++;
-            if (rxBuf.in>= MODEM_MAXRXBUF) rxBuf.in=0;
-
-            rxBuf.cnt++;
-
-        	if (modemStatus.ioState == MODEMIOSTATE_TRANSPARENT) {
-//#define MODEM_RX_IRQ_BLOCKMODE
-#ifndef MODEM_RX_IRQ_BLOCKMODE
-        		if ((rxBuf.cnt ) <= 1 || (rxBuf.cnt > (MODEM_MAXRXBUF/2))) sendEvent = true; // TODO: make this more intelligent (for better performance)
-#else
-        		// TODO : needs debugging/testing
-        		// now the little bit smarter implementation without refactoring the higher layers
-        		// check if we have a read request in progress
-        		if (modemStatus.transparentRxState.count) {
-        		    // copy over what may be accumulated in the software fifo
-        		    while (modemStatus.transparentRxState.count && rxBuf.cnt) {
-
-        		        *modemStatus.transparentRxState.dest++ = rxBuf.data[ rxBuf.out++ ];
-        		        if ( rxBuf.out >= MODEM_MAXRXBUF) rxBuf.out = 0;
-                        rxBuf.cnt--;
-                        modemStatus.transparentRxState.count--;
-        		    }
-                    if (modemStatus.transparentRxState.count == 0) {
-                        // notify that the read is ready
-                        xSemaphoreGiveFromISR (modemStatus.transparentRxState.readWait , &xHigherPriorityTaskWoken);
-                        // did the read left behind any characters ? then notify the task
-                        if (rxBuf.cnt ) sendEvent = true; // TODO: make this more intelligent (for better performance)
-                    }
-        		} else {
-        		    // let the task know new character have arrived, which must be handled somewhere
-        		    if ((rxBuf.cnt ) <= 1) sendEvent = true; // TODO: make this more intelligent (for better performance)
-        		}
-#endif
-        	}
+    if (rxRing.reader != NULL) {
+        if (idle || rxRing.paused || (count >= rxRing.wanted)) {
+            vTaskNotifyGiveFromISR(rxRing.reader, &xHigherPriorityTaskWoken);
         }
-     }
-     if (sendEvent ) xHigherPriorityTaskWoken = Modem_NotifyRxData_ISR( 0 );//xQueueSendToFrontFromISR(_EventQueue_Modem, &evt, NULL);
+    } else if (count) {
+        xHigherPriorityTaskWoken = Modem_NotifyRxData_ISR( 0 );
+    }
+    return xHigherPriorityTaskWoken;
+}
 
-     return  pdFALSE;// when using high baudrates, this task switch check takes too long
+/*
+ * Modem_EdmaRxCallbackISR
+ *
+ * @desc    eDMA half and full ring interrupts
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+static void Modem_EdmaRxCallbackISR(void *param, edma_chn_status_t status)
+{
+    CS1_CriticalVariable();
+    CS1_EnterCritical();
+    (void)Modem_RxIdleRearm();
+    CS1_ExitCritical();
 
+    if (Modem_RxEventISR(false) == pdTRUE) {
+        vPortYieldFromISR();
+    }
 }
 
 /*
- * MODEM_InterruptTx
+ * Modem_InterruptIdle
  *
- * @desc    handles the UART transmit interrupts
- *          puts as many as possible characters in the output fifo
+ * @desc    handles the idle line interrupt, the end of a burst of received characters.
+ *          The flag is cleared by reading S1 (done in the irq handler) and then D, but D belongs
+ *          to the DMA: a read here could take a character just arriving from it. So the interrupt
+ *          is switched off instead, the DMA reads D with the next character, which clears the flag,
+ *          and Modem_RxIdleRearm switches it on again once that character is in the ring.
  *
+ * @param   -
+ *
+ * @returns higher priority task woken
+ */
+static BaseType_t Modem_InterruptIdle()
+{
+    UART_CLR_C2(MODEM_uartBase, UART_C2_ILIE_MASK);
+    rxRing.idleIn = Modem_RxRingIn();
+    rxRing.idleOff = true;
+
+    return Modem_RxEventISR(true);
+}
+
+/*
+ * ModemIo_TickISR
+ *
+ * @desc    called from the tick hook, switches the idle line interrupt on again after a burst
+ *          too short for a DMA interrupt, so its end is seen within a tick.
+ *          Characters left in the uart fifo while paused come in without a following idle,
+ *          so the new characters are reported here as well.
  *
  * @param   -
  *
  * @returns -
  */
+void ModemIo_TickISR()
+{
+    bool rearmed = false;
+
+    if (rxRing.idleOff) {
+        CS1_CriticalVariable();
+        CS1_EnterCritical();
+        rearmed = Modem_RxIdleRearm();
+        CS1_ExitCritical();
+    }
+    if (rearmed && (Modem_RxEventISR(false) == pdTRUE)) {
+        vPortYieldFromISR();
+    }
+}
 
-static BaseType_t Modem_InterruptTx()
+/*
+ * Modem_TxStart
+ *
+ * @desc    starts the transmit eDMA on the next part of the head segment,
+ *          the UART TDRE DMA request paces it. The request is switched off by the hardware
+ *          at the end of the major loop, which interrupts.
+ *          Called with interrupts masked, or from the eDMA isr.
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+static void Modem_TxStart()
 {
-    // and now make more efficient use of the hardware fifo
-    uint16_t room = fifoSizeLookup[UART_HAL_GetRxFifoSize(MODEM_uartBase)] - UART_HAL_GetTxDatawordCountInFifo(MODEM_uartBase);
+    edma_transfer_config_t TcdConfig;
+    edma_software_tcd_t SoftwareTcd;
+    uint32_t left = txQueue.seg[txQueue.head].len - txQueue.sent;
 
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    if (txQueue.sent == 0) {
+        txQueue.started = xTaskGetTickCountFromISR();
+    }
+    txQueue.chunk = (left > MODEM_TXDMA_MAX_MAJOR) ? MODEM_TXDMA_MAX_MAJOR : left;
 
-#ifdef TESTPINS
-    // TODO do not forget to remove
-     //testpin function
-     GPIO_DRV_SetPinOutput( PTC11 ) ;
-#endif
+    memset(&TcdConfig, 0, sizeof(edma_transfer_config_t));
+
+    TcdConfig.srcAddr = (uint32_t)&txQueue.seg[txQueue.head].data[txQueue.sent];
+    TcdConfig.srcTransferSize = kEDMATransferSize_1Bytes;
+    TcdConfig.srcOffset = 1;
+    TcdConfig.srcLastAddrAdjust = 0;
+    TcdConfig.srcModulo = kEDMAModuloDisable;
+
+    TcdConfig.destAddr = UART_HAL_GetDataRegAddr(MODEM_uartBase);
+    TcdConfig.destTransferSize = kEDMATransferSize_1Bytes;
+    TcdConfig.destOffset = 0;
+    TcdConfig.destLastAddrAdjust = 0;
+    TcdConfig.destModulo = kEDMAModuloDisable;
+
+    TcdConfig.minorLoopCount = 1;
+    TcdConfig.majorLoopCount = txQueue.chunk;
 
-    while (room &&  txState.cnt > 0 ) {
-    	txState.cnt--;
-        room--;
-        UART_WR_D(MODEM_uartBase, *txState.data++);
+    memset(&SoftwareTcd, 0, sizeof(edma_software_tcd_t));
+    EDMA_DRV_PrepareDescriptorTransfer(&txQueue.edmaState, &SoftwareTcd, &TcdConfig, true, true);
+    EDMA_DRV_PushDescriptorToReg(&txQueue.edmaState, &SoftwareTcd);
+    EDMA_DRV_StartChannel(&txQueue.edmaState);
+}
+
+/*
+ * Modem_TxNext
+ *
+ * @desc    frees the head segment, done with, and starts the next one that was not cancelled.
+ *          Called with interrupts masked, or from the eDMA isr.
+ *
+ * @param   pxHigherPriorityTaskWoken - for the free segment semaphore
+ *
+ * @returns -
+ */
+static void Modem_TxNext(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    do {
+        txQueue.head = (txQueue.head + 1) % MODEM_TXQUEUE_LEN;
+        xSemaphoreGiveFromISR(txQueue.space, pxHigherPriorityTaskWoken);
+    } while ((txQueue.head != txQueue.tail) && txQueue.seg[txQueue.head].cancelled);
+    txQueue.sent = 0;
+    txQueue.chunk = 0;
+
+    if (txQueue.head != txQueue.tail) {
+        Modem_TxStart();
+    } else {
+        txQueue.running = false;
     }
+}
 
-    if ( txState.cnt == 0 ) {
-        // we have nothing more to write, so disable irq
+/*
+ * Modem_EdmaTxCallbackISR
+ *
+ * @desc    end of a transmit major loop: carry on with the segment, or report it done
+ *          and carry on with the next one in the queue
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+static void Modem_EdmaTxCallbackISR(void *param, edma_chn_status_t status)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
-    	//UART_HAL_SetIntMode(MODEM_uartBase, kUartIntTxDataRegEmpty, false);
-        UART_CLR_C2(MODEM_uartBase, UART_C2_TIE_MASK ); /* Disable TX interrupt */
-        if (txState.notifyWhenDone) {
-        	xSemaphoreGiveFromISR (txState.writeBlockDone, &xHigherPriorityTaskWoken);
-        }
+    if (!txQueue.running) {
+        // interrupt left pending by ModemIo_WriteAbort
+        return;
+    }
+    txQueue.sent += txQueue.chunk;
+    txQueue.chunk = 0;
+    if ((txQueue.sent < txQueue.seg[txQueue.head].len) && !txQueue.seg[txQueue.head].cancelled) {
+        Modem_TxStart();
+        return;
     }
 
-#ifdef TESTPINS
-    // TODO do not forget to remove
-     //testpin function
-     GPIO_DRV_ClearPinOutput( PTC11 );
-#endif
-     return xHigherPriorityTaskWoken;
+    if (txQueue.seg[txQueue.head].done != NULL) {
+        txQueue.seg[txQueue.head].done(txQueue.seg[txQueue.head].param, txQueue.sent, &xHigherPriorityTaskWoken);
+    }
+    Modem_TxNext(&xHigherPriorityTaskWoken);
+
+    if (xHigherPriorityTaskWoken == pdTRUE) {
+        vPortYieldFromISR();
+    }
 }
 
 
@@ -283,8 +485,9 @@ static BaseType_t Modem_InterruptTx()
  * MODEM_UART_ISR
  *
  * @desc    direct called from the vector table,
- *          handles the UART status events interrupts (normal operation transmit and receive stuff)
- *          calls the appropriate Rx or Tx routine for the real work.
+ *          handles the UART status events interrupts, only the receive idle line,
+ *          the characters themselves are moved by the DMA both ways
+ *          calls the appropriate Rx routine for the real work.
  * @param   -
  *
  * @returns -
@@ -295,18 +498,12 @@ void /*__attribute__((interrupt))*/ MODEM_UART_RX_TX_IRQhandler(void)
 	register uint16_t StatReg = MODEM_uartBase->S1;
 
     BaseType_t RxHigherPriorityTaskWoken = pdFALSE;
-    BaseType_t TxHigherPriorityTaskWoken = pdFALSE;
 
-    if (StatReg & UART_S1_RDRF_MASK) {   /* Is the receiver's interrupt flag set? */
-        RxHigherPriorityTaskWoken = Modem_InterruptRx();        /* If yes, then invoke the internal service routine.  */
+    if ((StatReg & UART_S1_IDLE_MASK) && (UART_RD_C2(MODEM_uartBase) & UART_C2_ILIE_MASK)) {   /* end of a burst received by the DMA ? */
+        RxHigherPriorityTaskWoken = Modem_InterruptIdle();
     }
 
-    if ( UART_RD_C2(MODEM_uartBase) & UART_C2_TIE_MASK )   { /*  TX interrupt enabled ? */
-        if (StatReg & UART_S1_TDRE_MASK) { /* Is the transmitter irq enabled and Is the transmitter empty? */
-            TxHigherPriorityTaskWoken = Modem_InterruptTx();      /* If yes, then invoke the internal service routine. */
-        }
-    }
-    if ((RxHigherPriorityTaskWoken == pdTRUE) || (TxHigherPriorityTaskWoken)) {
+    if (RxHigherPriorityTaskWoken == pdTRUE) {
         vPortYieldFromISR();
     }
 }
@@ -342,11 +539,112 @@ void /*__attribute__((interrupt))*/ MODEM_UART_ERR_IRQhandler(void)
  * @returns number of characters in the input buffer
  */
 
-uint8_t Modem_UART_GetCharsInRxBuf()
+uint32_t Modem_UART_GetCharsInRxBuf()
+{
+    return (Modem_RxRingIn() - rxRing.out) & MODEM_RXRING_MASK;
+}
+
+/*
+ * Modem_RxRingCopy
+ *
+ * @desc    takes what is available from the ring, up to len characters,
+ *          and switches the DMA requests on again when paused and enough room now.
+ *
+ * @param   dest    destination buffer
+ * @param   len     max number of characters
+ *
+ * @returns number of characters copied
+ */
+static uint32_t Modem_RxRingCopy(uint8_t *dest, uint32_t len)
+{
+    uint32_t out = rxRing.out;
+    uint32_t count = (Modem_RxRingIn() - out) & MODEM_RXRING_MASK;
+    uint32_t first;
+
+    if (count > len) count = len;
+
+    // at most two pieces, up to the end of the ring and from the start
+    first = MODEM_RXRING_SIZE - out;
+    if (first > count) first = count;
+    memcpy(dest, &rxRingData[out], first);
+    memcpy(&dest[first], rxRingData, count - first);
+    rxRing.out = (out + count) & MODEM_RXRING_MASK;
+
+    if (rxRing.paused || rxRing.idleOff) {
+        CS1_CriticalVariable();
+        CS1_EnterCritical();
+
+        if (rxRing.paused && (Modem_UART_GetCharsInRxBuf() <= MODEM_RXRING_RESUME)) {
+            rxRing.paused = false;
+            /* Enable RX DMA request and, unless waiting for characters after an idle, the idle line interrupt */
+            MODEM_uartBase->C2 |= UART_C2_RIE_MASK | (rxRing.idleOff ? 0 : UART_C2_ILIE_MASK);
+        }
+        (void)Modem_RxIdleRearm();
+
+        CS1_ExitCritical();
+    }
+    return count;
+}
+
+/*
+ * ModemIo_Read
+ *
+ * @desc    reads len characters, blocks until they have all arrived, the timeout expires or the read is aborted.
+ *          The task sleeps on a task notification from the DMA/idle line interrupts in the mean time.
+ *
+ * @param   data    destination buffer
+ * @param   len     number of characters to read
+ * @param   timeout in ticks
+ *
+ * @returns number of characters read
+ */
+uint32_t ModemIo_Read(uint8_t *data, uint32_t len, uint32_t timeout)
 {
-    return rxBuf.cnt;
+    TimeOut_t timeOut;
+    TickType_t ticksLeft = timeout;
+    uint32_t bytesRead = 0;
+
+    vTaskSetTimeOutState(&timeOut);
+    rxRing.abort = false;
+
+    while (true) {
+        // register first, so characters arriving during the copy still notify us
+        CS1_CriticalVariable();
+        CS1_EnterCritical();
+        rxRing.wanted = len - bytesRead;
+        rxRing.reader = xTaskGetCurrentTaskHandle();
+        CS1_ExitCritical();
+
+        bytesRead += Modem_RxRingCopy(&data[bytesRead], len - bytesRead);
+
+        if ((bytesRead == len) || rxRing.abort || (xTaskCheckForTimeOut(&timeOut, &ticksLeft) == pdTRUE)) {
+            break;
+        }
+        (void)ulTaskNotifyTake(pdTRUE, ticksLeft);
+    }
+    rxRing.reader = NULL;
+
+    return bytesRead;
 }
 
+/*
+ * ModemIo_ReadAbort
+ *
+ * @desc    lets a ModemIo_Read in progress return with what it has got so far
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+void ModemIo_ReadAbort()
+{
+    TaskHandle_t reader = rxRing.reader;
+
+    rxRing.abort = true;
+    if (reader != NULL) {
+        xTaskNotifyGive(reader);
+    }
+}
 
 /*
  * get_ch
@@ -360,57 +658,194 @@ uint8_t Modem_UART_GetCharsInRxBuf()
  */
 uint8_t Modem_UART_get_ch()
 {
-    uint8_t c;
+    uint8_t c = 0;
 
-    while ( rxBuf.cnt == 0) {
-        /* block, set idle ? */
-        vTaskDelay(1 / portTICK_PERIOD_MS); // 1ms is about ten char at 115 kbaud
+    (void)ModemIo_Read(&c, 1, portMAX_DELAY);
+
+    return c;
+}
+
+
+/*
+ * ModemIo_WriteQueue
+ *
+ * @desc    queues a segment for the transmit eDMA and returns, so the caller can prepare the next one
+ *          while this one goes out. The data must stay untouched until done is called, from the eDMA
+ *          interrupt (or from the task calling ModemIo_WriteAbort) with the number of bytes sent.
+ *          Segments go out in the order they were queued.
+ *
+ * @param   data    segment
+ * @param   len     its length
+ * @param   done    completion callback, or NULL
+ * @param   param   for the callback
+ * @param   timeout in ticks, to wait for room in the queue
+ *
+ * @returns false when not queued (no room in time)
+ */
+bool ModemIo_WriteQueue(const uint8_t *data, uint32_t len, tModemIoWriteDone done, void *param, uint32_t timeout)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (!txQueue.edmaReady) {
+        return false;
     }
-    c = rxBuf.data[ rxBuf.out++ ];
-    if ( rxBuf.out >= MODEM_MAXRXBUF) rxBuf.out = 0;
-
-#ifdef DIRTY_RTS_HACK
-    {
-        TickType_t ticks;
-        // dirty hack to bring down the RTS toggles
-        ticks = xTaskGetTickCount();
-
-        if (rxBuf.cnt <2) {
-            if ((ticks - rxBuf.tickCountAtFifoFull) <=1) {
-                vTaskDelay(1);
-            }
-        }
+    if (len == 0) {
+        if (done != NULL) done(param, 0, &xHigherPriorityTaskWoken);
+        return true;
     }
-#endif
-    // disable irq required ?
+    if (xSemaphoreTake(txQueue.space, (TickType_t)timeout) != pdTRUE) {
+        return false;
+    }
+
     CS1_CriticalVariable();
     CS1_EnterCritical();
 
-    rxBuf.cnt--;
+    txQueue.seg[txQueue.tail].data = data;
+    txQueue.seg[txQueue.tail].len = len;
+    txQueue.seg[txQueue.tail].done = done;
+    txQueue.seg[txQueue.tail].param = param;
+    txQueue.seg[txQueue.tail].cancelled = false;
+    txQueue.tail = (txQueue.tail + 1) % MODEM_TXQUEUE_LEN;
+    if (!txQueue.running) {
+        txQueue.running = true;
+        txQueue.sent = 0;
+        Modem_TxStart();
+    }
+
+    CS1_ExitCritical();
+
+    return true;
+}
+
+/*
+ * ModemIo_WriteAbort
+ *
+ * @desc    stops the transmit eDMA and drops all queued segments, their callbacks get what was sent of them
+ *
+ * @param   -
+ *
+ * @returns -
+ */
+void ModemIo_WriteAbort()
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t dropped = 0;
+    uint32_t sent;
+
+    if (!txQueue.edmaReady) {
+        return;
+    }
+
+    CS1_CriticalVariable();
+    CS1_EnterCritical();
 
-    // extra for HW flow control, which switches the rx interrupts off when software fifo full in the irq handler
-    // when software fifo is empty, switch the RX interrupts on again
-    if (rxBuf.cnt ==0) {
-    	MODEM_uartBase->C2 |= UART_C2_RIE_MASK;/* Enable RX interrupt */
+    EDMA_DRV_StopChannel(&txQueue.edmaState);
+    if (txQueue.running) {
+        sent = txQueue.sent + txQueue.chunk - EDMA_DRV_GetUnfinishedBytes(&txQueue.edmaState);
+        while (txQueue.head != txQueue.tail) {
+            if ((txQueue.seg[txQueue.head].done != NULL) && !txQueue.seg[txQueue.head].cancelled) {
+                txQueue.seg[txQueue.head].done(txQueue.seg[txQueue.head].param, sent, &xHigherPriorityTaskWoken);
+            }
+            txQueue.head = (txQueue.head + 1) % MODEM_TXQUEUE_LEN;
+            sent = 0;
+            dropped++;
+        }
     }
+    txQueue.running = false;
+    txQueue.sent = 0;
+    txQueue.chunk = 0;
+    // reset hardware fifo
+    UART_WR_CFIFO(MODEM_uartBase, UART_CFIFO_TXFLUSH_MASK );
 
-    // enable irq
     CS1_ExitCritical();
 
-    return c;
+    while (dropped--) {
+        xSemaphoreGive(txQueue.space);
+    }
+    if (xHigherPriorityTaskWoken == pdTRUE) {
+        taskYIELD();
+    }
 }
 
+/*
+ * ModemIo_WriteCancel
+ *
+ * @desc    takes one queued segment out, identified by its callback and param, the segments
+ *          queued before and after it are left alone. When it is on the wire it is stopped
+ *          where it is. Its callback gets what was sent of it.
+ *
+ * @param   done    completion callback the segment was queued with
+ * @param   param   for the callback
+ *
+ * @returns -
+ */
+void ModemIo_WriteCancel(tModemIoWriteDone done, void *param)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t i;
+
+    CS1_CriticalVariable();
+    CS1_EnterCritical();
+
+    for (i = txQueue.head; i != txQueue.tail; i = (i + 1) % MODEM_TXQUEUE_LEN) {
+        if ((txQueue.seg[i].done == done) && (txQueue.seg[i].param == param) && !txQueue.seg[i].cancelled) {
+            break;
+        }
+    }
+    if (i != txQueue.tail) {
+        txQueue.seg[i].cancelled = true;
+        if (i != txQueue.head) {
+            // not started, skipped when its turn comes
+            if (done != NULL) done(param, 0, &xHigherPriorityTaskWoken);
+        } else {
+            uint32_t unfinished;
+
+            EDMA_DRV_StopChannel(&txQueue.edmaState);
+            unfinished = EDMA_DRV_GetUnfinishedBytes(&txQueue.edmaState);
+            // when the major loop has just finished its interrupt is pending, that finishes the segment
+            if (unfinished != 0) {
+                if (done != NULL) done(param, txQueue.sent + txQueue.chunk - unfinished, &xHigherPriorityTaskWoken);
+                Modem_TxNext(&xHigherPriorityTaskWoken);
+            }
+        }
+    }
+
+    CS1_ExitCritical();
+
+    if (xHigherPriorityTaskWoken == pdTRUE) {
+        taskYIELD();
+    }
+}
 
 /*
- * alternate write function (preparing for change to DMA version
+ * ModemIo_WriteOnWire
+ *
+ * @desc    how long the segment on the wire has been going out, the link is stalled
+ *          when that gets longer than the time a segment may take
+ *
+ * @param   -
+ *
+ * @returns ticks, 0 when nothing is being sent
  */
+uint32_t ModemIo_WriteOnWire()
+{
+    TickType_t started = txQueue.started;
+
+    return txQueue.running ? (uint32_t)(xTaskGetTickCount() - started) : 0;
+}
+
+static void Modem_writeBlockDone(void *param, uint32_t written, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    txState.written = written;
+    xSemaphoreGiveFromISR(txState.writeBlockDone, pxHigherPriorityTaskWoken);
+}
 
 // returns the number of written bytes
 // if this is different from the specified amount, something is wrong !
 
 uint32_t Modem_writeBlock(uint8_t *data, uint32_t len, uint32_t timeout)
 {
-
+	TickType_t ticksLeft = timeout;
 	bool rc_ok = true;
 	uint32_t bytesWritten = 0;
 
@@ -418,48 +853,41 @@ uint32_t Modem_writeBlock(uint8_t *data, uint32_t len, uint32_t timeout)
 		rc_ok = false;
 		// still busy with a transfer
 	} else {
-
 		txState.busy = true;
-		txState.cnt = len;
-		txState.data = data;
-		txState.notifyWhenDone = true;
-
-    	MODEM_uartBase->C2 |= UART_C2_TIE_MASK;/* Enable TX interrupt */
-	}
-
-	// wait for semaphore or timeout
-	if (rc_ok) {
-		rc_ok = (xSemaphoreTake( txState.writeBlockDone, ( TickType_t ) timeout ) == pdTRUE);
+		txState.written = 0;
+		(void)xSemaphoreTake(txState.writeBlockDone, 0);
+
+		rc_ok = ModemIo_WriteQueue(data, len, Modem_writeBlockDone, NULL, timeout);
+		// wait for the segment to go out. The segments queued before it were already reported sent,
+		// so the timeout only counts from when a segment goes on the wire: each one gets it,
+		// and only a stalled link ends the wait.
+		while (rc_ok && (xSemaphoreTake( txState.writeBlockDone, ticksLeft ) != pdTRUE)) {
+			uint32_t onWire = ModemIo_WriteOnWire();
+
+			if (onWire >= timeout) {
+				// take this segment out, its callback still reports how far it got
+				rc_ok = false;
+				ModemIo_WriteCancel(Modem_writeBlockDone, NULL);
+				(void)xSemaphoreTake(txState.writeBlockDone, 0);
+			} else {
+				ticksLeft = timeout - onWire;
+			}
+		}
+		bytesWritten = txState.written;
 		txState.busy = false;
-		bytesWritten = len-txState.cnt;
+
 		if ((rc_ok == false) || (bytesWritten != len) ) {
 			// TODO : if timeout or error occurred, set modem state in error !
 		    if (rc_ok==false) LOG_DBG(LOG_LEVEL_MODEM,"Modem_writeBlock: timeout\n");
 		    if (bytesWritten != len) LOG_DBG(LOG_LEVEL_MODEM,"Modem_writeBlock: not all bytes written %d out of %d\n",bytesWritten, len );
-
-			// cleanup current interrupted transfer
-			CS1_CriticalVariable();
-		    CS1_EnterCritical();
-
-		    MODEM_uartBase->C2 &= ~UART_C2_TIE_MASK;/* Disable TX interrupt */
-		    // reset hardware fifo ?
-		    UART_WR_CFIFO(MODEM_uartBase, UART_CFIFO_TXFLUSH_MASK );
-
-			txState.cnt = 0;
-			txState.notifyWhenDone = false;
-
-		    CS1_ExitCritical();
 		}
 	}
 	return bytesWritten;
 }
 void Modem_writeBlockAbort()
 {
-    // nothing to abort when not writing
-    if (txState.busy) {
-        // just do as if we are ready, the difference between requested and actual transferred bytes will trigger the error handling
-        xSemaphoreGive( txState.writeBlockDone);
-    }
+    // the queued writes finish with less bytes than requested, which triggers the error handling
+    ModemIo_WriteAbort();
 }
 
 // these convenient (but depreciated) functions use a fixed character timeout of 10ms
@@ -511,21 +939,48 @@ bool Modem_put_s(char *str)
 
 void Modem_init_serial(uint32_t instance, uint32_t baudRate )
 {
-    rxBuf.cnt=0;
-    rxBuf.in=0;
-    rxBuf.out=0;
+    if (rxRing.edmaReady == false) {
+        // request the channel only once, makes reinit of this function possible
+        rxRing.edmaReady = (EDMA_DRV_RequestChannel(EDMACHANNEL_MODEM_RX, MODEM_UART_EDMA_RX_REQUEST,
+                                                    &rxRing.edmaState) == EDMACHANNEL_MODEM_RX);
+        if (rxRing.edmaReady) {
+            EDMA_DRV_InstallCallback(&rxRing.edmaState, Modem_EdmaRxCallbackISR, NULL);
+        } else {
+            LOG_DBG(LOG_LEVEL_MODEM,"Modem_init_serial: eDMA rx channel request failed\n");
+        }
+    } else {
+        EDMA_DRV_StopChannel(&rxRing.edmaState);
+    }
+    rxRing.out = 0;
+    rxRing.paused = false;
+    rxRing.idleOff = false;
 
 
 	if (txState.writeBlockDone == NULL) {
 		// create semaphore only once, makes reinit of this function possible
 		txState.writeBlockDone =  xSemaphoreCreateBinary();
+		txQueue.space = xSemaphoreCreateCounting(MODEM_TXQUEUE_LEN, MODEM_TXQUEUE_LEN);
+	}
+	if (txQueue.edmaReady == false) {
+        txQueue.edmaReady = (EDMA_DRV_RequestChannel(EDMACHANNEL_MODEM_TX, MODEM_UART_EDMA_TX_REQUEST,
+                                                     &txQueue.edmaState) == EDMACHANNEL_MODEM_TX);
+        if (txQueue.edmaReady) {
+            EDMA_DRV_InstallCallback(&txQueue.edmaState, Modem_EdmaTxCallbackISR, NULL);
+        } else {
+            LOG_DBG(LOG_LEVEL_MODEM,"Modem_init_serial: eDMA tx channel request failed\n");
+        }
+	} else {
+		ModemIo_WriteAbort();
 	}
-	txState.cnt = 0;
 	txState.busy = false;
-	txState.notifyWhenDone = false;
 
     Modem_UART_Init(instance, baudRate);// comport index and baudrate
 
+    if (rxRing.edmaReady) {
+        // a fresh major loop starts writing the ring at index 0 again
+        Modem_RxEdmaConfig();
+        EDMA_DRV_StartChannel(&rxRing.edmaState);
+    }
 }
 
 
@@ -535,17 +990,19 @@ void Modem_init_serial(uint32_t instance, uint32_t baudRate )
 void ModemIo_print_info()
 {
 	printf("modem serial info:\n");
-	printf("rxBuf   in=%d, out=%d, cnt=%d\n", rxBuf.in, rxBuf.out, rxBuf.cnt);
-	if (rxBuf.cnt) {
-		uint16_t i;
+	printf("rxRing  in=%d, out=%d, cnt=%d, paused=%d, idleOff=%d, reader=%s\n", Modem_RxRingIn(), rxRing.out, Modem_UART_GetCharsInRxBuf(),
+	        rxRing.paused, rxRing.idleOff, (rxRing.reader != NULL) ? "waiting" : "none");
+	if (Modem_UART_GetCharsInRxBuf()) {
+		uint32_t i;
 		printf("rx buffer contains: ");
-		for (i=0; i<rxBuf.cnt; i++) {
-			printf("%c", rxBuf.data[(rxBuf.out + i) % MODEM_MAXRXBUF]);
+		for (i=0; i<Modem_UART_GetCharsInRxBuf(); i++) {
+			printf("%c", rxRingData[(rxRing.out + i) & MODEM_RXRING_MASK]);
 		}
 		printf("\n");
 	}
-	printf("txState cnt=%d, busy=%d\n", txState.cnt, txState.busy  );
-	printf("MODEM_uart_err_count = %d\nMODEM_rx_fifo_overrun = %d\n",MODEM_uart_err_count, MODEM_rx_fifo_overrun);
+	printf("txQueue head=%d, tail=%d, running=%d, sent=%d, busy=%d\n", txQueue.head, txQueue.tail, txQueue.running,
+	        txQueue.sent, txState.busy  );
+	printf("MODEM_uart_err_count = %d\nMODEM_rx_fifo_overrun = %d\nMODEM_rx_pause_count = %d\n",MODEM_uart_err_count, MODEM_rx_fifo_overrun, MODEM_rx_pause_count);
 
 	printf("Bytes in UART fifo's  tx: %d, rx: %d\n",UART_HAL_GetTxDatawordCountInFifo(MODEM_uartBase), UART_HAL_GetRxDatawordCountInFifo(MODEM_uartBase));
 }
@@ -18,6 +18,8 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <FreeRTOS.h>
+
 #include "configModem.h"
 
 /*
@@ -38,6 +40,9 @@ extern "C" {
  * Types
  */
 
+// completion of a queued write, with the number of bytes sent
+typedef void (*tModemIoWriteDone)(void *param, uint32_t written, BaseType_t *pxHigherPriorityTaskWoken);
+
 
 /*
  * Data
@@ -47,18 +52,24 @@ extern "C" {
  * Interface functions
  */
 
-uint8_t Modem_UART_GetCharsInRxBuf();
+uint32_t Modem_UART_GetCharsInRxBuf();
 uint8_t Modem_UART_get_ch();
+uint32_t ModemIo_Read(uint8_t *data, uint32_t len, uint32_t timeout);
+void ModemIo_ReadAbort();
+void ModemIo_TickISR();
 
 void Modem_init_serial(uint32_t instance, uint32_t baudRate );
 uint32_t Modem_writeBlock(uint8_t *data, uint32_t len, uint32_t timeout);
 void Modem_writeBlockAbort();
+bool ModemIo_WriteQueue(const uint8_t *data, uint32_t len, tModemIoWriteDone done, void *param, uint32_t timeout);
+void ModemIo_WriteAbort();
+void ModemIo_WriteCancel(tModemIoWriteDone done, void *param);
+uint32_t ModemIo_WriteOnWire();
 
 // these will become obsolete (use fixed 10ms/char timeout
 bool Modem_put_ch(uint8_t c);
 // void MODEM_put_ch_nb(uint8_t c);
 bool Modem_put_s(char *str) ;
-void setIgnoreLF(bool bIgnoreLF);
 
 
 
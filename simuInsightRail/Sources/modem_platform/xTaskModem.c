@@ -36,6 +36,7 @@ extern "C" {
 
 
 #include "printgdf.h"
+#include "Trace.h"
 #include "Insight.h"
 
 
@@ -48,7 +49,6 @@ extern "C" {
 
 //
 //
-extern void setIgnoreLF(bool);
 
 #define MODEM_RX	(1)
 #define MODEM_DCD	(2)
@@ -261,11 +261,6 @@ static void init_MODEM_UART_event(uint32_t baudrate)
 	// not much yet, but more will come
 	modemStatus.atCommand.ATresponseBufIdx = 0;
 
-	// modemStatus.transparentRxState.readWait = xSemaphoreCreateBinary(); // moved to the task init, so we can call this init again without creating an extra semaphore
-	modemStatus.transparentRxState.amount = 0;
-	modemStatus.transparentRxState.count = 0;
-	modemStatus.transparentRxState.dest = NULL;
-
 	modemStatus.lastCharsInRxBufCount = 0;
 
 	Modem_init_serial(MODEM_UART_IDX, baudrate);
@@ -369,7 +364,6 @@ static void handle_MODEM_UART_event()
 					modemStatus.atCommand.AtCommandState = ATresponse;
 					modemStatus.atCommand.ATresponseBufIdx=0;
 					modemStatus.atCommand.ATlookForEnd=true;
-					setIgnoreLF(false);
         		}
         		break;
         	case ATsend_echo:
@@ -487,40 +481,15 @@ static void handle_MODEM_UART_event()
 	// we could have switch to transparent mode, with some chars left in the buffer
 	if (modemStatus.ioState == MODEMIOSTATE_TRANSPARENT) {
 
-        // not the most nice solution, but this will change anyway when going for uart DMA
-        // and if not going for DMA, this must move to the ISR, but not today
-        if (modemStatus.transparentRxState.count) {
-            //bool log= (Modem_UART_GetCharsInRxBuf() > 0);
-            //if (log) LOG_DBG(LOG_LEVEL_MODEM,"\ntransparent:");
-#ifdef MODEM_RX_IRQ_BLOCKMODE
-            CS1_CriticalVariable();
-            CS1_EnterCritical();
-#endif
-            while ((Modem_UART_GetCharsInRxBuf() > 0) && modemStatus.transparentRxState.count ) {
-                uint8_t c;
-                c= Modem_UART_get_ch();
-                *modemStatus.transparentRxState.dest++ = c;
-                modemStatus.transparentRxState.count--;
-                //LOG_DBG(LOG_LEVEL_MODEM,"%02x",c);
-            }
-#ifdef MODEM_RX_IRQ_BLOCKMODE
-            CS1_ExitCritical();
-#endif
-            //if (log) LOG_DBG(LOG_LEVEL_MODEM,"\n");
-            if (modemStatus.transparentRxState.count == 0) {
-                xSemaphoreGive( modemStatus.transparentRxState.readWait );
-                modemStatus.lastCharsInRxBufCount = 0;
-            }
-        } else {
-            // nobody expects these, so maybe we should give a 'hint' ?
-            uint32_t count = Modem_UART_GetCharsInRxBuf();
-
-            if (count > modemStatus.lastCharsInRxBufCount) {
-                modemStatus.lastCharsInRxBufCount = count;
-                // callback !
-                handleCallback(Modem_cb_incoming_data, NULL, count, NULL);
-            }
+        // reads take the characters from the rx ring themselves (ModemIo_Read), this event
+        // only comes when nobody is reading, so maybe we should give a 'hint' ?
+        uint32_t count = Modem_UART_GetCharsInRxBuf();
+
+        if (count > modemStatus.lastCharsInRxBufCount) {
+            // callback !
+            handleCallback(Modem_cb_incoming_data, NULL, count, NULL);
         }
+        modemStatus.lastCharsInRxBufCount = count;
     }
 }
 
@@ -543,7 +512,6 @@ void xTaskModem_Init()
 
     modemStatus.semAccess =  xSemaphoreCreateBinary();
     modemStatus.atCommand.atWait =  xSemaphoreCreateBinary();
-    modemStatus.transparentRxState.readWait = xSemaphoreCreateBinary();
 
     ModemInitCallBack();
 
@@ -631,62 +599,40 @@ void xTaskModem(void *pvParameters) {
 
 
 /*
- * this should be restructured when going to a DMA driver for the uart, now just to get it working without looking at the performance implications
+ * Modem_readBlock
+ *
+ * @desc    blocking read of a block in transparent mode, straight from the DMA rx ring
+ *
+ * @param   data    destination buffer
+ * @param   len     number of bytes to read
+ * @param   timeout in ticks
+ *
+ * @returns number of bytes read, less than len on timeout or abort
  */
 uint32_t Modem_readBlock( uint8_t *data, uint32_t len, uint32_t timeout )
 {
-	bool rc_ok = true;
-	uint32_t bytesRead = 0;
+	uint32_t bytesRead = ModemIo_Read(data, len, timeout);
 
-    CS1_CriticalVariable();
-
-    CS1_EnterCritical();
-	modemStatus.transparentRxState.dest = data;
-	modemStatus.transparentRxState.count = len;
-	modemStatus.transparentRxState.amount = len;
-    CS1_ExitCritical();
-
-    // make sure semaphore is cleared
-    xSemaphoreTake( modemStatus.transparentRxState.readWait, ( TickType_t ) 0 ) ;
-
-    // kick off the read by a dummy event, does not harm
-    xEventGroupSetBits(_EventGroup_Modem, MODEM_RX);
-
-	// wait for semaphore or timeout
-	if (rc_ok)
+	if (bytesRead != len)
 	{
-		rc_ok = (xSemaphoreTake( modemStatus.transparentRxState.readWait, ( TickType_t ) timeout ) == pdTRUE);
-	    CS1_CriticalVariable();
-	    CS1_EnterCritical();
-
-		bytesRead = len - modemStatus.transparentRxState.count;
-		modemStatus.transparentRxState.count = 0; // essentially stops reading anything that arrives now.
-
-	    CS1_ExitCritical();
-
-		if (rc_ok == false)
-		{
-			g_ModemDebugData[0] = 1;
-			g_ModemDebugData[1] = timeout;
-			// TODO : if timeout occurred, set modem state in error ?
-		}
+		g_ModemDebugData[0] = 1;
+		g_ModemDebugData[1] = timeout;
+		// TODO : if timeout occurred, set modem state in error ?
 	}
-	else
+
+	// anything left behind belongs to the next read, give the 'hint' for it again
+	modemStatus.lastCharsInRxBufCount = 0;
+	if (Modem_UART_GetCharsInRxBuf() > 0)
 	{
-		g_ModemDebugData[0] = 2;
-		g_ModemDebugData[1] = timeout;
+		xEventGroupSetBits(_EventGroup_Modem, MODEM_RX);
 	}
 	return bytesRead;
-
 }
 
 static void Modem_readBlockAbort()
 {
-    // read is in progress, if there are still bytes to read
-    if (modemStatus.transparentRxState.count) {
-        // this will act as if the read is done by the ISR task, but bytesRead will be less then requested
-        xSemaphoreGive(modemStatus.transparentRxState.readWait);
-    }
+    // a read in progress returns with less bytes than requested
+    ModemIo_ReadAbort();
 }
 
 /*
@@ -845,6 +791,7 @@ tModemTaskRc modemSendAt(tModemResultFunc * resultFunc, uint32_t maxAtWait, tMod
 		else
 		{
 			bool rc_ok = true;
+			TRACE_ENTER(TRACE_MODEM_AT);
 			// If the command is NULL, then we intend to exit the transparent mode
 			// so none of the following is necessary, go to the else part straight away.
 			if(cmd != NULL)
@@ -935,6 +882,8 @@ tModemTaskRc modemSendAt(tModemResultFunc * resultFunc, uint32_t maxAtWait, tMod
 				}
        		}
 
+       		TRACE_EXIT(TRACE_MODEM_AT);
+
        		// next AT command should not be issued directly after this one
        		startAtCommandBlockout();
 			modemStopTicks = 0;
@@ -980,6 +929,35 @@ int Modem_write(uint8_t *data, uint32_t len, uint32_t timeoutMs)
 	return writecount;
 }
 
+// queues the data for sending and returns, the data must stay untouched until it is sent
+// returns the number of bytes queued
+int Modem_writeQueued(const uint8_t *data, uint32_t len, uint32_t timeoutMs)
+{
+	int writecount = FAILURE;
+
+	if (modemStatus.ioState != MODEMIOSTATE_TRANSPARENT)
+	{
+		LOG_DBG(LOG_LEVEL_MODEM,"MODEM_writeQueued: wrong modem state : %s\n",MODEM_IOSTATETOSTRING(modemStatus.ioState));
+	}
+	else
+	{
+		// grab access semaphore
+		if (pdTRUE != xSemaphoreTake(modemStatus.semAccess , timeoutMs/portTICK_PERIOD_MS))
+		{
+			LOG_DBG(LOG_LEVEL_MODEM,"MODEM_writeQueued: access semTake failed\n" );
+		}
+		else
+		{
+			if (ModemIo_WriteQueue(data, len, NULL, NULL, timeoutMs/portTICK_PERIOD_MS))
+			{
+				writecount = (int)len;
+			}
+       		xSemaphoreGive( modemStatus.semAccess );
+		}
+	}
+	return writecount;
+}
+
 // returns the number of bytes read
 int Modem_read(uint8_t *data, uint32_t len, uint32_t timeoutMs)
 {
@@ -1018,8 +996,6 @@ int Modem_read(uint8_t *data, uint32_t len, uint32_t timeoutMs)
 //	printf("ioState = %s\n", MODEM_IOSTATETOSTRING(modemStatus.ioState));
 //	printf("AtCommandState = %s\n", MODEM_ATCOMMANDSTATETOSTRING(modemStatus.atCommand.AtCommandState ) );
 //	printf("Characters in responseBuf = %d\n", modemStatus.atCommand.ATresponseBufIdx);
-//	printf("transparent mode read status:\n");
-//	printf("dest address=%08x, amount=%d, count=%d\n",modemStatus.transparentRxState.dest, modemStatus.transparentRxState.amount, modemStatus.transparentRxState.count);
 //}
 
 /*
@@ -1075,7 +1051,7 @@ void Modem_WriteModemDebugDataAsEvents()
 		len += sprintf(&pFormattedStrBuf[len], ", %d", g_ModemDebugData[i]);
 	}
 
-	LOG_EVENT(10, LOG_NUM_MODEM, ERRLOGDEBUG, pFormattedStrBuf);
+	LOG_EVENT(10, LOG_NUM_MODEM, ERRLOGDEBUG, "%s", pFormattedStrBuf);
 }
 
 
@@ -124,12 +124,6 @@ typedef struct modem_status {
 		uint8_t *ATcopyptr;
 		uint32_t ATcopycount;
 	} atCommand;
-	struct {
-		SemaphoreHandle_t readWait;
-		uint8_t * dest;
-		uint32_t amount;
-		uint32_t count;
-	} transparentRxState;
 	uint32_t lastCharsInRxBufCount;// used to not spam callback calls when characters are received and nobody paying attention
 } tModemStatus;
 
@@ -166,10 +160,11 @@ void xTaskModem( void *pvParameters );
 BaseType_t Modem_NotifyRxData_ISR( uint32_t modemInterface );
 void Modem_DCD_ISR(uint32_t modemInterface );
 
-uint8_t Modem_UART_GetCharsInRxBuf();
+uint32_t Modem_UART_GetCharsInRxBuf();
 
 tModemTaskRc modemSendAt(tModemResultFunc * resultFunc, uint32_t maxAtWait,  tModemAtRc *pAtRc, const char *fmt, ...);
 int Modem_write(uint8_t *data, uint32_t len, uint32_t timeoutMs);
+int Modem_writeQueued(const uint8_t *data, uint32_t len, uint32_t timeoutMs);
 int Modem_read(uint8_t *data, uint32_t len, uint32_t timeoutMs);
 
 
@@ -51,6 +51,9 @@ typedef enum {
 
 // callback functions, a separate one, for every SvcData originated received message
 typedef uint32_t (* tSvcDataCallbackFuncPtr)(void * buf );
+// progress of a block transfer, the number of leading blocks delivered of the block count
+typedef void (* tSvcDataBlocksAckedFuncPtr)(uint32_t blocksAcked, uint32_t blockCount);
+
 typedef enum
 {
     SvcData_cb_pubAlive = 0,
@@ -138,6 +141,22 @@ ISvcDataRc_t ISvcData_Publish_Alive( void );
  */
 ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElementsOverrule, SKF_MsgType msgType, int32_t message_id );
 
+/**
+ * ISvcData_Publish_DataBlocks
+ *
+ * @brief Send message: Data, resuming a block transfer
+ * As ISvcData_Publish_Data, but starts at block firstBlock, the first one not delivered by an earlier
+ * (broken off) call for the same data, and reports each time more blocks are delivered.
+ *
+ * @param firstBlock    the first block to send, 0 for all
+ * @param blocksAcked   progress callback, or NULL, only called when published at QOS1
+ * @return
+ *   ISVCDATARC_OK       all blocks sent, and acknowledged when published at QOS1
+ *   ISVCDATARC_STATE    state error, e.g. service was not running
+ */
+ISvcDataRc_t ISvcData_Publish_DataBlocks(  SvcDataData_t * dataListId, uint32_t nrElementsOverrule, SKF_MsgType msgType, int32_t message_id,
+                                           uint32_t firstBlock, tSvcDataBlocksAckedFuncPtr blocksAcked );
+
 
 /**
  * ISvcData_RequestStoreData
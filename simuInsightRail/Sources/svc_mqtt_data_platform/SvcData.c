@@ -51,6 +51,7 @@ extern "C" {
 #include "SvcDataCLI.h"
 #include "CS1.h"
 #include "Resources.h"
+#include "Trace.h"
 
 // cpu.h or lower defines these two, but in a different way than another include file, and we do not use this define, so to avoid problems, undefine these
 #undef BIG_ENDIAN
@@ -62,6 +63,9 @@ extern "C" {
 // big TODO: undefine PROTOBUFTEST  when committing !!!
 //#define PROTOBUFTEST
 
+// wait for the PUBACKs of a QoS1 block transfer, time for a few full send buffers on a slow link
+#define SVCDATA_PUBACK_FLUSH_TIMEOUT_MS     (60000)
+
 /*
  * Types
  */
@@ -107,13 +111,14 @@ typedef struct {
 static SvcData_State_t State;
 
 // TX buffer (RX buffer is shared and provided by COMM component)
-// TODO : check that the size should be 'mqtt overhead' smaller than the mqtt buffer
-// mqtt overhead for a publish is roughly topiclenght+payloadlength+4
-// TxBuf would be the payload, so CONFIG_MQTT_SEND_BUFFER_SIZE-4-MAXTOPICSIZE
+// TxBuf is the publish payload, sent by the MQTT client straight from here (or copied into its
+// publish window), so it is the largest publish less the mqtt header and topic
 #ifdef PROTOBUF_GPB2_1
-static uint8_t TxBuf[CONFIG_MQTT_SEND_BUFFER_SIZE - MQTT_MAX_TOPIC_LEN - 4] = {SVCDATA_MQTT_SERDES_ID_GPB2_1, 0,};
+static uint8_t TxBuf[CONFIG_MQTT_MAX_PUBLISH_SIZE - CONFIG_MQTT_PUBLISH_OVERHEAD] = {SVCDATA_MQTT_SERDES_ID_GPB2_1, 0,};
+#define SVCDATA_TXBUF_PREAMBLE  (3)     // preamble + msg type
 #else
-static uint8_t TxBuf[CONFIG_MQTT_SEND_BUFFER_SIZE - MQTT_MAX_TOPIC_LEN - 4] = {SVCDATA_MQTT_SERDES_ID_GPB2, 0,};
+static uint8_t TxBuf[CONFIG_MQTT_MAX_PUBLISH_SIZE - CONFIG_MQTT_PUBLISH_OVERHEAD] = {SVCDATA_MQTT_SERDES_ID_GPB2, 0,};
+#define SVCDATA_TXBUF_PREAMBLE  (1)     // preamble
 #endif
 
 // Constructed MQTT TOPIC buffers
@@ -134,6 +139,17 @@ const  SKF_SvcDataMsg SvcDataMsg_Init = SKF_SvcDataMsg_init_default;
  */
 
 
+// encode a message, timed as the pbencode trace region
+static bool SvcDataEncode(pb_ostream_t *stream_p, const SKF_SvcDataMsg *msg_p)
+{
+    TRACE_ENTER(TRACE_PB_ENCODE);
+    bool rc_ok = pb_encode(stream_p, SKF_SvcDataMsg_fields, msg_p);
+    TRACE_EXIT(TRACE_PB_ENCODE);
+
+    return rc_ok;
+}
+
+
 /*
  * callback administration
  */
@@ -304,6 +320,36 @@ void SvcData_SetTimestamp(uint64_t timestamp)
 }
 
 
+/**
+ * SvcData_SetPublishQos
+ *
+ * @brief Set the QoS of the messages published, QOS1 has them acknowledged
+ * (and retransmitted) within the MQTT client's publish window
+ * @param qos
+ */
+void SvcData_SetPublishQos(enum QoS qos)
+{
+    State.mqttQosDefault = qos;
+}
+
+
+/**
+ * SvcData_IsPublishAcknowledged
+ *
+ * @brief Whether the server acknowledges the messages published (QOS1), so that
+ * ISvcData_Publish_DataBlocks() returning OK means delivered, not just handed to the modem
+ * @return true when acknowledged
+ */
+bool SvcData_IsPublishAcknowledged(void)
+{
+#ifdef PROTOBUFTEST
+    return true; // handled here, not sent
+#else
+    return (State.mqttQosDefault == QOS1);
+#endif
+}
+
+
 /**
  * SvcData_PublishMQTTMessage
  *
@@ -925,7 +971,7 @@ ISvcDataRc_t ISvcData_Publish_Alive( void )
     MsgTx._messages.publish._publications.alive.time_stamp = ConfigSvcData_GetIDEFTime();
     LOG_DBG( LOG_LEVEL_COMM, "MsgTx alive timestamp: %llu\n", MsgTx._messages.publish._publications.alive.time_stamp );
 
-    if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+    if (!SvcDataEncode(&stream, &MsgTx)) {
         LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal)\n" );
     }
 
@@ -965,6 +1011,117 @@ bool svcData_GetBlockInfo(uint32_t * offset_p, uint32_t * maxNrElements_p)
     return (State.blockTransfer);
 }
 
+/*
+ * SvcData_InitPublishData
+ *
+ * @brief Fill in MsgTx as block block_index of block_count of a PUBLISH-DATA message.
+ * The elements of the block are those set by State.ElementOffset and State.nrElements.
+ */
+static void SvcData_InitPublishData(SvcDataData_t * dataListId, SKF_MsgType msgType, int32_t message_id,
+                                    uint32_t block_count, uint32_t block_index)
+{
+    MsgTx = SvcDataMsg_Init;
+
+    MsgTx.hdr.function_id = SKF_FunctionId_PUBDATA;
+    MsgTx.hdr.message_id = message_id;
+    MsgTx.hdr.source_id.funcs.encode = &SvcDataMsg_HdrEncodeSourceId;
+    MsgTx.hdr.source_id.arg = 0; // TODO Pass source ID to encode function
+    MsgTx.hdr.type = msgType;
+    MsgTx.hdr.version = SVC_DATA_PROTOCOL_VERSION;
+
+    MsgTx.which__messages = SKF_SvcDataMsg_publish_tag;
+    MsgTx._messages.publish.which__publications = SKF_Publish_data_tag;
+
+    MsgTx._messages.publish._publications.data.block_count = block_count;
+    MsgTx._messages.publish._publications.data.block_index = block_index;
+    MsgTx._messages.publish._publications.data.has_block_count = block_count>1/* State.blockTransfer */;
+    MsgTx._messages.publish._publications.data.has_block_index = block_count>1/* State.blockTransfer */;
+
+    MsgTx._messages.publish._publications.data.data.param_value_groups.funcs.encode = &SvcDataMsg_EncodeParameterValueGroup;
+    MsgTx._messages.publish._publications.data.data.param_value_groups.arg = (void*)dataListId;
+}
+
+typedef struct {
+    SvcDataData_t * dataListId;
+    SKF_MsgType     msgType;
+    int32_t         message_id;
+} tSvcDataBlockPlan;
+
+/*
+ * SvcData_PublishDataBlockSize
+ *
+ * @brief Block planning sizing pass, the encoded size of a PUBLISH-DATA block.
+ * A published message gets its id when sent, so it is sized with the largest id, that way the plan,
+ * and so the blocks, are the same for every transfer of the data (a resumed transfer relies on that).
+ */
+static bool SvcData_PublishDataBlockSize(uint32_t blockIndex, uint32_t blockCount, uint32_t offset, uint32_t nrElements,
+                                         void * arg, size_t * size_p)
+{
+    const tSvcDataBlockPlan * plan_p = arg;
+
+    State.ElementOffset = offset;
+    State.nrElements = nrElements;
+    SvcData_InitPublishData(plan_p->dataListId, plan_p->msgType,
+                            plan_p->msgType == SKF_MsgType_REPLY ? plan_p->message_id : INT32_MAX,
+                            blockCount, blockIndex);
+    return pb_get_encoded_size(size_p, SKF_SvcDataMsg_fields, &MsgTx);
+}
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+/*
+ * SvcData_TestPublishDataBlock
+ *
+ * @brief For the unit tests, MsgTx made up as ISvcData_Publish_DataBlocks() does for a block, with the
+ * elements offset to offset+nrElements of the arrays in dataListId and the planning message id.
+ * The block is the service state, so not while it publishes, SvcData_TestEnd() when done.
+ *
+ * @return the message, to encode or size
+ */
+const SKF_SvcDataMsg * SvcData_TestPublishDataBlock(SvcDataData_t * dataListId, uint32_t blockIndex, uint32_t blockCount,
+                                                    uint32_t offset, uint32_t nrElements)
+{
+    State.blockTransfer = true;
+    State.ElementOffset = offset;
+    State.nrElements = nrElements;
+    SvcData_InitPublishData(dataListId, SKF_MsgType_PUBLISH, INT32_MAX, blockCount, blockIndex);
+
+    return &MsgTx;
+}
+
+/*
+ * SvcData_TestPlanBlocks
+ *
+ * @brief For the unit tests, the elements per block ISvcData_Publish_DataBlocks() plans for nrElements
+ * of the one array in dataListId, in blocks of at most maxSize. SvcData_TestEnd() when done.
+ *
+ * @return the number of elements per block, 0 when not even one element fits
+ */
+uint32_t SvcData_TestPlanBlocks(SvcDataData_t * dataListId, uint32_t nrElements, size_t maxSize)
+{
+    tSvcDataBlockPlan plan = { dataListId, SKF_MsgType_PUBLISH, 0 };
+    const DataDef_t * dataDef_p = getDataDefElementById(SvcData_IdefIdToDataStoreId(dataListId->ParamValueGroup_p->ParamValue_p[0]));
+
+    if (dataDef_p == NULL) {
+        return 0;
+    }
+    State.blockTransfer = true;
+    return SvcDataMsg_PlanBlockElements(nrElements, DATADEFTYPE2SIZE(dataDef_p->type), maxSize,
+                                        &SvcData_PublishDataBlockSize, &plan);
+}
+
+/*
+ * SvcData_TestEnd
+ *
+ * @brief Back out of the block state of the unit tests
+ */
+void SvcData_TestEnd(void)
+{
+    State.blockTransfer = false;
+    State.ElementOffset = 0;
+    State.nrElements = 0;
+}
+#endif
+
 /**
  * ISvcData_Publish_Data
  *
@@ -985,12 +1142,55 @@ bool svcData_GetBlockInfo(uint32_t * offset_p, uint32_t * maxNrElements_p)
  *   ISVCDATARC_STATE    state error, e.g. service was not running
  */
 ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElementsOverrule, SKF_MsgType msgType, int32_t message_id )
+{
+    return ISvcData_Publish_DataBlocks( dataListId, nrElementsOverrule, msgType, message_id, 0, NULL );
+}
+
+#ifndef PROTOBUFTEST
+/*
+ * SvcData_BlocksDelivered
+ *
+ * @brief The number of leading blocks of a transfer known to be delivered.
+ * PUBACKs come in publish order and the publishes in flight are the latest ones. They may include
+ * publishes sent before the transfer (window slots kept over a reconnect, other QoS1 publishes),
+ * those are acknowledged before any block, so counting them as blocks never counts a block too many.
+ *
+ * @param firstBlock    the first block sent by this transfer
+ * @param blocksSent    the blocks sent by it, from firstBlock
+ */
+static uint32_t SvcData_BlocksDelivered(uint32_t firstBlock, uint32_t blocksSent)
+{
+    int32_t delivered = (int32_t)blocksSent - MQTTPublishInflight(State.mqttClient_p);
+
+    return firstBlock + ((delivered > 0) ? (uint32_t)delivered : 0);
+}
+#endif
+
+/**
+ * ISvcData_Publish_DataBlocks
+ *
+ * @brief Send message: Data, starting at a given block
+ * As ISvcData_Publish_Data, but the blocks before firstBlock are skipped, they were delivered by an
+ * earlier call that was broken off. The block split only depends on the data list and the number of
+ * elements, so the blocks sent are the same as those of the earlier call.
+ *
+ * @param firstBlock    the first block to send, 0 for all
+ * @param blocksAcked   when not NULL, called (without the API mutex) each time more blocks are known
+ *                      to be delivered, with the number of leading blocks delivered and the block count,
+ *                      so only when published at QOS1
+ * @return
+ *   ISVCDATARC_OK       all blocks sent, and acknowledged when published at QOS1
+ *   ISVCDATARC_STATE    state error, e.g. service was not running
+ */
+ISvcDataRc_t ISvcData_Publish_DataBlocks(  SvcDataData_t * dataListId, uint32_t nrElementsOverrule, SKF_MsgType msgType, int32_t message_id,
+                                           uint32_t firstBlock, tSvcDataBlocksAckedFuncPtr blocksAcked )
 {
     int rc = -1;
     int result = ISVCDATARC_OK;
     uint32_t block_count = 1;
 
     uint32_t block_index = 0;
+    uint32_t blocks_acked = firstBlock;
 
 #ifdef DEBUG
     uint32_t startTimeMs, stopTimeMs;
@@ -1029,24 +1229,31 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
                 const DataDef_t * dataDef_p;
                 dataDef_p = getDataDefElementById( storeId);
                 if (dataDef_p != NULL) {
-                    uint32_t maxElementsPerBuffer, bufferSpace;
-
-                    // approximate room we have each buffer :
+                    tSvcDataBlockPlan plan = { dataListId, msgType, message_id };
+                    uint32_t maxElementsPerBuffer;
 
-                    bufferSpace = (sizeof(TxBuf) - sizeof(MsgTx.hdr)) *0.9 ; // TODO: replace wild guess about the overhead with something more precise
-                    maxElementsPerBuffer = bufferSpace / (DATADEFTYPE2SIZE(dataDef_p->type));
                     if (nrElementsOverrule == 0) {
                         nrElementsOverrule = dataDef_p->length;
                     }
                     if (nrElementsOverrule > dataDef_p->length) {
                         nrElementsOverrule = dataDef_p->length; // boundary check
                     }
-                    block_count = nrElementsOverrule/maxElementsPerBuffer +1;
                     State.blockTransfer = true;//block_count>1;
 
-                    State.maxElementsPerBuffer = maxElementsPerBuffer;
+                    // as many elements in each buffer as fit, found by sizing the messages
+                    maxElementsPerBuffer = SvcDataMsg_PlanBlockElements(nrElementsOverrule, DATADEFTYPE2SIZE(dataDef_p->type),
+                                                                        sizeof(TxBuf) - SVCDATA_TXBUF_PREAMBLE,
+                                                                        &SvcData_PublishDataBlockSize, &plan);
+                    if (maxElementsPerBuffer > 0) {
+                        block_count = (nrElementsOverrule + maxElementsPerBuffer - 1) / maxElementsPerBuffer;
+                    } else if (nrElementsOverrule == 0) {
+                        block_count = 1;// nothing, but the message is sent all the same
+                    } else {
+                        LOG_DBG( LOG_LEVEL_COMM, "ISvcData_Publish_Data(): no element of 0x%08x fits a buffer\n", dataDef_p->objectId);
+                        result = ISVCDATARC_ERR_PARAM;
+                    }
 
-                    //printf("maxElementsPerBuffer = %d, bufferSpace = %d\n",maxElementsPerBuffer, bufferSpace);// TODO : remove
+                    State.maxElementsPerBuffer = maxElementsPerBuffer;
 
                 } else {
                     result = ISVCDATARC_ERR_PARAM;
@@ -1063,11 +1270,20 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
 
 
 
-    for (block_index=0; (block_index < block_count) && (result == ISVCDATARC_OK); block_index++) {
+    if ((result == ISVCDATARC_OK) && (firstBlock > 0)) {
+        if (firstBlock >= block_count) {
+            // all delivered already
+            if (blocksAcked) blocksAcked(block_count, block_count);
+            return ISVCDATARC_OK;
+        }
+        LOG_DBG( LOG_LEVEL_COMM, "ISvcData_Publish_Data(): resume at block %d of %d\n", firstBlock, block_count);
+    }
+
+    for (block_index=firstBlock; (block_index < block_count) && (result == ISVCDATARC_OK); block_index++) {
 
         LOG_DBG( LOG_LEVEL_COMM, "block_count/index = %d/%d\n",block_count,block_index);// TODO : remove
 
-        if (block_index > 0) {
+        if (block_index > firstBlock) {
             // TODO Need to be resolved
         	// With out the delay the multiple blocks transfer will end up in sending a block multiple time
         	// missing another block. (the case when receiving a block at the same time as sending)
@@ -1085,9 +1301,6 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
 
         // Construct PUBLISH-DATA message and send
 
-        // Construct message
-        MsgTx = SvcDataMsg_Init;
-
 #ifdef PROTOBUF_GPB2_1
         // Define serialization type (Preamble)
         TxBuf[0] = SVCDATA_MQTT_SERDES_ID_GPB2_1;
@@ -1098,38 +1311,23 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
         // Skip Preamble + MsgType
         // For now use the the UNKNOWN Msg type as intermediate step for
         // NEW implementation of the flat IDEF protocol
-        pb_ostream_t stream = pb_ostream_from_buffer(&TxBuf[3], sizeof(TxBuf)-3);
 #else
         // Define serialization type (Preamble)
         TxBuf[0] = SVCDATA_MQTT_SERDES_ID_GPB2;
 
         // Skip Preamble
-        pb_ostream_t stream = pb_ostream_from_buffer(&TxBuf[1], sizeof(TxBuf)-1);
 #endif
+        // Single pass, the parameter value callbacks fetch the data from the DataStore only once
+        pb_ostream_t stream = pb_ostream_from_buffer_single_pass(&TxBuf[SVCDATA_TXBUF_PREAMBLE], sizeof(TxBuf)-SVCDATA_TXBUF_PREAMBLE);
 
-        MsgTx.hdr.function_id = SKF_FunctionId_PUBDATA;
-        MsgTx.hdr.message_id = msgType == SKF_MsgType_REPLY ? message_id : DATAMSG_GETNEXTID(State.dataMsgTxLastId);
-        MsgTx.hdr.source_id.funcs.encode = &SvcDataMsg_HdrEncodeSourceId;
-        MsgTx.hdr.source_id.arg = 0; // TODO Pass source ID to encode function
-        MsgTx.hdr.type = msgType;
-        MsgTx.hdr.version = SVC_DATA_PROTOCOL_VERSION;
-
-        MsgTx.which__messages = SKF_SvcDataMsg_publish_tag;
-        MsgTx._messages.publish.which__publications = SKF_Publish_data_tag;
-
-        // TODO : what to do with messages which have blocks ?
-        MsgTx._messages.publish._publications.data.block_count = block_count;
-        MsgTx._messages.publish._publications.data.block_index = block_index;
-        MsgTx._messages.publish._publications.data.has_block_count = block_count>1/* State.blockTransfer */;
-        MsgTx._messages.publish._publications.data.has_block_index = block_count>1/* State.blockTransfer */;
-
-        MsgTx._messages.publish._publications.data.data.param_value_groups.funcs.encode = &SvcDataMsg_EncodeParameterValueGroup;
-        MsgTx._messages.publish._publications.data.data.param_value_groups.arg = (void*)dataListId;
+        // Construct message
+        SvcData_InitPublishData(dataListId, msgType, msgType == SKF_MsgType_REPLY ? message_id : DATAMSG_GETNEXTID(State.dataMsgTxLastId),
+                                block_count, block_index);
 
 
         // LOG_DBG( LOG_LEVEL_COMM, "MsgTx dataListId: %u\n", dataListId );
 
-        if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+        if (!SvcDataEncode(&stream, &MsgTx)) {
             LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal) pbencode error: %s\n", stream.errmsg ? stream.errmsg : "unknown" );
             result = ISVCDATARC_ERR_FATAL; // programming error ?
         }
@@ -1137,13 +1335,7 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
         //SvcDataMsg_PrintOStreamBytes(&stream);
 
         if (result == ISVCDATARC_OK) {
-            size_t len = stream.bytes_written;
-
-#ifdef PROTOBUF_GPB2_1
-            len += 3; // Add length of preamble + msg_type
-#else
-            len += 1; // Add length of preamble
-#endif
+            size_t len = stream.bytes_written + SVCDATA_TXBUF_PREAMBLE; // Add length of preamble (+ msg_type)
 
             //printf("encoded size = %d\n",len);
 #ifdef PROTOBUFTEST
@@ -1160,7 +1352,43 @@ ISvcDataRc_t ISvcData_Publish_Data(  SvcDataData_t * dataListId, uint32_t nrElem
         // Release API Mutex
         xSemaphoreGive(State.apiMutex);
 
+#ifdef PROTOBUFTEST
+        if ((result == ISVCDATARC_OK) && blocksAcked) {
+            blocks_acked = block_index + 1;
+            blocksAcked(blocks_acked, block_count);
+        }
+#else
+        // PUBACKs come in publish order, so all but the blocks still in flight are delivered
+        if ((result == ISVCDATARC_OK) && blocksAcked && (State.mqttQosDefault == QOS1)) {
+            uint32_t acked = SvcData_BlocksDelivered(firstBlock, block_index + 1 - firstBlock);
+            if (acked > blocks_acked) {
+                blocks_acked = acked;
+                blocksAcked(blocks_acked, block_count);
+            }
+        }
+#endif
+    }
+#ifndef PROTOBUFTEST
+    // the blocks were sent ahead of their PUBACKs, the data is only delivered once they are all in
+    if ((result == ISVCDATARC_OK) && (State.mqttQosDefault == QOS1)) {
+        if (MQTTPublishFlush(State.mqttClient_p, SVCDATA_PUBACK_FLUSH_TIMEOUT_MS) != SUCCESS) {
+            LOG_DBG( LOG_LEVEL_COMM, "ISvcData_Publish_Data(): not all blocks acknowledged\n");
+            result = ISVCDATARC_ERR_MQTT;
+            if (blocksAcked) {
+                // record those that did come in, to resume after
+                uint32_t acked = SvcData_BlocksDelivered(firstBlock, block_count - firstBlock);
+                if (acked > blocks_acked) {
+                    blocks_acked = acked;
+                    blocksAcked(blocks_acked, block_count);
+                }
+            }
+        }
     }
+    // all acknowledged, QoS0 blocks are never known to be delivered so are not reported
+    if ((result == ISVCDATARC_OK) && blocksAcked && (State.mqttQosDefault == QOS1) && (blocks_acked < block_count)) {
+        blocksAcked(block_count, block_count);
+    }
+#endif
 #ifdef DEBUG
 
 //    SEGGER_SYSVIEW_OnUserStop(0x1);
@@ -1266,7 +1494,7 @@ ISvcDataRc_t ISvcData_RequestStoreData(  SvcDataData_t * dataListId, uint32_t *
 
         // LOG_DBG( LOG_LEVEL_COMM, "MsgTx dataListId: %u\n", dataListId );
 
-        if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+        if (!SvcDataEncode(&stream, &MsgTx)) {
             LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal) pbencode error: %s\n", stream.errmsg ? stream.errmsg : "unknown" );
             result = ISVCDATARC_ERR_FATAL; // programming error ?
         }
@@ -1433,7 +1661,7 @@ ISvcDataRc_t ISvcData_ReplyStoreData( uint32_t message_id, int32_t result_code,
             LOG_DBG( LOG_LEVEL_COMM,"MsgTx replyStoreData info : %s\n", info);
         }
 
-        if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+        if (!SvcDataEncode(&stream, &MsgTx)) {
             LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal) pbencode error: %s\n", stream.errmsg ? stream.errmsg : "unknown" );
             result = ISVCDATARC_ERR_FATAL; // programming error ?
         }
@@ -1603,7 +1831,7 @@ ISvcDataRc_t ISvcData_RequestGetData(  SvcDataParamValueGroup_t * dataListId, ui
 
         // LOG_DBG( LOG_LEVEL_COMM, "MsgTx dataListId: %u\n", dataListId );
 
-        if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+        if (!SvcDataEncode(&stream, &MsgTx)) {
             LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal) pbencode error: %s\n", stream.errmsg ? stream.errmsg : "unknown" );
             result = ISVCDATARC_ERR_FATAL; // programming error ?
         }
@@ -1744,7 +1972,7 @@ ISvcDataRc_t ISvcData_ReplyGetData( uint32_t message_id, int32_t result_code, ch
             LOG_DBG( LOG_LEVEL_COMM,"MsgTx replyGetData info : %s\n", info);
         }
 
-        if (!pb_encode(&stream, SKF_SvcDataMsg_fields, &MsgTx)) {
+        if (!SvcDataEncode(&stream, &MsgTx)) {
             LOG_DBG( LOG_LEVEL_COMM, "pb_encode error! (fatal) pbencode error: %s\n", stream.errmsg ? stream.errmsg : "unknown" );
             result = ISVCDATARC_ERR_FATAL; // programming error ?
         }
@@ -17,6 +17,7 @@ extern "C" {
  */
 #include "MQTTClient.h"
 #include "configIDEF.h"
+#include "svcdata.pb.h"
 
 /*
  * Macros
@@ -76,6 +77,16 @@ int SvcData_PublishMQTTMessage( void *payload_p, int payloadlen );
 bool svcData_GetBlockInfo(uint32_t * offset_p, uint32_t * maxNrElements_p);
 
 void SvcData_SetTimestamp(uint64_t timestamp);
+void SvcData_SetPublishQos(enum QoS qos);
+bool SvcData_IsPublishAcknowledged(void);
+
+#ifdef CONFIG_PLATFORM_IDEFSVCTESTDATA
+// unit test access to the PUBLISH-DATA blocks
+const SKF_SvcDataMsg * SvcData_TestPublishDataBlock(SvcDataData_t * dataListId, uint32_t blockIndex, uint32_t blockCount,
+                                                    uint32_t offset, uint32_t nrElements);
+uint32_t SvcData_TestPlanBlocks(SvcDataData_t * dataListId, uint32_t nrElements, size_t maxSize);
+void SvcData_TestEnd(void);
+#endif
 
 // function prototypes for Ephemeris download
 int EPO_Start( void );
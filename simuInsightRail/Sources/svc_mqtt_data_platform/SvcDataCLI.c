@@ -85,6 +85,14 @@ static bool cliSvcData( uint32_t args, uint8_t * argv[], uint32_t * argi)
                 LOG_DBG( LOG_LEVEL_CLI, "Publish Data: failed\n");
             }
         }
+        if (strcmp((const char*)argv[0], "qos") == 0) {
+            if ((args > 1) && (argi[1] <= QOS1)) {
+                SvcData_SetPublishQos((enum QoS)argi[1]);
+                rc = ISVCDATARC_OK;
+            } else {
+                printf("qos must be 0 or 1\n");
+            }
+        }
         if (strcmp((const char*)argv[0], "storeData") == 0) {
             uint32_t testnr = 0;
             uint32_t messageId;
@@ -167,6 +175,7 @@ static bool cliSvcDataLongHelp( uint32_t args, uint8_t * argv[], uint32_t * argi
             "  stop             Stop IDEF Data Service\n"
             "  pubAlive         Publish IDEF Alive message\n"
             "  pubData   <testnum> <elements>  Publish IDEF Data message (testdatasets)\n"
+            "  qos       <0|1>  QoS of the messages published, 1 for acknowledged (mqtt window)\n"
             "  storeData        request IDEF storeData message (testdatasets)\n"
             "  replyStoreData   reply IDEF StoreData message (test purposes only !)\n"
             "  getData          request IDEF getData message (testdatasets)\n"
@@ -305,9 +305,9 @@ bool SvcDataMsg_DecodeHeader(pb_istream_t *stream_p, SKF_SvcDataMsg *msg_p)
 
 bool SvcDataMsg_EncodeUint8(pb_ostream_t *stream_p, const pb_field_t *field, void * const *arg)
 {
-    uint8_t tmp;
-    uint32_t idx;
+    uint8_t tmp[64];// byte arrays (compressed waveforms) can be long, so copy them in pieces
     uint32_t startIdx, count;
+    uint32_t buf_items = sizeof(tmp)/sizeof(*tmp);
 
     const DataDef_t * dataDef_p = *arg;
 
@@ -323,19 +323,23 @@ bool SvcDataMsg_EncodeUint8(pb_ostream_t *stream_p, const pb_field_t *field, voi
         count = dataDef_p->length;
     }
 
+    if (buf_items>count) buf_items=count;
+
     // implement 'own' writestring
-    if (!pb_encode_varint(stream_p, (uint64_t) (sizeof(tmp) * count)))
+    if (!pb_encode_varint(stream_p, (uint64_t) (sizeof(*tmp) * count)))
         return false;
 
-
-    for (idx = startIdx; idx < startIdx+count; idx++) {
-#if 1
-        if (false == DataStore_BlockGetUint8(dataDef_p->objectId, idx, 1, &tmp)) return false;
-
-#else
-        tmp = ((uint8_t *) dataDef_p->address)[idx];      // a lot faster then using DataStore_GetUint16()
-#endif
-        pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp));
+    if (stream_p->callback == NULL) {
+        // nanoproto 'size' probe call, don't do the real work, just simulate we have done it.
+        stream_p->bytes_written += (sizeof(*tmp) * count);
+    } else {
+        while (count) {
+            if (false == DataStore_BlockGetUint8(dataDef_p->objectId, startIdx, buf_items, &tmp[0])) return false;
+            if (!pb_write(stream_p, &tmp[0], buf_items * sizeof(*tmp))) return false;
+            startIdx += buf_items;
+            count -= buf_items;
+            if (buf_items>count) buf_items=count;
+        }
     }
 
     return true;
@@ -365,6 +369,12 @@ bool SvcDataMsg_EncodeUint16(pb_ostream_t *stream_p, const pb_field_t *field, vo
     if (!pb_encode_varint(stream_p, (uint64_t) (sizeof(tmp) * count)))
         return false;
 
+    if (stream_p->callback == NULL) {
+        // nanoproto 'size' probe call, don't do the real work, just simulate we have done it.
+        stream_p->bytes_written += (sizeof(tmp) * count);
+        return true;
+    }
+
     for (idx = startIdx; idx < startIdx+count; idx++) {
 #if 1
         if (false == DataStore_BlockGetUint16(dataDef_p->objectId, idx, 1, &tmp)) return false;
@@ -376,7 +386,7 @@ bool SvcDataMsg_EncodeUint16(pb_ostream_t *stream_p, const pb_field_t *field, vo
 #else
         tmp = __builtin_bswap16(tmp);// convert to high byte first network order
 #endif
-        pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp));
+        if (!pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp))) return false;
     }
 
     return true;
@@ -414,7 +424,7 @@ bool SvcDataMsg_EncodeUint32(pb_ostream_t *stream_p, const pb_field_t *field, vo
         tmp = ((uint32_t *) dataDef_p->address)[idx];      // a lot faster then using DataStore_GetUint32()
 #endif
         tmp = __builtin_bswap32(tmp);// convert to high byte first network order
-        pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp));
+        if (!pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp))) return false;
     }
 
     return true;
@@ -464,7 +474,7 @@ bool SvcDataMsg_EncodeUint32(pb_ostream_t *stream_p, const pb_field_t *field, vo
                 tmp[idx] = _byteswap_ulong(tmp[idx]);
 #endif
             }
-            pb_write(stream_p, (uint8_t*) &tmp[0], buf_items * sizeof(*tmp));
+            if (!pb_write(stream_p, (uint8_t*) &tmp[0], buf_items * sizeof(*tmp))) return false;
             startIdx += buf_items;
             count -= buf_items;
             if (buf_items>count) buf_items=count;
@@ -500,6 +510,12 @@ bool SvcDataMsg_EncodeUint64(pb_ostream_t *stream_p, const pb_field_t *field, vo
     if (!pb_encode_varint(stream_p, (uint64_t) (sizeof(tmp) * count)))
         return false;
 
+    if (stream_p->callback == NULL) {
+        // nanoproto 'size' probe call, don't do the real work, just simulate we have done it.
+        stream_p->bytes_written += (sizeof(tmp) * count);
+        return true;
+    }
+
     for (idx = startIdx; idx < startIdx+count; idx++) {
 #if 1
        if (false == DataStore_BlockGetUint64(dataDef_p->objectId, idx, 1, &tmp)) return false;
@@ -512,7 +528,7 @@ bool SvcDataMsg_EncodeUint64(pb_ostream_t *stream_p, const pb_field_t *field, vo
        tmp = _byteswap_uint64(tmp);// convert to high byte first network order
 #endif
        
-        pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp));
+        if (!pb_write(stream_p, (uint8_t*) &tmp, sizeof(tmp))) return false;
     }
 
     return true;
@@ -553,7 +569,7 @@ bool SvcDataMsg_EncodeSingle(pb_ostream_t *stream_p, const pb_field_t *field, vo
         tmp.f = ((float *) dataDef_p->address)[idx];      // a lot faster then using DataStore_GetUint32()
 #endif
         tmp.u =  __builtin_bswap32( tmp.u);// convert to high byte first network order
-        pb_write(stream_p, (uint8_t*) &tmp.f, sizeof(tmp.f));
+        if (!pb_write(stream_p, (uint8_t*) &tmp.f, sizeof(tmp.f))) return false;
     }
 
     return true;
@@ -606,7 +622,7 @@ bool SvcDataMsg_EncodeSingle(pb_ostream_t *stream_p, const pb_field_t *field, vo
 #endif
                 
             }
-            pb_write(stream_p, (uint8_t*) &tmp[0].u, buf_items * sizeof(tmp[0].u));
+            if (!pb_write(stream_p, (uint8_t*) &tmp[0].u, buf_items * sizeof(tmp[0].u))) return false;
             startIdx += buf_items;
             count -= buf_items;
             if (buf_items>count) buf_items=count;
@@ -644,6 +660,12 @@ bool SvcDataMsg_EncodeDouble(pb_ostream_t *stream_p, const pb_field_t *field, vo
     if (!pb_encode_varint(stream_p, (uint64_t) (sizeof(tmp) * count)))
         return false;
 
+    if (stream_p->callback == NULL) {
+        // nanoproto 'size' probe call, don't do the real work, just simulate we have done it.
+        stream_p->bytes_written += (sizeof(tmp) * count);
+        return true;
+    }
+
     for (idx = startIdx; idx < startIdx+count; idx++) {
 #if 1
        if (false == DataStore_BlockGetDouble(dataDef_p->objectId, idx, 1, &tmp.d)) return false;
@@ -658,7 +680,7 @@ bool SvcDataMsg_EncodeDouble(pb_ostream_t *stream_p, const pb_field_t *field, vo
 #endif
 
         
-        pb_write(stream_p, (uint8_t*) &tmp.d, sizeof(tmp.d));
+        if (!pb_write(stream_p, (uint8_t*) &tmp.d, sizeof(tmp.d))) return false;
 
     }
 
@@ -700,7 +722,7 @@ bool SvcDataMsg_EncodeString(pb_ostream_t *stream_p, const pb_field_t *field, vo
         // now do the same inefficient string read for actually sending the bytes out
         for (idx=0; (idx < len) ; idx++) {
             DataStore_GetString(dataDef_p->objectId, idx, 1, &tmpbuf);// read 1 char from the string (TODO: read a small block to speed things up)
-            pb_write(stream_p, (uint8_t*) &tmpbuf, 1);
+            if (!pb_write(stream_p, (uint8_t*) &tmpbuf, 1)) return false;
         }
 
     }
@@ -712,7 +734,7 @@ bool SvcDataMsg_EncodeString(pb_ostream_t *stream_p, const pb_field_t *field, vo
     if (!pb_encode_varint(stream_p, (uint64_t) len))
         return false;
 
-    pb_write(stream_p, (uint8_t*)dataDef_p->address, len);
+    if (!pb_write(stream_p, (uint8_t*)dataDef_p->address, len)) return false;
 #endif
     return true;
 }
@@ -1131,6 +1153,89 @@ bool SvcDataMsg_DecodeParameterValueGroup(pb_istream_t *stream_p, const pb_field
 
 
 
+// size of the largest block, when perBlock elements go in each: of the full blocks the one with the
+// largest offset, and the last block
+static bool blocksFit(uint32_t nrElements, uint32_t perBlock, size_t maxSize,
+                      tSvcDataMsgBlockSizeFuncPtr blockSize, void * arg, size_t * size_p)
+{
+    uint32_t blockCount = (nrElements + perBlock - 1) / perBlock;
+    uint32_t lastOffset = (blockCount - 1) * perBlock;
+    size_t size;
+
+    if (!blockSize(blockCount - 1, blockCount, lastOffset, nrElements - lastOffset, arg, size_p)) {
+        *size_p = 0;// sizing failed
+        return false;
+    }
+    if ((blockCount > 1) && ((nrElements - lastOffset) < perBlock)) {
+        if (!blockSize(blockCount - 2, blockCount, lastOffset - perBlock, perBlock, arg, &size)) {
+            *size_p = 0;
+            return false;
+        }
+        if (size > *size_p) {
+            *size_p = size;
+        }
+    }
+    return (*size_p <= maxSize);
+}
+
+/*
+ * SvcDataMsg_PlanBlockElements
+ *
+ * @brief Plan the split of an array over a block transfer: the number of elements each block
+ * takes, so that the blocks are packed as full as they can be within maxSize.
+ * All blocks but the last take the same number of elements, so block n always starts at
+ * element n * elements per block, whatever was sent before.
+ * The block sizes come from sizing passes (blockSize), so they are exact for the header and
+ * for the nested length and offset fields, which grow with the element count and offset.
+ *
+ * @param nrElements    the number of array elements to transfer
+ * @param elementSize   the encoded size of an element
+ * @param maxSize       the size available for an encoded block
+ * @param blockSize     sizing function
+ * @param arg           passed to blockSize
+ * @return the number of elements per block, 0 when not even one element fits
+ */
+uint32_t SvcDataMsg_PlanBlockElements(uint32_t nrElements, uint32_t elementSize, size_t maxSize,
+                                      tSvcDataMsgBlockSizeFuncPtr blockSize, void * arg)
+{
+    uint32_t perBlock;
+    size_t size;
+
+    if ((nrElements == 0) || (elementSize == 0)) {
+        return 0;
+    }
+
+    // the size without elements is the overhead, what remains holds at most this many
+    if (!blockSize(0, 1, 0, 0, arg, &size) || (size >= maxSize)) {
+        return 0;
+    }
+    perBlock = (maxSize - size) / elementSize;
+    if (perBlock > nrElements) {
+        perBlock = nrElements;
+    }
+
+    // less, by the bytes the length and offset fields grew
+    while ((perBlock > 0) && !blocksFit(nrElements, perBlock, maxSize, blockSize, arg, &size)) {
+        uint32_t over;
+
+        if (size <= maxSize) {
+            return 0;// sizing failed
+        }
+        over = (size - maxSize + elementSize - 1) / elementSize;
+        perBlock = (over < perBlock) ? perBlock - over : 0;
+    }
+    if (perBlock == 0) {
+        return 0;
+    }
+
+    // a field shrinking with the block count may leave room for another
+    while ((perBlock < nrElements) && blocksFit(nrElements, perBlock + 1, maxSize, blockSize, arg, &size)) {
+        perBlock++;
+    }
+
+    return perBlock;
+}
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
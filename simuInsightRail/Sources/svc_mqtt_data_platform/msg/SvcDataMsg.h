@@ -31,6 +31,10 @@ extern "C" {
  * Types
  */
 
+// gives in size_p the encoded size of block blockIndex of blockCount, holding nrElements array elements from offset
+typedef bool (* tSvcDataMsgBlockSizeFuncPtr)(uint32_t blockIndex, uint32_t blockCount, uint32_t offset, uint32_t nrElements,
+                                             void * arg, size_t * size_p);
+
 /*
  * Data
  */
@@ -59,6 +63,9 @@ bool SvcDataMsg_EncodeString(pb_ostream_t *stream_p, const pb_field_t *field, vo
 bool SvcDataMsg_DecodeParameterValueGroup(pb_istream_t *stream_p, const pb_field_t *field_p, void **arg);
 bool SvcDataMsg_EncodeParameterValueGroup(pb_ostream_t *stream_p, const pb_field_t *field, void * const *arg);
 
+uint32_t SvcDataMsg_PlanBlockElements(uint32_t nrElements, uint32_t elementSize, size_t maxSize,
+                                      tSvcDataMsgBlockSizeFuncPtr blockSize, void * arg);
+
 
 #if 0
 //*********** Encoding *************
@@ -101,7 +101,7 @@ uint8_t *pImageBuf = (uint8_t *) __sample_buffer;
 //uint32_t imageBufSize = (uint32_t) __sample_buffer_size;
 
 
-static uint8_t TxBuf[CONFIG_MQTT_SEND_BUFFER_SIZE - MQTT_MAX_TOPIC_LEN - 4] = {SVCDATA_MQTT_SERDES_ID_GPB2_1, 0,};
+static uint8_t TxBuf[CONFIG_MQTT_MAX_PUBLISH_SIZE - CONFIG_MQTT_PUBLISH_OVERHEAD] = {SVCDATA_MQTT_SERDES_ID_GPB2_1, 0,};
 
 // Constructed MQTT TOPIC buffers
 static char MQTTTopic_SvcFirmware[MQTT_MAX_TOPIC_LEN+1] = {0,}; // NULL terminated string to pass to MQTT(Un)Subscribe()
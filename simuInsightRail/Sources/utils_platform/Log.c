@@ -8,17 +8,38 @@ extern "C" {
  *  Created on: 25 nov. 2015
  *      Author: D. van der Velde
  *
+ * LOG_DBG output does not go to the debug UART in the caller's task, it is
+ * formatted into a ring and written out by the LOG task, at idle priority.
+ * Messages are only added whole, those that do not fit are dropped and
+ * counted, as are those over the rate of their module.
  */
 
 /*
  * Includes
  */
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "Log.h"
+#include "xTaskDefs.h"
 
 /*
  * Macros
  */
 
+// the ring size must be a power of 2
+#define LOG_RING_MASK		(LOG_DBG_RING_SIZE - 1)
+#define LOG_CHUNK			(64)
+
+// the producers only wait for each other's formatting, not for the UART
+#define LOG_MAX_WAIT_MS		(10)
+
 /*
  * Types
  */
@@ -30,13 +51,219 @@ extern "C" {
 /* Global debug log level */
 uint32_t dbg_logging = 0;
 
+/* LOG_DBG messages dropped, the ring was full, and over the rate of their module */
+uint32_t dbg_logDropped = 0;
+uint32_t dbg_logRateLimited = 0;
+
+/*
+ * head is moved by the producers, a whole message at once, tail by the LOG task
+ */
+static struct {
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t pending;		// the end of the message being formatted
+	bool overflow;			// it does not fit
+	char data[LOG_DBG_RING_SIZE];
+} logRing;
+
+// token bucket per module (bit of the level)
+static struct {
+	TickType_t last;
+	uint32_t tokens;
+} logRate[32];
+
+static SemaphoreHandle_t xLogMutex = NULL;
+static TaskHandle_t _TaskHandle_Log = NULL;
 
 /*
  * Functions
  */
 
+/*
+ * logPutCh
+ *
+ * @desc    the put_c of the formatter, adds a character to the message being formatted
+ */
+static void logPutCh(uint8_t c)
+{
+	if((logRing.pending - logRing.tail) >= LOG_DBG_RING_SIZE)
+	{
+		logRing.overflow = true;
+	}
+	if(!logRing.overflow)
+	{
+		logRing.data[logRing.pending++ & LOG_RING_MASK] = c;
+	}
+}
+
+/*
+ * logRateOk
+ *
+ * @desc    takes a token from the bucket of the module of the message
+ *
+ * @param   level - the LOG_LEVEL of the message, the lowest bit set counts
+ *
+ * @returns false when the module is over its rate
+ */
+static bool logRateOk(uint32_t level)
+{
+	TickType_t now = xTaskGetTickCount();
+	uint32_t module = 0;
+	uint32_t refill;
+
+	while((module < 31) && !(level & (1 << module)))
+	{
+		module++;
+	}
+
+	refill = ((now - logRate[module].last) * LOG_DBG_RATE_PER_SEC) / configTICK_RATE_HZ;
+	if(refill > 0)
+	{
+		logRate[module].tokens = ((logRate[module].tokens + refill) < LOG_DBG_RATE_BURST) ?
+								 (logRate[module].tokens + refill) : LOG_DBG_RATE_BURST;
+		logRate[module].last = now;
+	}
+	if(logRate[module].tokens == 0)
+	{
+		return false;
+	}
+	logRate[module].tokens--;
+	return true;
+}
+
+/*
+ * Log_printf
+ *
+ * @desc    formats a LOG_DBG message into the ring, to be written out by the LOG task
+ *          before Log_Init() it is written out at once
+ *
+ * @param   level - the LOG_LEVEL of the message
+ * @param   format, ... - as printf
+ *
+ * @returns -
+ */
+void Log_printf(uint32_t level, const char *format, ...)
+{
+	va_list args;
+	bool added;
+
+	if(xLogMutex == NULL)
+	{
+		va_start(args, format);
+		vprintgdf(put_ch, format, args);
+		va_end(args);
+		return;
+	}
+
+	if(xSemaphoreTake(xLogMutex, LOG_MAX_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE)
+	{
+		dbg_logDropped++;
+		return;
+	}
+	if(!logRateOk(level))
+	{
+		dbg_logRateLimited++;
+		xSemaphoreGive(xLogMutex);
+		return;
+	}
+
+	logRing.pending = logRing.head;
+	logRing.overflow = false;
+	va_start(args, format);
+	vprintgdf(logPutCh, format, args);
+	va_end(args);
+
+	added = !logRing.overflow;
+	if(added)
+	{
+		logRing.head = logRing.pending;
+	}
+	else
+	{
+		dbg_logDropped++;
+	}
+	xSemaphoreGive(xLogMutex);
+
+	if(added)
+	{
+		xTaskNotifyGive(_TaskHandle_Log);
+	}
+}
+
+/*
+ * taskLog
+ *
+ * @desc    writes out the messages in the ring, and reports those dropped
+ */
+static void taskLog(void *pvParameters)
+{
+	char chunk[LOG_CHUNK + 1];
+	uint32_t dropped = 0, rateLimited = 0;
+
+	for(;;)
+	{
+		(void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		while(logRing.tail != logRing.head)
+		{
+			uint32_t tail = logRing.tail & LOG_RING_MASK;
+			uint32_t len = logRing.head - logRing.tail;
+
+			// up to the end of the ring
+			if(len > (LOG_DBG_RING_SIZE - tail))
+			{
+				len = LOG_DBG_RING_SIZE - tail;
+			}
+			if(len > LOG_CHUNK)
+			{
+				len = LOG_CHUNK;
+			}
+			memcpy(chunk, &logRing.data[tail], len);
+			chunk[len] = '\0';
+			logRing.tail += len;
+
+			printf("%s", chunk);
+		}
+
+		if((dropped != dbg_logDropped) || (rateLimited != dbg_logRateLimited))
+		{
+			printf("\n<<< log: %d dropped, %d over rate >>>\n",
+				   dbg_logDropped - dropped, dbg_logRateLimited - rateLimited);
+			dropped = dbg_logDropped;
+			rateLimited = dbg_logRateLimited;
+		}
+	}
+}
+
+/*
+ * Log_Init
+ *
+ * @desc    starts the LOG task, LOG_DBG output goes through the ring from then on
+ *
+ * @returns -
+ */
+void Log_Init(void)
+{
+	if(xLogMutex == NULL)
+	{
+		for(int i = 0; i < sizeof(logRate)/sizeof(logRate[0]); i++)
+		{
+			logRate[i].tokens = LOG_DBG_RATE_BURST;
+		}
+		xTaskCreate( taskLog,                // Task function name
+					 "LOG",                  // Task name string
+					 STACKSIZE_XTASK_LOG,    // Allocated stack size on FreeRTOS heap
+					 NULL,                   // (void*)pvParams
+					 PRIORITY_XTASK_LOG,     // Task priority
+					 &_TaskHandle_Log );     // Task handle
+		if(_TaskHandle_Log != NULL)
+		{
+			xLogMutex = xSemaphoreCreateMutex();
+		}
+	}
+}
 
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
@@ -25,10 +25,10 @@ extern "C" {
  * Macros
  */
 
-// TODO Change to calling CLI write and off-load the calling task from writing to output
+// the output is written by the LOG task, the calling task does not wait for the UART
 #ifdef DEBUG
-#define LOG_DBG(m_level,...)       do { if ((dbg_logging) & (m_level)) printf(__VA_ARGS__); } while (0);
-#define LOG_DBG_NB(m_level,...)    do { if ((dbg_logging) & (m_level)) printf_nb(__VA_ARGS__); } while (0);
+#define LOG_DBG(m_level,...)       do { if ((dbg_logging) & (m_level)) Log_printf((m_level), __VA_ARGS__); } while (0);
+#define LOG_DBG_NB(m_level,...)    do { if ((dbg_logging) & (m_level)) Log_printf((m_level), __VA_ARGS__); } while (0);
 //#define LOG_EVENT(...) do { printf("%s (%d) :",__FILE__,__LINE__); printf(__VA_ARGS__); } while (0);
 #else
 #define LOG_DBG(m_level,...)
@@ -45,11 +45,16 @@ extern "C" {
  */
 
 extern uint32_t dbg_logging;
+extern uint32_t dbg_logDropped;
+extern uint32_t dbg_logRateLimited;
 
 /*
  * Functions
  */
 
+void Log_Init(void);
+void Log_printf(uint32_t level, const char *format, ...);
+
 #endif /* LOG_H_ */
 
 
@@ -0,0 +1,183 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * TaskStats.c
+ *
+ * The FreeRTOS run time counter, on the DWT cycle counter (clock() in the
+ * simulator), and the capture of the CPU time and stack high-water mark of
+ * each task. The counter is extended from the cycle counter at every context
+ * switch and tick, so it does not lose time when the cycle counter wraps.
+ */
+
+/*
+ * Includes
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Resources.h"
+#include "CS1.h"
+#include "printgdf.h"
+#include "TaskStats.h"
+
+/*
+ * Macros
+ */
+
+#define TASKSTATS_CYCLES_MASK	((1u << TASKSTATS_CYCLES_SHIFT) - 1)
+
+/*
+ * Data
+ */
+
+static struct {
+	uint32_t lastCycles;
+	uint32_t remainder;		// cycles not yet counted
+	uint32_t counter;
+} runTime;
+
+/*
+ * Functions
+ */
+
+static uint32_t taskStatsCounterHz(void)
+{
+#ifdef _MSC_VER
+	return CLOCKS_PER_SEC;
+#else
+	return SystemCoreClock >> TASKSTATS_CYCLES_SHIFT;
+#endif
+}
+
+/*
+ * TaskStats_ConfigureTimer
+ *
+ * @desc    portCONFIGURE_TIMER_FOR_RUN_TIME_STATS(), starts the cycle counter
+ *
+ * @returns -
+ */
+void TaskStats_ConfigureTimer(void)
+{
+#ifndef _MSC_VER
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	runTime.lastCycles = DWT->CYCCNT;
+#endif
+}
+
+/*
+ * TaskStats_GetRunTimeCounter
+ *
+ * @desc    portGET_RUN_TIME_COUNTER_VALUE(), also called from the tick hook
+ *          so it is called at least once per cycle counter wrap
+ *
+ * @returns the run time counter
+ */
+uint32_t TaskStats_GetRunTimeCounter(void)
+{
+#ifdef _MSC_VER
+	return (uint32_t)clock();
+#else
+	uint32_t counter;
+	CS1_CriticalVariable();
+
+	CS1_EnterCritical();
+	uint32_t cycles = DWT->CYCCNT;
+	uint32_t elapsed = (cycles - runTime.lastCycles) + runTime.remainder;
+
+	runTime.lastCycles = cycles;
+	runTime.counter += elapsed >> TASKSTATS_CYCLES_SHIFT;
+	runTime.remainder = elapsed & TASKSTATS_CYCLES_MASK;
+	counter = runTime.counter;
+	CS1_ExitCritical();
+
+	return counter;
+#endif
+}
+
+/*
+ * TaskStats_Capture
+ *
+ * @desc    captures the run time and stack high-water mark of every task
+ *
+ * @param   pRecord - RETURNS the statistics, the crc is not set
+ *
+ * @returns false when the task states could not be read
+ */
+bool TaskStats_Capture(tTaskStatsRecord *pRecord)
+{
+	UBaseType_t numTasks = uxTaskGetNumberOfTasks();
+	TaskStatus_t *pStatus;
+
+	memset(pRecord, 0, sizeof(*pRecord));
+	pRecord->counterHz = taskStatsCounterHz();
+
+	// only needed for the capture, so taken from the heap as vTaskGetRunTimeStats() does
+	pStatus = pvPortMalloc(numTasks * sizeof(TaskStatus_t));
+	if(pStatus == NULL)
+	{
+		return false;
+	}
+	numTasks = uxTaskGetSystemState(pStatus, numTasks, &pRecord->totalRunTime);
+
+	pRecord->numTasks = (numTasks < TASKSTATS_MAX_TASKS) ? numTasks : TASKSTATS_MAX_TASKS;
+	for(uint32_t i = 0; i < pRecord->numTasks; i++)
+	{
+		strncpy(pRecord->tasks[i].name, pStatus[i].pcTaskName, sizeof(pRecord->tasks[i].name) - 1);
+		pRecord->tasks[i].runTime = pStatus[i].ulRunTimeCounter;
+		pRecord->tasks[i].stackHighWater = pStatus[i].usStackHighWaterMark;
+		pRecord->tasks[i].priority = pStatus[i].uxBasePriority;
+	}
+	vPortFree(pStatus);
+
+	return (numTasks > 0);
+}
+
+/*
+ * TaskStats_Print
+ *
+ * @desc    prints the CPU time, share and stack high-water mark of each task
+ *
+ * @param   pRecord - the statistics
+ *
+ * @returns -
+ */
+void TaskStats_Print(const tTaskStatsRecord *pRecord)
+{
+	uint32_t total = (pRecord->totalRunTime > 0) ? pRecord->totalRunTime : 1;
+	uint32_t hz = (pRecord->counterHz > 0) ? pRecord->counterHz : 1;
+	uint32_t idle = 0;
+
+	for(uint32_t i = 0; (i < pRecord->numTasks) && (i < TASKSTATS_MAX_TASKS); i++)
+	{
+		if(strcmp(pRecord->tasks[i].name, "IDLE") == 0)
+		{
+			idle = pRecord->tasks[i].runTime;
+		}
+	}
+
+	printf("run time %d ms, %d tasks, cpu load %d%%\n", (uint32_t)(((uint64_t)pRecord->totalRunTime * 1000) / hz),
+		   pRecord->numTasks, 100 - (uint32_t)(((uint64_t)idle * 100) / total));
+	printf("prio   cpu(ms)  cpu(%%)  stack free (%d bytes sized)  task\n", sizeof(StackType_t));
+	for(uint32_t i = 0; (i < pRecord->numTasks) && (i < TASKSTATS_MAX_TASKS); i++)
+	{
+		const tTaskStatsTask *pTask = &pRecord->tasks[i];
+		uint32_t permille = (uint32_t)(((uint64_t)pTask->runTime * 1000) / total);
+
+		printf("%4d %9d %5d.%d %6d  %s\n", pTask->priority,
+			   (uint32_t)(((uint64_t)pTask->runTime * 1000) / hz), permille / 10, permille % 10,
+			   pTask->stackHighWater, pTask->name);
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * TaskStats.h
+ *
+ * FreeRTOS run time statistics and stack high-water marks of all tasks. The
+ * node boots on every wakeup, so the statistics are those of the wakeup.
+ */
+
+#ifndef TASKSTATS_H_
+#define TASKSTATS_H_
+
+/*
+ * Includes
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+/*
+ * Macros
+ */
+
+#define TASKSTATS_MAX_TASKS			(20)
+
+// the run time counter counts cycles / 2^TASKSTATS_CYCLES_SHIFT, it wraps after 38 minutes at 120 MHz
+#define TASKSTATS_CYCLES_SHIFT		(6)
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	char name[configMAX_TASK_NAME_LEN];
+	uint32_t runTime;
+	uint16_t stackHighWater;		// stack words never used
+	uint8_t priority;
+	uint8_t spare;
+} tTaskStatsTask;
+
+// as stored in external flash at the end of a wakeup
+typedef struct
+{
+	uint32_t totalRunTime;
+	uint32_t counterHz;
+	uint32_t numTasks;
+	tTaskStatsTask tasks[TASKSTATS_MAX_TASKS];
+	uint32_t crc;
+} tTaskStatsRecord;
+
+/*
+ * Functions
+ */
+
+void TaskStats_ConfigureTimer(void);
+uint32_t TaskStats_GetRunTimeCounter(void);
+bool TaskStats_Capture(tTaskStatsRecord *pRecord);
+void TaskStats_Print(const tTaskStatsRecord *pRecord);
+
+#endif /* TASKSTATS_H_ */
+
+
+#ifdef __cplusplus
+}
+#endif
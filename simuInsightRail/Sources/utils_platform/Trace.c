@@ -0,0 +1,343 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Trace.c
+ *
+ * Trace points on the DWT cycle counter, the simulator uses clock() instead.
+ * Entering and exiting only reads the counter and updates the statistics of
+ * the region, with interrupts briefly disabled, so they can be left in the hot
+ * paths. Durations are in ticks (cycles), converted to us when printed.
+ */
+
+/*
+ * Includes
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "Resources.h"
+#include "CS1.h"
+#include "printgdf.h"
+#include "Trace.h"
+
+/*
+ * Macros
+ */
+
+#define TRACE_RING_MASK		(TRACE_RING_SIZE - 1)
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[TRACE_HIST_BUCKETS];
+} tTraceRegionStats;
+
+typedef struct
+{
+	uint32_t stamp;
+	uint8_t region;
+	bool bExit;
+} tTraceEvent;
+
+/*
+ * Data
+ */
+
+static const char * const traceNames[TRACE_NUM_REGIONS] =
+{
+	"adcblock",
+	"dspblock",
+	"is25prog",
+	"pbencode",
+	"mqttpub",
+	"modemat",
+};
+
+static tTraceRegionStats traceStats[TRACE_NUM_REGIONS];
+
+static struct {
+	uint32_t head;
+	tTraceEvent events[TRACE_RING_SIZE];
+} traceRing;
+
+/*
+ * Functions
+ */
+
+/*
+ * traceNow
+ *
+ * @desc    the free running tick counter, the cycle counter on the target
+ */
+static inline uint32_t traceNow(void)
+{
+#ifdef _MSC_VER
+	return (uint32_t)clock();
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+static uint32_t traceTicksPerSec(void)
+{
+#ifdef _MSC_VER
+	return CLOCKS_PER_SEC;
+#else
+	return SystemCoreClock;
+#endif
+}
+
+/*
+ * traceBucket
+ *
+ * @desc    the histogram bucket of a duration, by its number of significant bits
+ */
+static inline uint32_t traceBucket(uint32_t ticks)
+{
+	uint32_t bits;
+
+#ifdef _MSC_VER
+	for(bits = 0; (bits < 32) && (ticks >> bits); bits++)
+	{
+	}
+#else
+	bits = 32 - __CLZ(ticks);
+#endif
+	if(bits <= TRACE_HIST_MIN_BITS)
+	{
+		return 0;
+	}
+	bits -= TRACE_HIST_MIN_BITS;
+	return (bits < TRACE_HIST_BUCKETS) ? bits : (TRACE_HIST_BUCKETS - 1);
+}
+
+static inline void traceEvent(tTraceRegion region, uint32_t stamp, bool bExit)
+{
+	tTraceEvent *pEvent = &traceRing.events[traceRing.head++ & TRACE_RING_MASK];
+
+	pEvent->stamp = stamp;
+	pEvent->region = region;
+	pEvent->bExit = bExit;
+}
+
+/*
+ * Trace_Init
+ *
+ * @desc    starts the cycle counter, it is never reset, durations are differences
+ *
+ * @returns -
+ */
+void Trace_Init(void)
+{
+#ifndef _MSC_VER
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	Trace_Reset();
+}
+
+/*
+ * Trace_Enter
+ *
+ * @desc    use TRACE_ENTER(), records entering a region
+ *
+ * @param   region - the region entered
+ *
+ * @returns the start time, for Trace_Exit()
+ */
+uint32_t Trace_Enter(tTraceRegion region)
+{
+	uint32_t start = traceNow();
+	CS1_CriticalVariable();
+
+	CS1_EnterCritical();
+	traceEvent(region, start, false);
+	CS1_ExitCritical();
+
+	return start;
+}
+
+/*
+ * Trace_Exit
+ *
+ * @desc    use TRACE_EXIT(), records exiting a region and adds its duration to the statistics
+ *
+ * @param   region - the region exited
+ * @param   start - as returned by Trace_Enter()
+ *
+ * @returns -
+ */
+void Trace_Exit(tTraceRegion region, uint32_t start)
+{
+	uint32_t stop = traceNow();
+	uint32_t ticks = stop - start;
+	uint32_t bucket = traceBucket(ticks);
+	tTraceRegionStats *pStats = &traceStats[region];
+	CS1_CriticalVariable();
+
+	CS1_EnterCritical();
+	if((pStats->count == 0) || (ticks < pStats->min))
+	{
+		pStats->min = ticks;
+	}
+	if(ticks > pStats->max)
+	{
+		pStats->max = ticks;
+	}
+	pStats->count++;
+	pStats->sum += ticks;
+	pStats->hist[bucket]++;
+	traceEvent(region, stop, true);
+	CS1_ExitCritical();
+}
+
+/*
+ * Trace_GetStats
+ *
+ * @desc    a copy of the statistics of a region, in ticks
+ *
+ * @param   region - the region
+ * @param   pStats - RETURNS the statistics
+ *
+ * @returns false when there is no such region
+ */
+bool Trace_GetStats(tTraceRegion region, tTraceStats *pStats)
+{
+	tTraceRegionStats stats;
+	CS1_CriticalVariable();
+
+	if(region >= TRACE_NUM_REGIONS)
+	{
+		return false;
+	}
+
+	CS1_EnterCritical();
+	stats = traceStats[region];
+	CS1_ExitCritical();
+
+	memset(pStats, 0, sizeof(*pStats));
+	pStats->region = region;
+	pStats->numRegions = TRACE_NUM_REGIONS;
+	pStats->numBuckets = TRACE_HIST_BUCKETS;
+	pStats->histMinBits = TRACE_HIST_MIN_BITS;
+	pStats->ticksPerSec = traceTicksPerSec();
+	pStats->count = stats.count;
+	pStats->min = stats.min;
+	pStats->max = stats.max;
+	pStats->avg = (stats.count > 0) ? (uint32_t)(stats.sum / stats.count) : 0;
+	strncpy(pStats->name, traceNames[region], sizeof(pStats->name) - 1);
+	memcpy(pStats->hist, stats.hist, sizeof(pStats->hist));
+
+	return true;
+}
+
+/*
+ * Trace_Reset
+ *
+ * @desc    clears the statistics and the ring
+ *
+ * @returns -
+ */
+void Trace_Reset(void)
+{
+	CS1_CriticalVariable();
+
+	CS1_EnterCritical();
+	memset(traceStats, 0, sizeof(traceStats));
+	memset(&traceRing, 0, sizeof(traceRing));
+	CS1_ExitCritical();
+}
+
+/*
+ * Trace_TicksToUs
+ *
+ * @desc    converts a duration in ticks to microseconds
+ *
+ * @param   ticks - the duration
+ *
+ * @returns the duration in us
+ */
+uint32_t Trace_TicksToUs(uint32_t ticks)
+{
+	return (uint32_t)(((uint64_t)ticks * 1000000) / traceTicksPerSec());
+}
+
+/*
+ * Trace_Print
+ *
+ * @desc    prints min/avg/max and the histogram of every region, in us
+ *
+ * @returns -
+ */
+void Trace_Print(void)
+{
+	tTraceStats stats;
+
+	printf(" count    min(us)    avg(us)    max(us)  region\n");
+	for(int region = 0; region < TRACE_NUM_REGIONS; region++)
+	{
+		(void)Trace_GetStats((tTraceRegion)region, &stats);
+		printf("%6d %10d %10d %10d  %s\n", stats.count,
+			   Trace_TicksToUs(stats.min), Trace_TicksToUs(stats.avg), Trace_TicksToUs(stats.max), stats.name);
+
+		for(int bucket = 0; bucket < TRACE_HIST_BUCKETS; bucket++)
+		{
+			if(stats.hist[bucket] == 0)
+			{
+				continue;
+			}
+			if(bucket < (TRACE_HIST_BUCKETS - 1))
+			{
+				printf("    < %10d us: %d\n", Trace_TicksToUs(1u << (TRACE_HIST_MIN_BITS + bucket)), stats.hist[bucket]);
+			}
+			else
+			{
+				printf("   >= %10d us: %d\n", Trace_TicksToUs(1u << (TRACE_HIST_MIN_BITS + bucket - 1)), stats.hist[bucket]);
+			}
+		}
+	}
+}
+
+/*
+ * Trace_PrintRing
+ *
+ * @desc    prints the latest enter/exit events, oldest first, in us from the oldest
+ *
+ * @returns -
+ */
+void Trace_PrintRing(void)
+{
+	static tTraceEvent events[TRACE_RING_SIZE];
+	uint32_t head, count;
+	CS1_CriticalVariable();
+
+	CS1_EnterCritical();
+	memcpy(events, traceRing.events, sizeof(events));
+	head = traceRing.head;
+	CS1_ExitCritical();
+
+	count = (head < TRACE_RING_SIZE) ? head : TRACE_RING_SIZE;
+	for(uint32_t i = head - count; i != head; i++)
+	{
+		const tTraceEvent *pEvent = &events[i & TRACE_RING_MASK];
+
+		printf("%10d us  %s %s\n", Trace_TicksToUs(pEvent->stamp - events[(head - count) & TRACE_RING_MASK].stamp),
+			   traceNames[pEvent->region], pEvent->bExit ? "exit" : "enter");
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
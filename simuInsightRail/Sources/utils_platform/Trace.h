@@ -0,0 +1,102 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Trace.h
+ *
+ * Trace points, timing named regions of the hot paths with the DWT cycle
+ * counter. Each region keeps its count, min/avg/max and a histogram, and the
+ * latest enter/exit events are kept in a RAM ring. See the "trace" CLI
+ * command, and E_BinaryCli_TraceStats for the binary CLI.
+ *
+ * Usage, in one block (TRACE_ENTER declares the start time):
+ *
+ *     TRACE_ENTER(TRACE_IS25_PAGE_PROG);
+ *     ...
+ *     TRACE_EXIT(TRACE_IS25_PAGE_PROG);
+ *
+ * A region must take less than 2^32 cycles (35 s at 120 MHz).
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/*
+ * Includes
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "configFeatures.h"
+
+/*
+ * Macros
+ */
+
+// number of enter/exit events kept, must be a power of 2
+#define TRACE_RING_SIZE			(64)
+
+// histogram bucket 0 is below 2^TRACE_HIST_MIN_BITS ticks, each following one twice as wide
+#define TRACE_HIST_BUCKETS		(20)
+#define TRACE_HIST_MIN_BITS		(10)
+
+#define TRACE_NAME_LEN			(12)
+
+#ifdef CONFIG_PLATFORM_TRACE
+#define TRACE_ENTER(m_region)	uint32_t traceStart_##m_region = Trace_Enter(m_region)
+#define TRACE_EXIT(m_region)	Trace_Exit((m_region), traceStart_##m_region)
+#else
+#define TRACE_ENTER(m_region)
+#define TRACE_EXIT(m_region)
+#endif
+
+/*
+ * Types
+ */
+
+typedef enum
+{
+	TRACE_ADC_BLOCK = 0,		// measure task, handling of an ADC block
+	TRACE_DSP_BLOCK,			// DSP of an ADC block, all chains
+	TRACE_IS25_PAGE_PROG,		// external flash, one page program
+	TRACE_PB_ENCODE,			// nanopb encode of a message
+	TRACE_MQTT_PUBLISH,			// MQTT publish
+	TRACE_MODEM_AT,				// modem AT command round trip
+	TRACE_NUM_REGIONS
+} tTraceRegion;
+
+// the statistics of a region, as sent over the binary CLI (all little endian uint32)
+typedef struct
+{
+	uint8_t region;
+	uint8_t numRegions;
+	uint8_t numBuckets;
+	uint8_t histMinBits;
+	uint32_t ticksPerSec;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint32_t avg;
+	char name[TRACE_NAME_LEN];
+	uint32_t hist[TRACE_HIST_BUCKETS];
+} tTraceStats;
+
+/*
+ * Functions
+ */
+
+void Trace_Init(void);
+uint32_t Trace_Enter(tTraceRegion region);
+void Trace_Exit(tTraceRegion region, uint32_t start);
+bool Trace_GetStats(tTraceRegion region, tTraceStats *pStats);
+void Trace_Reset(void);
+void Trace_Print(void);
+void Trace_PrintRing(void);
+uint32_t Trace_TicksToUs(uint32_t ticks);
+
+#endif /* TRACE_H_ */
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -242,23 +242,12 @@ static void print_double(void (*put_c)(uint8_t c), char fc, char flags, short wi
 
 	not full/fool proof parsing, so silly format strings will probably give silly results
 	
+	vprintgdf() does the formatting, without the lock, for callers that keep their output apart themselves
  */
-void printgdf(void (*put_c)(uint8_t c), const char *format, ...)
+void vprintgdf(void (*put_c)(uint8_t c), const char *format, va_list args)
 {
 	char c;
-	va_list args;
-
-	va_start(args, format);
 
-#ifdef PROTECT_PRINTF
-	if(!xSemaphore)
-	{
-		xSemaphore = xSemaphoreCreateMutex();
-    }
-	if(true == xSemaphoreTake( xSemaphore, 200 ))
-	{
-#endif
-	
 	while( (c = *format++) != 0) {
 		if (c == '%') {
 			short width=0;
@@ -413,6 +402,24 @@ void printgdf(void (*put_c)(uint8_t c), const char *format, ...)
 		}
 	
 	} //while
+}
+
+void printgdf(void (*put_c)(uint8_t c), const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+
+#ifdef PROTECT_PRINTF
+	if(!xSemaphore)
+	{
+		xSemaphore = xSemaphoreCreateMutex();
+    }
+	if(true == xSemaphoreTake( xSemaphore, 200 ))
+	{
+#endif
+
+	vprintgdf(put_c, format, args);
 
 	if(binaryCLI_getMode() == E_CLI_MODE_BINARY)
 	{
@@ -22,7 +22,9 @@ extern "C" {
 #ifndef NEWLIB_NANO
 
 // use homebrew printf
+#include <stdarg.h>
 void printgdf(void (*put_c)(uint8_t c), const char *format, ...);
+void vprintgdf(void (*put_c)(uint8_t c), const char *format, va_list args);
 void suspendCli();
 
 #define printf(...)	     printgdf(put_ch, __VA_ARGS__)
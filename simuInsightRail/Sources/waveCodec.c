@@ -0,0 +1,486 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * waveCodec.c
+ *
+ * Lossless waveform codec, see waveCodec.h for the stream format.
+ * Plain C without target dependencies, so the decoder builds as is on a host.
+ */
+
+#include <string.h>
+#include "waveCodec.h"
+
+#define WAVECODEC_MAX_ORDER         (2)
+#define WAVECODEC_VERBATIM          (3)
+#define WAVECODEC_MAX_K             (31)
+#define WAVECODEC_ESCAPE_BITS       (35)
+
+typedef struct
+{
+	uint8_t *p;
+	uint32_t pos;			// bytes written
+	uint32_t size;			// bytes available
+	uint64_t acc;
+	uint32_t bits;			// bits in acc not yet written
+	bool overflow;
+} tBitWriter;
+
+typedef struct
+{
+	const uint8_t *p;
+	uint32_t pos;			// bytes read
+	uint32_t size;
+	uint64_t acc;
+	uint32_t bits;			// bits in acc not yet used
+	bool underflow;
+} tBitReader;
+
+/**
+ * Append up to 32 bits, most significant first
+ */
+static void putBits(tBitWriter *w, uint32_t value, uint32_t n)
+{
+	if (n == 0)
+	{
+		return;
+	}
+	w->acc = (w->acc << n) | (value & (0xFFFFFFFFu >> (32 - n)));
+	w->bits += n;
+	while (w->bits >= 8)
+	{
+		w->bits -= 8;
+		if (w->pos < w->size)
+		{
+			w->p[w->pos++] = (uint8_t)(w->acc >> w->bits);
+		}
+		else
+		{
+			w->overflow = true;
+		}
+	}
+}
+
+/**
+ * Pad to a whole byte
+ */
+static void flushBits(tBitWriter *w)
+{
+	if (w->bits)
+	{
+		putBits(w, 0, 8 - w->bits);
+	}
+}
+
+static uint32_t getBits(tBitReader *r, uint32_t n)
+{
+	if (n == 0)
+	{
+		return 0;
+	}
+	while (r->bits < n)
+	{
+		if (r->pos < r->size)
+		{
+			r->acc = (r->acc << 8) | r->p[r->pos++];
+		}
+		else
+		{
+			r->acc <<= 8;
+			r->underflow = true;
+		}
+		r->bits += 8;
+	}
+	r->bits -= n;
+	return (uint32_t)(r->acc >> r->bits) & (0xFFFFFFFFu >> (32 - n));
+}
+
+static void alignBits(tBitReader *r)
+{
+	r->bits -= (r->bits % 8);
+}
+
+static uint64_t zigzag(int64_t e)
+{
+	return (e < 0) ? ((((uint64_t)(-(e + 1))) << 1) | 1) : (((uint64_t)e) << 1);
+}
+
+static int64_t unzigzag(uint64_t u)
+{
+	return (u & 1) ? (-(int64_t)(u >> 1) - 1) : (int64_t)(u >> 1);
+}
+
+/**
+ * Prediction residual of sample i (i >= order)
+ */
+static int64_t residual(const int32_t *x, uint32_t i, uint32_t order)
+{
+	switch (order)
+	{
+	case 1:
+		return (int64_t)x[i] - x[i-1];
+	case 2:
+		return (int64_t)x[i] - (2 * (int64_t)x[i-1]) + x[i-2];
+	default:
+		return x[i];
+	}
+}
+
+static int64_t prediction(const int32_t *x, uint32_t i, uint32_t order)
+{
+	switch (order)
+	{
+	case 1:
+		return x[i-1];
+	case 2:
+		return (2 * (int64_t)x[i-1]) - x[i-2];
+	default:
+		return 0;
+	}
+}
+
+static uint32_t riceBits(uint64_t zz, uint32_t k)
+{
+	uint64_t q = zz >> k;
+
+	return (q < WAVECODEC_RICE_ESCAPE) ? ((uint32_t)q + 1 + k) : (WAVECODEC_RICE_ESCAPE + WAVECODEC_ESCAPE_BITS);
+}
+
+static void putRice(tBitWriter *w, uint64_t zz, uint32_t k)
+{
+	uint64_t q = zz >> k;
+
+	if (q < WAVECODEC_RICE_ESCAPE)
+	{
+		// q ones and a terminating zero
+		putBits(w, 0xFFFFFFFEu, (uint32_t)q + 1);
+		putBits(w, (uint32_t)zz, k);
+	}
+	else
+	{
+		putBits(w, 0xFFFFFFFFu, WAVECODEC_RICE_ESCAPE);
+		putBits(w, (uint32_t)(zz >> 32), WAVECODEC_ESCAPE_BITS - 32);
+		putBits(w, (uint32_t)zz, 32);
+	}
+}
+
+static bool getRice(tBitReader *r, uint32_t k, uint64_t *zz_p)
+{
+	uint32_t q = 0;
+
+	while ((q < WAVECODEC_RICE_ESCAPE) && getBits(r, 1))
+	{
+		q++;
+	}
+	if (q < WAVECODEC_RICE_ESCAPE)
+	{
+		*zz_p = ((uint64_t)q << k) | getBits(r, k);
+	}
+	else
+	{
+		*zz_p = (uint64_t)getBits(r, WAVECODEC_ESCAPE_BITS - 32) << 32;
+		*zz_p |= getBits(r, 32);
+	}
+	return !r->underflow;
+}
+
+/**
+ * Rice parameter giving the fewest bits for residuals first to last
+ */
+static uint32_t bestRiceParameter(const int32_t *x, uint32_t first, uint32_t last, uint32_t order, uint32_t *pBits)
+{
+	uint64_t sum = 0;
+	uint32_t k = 0;
+	uint32_t best = 0;
+	uint32_t i;
+
+	*pBits = UINT32_MAX;
+	if (first >= last)
+	{
+		*pBits = 0;
+		return 0;
+	}
+
+	// estimate from the mean, then try either side of it
+	for (i = first; i < last; i++)
+	{
+		sum += zigzag(residual(x, i, order));
+	}
+	while ((k < WAVECODEC_MAX_K) && (((uint64_t)(last - first) << (k + 1)) <= sum))
+	{
+		k++;
+	}
+	for (uint32_t tryK = (k > 0) ? (k - 1) : 0; (tryK <= (k + 1)) && (tryK <= WAVECODEC_MAX_K); tryK++)
+	{
+		uint32_t bits = 0;
+
+		for (i = first; i < last; i++)
+		{
+			bits += riceBits(zigzag(residual(x, i, order)), tryK);
+		}
+		if (bits < *pBits)
+		{
+			*pBits = bits;
+			best = tryK;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Code one block with the predictor giving the smallest residuals, and the
+ * best Rice parameter for each partition of it, or verbatim
+ */
+static void encodeBlock(tBitWriter *w, const int32_t *x, uint32_t n)
+{
+	uint64_t sum[WAVECODEC_MAX_ORDER + 1] = { 0 };
+	uint8_t k[WAVECODEC_BLOCK_SAMPLES / WAVECODEC_PARTITION_SAMPLES];
+	uint32_t order = 0;
+	uint32_t bits;
+	uint32_t part;
+	uint32_t i;
+
+	// compare the predictors on the samples all of them can predict
+	if (n > WAVECODEC_MAX_ORDER)
+	{
+		for (i = WAVECODEC_MAX_ORDER; i < n; i++)
+		{
+			for (uint32_t o = 0; o <= WAVECODEC_MAX_ORDER; o++)
+			{
+				sum[o] += zigzag(residual(x, i, o));
+			}
+		}
+		for (uint32_t o = 1; o <= WAVECODEC_MAX_ORDER; o++)
+		{
+			if (sum[o] < sum[order])
+			{
+				order = o;
+			}
+		}
+	}
+
+	bits = 8 + (32 * order);
+	for (part = 0; (part * WAVECODEC_PARTITION_SAMPLES) < n; part++)
+	{
+		uint32_t first = part * WAVECODEC_PARTITION_SAMPLES;
+		uint32_t last = first + WAVECODEC_PARTITION_SAMPLES;
+		uint32_t partBits;
+
+		k[part] = bestRiceParameter(x, (first > order) ? first : order, (last < n) ? last : n, order, &partBits);
+		bits += 5 + partBits;
+	}
+
+	if (bits >= (8 + (32 * n)))
+	{
+		putBits(w, WAVECODEC_VERBATIM << 6, 8);
+		for (i = 0; i < n; i++)
+		{
+			putBits(w, (uint32_t)x[i], 32);
+		}
+	}
+	else
+	{
+		putBits(w, order << 6, 8);
+		for (i = 0; i < order; i++)
+		{
+			putBits(w, (uint32_t)x[i], 32);
+		}
+		for (i = order; i < n; i++)
+		{
+			if ((i == order) || ((i % WAVECODEC_PARTITION_SAMPLES) == 0))
+			{
+				part = i / WAVECODEC_PARTITION_SAMPLES;
+				putBits(w, k[part], 5);
+			}
+			putRice(w, zigzag(residual(x, i, order)), k[part]);
+		}
+		flushBits(w);
+	}
+}
+
+static bool decodeBlock(tBitReader *r, int32_t *x, uint32_t n)
+{
+	uint32_t order = getBits(r, 8) >> 6;
+	uint32_t k = 0;
+	uint32_t i;
+
+	if (order == WAVECODEC_VERBATIM)
+	{
+		for (i = 0; i < n; i++)
+		{
+			x[i] = (int32_t)getBits(r, 32);
+		}
+	}
+	else
+	{
+		for (i = 0; (i < order) && (i < n); i++)
+		{
+			x[i] = (int32_t)getBits(r, 32);
+		}
+		for (; i < n; i++)
+		{
+			uint64_t zz;
+			int64_t value;
+
+			if ((i == order) || ((i % WAVECODEC_PARTITION_SAMPLES) == 0))
+			{
+				k = getBits(r, 5);
+			}
+			if (!getRice(r, k, &zz))
+			{
+				return false;
+			}
+			value = prediction(x, i, order) + unzigzag(zz);
+			if ((value < INT32_MIN) || (value > INT32_MAX))
+			{
+				return false;
+			}
+			x[i] = (int32_t)value;
+		}
+		alignBits(r);
+	}
+
+	return !r->underflow;
+}
+
+/**
+ * waveCodec_MaxEncodedBytes
+ *
+ * @brief Largest encoded size of a number of samples
+ * @param numSamples - number of samples
+ * @return size in bytes
+ */
+uint32_t waveCodec_MaxEncodedBytes(uint32_t numSamples)
+{
+	return WAVECODEC_HEADER_BYTES +
+		   ((numSamples + WAVECODEC_BLOCK_SAMPLES - 1) / WAVECODEC_BLOCK_SAMPLES) +
+		   (numSamples * sizeof(int32_t));
+}
+
+/**
+ * waveCodec_Encode
+ *
+ * @brief Compress a waveform. The output may overwrite the samples (pOut the
+ *        same as pSamples): each block is copied before its output is written,
+ *        and encoding fails if the output would reach samples not yet coded.
+ *        That can only happen for a waveform which does not compress.
+ *        Not reentrant, uses a static block buffer.
+ * @param pSamples - the samples
+ * @param numSamples - number of samples
+ * @param scaling - sample to float scale factor, passed on in the header
+ * @param pOut - output buffer
+ * @param outSize - size of the output buffer in bytes
+ * @return encoded size in bytes, or -1 when it does not fit
+ */
+int32_t waveCodec_Encode(const int32_t *pSamples, uint32_t numSamples, float scaling,
+						 uint8_t *pOut, uint32_t outSize)
+{
+	static int32_t block[WAVECODEC_BLOCK_SAMPLES];
+	bool bInPlace = ((const uint8_t *)pSamples == pOut);
+	tBitWriter w = { pOut, 0, 0, 0, 0, false };
+	union {
+		float f;
+		uint32_t u;
+	} scale;
+	uint32_t start = 0;
+	uint32_t n;
+
+	do
+	{
+		n = numSamples - start;
+		if (n > WAVECODEC_BLOCK_SAMPLES)
+		{
+			n = WAVECODEC_BLOCK_SAMPLES;
+		}
+		memcpy(block, &pSamples[start], n * sizeof(int32_t));
+
+		w.size = outSize;
+		if (bInPlace && ((start + n) < numSamples) && (((start + n) * sizeof(int32_t)) < outSize))
+		{
+			w.size = (start + n) * sizeof(int32_t);
+		}
+
+		if (start == 0)
+		{
+			scale.f = scaling;
+			putBits(&w, ('W' << 8) | 'C', 16);
+			putBits(&w, (WAVECODEC_VERSION << 8) | WAVECODEC_BLOCK_LOG2, 16);
+			putBits(&w, numSamples, 32);
+			putBits(&w, scale.u, 32);
+		}
+		if (n)
+		{
+			encodeBlock(&w, block, n);
+		}
+		if (w.overflow)
+		{
+			return -1;
+		}
+		start += n;
+	} while (start < numSamples);
+
+	return (int32_t)w.pos;
+}
+
+/**
+ * waveCodec_Decode
+ *
+ * @brief Decompress a waveform
+ * @param pIn - the encoded stream
+ * @param inSize - size of the encoded stream in bytes
+ * @param pSamples - output samples
+ * @param maxSamples - room in pSamples
+ * @param pScaling - output sample to float scale factor, may be NULL
+ * @return number of samples, or -1 when the stream is invalid or too long
+ */
+int32_t waveCodec_Decode(const uint8_t *pIn, uint32_t inSize,
+						 int32_t *pSamples, uint32_t maxSamples, float *pScaling)
+{
+	tBitReader r = { pIn, 0, inSize, 0, 0, false };
+	union {
+		float f;
+		uint32_t u;
+	} scale;
+	uint32_t numSamples;
+	uint32_t start;
+	uint32_t n;
+
+	if ((getBits(&r, 16) != (('W' << 8) | 'C')) ||
+		(getBits(&r, 8) != WAVECODEC_VERSION) ||
+		(getBits(&r, 8) != WAVECODEC_BLOCK_LOG2))
+	{
+		return -1;
+	}
+	numSamples = getBits(&r, 32);
+	scale.u = getBits(&r, 32);
+	if (r.underflow || (numSamples > maxSamples) || (numSamples > INT32_MAX))
+	{
+		return -1;
+	}
+
+	for (start = 0; start < numSamples; start += n)
+	{
+		n = numSamples - start;
+		if (n > WAVECODEC_BLOCK_SAMPLES)
+		{
+			n = WAVECODEC_BLOCK_SAMPLES;
+		}
+		if (!decodeBlock(&r, &pSamples[start], n))
+		{
+			return -1;
+		}
+	}
+
+	if (pScaling)
+	{
+		*pScaling = scale.f;
+	}
+	return (int32_t)numSamples;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * waveCodec.h
+ *
+ * Lossless compression of the int32 waveform samples for upload.
+ *
+ * The samples are split into blocks, each coded on its own with the best of
+ * a few fixed linear predictors (none, 1st or 2nd difference) and Rice coding
+ * of the prediction residuals, or stored verbatim when that does not pay.
+ * Each partition of a block has its own Rice parameter, so that a burst
+ * (an impact) only costs bits where it happens.
+ *
+ * Stream format, multi-byte values big endian (network order):
+ *   header  'W' 'C' <version> <log2 block samples> <uint32 samples> <float scaling>
+ *   blocks  <order:2 | spare:6> <order warm-up samples, int32>
+ *           per partition: <rice k:5> <Rice coded zigzagged residuals>
+ *           padded to a whole byte
+ * A verbatim block (order 3) holds its samples as int32.
+ * A residual whose Rice quotient reaches WAVECODEC_RICE_ESCAPE is sent as
+ * WAVECODEC_RICE_ESCAPE 1 bits followed by the zigzagged residual in 35 bits.
+ *
+ * The decoded samples times the scaling give the float values otherwise
+ * uploaded.
+ */
+
+#ifndef SOURCES_WAVECODEC_H_
+#define SOURCES_WAVECODEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WAVECODEC_VERSION           (1)
+#define WAVECODEC_BLOCK_LOG2        (8)
+#define WAVECODEC_BLOCK_SAMPLES     (1 << WAVECODEC_BLOCK_LOG2)
+#define WAVECODEC_PARTITION_SAMPLES (32)
+#define WAVECODEC_HEADER_BYTES      (12)
+#define WAVECODEC_RICE_ESCAPE       (24)
+
+uint32_t waveCodec_MaxEncodedBytes(uint32_t numSamples);
+int32_t waveCodec_Encode(const int32_t *pSamples, uint32_t numSamples, float scaling,
+						 uint8_t *pOut, uint32_t outSize);
+int32_t waveCodec_Decode(const uint8_t *pIn, uint32_t inSize,
+						 int32_t *pSamples, uint32_t maxSamples, float *pScaling);
+
+#endif /* SOURCES_WAVECODEC_H_ */
+
+
+#ifdef __cplusplus
+}
+#endif
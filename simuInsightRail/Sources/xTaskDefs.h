@@ -67,6 +67,8 @@ typedef struct {
 
 #define PRIORITY_XTASK_POWER            ( tskIDLE_PRIORITY + 1 )
 #define PRIORITY_XTASK_EXT_FLASH        ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_XTASK_EVENTLOG         ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_XTASK_LOG              ( tskIDLE_PRIORITY )
 
 
 
@@ -87,6 +89,8 @@ typedef struct {
 #define STACKSIZE_XTASK_CLI               ( ( unsigned portSHORT)(   4*256 + FREERTOS_THREAD_TASK_OVERHEAD))
 #define STACKSIZE_XTASK_POWER             ( ( unsigned portSHORT)(   256 + FREERTOS_THREAD_TASK_OVERHEAD))
 #define STACKSIZE_XTASK_EXT_FLASH         ( ( unsigned portSHORT)(   256 + FREERTOS_THREAD_TASK_OVERHEAD))
+#define STACKSIZE_XTASK_EVENTLOG          ( ( unsigned portSHORT)(   256 + FREERTOS_THREAD_TASK_OVERHEAD))
+#define STACKSIZE_XTASK_LOG               ( ( unsigned portSHORT)(   256 + FREERTOS_THREAD_TASK_OVERHEAD))
 #define STACKSIZE_XTASK_PMIC              ( ( unsigned portSHORT)(   2*256 + FREERTOS_THREAD_TASK_OVERHEAD))
 #define STACKSIZE_XTASK_GNSS              ( ( unsigned portSHORT)(   2*256 + FREERTOS_THREAD_TASK_OVERHEAD))
 #define STACKSIZE_XTASK_BINCLI            ( ( unsigned portSHORT)(   2*256 + FREERTOS_THREAD_TASK_OVERHEAD))
@@ -31,6 +31,9 @@ uint32_t __app_cfg_shadow [0x2000 / sizeof(char)];
 uint32_t  __eventlog_size = 0x3000;
 uint32_t __event_log[0x3000 / sizeof(char)];
 
+uint32_t  __eventlog_ram_size = 0x800;
+uint32_t __eventlog_ram[0x800 / sizeof(char)];
+
 uint32_t __bootcfg_size = 0x1000;
 uint32_t __bootcfg[0x1000 / sizeof(char)];
 